@@ -6096,7 +6096,8 @@ INSTANTIATE_TEST_CASE_P(
                       CompactionPri::kOldestLargestSeqFirst,
                       CompactionPri::kOldestSmallestSeqFirst,
                       CompactionPri::kMinOverlappingRatio,
-                      CompactionPri::kRoundRobin));
+                      CompactionPri::kRoundRobin,
+                      CompactionPri::kMergeOperandDensity));
 
 TEST_F(DBCompactionTest, PersistRoundRobinCompactCursor) {
   Options options = CurrentOptions();
@@ -1,21 +1,97 @@
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "rocksdb/graph.h"
+#include "db/graph_set_ops.h"
+#include "db/write_batch_internal.h"
+#include "monitoring/statistics_impl.h"
+#include "rocksdb/graph_changes.h"
+#include "rocksdb/graph_csr_snapshot.h"
+#include "rocksdb/graph_edge_filter.h"
+#include "rocksdb/graph_perf_context.h"
+#include "rocksdb/graph_trace.h"
+#include "rocksdb/graph_transaction.h"
+#include "rocksdb/perf_level.h"
+#include "rocksdb/system_clock.h"
+#include "rocksdb/transaction_log.h"
+#include "rocksdb/utilities/optimistic_transaction_db.h"
+#include "rocksdb/utilities/transaction_db.h"
 #include "rocksdb/write_batch.h"
+#include "util/coding.h"
+#include "util/hash.h"
 
 namespace ROCKSDB_NAMESPACE {
 
+namespace {
+// Merge operands folded on this thread; adjacency reads diff it around Get.
+thread_local uint64_t adj_merge_operands = 0;
+
+int DepthBucket(uint64_t operands) {
+  int bucket = 0;
+  while (operands > 0 && bucket < GraphStats::kDepthBuckets - 1) {
+    operands >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void UpdateMax(std::atomic<uint64_t>* max, uint64_t value) {
+  uint64_t cur = max->load(std::memory_order_relaxed);
+  while (value > cur && !max->compare_exchange_weak(cur, value)) {
+  }
+}
+}  // namespace
+
+const std::string GraphProperties::kStats = "rocksgraph.stats";
+const std::string GraphProperties::kDegreeHistogram =
+    "rocksgraph.degree-histogram";
+const std::string GraphProperties::kMergeOperandDepth =
+    "rocksgraph.merge-operand-depth";
+const std::string GraphProperties::kPolicyMix = "rocksgraph.policy-mix";
+const std::string GraphProperties::kSketchMemory = "rocksgraph.sketch-memory";
+const std::string GraphProperties::kNumVertices = "rocksgraph.num-vertices";
+const std::string GraphProperties::kNumEdges = "rocksgraph.num-edges";
+const std::string GraphProperties::kAdjListReads = "rocksgraph.adj-list-reads";
+const std::string GraphProperties::kMaxMergeOperands =
+    "rocksgraph.max-merge-operands";
+const std::string GraphProperties::kMorrisSaturated =
+    "rocksgraph.morris-saturated";
+
 void inline MergeSortOutEdges(const Edges& existing_edges,
                               const Edges& new_edges, Edges& merged_edges,
-                              node_id_t vertex, node_id_t& m,
+                              node_id_t vertex, std::atomic<node_id_t>& m,
                               bool is_partial = true,
-                              MorrisCounter* mor = NULL) {
+                              MorrisCounter* mor = NULL,
+                              bool symmetric = false) {
+  // a symmetric list holds each edge at both endpoints; only the copy at the
+  // smaller endpoint adjusts the edge count
+  auto counts = [symmetric, vertex](node_id_t other) {
+    return !symmetric || vertex <= other;
+  };
   std::vector<node_id_t> delete_edges;
   node_id_t pivot_ex = 0;
   node_id_t pivot_new = 0;
   uint32_t edge_count = 0;
   // sorted_merge
   auto merge_edges_list = new Edge[merged_edges.num_edges_out];
+  // attributes stay aligned with the ids; entries from a list without them
+  // get the defaults
+  EdgeAttr* merge_attrs = existing_edges.attrs_out || new_edges.attrs_out
+                              ? new EdgeAttr[merged_edges.num_edges_out]
+                              : NULL;
+  auto take = [&](const Edges& edges, node_id_t& pivot) {
+    if (merge_attrs && edges.attrs_out) {
+      merge_attrs[edge_count] = edges.attrs_out[pivot];
+    }
+    merge_edges_list[edge_count++].nxt = edges.nxts_out[pivot++].nxt;
+  };
   while (pivot_ex < existing_edges.num_edges_out ||
          pivot_new < new_edges.num_edges_out) {
     bool is_deleted = false;
@@ -24,19 +100,28 @@ void inline MergeSortOutEdges(const Edges& existing_edges,
         if (delete_edge == existing_edges.nxts_out[pivot_ex].nxt) {
           pivot_ex++;
           is_deleted = true;
-          mor->DecayCounter(vertex);
-          m--;
+          if (mor) mor->DecayCounter(vertex);
+          if (counts(delete_edge)) m--;
         }
       }
     }
     if (is_deleted) continue;
     if (pivot_ex >= existing_edges.num_edges_out) {
-      merge_edges_list[edge_count++].nxt = new_edges.nxts_out[pivot_new++].nxt;
+      // a full merge has nothing left for the marker to delete
+      if (!is_partial && new_edges.nxts_out[pivot_new].nxt < 0) {
+        pivot_new++;
+        continue;
+      }
+      take(new_edges, pivot_new);
       continue;
     }
     if (pivot_new >= new_edges.num_edges_out) {
-      merge_edges_list[edge_count++].nxt =
-          existing_edges.nxts_out[pivot_ex++].nxt;
+      // nor for a marker left in the base list
+      if (!is_partial && existing_edges.nxts_out[pivot_ex].nxt < 0) {
+        pivot_ex++;
+        continue;
+      }
+      take(existing_edges, pivot_ex);
       continue;
     }
     if (existing_edges.nxts_out[pivot_ex].nxt < 0) {
@@ -55,19 +140,19 @@ void inline MergeSortOutEdges(const Edges& existing_edges,
     }
     if (existing_edges.nxts_out[pivot_ex].nxt ==
         new_edges.nxts_out[pivot_new].nxt) {
+      if (counts(existing_edges.nxts_out[pivot_ex].nxt)) m--;
       pivot_ex++;
-      mor->DecayCounter(vertex);
-      m--;
+      if (mor) mor->DecayCounter(vertex);
     } else if (existing_edges.nxts_out[pivot_ex].nxt >
                new_edges.nxts_out[pivot_new].nxt) {
-      merge_edges_list[edge_count++].nxt = new_edges.nxts_out[pivot_new++].nxt;
+      take(new_edges, pivot_new);
     } else {
-      merge_edges_list[edge_count++].nxt =
-          existing_edges.nxts_out[pivot_ex++].nxt;
+      take(existing_edges, pivot_ex);
     }
   }
   merged_edges.num_edges_out = edge_count;
   merged_edges.nxts_out = merge_edges_list;
+  merged_edges.attrs_out = merge_attrs;
 }
 
 void inline MergeSortInEdges(const Edges& existing_edges,
@@ -80,6 +165,15 @@ void inline MergeSortInEdges(const Edges& existing_edges,
   uint32_t edge_count = 0;
   // sorted_merge
   auto merge_edges_list = new Edge[merged_edges.num_edges_in];
+  EdgeAttr* merge_attrs = existing_edges.attrs_in || new_edges.attrs_in
+                              ? new EdgeAttr[merged_edges.num_edges_in]
+                              : NULL;
+  auto take = [&](const Edges& edges, node_id_t& pivot) {
+    if (merge_attrs && edges.attrs_in) {
+      merge_attrs[edge_count] = edges.attrs_in[pivot];
+    }
+    merge_edges_list[edge_count++].nxt = edges.nxts_in[pivot++].nxt;
+  };
   while (pivot_ex < existing_edges.num_edges_in ||
          pivot_new < new_edges.num_edges_in) {
     bool is_deleted = false;
@@ -88,18 +182,27 @@ void inline MergeSortInEdges(const Edges& existing_edges,
         if (delete_edge == existing_edges.nxts_in[pivot_ex].nxt) {
           pivot_ex++;
           is_deleted = true;
-          mor->DecayCounter(vertex);
+          if (mor) mor->DecayCounter(vertex);
         }
       }
     }
     if (is_deleted) continue;
     if (pivot_ex >= existing_edges.num_edges_in) {
-      merge_edges_list[edge_count++].nxt = new_edges.nxts_in[pivot_new++].nxt;
+      // a full merge has nothing left for the marker to delete
+      if (!is_partial && new_edges.nxts_in[pivot_new].nxt < 0) {
+        pivot_new++;
+        continue;
+      }
+      take(new_edges, pivot_new);
       continue;
     }
     if (pivot_new >= new_edges.num_edges_in) {
-      merge_edges_list[edge_count++].nxt =
-          existing_edges.nxts_in[pivot_ex++].nxt;
+      // nor for a marker left in the base list
+      if (!is_partial && existing_edges.nxts_in[pivot_ex].nxt < 0) {
+        pivot_ex++;
+        continue;
+      }
+      take(existing_edges, pivot_ex);
       continue;
     }
     if (existing_edges.nxts_in[pivot_ex].nxt < 0) {
@@ -119,17 +222,17 @@ void inline MergeSortInEdges(const Edges& existing_edges,
     if (existing_edges.nxts_in[pivot_ex].nxt ==
         new_edges.nxts_in[pivot_new].nxt) {
       pivot_ex++;
-      mor->DecayCounter(vertex);
+      if (mor) mor->DecayCounter(vertex);
     } else if (existing_edges.nxts_in[pivot_ex].nxt >
                new_edges.nxts_in[pivot_new].nxt) {
-      merge_edges_list[edge_count++].nxt = new_edges.nxts_in[pivot_new++].nxt;
+      take(new_edges, pivot_new);
     } else {
-      merge_edges_list[edge_count++].nxt =
-          existing_edges.nxts_in[pivot_ex++].nxt;
+      take(existing_edges, pivot_ex);
     }
   }
   merged_edges.num_edges_in = edge_count;
   merged_edges.nxts_in = merge_edges_list;
+  merged_edges.attrs_in = merge_attrs;
 }
 
 bool RocksGraph::AdjacentListMergeOp::Merge(const Slice& key,
@@ -137,23 +240,31 @@ bool RocksGraph::AdjacentListMergeOp::Merge(const Slice& key,
                                             const Slice& value,
                                             std::string* new_value,
                                             Logger* logger) const {
+  adj_merge_operands++;
+  // markers sort first; without a base they delete nothing
+  EdgeListView view(value.data(), value.size(), encoding_type_);
+  bool has_markers = (view.num_edges_out() > 0 && view.out(0) < 0) ||
+                     (view.num_edges_in() > 0 && view.in(0) < 0);
   if (key.size()) {
-    if (!existing_value) {
+    if (!existing_value && !has_markers) {
       *new_value = value.ToString();
       return true;
     }
   }
   Edges new_edges, existing_edges, merged_edges;
   decode_edges(&new_edges, value.data(), value.size(), encoding_type_);
-  decode_edges(&existing_edges, existing_value->data(), existing_value->size(), encoding_type_);
+  if (existing_value) {
+    decode_edges(&existing_edges, existing_value->data(),
+                 existing_value->size(), encoding_type_);
+  }
   merged_edges.num_edges_out =
       existing_edges.num_edges_out + new_edges.num_edges_out;
   merged_edges.num_edges_in =
       existing_edges.num_edges_in + new_edges.num_edges_in;
   MergeSortOutEdges(existing_edges, new_edges, merged_edges,
-                    decode_node(key.data()), *m_, false, morris_);
+                    decode_node(key), *m_, false, morris_, symmetric_);
   MergeSortInEdges(existing_edges, new_edges, merged_edges,
-                   decode_node(key.data()), false, morris_);
+                   decode_node(key), false, morris_);
   free_edges(&existing_edges);
   free_edges(&new_edges);
   encode_edges(&merged_edges, new_value, encoding_type_);
@@ -182,9 +293,9 @@ bool RocksGraph::AdjacentListMergeOp::PartialMerge(const Slice& key,
   merged_edges.num_edges_in =
       existing_edges.num_edges_in + new_edges.num_edges_in;
   MergeSortOutEdges(existing_edges, new_edges, merged_edges,
-                    decode_node(key.data()), *m_, true, morris_);
+                    decode_node(key), *m_, true, morris_, symmetric_);
   MergeSortInEdges(existing_edges, new_edges, merged_edges,
-                   decode_node(key.data()), true, morris_);
+                   decode_node(key), true, morris_);
   free_edges(&existing_edges);
   free_edges(&new_edges);
   encode_edges(&merged_edges, new_value, encoding_type_);
@@ -288,8 +399,14 @@ bool RocksGraph::PropertyMergeOp::PartialMerge(const Slice& key,
   if (key.size()) logger->Flush();
 }
 
+// With `new_attrs`, attributes are carried over when the list or the insert
+// has any; the inserted (or already present) edge takes `insert_attr`, or
+// the defaults if that is NULL.
 bool inline InsertToEdgeList(Edge*& new_list, const Edge* cur_list,
-                             node_id_t cur_length, node_id_t insert_id) {
+                             node_id_t cur_length, node_id_t insert_id,
+                             EdgeAttr** new_attrs = NULL,
+                             const EdgeAttr* cur_attrs = NULL,
+                             const EdgeAttr* insert_attr = NULL) {
   new_list = new Edge[cur_length + 1];
   node_id_t pivot_ex = 0;
   uint32_t edge_count = 0;
@@ -309,9 +426,30 @@ bool inline InsertToEdgeList(Edge*& new_list, const Edge* cur_list,
   if (cur_length == 0 || cur_list[cur_length - 1].nxt < insert_id) {
     new_list[cur_length].nxt = insert_id;
   }
+  if (new_attrs != NULL && (cur_attrs != NULL || insert_attr != NULL)) {
+    *new_attrs = new EdgeAttr[cur_length + 1];
+    node_id_t new_length = is_merge ? cur_length : cur_length + 1;
+    node_id_t cur = 0;
+    for (node_id_t i = 0; i < new_length; i++) {
+      if (new_list[i].nxt == insert_id) {
+        if (insert_attr != NULL) (*new_attrs)[i] = *insert_attr;
+        if (is_merge) cur++;
+      } else {
+        if (cur_attrs != NULL) (*new_attrs)[i] = cur_attrs[cur];
+        cur++;
+      }
+    }
+  }
   return is_merge;
 }
 
+inline EdgeAttr* CopyEdgeAttrs(const EdgeAttr* attrs, uint32_t num) {
+  if (attrs == NULL) return NULL;
+  EdgeAttr* copy = new EdgeAttr[num];
+  std::copy(attrs, attrs + num, copy);
+  return copy;
+}
+
 node_id_t RocksGraph::random_walk(node_id_t start, float decay_factor) {
   node_id_t cur = start;
   for (;;) {
@@ -319,7 +457,7 @@ node_id_t RocksGraph::random_walk(node_id_t start, float decay_factor) {
     std::string key;
     std::string value;
     encode_node(VertexKey{.id = cur}, &key);
-    Status s = db_->Get(ReadOptions(), adj_cf_, key, &value);
+    Status s = ReadAdjacency(key, &value);
     if (!s.ok()) {
       return 0;
     }
@@ -344,6 +482,9 @@ node_id_t RocksGraph::CountVertex() { return n; }
 node_id_t RocksGraph::CountEdge() { return m; }
 
 Status RocksGraph::AddVertex(node_id_t id) {
+  TraceOp(kGraphTraceAddVertex, id);
+  Status s = ToInternalId(id, &id, true);
+  if (!s.ok()) return s;
   n++;
   VertexKey v{.id = id};
   std::string key, value;
@@ -355,11 +496,12 @@ Status RocksGraph::AddVertex(node_id_t id) {
   free_edges(&edges);
   // if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY)
   //   return db_->Merge(WriteOptions(), adj_cf_, key, value);
-  db_->Put(WriteOptions(), adj_cf_, key, value);
-  value = "";
-  db_->Put(WriteOptions(), edge_prop_cf_, key, value);
-  db_->Put(WriteOptions(), vertex_prop_cf_, key, value);
-  return Status::OK();
+  WriteBatch batch;
+  batch.Put(adj_cf_, key, value);
+  batch.Put(edge_prop_cf_, key, "");
+  batch.Put(vertex_prop_cf_, key, "");
+  PutGraphChangeRecord(&batch, kGraphChangeAddVertex, id);
+  return WriteGraph(&batch);
 }
 
 Status RocksGraph::AddEdge(node_id_t from, node_id_t to) {
@@ -372,7 +514,23 @@ Status RocksGraph::AddEdge(node_id_t from, node_id_t to) {
   //   mor_in.AddCounter(to);
   // }
 
-  Status s;
+  TraceOp(kGraphTraceAddEdge, from, to);
+  return WriteEdge(from, to, NULL);
+}
+
+Status RocksGraph::AddEdge(node_id_t from, node_id_t to, const EdgeAttr& attr) {
+  TraceOp(kGraphTraceAddEdge, from, to);
+  return WriteEdge(from, to, &attr);
+}
+
+Status RocksGraph::WriteEdge(node_id_t from, node_id_t to,
+                             const EdgeAttr* attr) {
+  Status s = ToInternalId(from, &from, true);
+  if (s.ok()) s = ToInternalId(to, &to, true);
+  if (!s.ok()) return s;
+  if (!is_directed_) {
+    return AddUndirectedEdge(from, to, edge_update_policy_, attr);
+  }
   m++;
   WriteBatch batch;
   bool in_edge_handled = false;
@@ -390,16 +548,17 @@ Status RocksGraph::AddEdge(node_id_t from, node_id_t to) {
     out_policy = AdaptPolicy(from, update_ratio_, lookup_ratio_);
   }
   if (out_policy == EDGE_UPDATE_LAZY || out_policy == EDGE_UPDATE_FULL_LAZY) {
-    mor.AddCounter(from);
+    CountDegree(from);
     Edges edges{.num_edges_out = 1, .num_edges_in = 0};
     edges.nxts_out = new Edge[1];
     edges.nxts_out[0] = Edge{.nxt = to};
+    edges.attrs_out = CopyEdgeAttrs(attr, 1);
     encode_edges(&edges, &value_out, encoding_type_);
     free_edges(&edges);
     batch.Merge(adj_cf_, key_out, value_out);
   } else if (out_policy == EDGE_UPDATE_EAGER) {
     Edges existing_edges{.num_edges_out = 0, .num_edges_in = 0};
-    s = GetAllEdges(from, &existing_edges);
+    s = GetAllEdgesInternal(from, &existing_edges);
     if (!s.ok() && !s.IsNotFound()) {
       return s;
     }
@@ -409,14 +568,17 @@ Status RocksGraph::AddEdge(node_id_t from, node_id_t to) {
     new_edges.nxts_in = new Edge[existing_edges.num_edges_in];
     memcpy(new_edges.nxts_in, existing_edges.nxts_in,
            existing_edges.num_edges_in * sizeof(Edge));
+    new_edges.attrs_in =
+        CopyEdgeAttrs(existing_edges.attrs_in, existing_edges.num_edges_in);
     // insert new out neighbor by order
-    bool is_merge =
-        InsertToEdgeList(new_edges.nxts_out, existing_edges.nxts_out,
-                         existing_edges.num_edges_out, to);
+    bool is_merge = InsertToEdgeList(
+        new_edges.nxts_out, existing_edges.nxts_out,
+        existing_edges.num_edges_out, to, &new_edges.attrs_out,
+        existing_edges.attrs_out, attr);
     if (is_merge)
       new_edges.num_edges_out--;
     else
-      mor.AddCounter(from);
+      CountDegree(from);
     if (is_merge) m--;
     // For self-loops, also insert the in-edge in the same write
     if (from == to) {
@@ -424,18 +586,20 @@ Status RocksGraph::AddEdge(node_id_t from, node_id_t to) {
       Edges combined{.num_edges_out = new_edges.num_edges_out,
                      .num_edges_in = new_edges.num_edges_in + 1};
       combined.nxts_out = new_edges.nxts_out;
-      bool is_merge_in =
-          InsertToEdgeList(combined.nxts_in, new_edges.nxts_in,
-                           new_edges.num_edges_in, from);
+      combined.attrs_out = new_edges.attrs_out;
+      bool is_merge_in = InsertToEdgeList(
+          combined.nxts_in, new_edges.nxts_in, new_edges.num_edges_in, from,
+          &combined.attrs_in, new_edges.attrs_in, attr);
       if (is_merge_in)
         combined.num_edges_in--;
       else
-        mor.AddCounter(to);
+        CountDegree(to);
       std::string new_value;
       encode_edges(&combined, &new_value, encoding_type_);
       free_edges(&existing_edges);
-      // Free only nxts_in from new_edges (nxts_out moved to combined)
+      // Free only the in list of new_edges (the out list moved to combined)
       delete[] new_edges.nxts_in;
+      delete[] new_edges.attrs_in;
       free_edges(&combined);
       batch.Put(adj_cf_, key_out, new_value);
     } else {
@@ -459,16 +623,17 @@ Status RocksGraph::AddEdge(node_id_t from, node_id_t to) {
       in_policy = AdaptPolicy(from, update_ratio_, lookup_ratio_);
     }
     if (in_policy == EDGE_UPDATE_LAZY || in_policy == EDGE_UPDATE_FULL_LAZY) {
-      mor.AddCounter(to);
+      CountDegree(to);
       Edges edges{.num_edges_out = 0, .num_edges_in = 1};
       edges.nxts_in = new Edge[1];
       edges.nxts_in[0] = Edge{.nxt = from};
+      edges.attrs_in = CopyEdgeAttrs(attr, 1);
       encode_edges(&edges, &value_in, encoding_type_);
       free_edges(&edges);
       batch.Merge(adj_cf_, key_in, value_in);
     } else if (in_policy == EDGE_UPDATE_EAGER) {
       Edges existing_edges{.num_edges_out = 0, .num_edges_in = 0};
-      s = GetAllEdges(to, &existing_edges);
+      s = GetAllEdgesInternal(to, &existing_edges);
       if (!s.ok() && !s.IsNotFound()) {
         return s;
       }
@@ -478,12 +643,16 @@ Status RocksGraph::AddEdge(node_id_t from, node_id_t to) {
       new_edges.nxts_out = new Edge[existing_edges.num_edges_out];
       memcpy(new_edges.nxts_out, existing_edges.nxts_out,
              existing_edges.num_edges_out * sizeof(Edge));
-      bool is_merge = InsertToEdgeList(new_edges.nxts_in, existing_edges.nxts_in,
-                                       existing_edges.num_edges_in, from);
+      new_edges.attrs_out =
+          CopyEdgeAttrs(existing_edges.attrs_out, existing_edges.num_edges_out);
+      bool is_merge = InsertToEdgeList(
+          new_edges.nxts_in, existing_edges.nxts_in,
+          existing_edges.num_edges_in, from, &new_edges.attrs_in,
+          existing_edges.attrs_in, attr);
       if (is_merge)
         new_edges.num_edges_in--;
       else
-        mor.AddCounter(to);
+        CountDegree(to);
       std::string new_value;
       encode_edges(&new_edges, &new_value, encoding_type_);
       free_edges(&existing_edges);
@@ -491,10 +660,16 @@ Status RocksGraph::AddEdge(node_id_t from, node_id_t to) {
       batch.Put(adj_cf_, key_in, new_value);
     }
   }
-  return db_->Write(WriteOptions(), &batch);
+  PutGraphChangeRecord(&batch, kGraphChangeAddEdge, from, to);
+  return WriteGraph(&batch);
 }
 
 Status RocksGraph::AddEdgeLazy(node_id_t from, node_id_t to) {
+  TraceOp(kGraphTraceAddEdgeLazy, from, to);
+  Status s = ToInternalId(from, &from, true);
+  if (s.ok()) s = ToInternalId(to, &to, true);
+  if (!s.ok()) return s;
+  if (!is_directed_) return AddUndirectedEdge(from, to, EDGE_UPDATE_LAZY);
   m++;
   WriteBatch batch;
 
@@ -503,7 +678,7 @@ Status RocksGraph::AddEdgeLazy(node_id_t from, node_id_t to) {
     VertexKey v{.id = from};
     std::string key, value;
     encode_node(v, &key);
-    mor.AddCounter(from);
+    CountDegree(from);
     Edges edges{.num_edges_out = 1, .num_edges_in = 0};
     edges.nxts_out = new Edge[1];
     edges.nxts_out[0] = Edge{.nxt = to};
@@ -517,7 +692,7 @@ Status RocksGraph::AddEdgeLazy(node_id_t from, node_id_t to) {
     VertexKey v{.id = to};
     std::string key, value;
     encode_node(v, &key);
-    mor.AddCounter(to);
+    CountDegree(to);
     Edges edges{.num_edges_out = 0, .num_edges_in = 1};
     edges.nxts_in = new Edge[1];
     edges.nxts_in[0] = Edge{.nxt = from};
@@ -526,10 +701,14 @@ Status RocksGraph::AddEdgeLazy(node_id_t from, node_id_t to) {
     batch.Merge(adj_cf_, key, value);
   }
 
-  return db_->Write(WriteOptions(), &batch);
+  PutGraphChangeRecord(&batch, kGraphChangeAddEdge, from, to);
+  return WriteGraph(&batch);
 }
 
 Status RocksGraph::AddVertexProperty(node_id_t id, Property prop) {
+  TraceOp(kGraphTraceAddVertexProperty, id, 0, &prop);
+  Status s = ToInternalId(id, &id);
+  if (!s.ok()) return s;
   VertexKey v{.id = id};
   std::string key, value;
   encode_node(v, &key);
@@ -537,8 +716,56 @@ Status RocksGraph::AddVertexProperty(node_id_t id, Property prop) {
   return db_->Put(WriteOptions(), vertex_prop_cf_, key, value);
 }
 
+Status RocksGraph::AddVertexProperties(const std::vector<node_id_t>& ids,
+                                       const std::vector<Property>& props) {
+  std::vector<node_id_t> internal_ids(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    Status s = ToInternalId(ids[i], &internal_ids[i]);
+    if (!s.ok()) return s;
+  }
+  return AddVertexPropertiesInternal(internal_ids, props);
+}
+
+Status RocksGraph::AddVertexPropertiesInternal(
+    const std::vector<node_id_t>& ids, const std::vector<Property>& props) {
+  if (ids.size() != props.size()) {
+    return Status::InvalidArgument("ids and props differ in length");
+  }
+  std::vector<std::string> key_bufs(ids.size());
+  std::vector<Slice> keys(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    encode_node(VertexKey{.id = ids[i]}, &key_bufs[i]);
+    keys[i] = key_bufs[i];
+  }
+  std::vector<PinnableSlice> values(ids.size());
+  std::vector<Status> statuses(ids.size());
+  db_->MultiGet(ReadOptions(), vertex_prop_cf_, ids.size(), keys.data(),
+                values.data(), statuses.data());
+  WriteBatch batch;
+  for (size_t i = 0; i < ids.size(); i++) {
+    if (!statuses[i].ok() && !statuses[i].IsNotFound()) {
+      return statuses[i];
+    }
+    std::vector<Property> existing_props, merged_props;
+    if (statuses[i].ok() && values[i].size() > 0) {
+      std::string existing = values[i].ToString();
+      std::string::iterator it = existing.begin();
+      decode_properties(it, existing_props);
+    }
+    merge_properties(existing_props, {props[i]}, merged_props);
+    std::string value;
+    concatenate_properties(merged_props, &value);
+    batch.Put(vertex_prop_cf_, keys[i], value);
+  }
+  return db_->Write(WriteOptions(), &batch);
+}
+
 Status RocksGraph::AddEdgeProperty(node_id_t from, node_id_t to,
                                    Property prop) {
+  TraceOp(kGraphTraceAddEdgeProperty, from, to, &prop);
+  Status s = ToInternalId(from, &from);
+  if (s.ok()) s = ToInternalId(to, &to);
+  if (!s.ok()) return s;
   VertexKey v{.id = from};
   std::string key, value;
   encode_node(v, &key);
@@ -549,11 +776,14 @@ Status RocksGraph::AddEdgeProperty(node_id_t from, node_id_t to,
 
 Status RocksGraph::GetVertexProperty(node_id_t id,
                                      std::vector<Property>& props) {
+  TraceOp(kGraphTraceGetVertexProperty, id);
+  Status s = ToInternalId(id, &id);
+  if (!s.ok()) return s;
   VertexKey v{.id = id};
   std::string key;
   encode_node(v, &key);
   std::string value;
-  Status s = db_->Get(ReadOptions(), vertex_prop_cf_, key, &value);
+  s = db_->Get(ReadOptions(), vertex_prop_cf_, key, &value);
   if (!s.ok()) {
     return s;
   }
@@ -564,11 +794,15 @@ Status RocksGraph::GetVertexProperty(node_id_t id,
 
 Status RocksGraph::GetEdgeProperty(node_id_t from, node_id_t to,
                                    std::vector<Property>& props) {
+  TraceOp(kGraphTraceGetEdgeProperty, from, to);
+  Status s = ToInternalId(from, &from);
+  if (s.ok()) s = ToInternalId(to, &to);
+  if (!s.ok()) return s;
   VertexKey v{.id = from};
   std::string key;
   encode_node(v, &key);
   std::string value;
-  Status s = db_->Get(ReadOptions(), edge_prop_cf_, key, &value);
+  s = db_->Get(ReadOptions(), edge_prop_cf_, key, &value);
   if (!s.ok()) {
     return s;
   }
@@ -592,7 +826,7 @@ std::vector<std::pair<node_id_t, node_id_t>> RocksGraph::GetEdgesWithProperty(
   std::unique_ptr<rocksdb::Iterator> it(
       db_->NewIterator(ReadOptions(), edge_prop_cf_));
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    from = decode_node(it->key().ToString());
+    from = decode_node(it->key());
     std::string value = it->value().ToString();
     std::string::iterator str_it = value.begin();
     while (str_it < value.end()) {
@@ -601,7 +835,10 @@ std::vector<std::pair<node_id_t, node_id_t>> RocksGraph::GetEdgesWithProperty(
       decode_properties(str_it, props);
       for (Property value_prop : props) {
         if (value_prop.name == prop.name && value_prop.value == prop.value) {
-          result.push_back(std::make_pair(from, to));
+          node_id_t ext_from = from, ext_to = to;
+          ToExternalId(from, &ext_from);
+          ToExternalId(to, &ext_to);
+          result.push_back(std::make_pair(ext_from, ext_to));
           break;
         }
       }
@@ -622,7 +859,7 @@ std::vector<node_id_t> RocksGraph::GetVerticesWithProperty(Property prop) {
   std::unique_ptr<rocksdb::Iterator> it(
       db_->NewIterator(ReadOptions(), vertex_prop_cf_));
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    from = decode_node(it->key().ToString());
+    from = decode_node(it->key());
     std::string value = it->value().ToString();
     std::string::iterator str_it = value.begin();
     while (str_it < value.end()) {
@@ -630,7 +867,9 @@ std::vector<node_id_t> RocksGraph::GetVerticesWithProperty(Property prop) {
       decode_properties(str_it, props);
       for (Property value_prop : props) {
         if (value_prop.name == prop.name && value_prop.value == prop.value) {
-          result.push_back(from);
+          node_id_t ext_from = from;
+          ToExternalId(from, &ext_from);
+          result.push_back(ext_from);
           break;
         }
       }
@@ -646,7 +885,19 @@ std::vector<node_id_t> RocksGraph::GetVerticesWithProperty(Property prop) {
 }
 std::pair<std::string, std::string> RocksGraph::AddEdges(
     node_id_t v, std::vector<node_id_t>& tos, std::vector<node_id_t>& froms) {
-  m += static_cast<node_id_t>(tos.size());
+  if (!is_directed_) {
+    // one symmetric list; each edge is counted at its smaller endpoint
+    tos.insert(tos.end(), froms.begin(), froms.end());
+    std::sort(tos.begin(), tos.end());
+    tos.erase(std::unique(tos.begin(), tos.end()), tos.end());
+    froms.clear();
+    m += static_cast<node_id_t>(
+        tos.end() - std::lower_bound(tos.begin(), tos.end(), v));
+  } else {
+    m += static_cast<node_id_t>(tos.size());
+  }
+  // the caller writes the list itself, past WriteGraph
+  MarkChanged(v);
   Edges new_edges{.num_edges_out = static_cast<uint32_t>(tos.size()),
                   .num_edges_in = static_cast<uint32_t>(froms.size())};
   VertexKey v_out{.id = v};
@@ -654,11 +905,11 @@ std::pair<std::string, std::string> RocksGraph::AddEdges(
   new_edges.nxts_in = new Edge[new_edges.num_edges_in];
   for (size_t i = 0; i < tos.size(); i++) {
     new_edges.nxts_out[i].nxt = tos[i];
-    mor.AddCounter(v);
+    CountDegree(v);
   }
   for (size_t i = 0; i < froms.size(); i++) {
     new_edges.nxts_in[i].nxt = froms[i];
-    mor.AddCounter(v);
+    CountDegree(v);
   }
   std::string new_value;
   std::string key_out;
@@ -671,6 +922,14 @@ std::pair<std::string, std::string> RocksGraph::AddEdges(
 Status RocksGraph::AddVertexWithEdges(node_id_t id,
                                       std::vector<node_id_t>& out_neighbors,
                                       std::vector<node_id_t>& in_neighbors) {
+  Status s = ToInternalId(id, &id, true);
+  for (size_t i = 0; s.ok() && i < out_neighbors.size(); i++) {
+    s = ToInternalId(out_neighbors[i], &out_neighbors[i], true);
+  }
+  for (size_t i = 0; s.ok() && i < in_neighbors.size(); i++) {
+    s = ToInternalId(in_neighbors[i], &in_neighbors[i], true);
+  }
+  if (!s.ok()) return s;
   // Warn if vertex likely already exists (low-cost check via Morris Counter)
   if (mor.GetVertexCount(id) > 0) {
     fprintf(stderr,
@@ -680,6 +939,13 @@ Status RocksGraph::AddVertexWithEdges(node_id_t id,
             (long long)id, mor.GetVertexCount(id));
   }
 
+  if (!is_directed_) {
+    // undirected: a single symmetric list in the out slot
+    out_neighbors.insert(out_neighbors.end(), in_neighbors.begin(),
+                         in_neighbors.end());
+    in_neighbors.clear();
+  }
+
   // Sort and deduplicate edge lists
   std::sort(out_neighbors.begin(), out_neighbors.end());
   out_neighbors.erase(std::unique(out_neighbors.begin(), out_neighbors.end()),
@@ -718,19 +984,43 @@ Status RocksGraph::AddVertexWithEdges(node_id_t id,
 
   // Update counters
   n++;
-  m += static_cast<node_id_t>(out_neighbors.size());
+  if (is_directed_) {
+    m += static_cast<node_id_t>(out_neighbors.size());
+  } else {
+    m += static_cast<node_id_t>(
+        out_neighbors.end() -
+        std::lower_bound(out_neighbors.begin(), out_neighbors.end(), id));
+  }
   for (uint32_t i = 0; i < out_neighbors.size(); i++) {
-    mor.AddCounter(id);
+    CountDegree(id);
   }
   for (uint32_t i = 0; i < in_neighbors.size(); i++) {
-    mor.AddCounter(id);
+    CountDegree(id);
   }
 
-  return db_->Write(WriteOptions(), &batch);
+  PutGraphChangeRecord(&batch, kGraphChangeAddVertex, id);
+  for (node_id_t u : out_neighbors) {
+    if (is_directed_ || u >= id) {
+      PutGraphChangeRecord(&batch, kGraphChangeAddEdge, id, u);
+    } else {
+      PutGraphChangeRecord(&batch, kGraphChangeAddEdge, u, id);
+    }
+  }
+  for (node_id_t w : in_neighbors) {
+    PutGraphChangeRecord(&batch, kGraphChangeAddEdge, w, id);
+  }
+  return WriteGraph(&batch);
 }
 
 Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
-  Status s;
+  TraceOp(kGraphTraceDeleteEdge, from, to);
+  Status s = ToInternalId(from, &from);
+  if (s.ok()) s = ToInternalId(to, &to);
+  if (!s.ok()) return s;
+  if (!is_directed_) return DeleteUndirectedEdge(from, to);
+  // Eager updates read the list they rewrite, so the out side is written
+  // before the in side is read; a self-loop needs both in one list.
+  WriteBatch out_batch;
   VertexKey v{.id = from};
   std::string key_out, value_out;
   encode_node(v, &key_out);
@@ -745,14 +1035,14 @@ Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
     edges.nxts_out[0] = Edge{.nxt = -(to + 1)};
     encode_edges(&edges, &value_out, encoding_type_);
     free_edges(&edges);
-    s = db_->Merge(WriteOptions(), adj_cf_, key_out, value_out);
+    s = out_batch.Merge(adj_cf_, key_out, value_out);
     if (!s.ok() && !s.IsNotFound()) {
       return s;
     }
   } else if (out_policy == EDGE_UPDATE_EAGER ||
              encoding_type_ == ENCODING_TYPE_EFP) {
     Edges existing_edges{.num_edges_out = 0};
-    s = GetAllEdges(from, &existing_edges);
+    s = GetAllEdgesInternal(from, &existing_edges);
     if (!s.ok() && !s.IsNotFound()) {
       return s;
     }
@@ -761,7 +1051,12 @@ Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
     new_edges.nxts_in = new Edge[existing_edges.num_edges_in];
     memcpy(new_edges.nxts_in, existing_edges.nxts_in,
            existing_edges.num_edges_in * sizeof(Edge));
+    new_edges.attrs_in =
+        CopyEdgeAttrs(existing_edges.attrs_in, existing_edges.num_edges_in);
     new_edges.nxts_out = new Edge[new_edges.num_edges_out];
+    if (existing_edges.attrs_out) {
+      new_edges.attrs_out = new EdgeAttr[new_edges.num_edges_out];
+    }
     node_id_t pivot_ex = 0;
     uint32_t edge_count = 0;
     while (pivot_ex < existing_edges.num_edges_out) {
@@ -770,6 +1065,9 @@ Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
         m--;
         pivot_ex++;
       } else {
+        if (new_edges.attrs_out) {
+          new_edges.attrs_out[edge_count] = existing_edges.attrs_out[pivot_ex];
+        }
         new_edges.nxts_out[edge_count++].nxt =
             existing_edges.nxts_out[pivot_ex++].nxt;
       }
@@ -779,12 +1077,19 @@ Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
     encode_edges(&new_edges, &new_value, encoding_type_);
     free_edges(&existing_edges);
     free_edges(&new_edges);
-    s = db_->Put(WriteOptions(), adj_cf_, key_out, new_value);
+    s = out_batch.Put(adj_cf_, key_out, new_value);
     if (!s.ok() && !s.IsNotFound()) {
       return s;
     }
   }
 
+  if (out_batch.Count() > 0) {
+    PutGraphChangeRecord(&out_batch, kGraphChangeDeleteEdge, from, to);
+    s = WriteGraph(&out_batch);
+    if (!s.ok()) return s;
+  }
+
+  WriteBatch in_batch;
   VertexKey v_in{.id = to};
   std::string key_in, value_in;
   encode_node(v_in, &key_in);
@@ -798,14 +1103,14 @@ Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
     edges.nxts_in[0] = Edge{.nxt = -(from + 1)};
     encode_edges(&edges, &value_in, encoding_type_);
     free_edges(&edges);
-    s = db_->Merge(WriteOptions(), adj_cf_, key_in, value_in);
+    s = in_batch.Merge(adj_cf_, key_in, value_in);
     if (!s.ok() && !s.IsNotFound()) {
       return s;
     }
   } else if (in_policy == EDGE_UPDATE_EAGER ||
              encoding_type_ == ENCODING_TYPE_EFP) {
     Edges existing_edges{.num_edges_in = 0};
-    s = GetAllEdges(to, &existing_edges);
+    s = GetAllEdgesInternal(to, &existing_edges);
     if (!s.ok() && !s.IsNotFound()) {
       return s;
     }
@@ -815,7 +1120,12 @@ Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
     new_edges.nxts_out = new Edge[existing_edges.num_edges_out];
     memcpy(new_edges.nxts_out, existing_edges.nxts_out,
            existing_edges.num_edges_out * sizeof(Edge));
+    new_edges.attrs_out =
+        CopyEdgeAttrs(existing_edges.attrs_out, existing_edges.num_edges_out);
     new_edges.nxts_in = new Edge[new_edges.num_edges_in];
+    if (existing_edges.attrs_in) {
+      new_edges.attrs_in = new EdgeAttr[new_edges.num_edges_in];
+    }
     node_id_t pivot_ex = 0;
     uint32_t edge_count = 0;
     while (pivot_ex < existing_edges.num_edges_in) {
@@ -823,6 +1133,9 @@ Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
         mor.DecayCounter(to);
         pivot_ex++;
       } else {
+        if (new_edges.attrs_in) {
+          new_edges.attrs_in[edge_count] = existing_edges.attrs_in[pivot_ex];
+        }
         new_edges.nxts_in[edge_count++].nxt =
             existing_edges.nxts_in[pivot_ex++].nxt;
       }
@@ -832,103 +1145,2352 @@ Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to) {
     encode_edges(&new_edges, &new_value, encoding_type_);
     free_edges(&existing_edges);
     free_edges(&new_edges);
-    s = db_->Put(WriteOptions(), adj_cf_, key_in, new_value);
+    s = in_batch.Put(adj_cf_, key_in, new_value);
     if (!s.ok() && !s.IsNotFound()) {
       return s;
     }
   }
-  return s;
+  if (in_batch.Count() == 0) return s;
+  // reported with the out side
+  PutGraphChangeRecord(&in_batch, kGraphChangeTypeMax);
+  return WriteGraph(&in_batch);
 }
 
-Status RocksGraph::GetAllEdges(node_id_t src, Edges* edges) {
-  VertexKey v{.id = src};
-  std::string key;
-  encode_node(v, &key);
-  std::string value;
+Status RocksGraph::AddUndirectedEdge(node_id_t from, node_id_t to,
+                                     int policy, const EdgeAttr* attr) {
+  // Both endpoints follow one policy: an eager side that finds a duplicate
+  // leaves m alone, while a lazy side's merge would take it out again.
+  if (policy == EDGE_UPDATE_ADAPTIVE) {
+    policy = AdaptPolicy(std::min(from, to), update_ratio_, lookup_ratio_);
+  }
+  WriteBatch batch;
+  bool is_new = true;
+  Status s = InsertNeighbor(&batch, from, to, policy, &is_new, attr);
+  if (s.ok() && from != to) {
+    s = InsertNeighbor(&batch, to, from, policy, &is_new, attr);
+  }
+  if (!s.ok()) return s;
+  // lazy inserts are always counted; the merge operator takes duplicates
+  // back out
+  if (is_new) m++;
+  PutGraphChangeRecord(&batch, kGraphChangeAddEdge, from, to);
+  return WriteGraph(&batch);
+}
+
+Status RocksGraph::InsertNeighbor(WriteBatch* batch, node_id_t v, node_id_t u,
+                                  int policy, bool* is_new,
+                                  const EdgeAttr* attr) {
+  VertexKey key_v{.id = v};
+  std::string key, value;
+  encode_node(key_v, &key);
+  if (policy == EDGE_UPDATE_FULL_LAZY) {
+    encode_node_hash(key_v, u, &key);
+  }
+  if (policy == EDGE_UPDATE_ADAPTIVE) {
+    policy = AdaptPolicy(v, update_ratio_, lookup_ratio_);
+  }
+  if (policy == EDGE_UPDATE_LAZY || policy == EDGE_UPDATE_FULL_LAZY) {
+    CountDegree(v);
+    Edges edges{.num_edges_out = 1, .num_edges_in = 0};
+    edges.nxts_out = new Edge[1];
+    edges.nxts_out[0] = Edge{.nxt = u};
+    edges.attrs_out = CopyEdgeAttrs(attr, 1);
+    encode_edges(&edges, &value, encoding_type_);
+    free_edges(&edges);
+    return batch->Merge(adj_cf_, key, value);
+  }
+  Edges existing_edges;
+  Status s = GetAllEdgesInternal(v, &existing_edges);
+  if (!s.ok() && !s.IsNotFound()) {
+    return s;
+  }
+  Edges new_edges{.num_edges_out = existing_edges.num_edges_out + 1,
+                  .num_edges_in = 0};
+  if (InsertToEdgeList(new_edges.nxts_out, existing_edges.nxts_out,
+                       existing_edges.num_edges_out, u, &new_edges.attrs_out,
+                       existing_edges.attrs_out, attr)) {
+    new_edges.num_edges_out--;
+    *is_new = false;
+  } else {
+    CountDegree(v);
+  }
+  encode_edges(&new_edges, &value, encoding_type_);
+  free_edges(&existing_edges);
+  free_edges(&new_edges);
+  return batch->Put(adj_cf_, key, value);
+}
+
+Status RocksGraph::DeleteUndirectedEdge(node_id_t from, node_id_t to) {
+  WriteBatch batch;
+  Status s = RemoveNeighbor(&batch, from, to);
+  if (s.ok() && from != to) s = RemoveNeighbor(&batch, to, from);
+  if (!s.ok()) return s;
+  PutGraphChangeRecord(&batch, kGraphChangeDeleteEdge, from, to);
+  return WriteGraph(&batch);
+}
+
+Status RocksGraph::RemoveNeighbor(WriteBatch* batch, node_id_t v,
+                                  node_id_t u) {
+  VertexKey key_v{.id = v};
+  std::string key, value;
+  encode_node(key_v, &key);
+  int policy = edge_update_policy_;
+  if (policy == EDGE_UPDATE_ADAPTIVE) {
+    policy = AdaptPolicy(v, update_ratio_, lookup_ratio_);
+  }
+  if (policy == EDGE_UPDATE_LAZY && encoding_type_ != ENCODING_TYPE_EFP) {
+    Edges edges{.num_edges_out = 1, .num_edges_in = 0};
+    edges.nxts_out = new Edge[1];
+    edges.nxts_out[0] = Edge{.nxt = -(u + 1)};
+    encode_edges(&edges, &value, encoding_type_);
+    free_edges(&edges);
+    return batch->Merge(adj_cf_, key, value);
+  }
+  if (policy != EDGE_UPDATE_EAGER && encoding_type_ != ENCODING_TYPE_EFP) {
+    return Status::OK();
+  }
+  Edges existing_edges;
+  Status s = GetAllEdgesInternal(v, &existing_edges);
+  if (!s.ok()) {
+    return s.IsNotFound() ? Status::OK() : s;
+  }
+  Edges new_edges{.num_edges_out = 0, .num_edges_in = 0};
+  new_edges.nxts_out = new Edge[existing_edges.num_edges_out];
+  if (existing_edges.attrs_out) {
+    new_edges.attrs_out = new EdgeAttr[existing_edges.num_edges_out];
+  }
+  for (uint32_t i = 0; i < existing_edges.num_edges_out; i++) {
+    if (existing_edges.nxts_out[i].nxt == u) {
+      mor.DecayCounter(v);
+      if (v <= u) m--;
+    } else {
+      if (new_edges.attrs_out) {
+        new_edges.attrs_out[new_edges.num_edges_out] =
+            existing_edges.attrs_out[i];
+      }
+      new_edges.nxts_out[new_edges.num_edges_out++] = existing_edges.nxts_out[i];
+    }
+  }
+  encode_edges(&new_edges, &value, encoding_type_);
+  free_edges(&existing_edges);
+  free_edges(&new_edges);
+  return batch->Put(adj_cf_, key, value);
+}
+
+namespace {
+// Compacts `list` in place without `target`; returns the new length.
+uint32_t RemoveFromEdgeList(Edge* list, EdgeAttr* attrs, uint32_t num,
+                            node_id_t target) {
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < num; i++) {
+    if (list[i].nxt == target) continue;
+    if (attrs) attrs[kept] = attrs[i];
+    list[kept++] = list[i];
+  }
+  return kept;
+}
+}  // namespace
+
+Status RocksGraph::DeleteVertex(node_id_t id) {
   if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
-    std::string start;
-    std::string end;
-    encode_node(v, &start);
-    // start.push_back(static_cast<char>(0x00));
-    encode_node(v, &end);
-    std::string::iterator sit = end.begin();
-    for (; *(sit + 1) != 0; ++sit) {
+    return Status::NotSupported("DeleteVertex needs the vertex's edge list");
+  }
+  TraceOp(kGraphTraceDeleteVertex, id);
+  Status s = ToInternalId(id, &id);
+  if (!s.ok()) return s;
+  Edges edges{.num_edges_out = 0, .num_edges_in = 0};
+  s = GetAllEdgesInternal(id, &edges);
+  if (!s.ok()) return s;
+  WriteBatch batch;
+  std::string key;
+  encode_node(VertexKey{.id = id}, &key);
+  batch.Delete(adj_cf_, key);
+  batch.Delete(edge_prop_cf_, key);
+  batch.Delete(vertex_prop_cf_, key);
+
+  // The vertex's own list goes away without passing through the merge
+  // operator, so its edges are uncounted here; the operands sent to the
+  // neighbors uncount the rest, as lazy DeleteEdge does.
+  std::unordered_map<node_id_t, int> masks;
+  for (uint32_t i = 0; i < edges.num_edges_out; i++) {
+    node_id_t u = edges.nxts_out[i].nxt;
+    if (u < 0) continue;
+    if (is_directed_ || u >= id) m--;
+    if (u == id) continue;
+    // u keeps id in its in list, or in its own symmetric list
+    masks[u] |= 1 << (is_directed_ ? EDGE_DIRECTION_IN : EDGE_DIRECTION_OUT);
+  }
+  for (uint32_t i = 0; i < edges.num_edges_in; i++) {
+    node_id_t w = edges.nxts_in[i].nxt;
+    if (w < 0 || w == id) continue;
+    masks[w] |= 1 << EDGE_DIRECTION_OUT;
+  }
+  free_edges(&edges);
+  s = UnlinkNeighbors(&batch, id, masks);
+  if (s.ok()) s = DeleteLabeledLists(&batch, id);
+  if (!s.ok()) return s;
+  n--;
+  mor.ResetCounter(id);
+  PutGraphChangeRecord(&batch, kGraphChangeDeleteVertex, id);
+  return WriteGraph(&batch);
+}
+
+Status RocksGraph::UnlinkNeighbors(
+    WriteBatch* batch, node_id_t id,
+    const std::unordered_map<node_id_t, int>& masks) {
+  for (const auto& neighbor : masks) {
+    node_id_t u = neighbor.first;
+    bool out = neighbor.second & (1 << EDGE_DIRECTION_OUT);
+    bool in = neighbor.second & (1 << EDGE_DIRECTION_IN);
+    std::string key, value;
+    encode_node(VertexKey{.id = u}, &key);
+    if (encoding_type_ != ENCODING_TYPE_EFP) {
+      Edges marker{.num_edges_out = out ? 1u : 0u,
+                   .num_edges_in = in ? 1u : 0u};
+      marker.nxts_out = new Edge[marker.num_edges_out];
+      marker.nxts_in = new Edge[marker.num_edges_in];
+      if (out) marker.nxts_out[0] = Edge{.nxt = -(id + 1)};
+      if (in) marker.nxts_in[0] = Edge{.nxt = -(id + 1)};
+      encode_edges(&marker, &value, encoding_type_);
+      free_edges(&marker);
+      batch->Merge(adj_cf_, key, value);
+      continue;
     }
-    *sit = *sit + 1;
+    Edges existing{.num_edges_out = 0, .num_edges_in = 0};
+    Status s = GetAllEdgesInternal(u, &existing);
+    if (s.IsNotFound()) continue;
+    if (!s.ok()) return s;
+    uint32_t removed = 0;
+    if (out) {
+      uint32_t kept = RemoveFromEdgeList(existing.nxts_out, existing.attrs_out,
+                                         existing.num_edges_out, id);
+      // DeleteVertex already uncounted the edge when u > id
+      if (kept < existing.num_edges_out && (is_directed_ || u < id)) m--;
+      removed += existing.num_edges_out - kept;
+      existing.num_edges_out = kept;
+    }
+    if (in) {
+      uint32_t kept = RemoveFromEdgeList(existing.nxts_in, existing.attrs_in,
+                                         existing.num_edges_in, id);
+      removed += existing.num_edges_in - kept;
+      existing.num_edges_in = kept;
+    }
+    for (uint32_t i = 0; i < removed; i++) mor.DecayCounter(u);
+    encode_edges(&existing, &value, encoding_type_);
+    free_edges(&existing);
+    batch->Put(adj_cf_, key, value);
+  }
+  return Status::OK();
+}
 
-    // end.push_back(static_cast<char>(0xFF));
-    //  std::cout<<"start: "<< start << std::endl;
-    //  std::cout<<"end: "<< end << std::endl;
-    Slice lower_key((char*)start.c_str());
-    Slice upper_key((char*)end.c_str());
+Status RocksGraph::DeleteLabeledLists(WriteBatch* batch, node_id_t id) {
+  std::string prefix;
+  encode_node(id, &prefix);
+  ReadOptions read_options;
+  read_options.prefix_same_as_start = true;
+  std::unique_ptr<Iterator> it(db_->NewIterator(read_options, label_cf_));
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix);
+       it->Next()) {
+    if (it->key().size() != LABELED_KEY_SIZE) continue;
+    batch->Delete(label_cf_, it->key());
+    edge_label_t label = decode_label(it->key().data());
+    bool in = it->key()[LABELED_KEY_SIZE - 1] == EDGE_DIRECTION_IN;
+    // the neighbor holds id in the opposite list, or in its own symmetric one
+    int reverse = !is_directed_ || in ? EDGE_DIRECTION_OUT : EDGE_DIRECTION_IN;
+    MorrisCounter* degrees = LabelDegreeCounter(label);
+    degrees->ResetCounter(id);
+    EdgeListView view(it->value().data(), it->value().size(), encoding_type_);
+    for (uint32_t i = 0; i < view.num_edges_out() + view.num_edges_in(); i++) {
+      node_id_t u = view.at(EDGE_DIRECTION_BOTH, i);
+      if (u < 0) continue;
+      if (!in && (is_directed_ || u >= id)) m--;
+      if (u == id) continue;
+      if (encoding_type_ == ENCODING_TYPE_EFP) {
+        Status s = UpdateLabeledList(batch, u, id, label, reverse, true, NULL,
+                                     NULL);
+        if (!s.ok()) return s;
+        continue;
+      }
+      degrees->DecayCounter(u);
+      std::string key, value;
+      encode_labeled_node(u, label, reverse, &key);
+      Edges marker{.num_edges_out = 0, .num_edges_in = 0};
+      Edge*& list = reverse == EDGE_DIRECTION_IN ? marker.nxts_in
+                                                 : marker.nxts_out;
+      uint32_t& num = reverse == EDGE_DIRECTION_IN ? marker.num_edges_in
+                                                   : marker.num_edges_out;
+      num = 1;
+      list = new Edge[1];
+      list[0] = Edge{.nxt = -(id + 1)};
+      encode_edges(&marker, &value, encoding_type_);
+      free_edges(&marker);
+      batch->Merge(label_cf_, key, value);
+    }
+  }
+  return it->status();
+}
 
-    rocksdb::ReadOptions read_options;
-    read_options.iterate_lower_bound = &lower_key;
-    read_options.iterate_upper_bound = &upper_key;
+Status RocksGraph::AddEdge(node_id_t from, node_id_t to, edge_label_t label,
+                           const EdgeAttr* attr) {
+  if (attr && attr->label != label) {
+    return Status::InvalidArgument("EdgeAttr::label differs from the label");
+  }
+  // edges without other attributes still get the label column
+  EdgeAttr labeled;
+  labeled.label = label;
+  if (!attr && label != EdgeAttr().label) attr = &labeled;
+  TraceOp(kGraphTraceAddLabeledEdge, from, to, nullptr, label);
+  Status s = ToInternalId(from, &from, true);
+  if (s.ok()) s = ToInternalId(to, &to, true);
+  if (!s.ok()) return s;
+  WriteBatch batch;
+  bool is_new = true;
+  s = UpdateLabeledList(&batch, from, to, label, EDGE_DIRECTION_OUT, false,
+                        attr, &is_new);
+  if (s.ok() && is_directed_) {
+    s = UpdateLabeledList(&batch, to, from, label, EDGE_DIRECTION_IN, false,
+                          attr, &is_new);
+  } else if (s.ok() && from != to) {
+    s = UpdateLabeledList(&batch, to, from, label, EDGE_DIRECTION_OUT, false,
+                          attr, &is_new);
+  }
+  if (!s.ok()) return s;
+  // lazy inserts are always counted; the merge operator takes duplicates
+  // back out
+  if (is_new) m++;
+  PutGraphChangeRecord(&batch, kGraphChangeAddLabeledEdge, from, to, label);
+  return WriteGraph(&batch);
+}
 
-    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(read_options));
-    //int edge_count = 0;
-    for (it->Seek(start); it->Valid(); it->Next()) {
-      //edge_count++;
-      it->value();
-      // decode_edges(edges,  it->value().ToString(), encoding_type_);
+Status RocksGraph::DeleteEdge(node_id_t from, node_id_t to,
+                              edge_label_t label) {
+  TraceOp(kGraphTraceDeleteLabeledEdge, from, to, nullptr, label);
+  Status s = ToInternalId(from, &from);
+  if (s.ok()) s = ToInternalId(to, &to);
+  if (!s.ok()) return s;
+  WriteBatch batch;
+  s = UpdateLabeledList(&batch, from, to, label, EDGE_DIRECTION_OUT, true,
+                        NULL, NULL);
+  if (s.ok() && is_directed_) {
+    s = UpdateLabeledList(&batch, to, from, label, EDGE_DIRECTION_IN, true,
+                          NULL, NULL);
+  } else if (s.ok() && from != to) {
+    s = UpdateLabeledList(&batch, to, from, label, EDGE_DIRECTION_OUT, true,
+                          NULL, NULL);
+  }
+  if (!s.ok()) return s;
+  PutGraphChangeRecord(&batch, kGraphChangeDeleteLabeledEdge, from, to,
+                       label);
+  return WriteGraph(&batch);
+}
+
+Status RocksGraph::UpdateLabeledList(WriteBatch* batch, node_id_t v,
+                                     node_id_t u, edge_label_t label,
+                                     int direction, bool remove,
+                                     const EdgeAttr* attr, bool* is_new) {
+  std::string key, value;
+  encode_labeled_node(v, label, direction, &key);
+  MorrisCounter* degrees = LabelDegreeCounter(label);
+  int policy = edge_update_policy_;
+  if (policy == EDGE_UPDATE_ADAPTIVE) {
+    policy = AdaptPolicy(v, update_ratio_, lookup_ratio_);
+  }
+  bool in = direction == EDGE_DIRECTION_IN;
+  Edges update{.num_edges_out = 0, .num_edges_in = 0};
+  Edge*& list = in ? update.nxts_in : update.nxts_out;
+  EdgeAttr*& attrs = in ? update.attrs_in : update.attrs_out;
+  uint32_t& num = in ? update.num_edges_in : update.num_edges_out;
+  // lazy deletes need a negative id, which EFP cannot encode
+  if (policy != EDGE_UPDATE_EAGER &&
+      !(remove && encoding_type_ == ENCODING_TYPE_EFP)) {
+    if (remove) {
+      degrees->DecayCounter(v);
+    } else {
+      degrees->AddCounter(v);
     }
-    // printf("edge_count: %d\t", edge_count);
-    return Status::OK();
+    num = 1;
+    list = new Edge[1];
+    list[0] = Edge{.nxt = remove ? -(u + 1) : u};
+    if (!remove) attrs = CopyEdgeAttrs(attr, 1);
+    encode_edges(&update, &value, encoding_type_);
+    free_edges(&update);
+    return batch->Merge(label_cf_, key, value);
   }
-  Status s = db_->Get(ReadOptions(), adj_cf_, key, &value);
-  if (!s.ok()) {
-    return s;
+
+  Edges existing{.num_edges_out = 0, .num_edges_in = 0};
+  Status s = ReadLabeledList(v, label, direction, &existing);
+  if (!s.ok() && !s.IsNotFound()) return s;
+  const Edge* cur = in ? existing.nxts_in : existing.nxts_out;
+  const EdgeAttr* cur_attrs = in ? existing.attrs_in : existing.attrs_out;
+  uint32_t cur_num = in ? existing.num_edges_in : existing.num_edges_out;
+  if (remove) {
+    list = new Edge[cur_num];
+    if (cur_attrs) attrs = new EdgeAttr[cur_num];
+    for (uint32_t i = 0; i < cur_num; i++) {
+      if (cur[i].nxt == u) {
+        degrees->DecayCounter(v);
+        // the copy that counts the edge, as in the unlabeled lists
+        if (!in && (is_directed_ || v <= u)) m--;
+        continue;
+      }
+      if (attrs) attrs[num] = cur_attrs[i];
+      list[num++] = cur[i];
+    }
+  } else if (InsertToEdgeList(list, cur, cur_num, u, &attrs, cur_attrs,
+                              attr)) {
+    num = cur_num;
+    *is_new = false;
+  } else {
+    num = cur_num + 1;
+    degrees->AddCounter(v);
   }
+  free_edges(&existing);
+  encode_edges(&update, &value, encoding_type_);
+  free_edges(&update);
+  return batch->Put(label_cf_, key, value);
+}
+
+Status RocksGraph::ReadLabeledList(node_id_t v, edge_label_t label,
+                                   int direction, Edges* edges) {
+  std::string key, value;
+  encode_labeled_node(v, label, direction, &key);
+  Status s = db_->Get(ReadOptions(), label_cf_, key, &value);
+  if (!s.ok()) return s;
   decode_edges(edges, value, encoding_type_);
   return Status::OK();
-  // if(edge_update_policy_ != EDGE_UPDATE_EAGER){
-  // GetMergeOperandsOptions merge_operands_info;
-  // int number_of_operands = 0;
-  // int maximum_levels = 10;
-  // merge_operands_info.expected_max_number_of_operands = maximum_levels;
-  // std::vector<PinnableSlice> values(maximum_levels);
-  // s = db_->GetMergeOperands(ReadOptions(), adj_cf_, key,
-  //                           values.data(), &merge_operands_info,
-  //                           &number_of_operands);
-  // }
 }
 
-node_id_t RocksGraph::GetOutDegree(node_id_t src) {
-  VertexKey v{.id = src};
-  std::string key;
-  encode_node(v, &key);
-  std::string value;
-  Status s = db_->Get(ReadOptions(), adj_cf_, key, &value);
+Status RocksGraph::GetAllEdges(node_id_t src, edge_label_t label,
+                               Edges* edges) {
+  edges->num_edges_out = 0;
+  edges->num_edges_in = 0;
+  edges->nxts_out = edges->nxts_in = NULL;
+  edges->attrs_out = edges->attrs_in = NULL;
+  Status s = ToInternalId(src, &src);
+  if (!s.ok()) return s;
+  Edges out{.num_edges_out = 0, .num_edges_in = 0};
+  Edges in{.num_edges_out = 0, .num_edges_in = 0};
+  s = ReadLabeledList(src, label, EDGE_DIRECTION_OUT, &out);
+  bool found = s.ok();
+  if ((s.ok() || s.IsNotFound()) && is_directed_) {
+    s = ReadLabeledList(src, label, EDGE_DIRECTION_IN, &in);
+    found = found || s.ok();
+  }
+  if (!s.ok() && !s.IsNotFound()) {
+    free_edges(&out);
+    return s;
+  }
+  if (!found) return Status::NotFound();
+  std::swap(edges->num_edges_out, out.num_edges_out);
+  std::swap(edges->nxts_out, out.nxts_out);
+  std::swap(edges->attrs_out, out.attrs_out);
+  std::swap(edges->num_edges_in, in.num_edges_in);
+  std::swap(edges->nxts_in, in.nxts_in);
+  std::swap(edges->attrs_in, in.attrs_in);
+  free_edges(&out);
+  free_edges(&in);
+  return relabel_ ? TranslateEdges(edges) : Status::OK();
+}
+
+Status RocksGraph::GetAllLabeledEdges(node_id_t src,
+                                      std::vector<LabeledEdges>* lists) {
+  lists->clear();
+  Status s = ToInternalId(src, &src);
+  if (!s.ok()) return s;
+  std::string prefix;
+  encode_node(src, &prefix);
+  ReadOptions read_options;
+  read_options.prefix_same_as_start = true;
+  std::unique_ptr<Iterator> it(db_->NewIterator(read_options, label_cf_));
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix);
+       it->Next()) {
+    if (it->key().size() != LABELED_KEY_SIZE) continue;
+    edge_label_t label = decode_label(it->key().data());
+    if (lists->empty() || lists->back().label != label) {
+      lists->emplace_back();
+      lists->back().label = label;
+    }
+    Edges decoded;
+    decode_edges(&decoded, it->value().data(), it->value().size(),
+                 encoding_type_);
+    Edges& edges = lists->back().edges;
+    if (it->key()[LABELED_KEY_SIZE - 1] == EDGE_DIRECTION_IN) {
+      std::swap(edges.num_edges_in, decoded.num_edges_in);
+      std::swap(edges.nxts_in, decoded.nxts_in);
+      std::swap(edges.attrs_in, decoded.attrs_in);
+    } else {
+      std::swap(edges.num_edges_out, decoded.num_edges_out);
+      std::swap(edges.nxts_out, decoded.nxts_out);
+      std::swap(edges.attrs_out, decoded.attrs_out);
+    }
+    free_edges(&decoded);
+  }
+  s = it->status();
+  for (size_t i = 0; s.ok() && relabel_ && i < lists->size(); i++) {
+    s = TranslateEdges(&(*lists)[i].edges);
+  }
+  return s;
+}
+
+node_id_t RocksGraph::GetOutDegree(node_id_t id, edge_label_t label) {
+  if (!ToInternalId(id, &id).ok()) return 0;
+  std::string key, value;
+  encode_labeled_node(id, label, EDGE_DIRECTION_OUT, &key);
+  Status s = db_->Get(ReadOptions(), label_cf_, key, &value);
   if (!s.ok() || value.size() < sizeof(uint32_t)) return 0;
   return *reinterpret_cast<const uint32_t*>(value.data());
 }
 
-node_id_t RocksGraph::GetInDegree(node_id_t src) {
-  VertexKey v{.id = src};
-  std::string key;
-  encode_node(v, &key);
-  std::string value;
-  Status s = db_->Get(ReadOptions(), adj_cf_, key, &value);
+node_id_t RocksGraph::GetInDegree(node_id_t id, edge_label_t label) {
+  if (!is_directed_) return GetOutDegree(id, label);
+  if (!ToInternalId(id, &id).ok()) return 0;
+  std::string key, value;
+  encode_labeled_node(id, label, EDGE_DIRECTION_IN, &key);
+  Status s = db_->Get(ReadOptions(), label_cf_, key, &value);
   if (!s.ok() || value.size() < 2 * sizeof(uint32_t)) return 0;
   return *reinterpret_cast<const uint32_t*>(value.data() + sizeof(uint32_t));
 }
 
-node_id_t RocksGraph::GetDegreeApproximate(node_id_t src,
-                                           int filter_type_manual) {
-  if (filter_type_manual > 0 && filter_type_ != FILTER_TYPE_ALL) {
-    printf(
-        "degree filter setting error: filter_type_manual > 0 should only be "
-        "set when FILTER_TYPE_ALL\n");
+node_id_t RocksGraph::GetLabelDegreeApproximate(node_id_t id,
+                                                edge_label_t label) {
+  if (!ToInternalId(id, &id).ok()) return 0;
+  std::lock_guard<std::mutex> lock(label_mu_);
+  auto it = label_degrees_.find(label);
+  return it == label_degrees_.end() ? 0 : it->second->GetVertexCount(id);
+}
+
+MorrisCounter* RocksGraph::LabelDegreeCounter(edge_label_t label) {
+  std::lock_guard<std::mutex> lock(label_mu_);
+  std::unique_ptr<MorrisCounter>& counter = label_degrees_[label];
+  if (!counter) counter.reset(new MorrisCounter());
+  return counter.get();
+}
+
+Status RocksGraph::GetAllEdges(node_id_t src, Edges* edges) {
+  TraceOp(kGraphTraceGetAllEdges, src);
+  if (!relabel_) return GetAllEdgesInternal(src, edges);
+  Status s = ToInternalId(src, &src);
+  if (!s.ok()) return s;
+  s = GetAllEdgesInternal(src, edges);
+  if (!s.ok()) return s;
+  return TranslateEdges(edges);
+}
+
+Status RocksGraph::HasEdge(node_id_t from, node_id_t to, bool* exists) {
+  TraceOp(kGraphTraceHasEdge, from, to);
+  *exists = false;
+  Status s = ToInternalId(from, &from);
+  if (s.ok()) s = ToInternalId(to, &to);
+  if (s.IsNotFound()) return Status::OK();
+  if (!s.ok()) return s;
+  bool found;
+  uint64_t index;
+  bool from_snapshot =
+      ServedByCSRSnapshot(from, &found, &index) != nullptr;
+  if (from_snapshot && !found) return Status::OK();
+  if (!from_snapshot && edge_filter_) {
+    RecordTick(statistics_.get(), GRAPH_EDGE_FILTER_CHECKED);
+    if (!edge_filter_cache_->EdgeMayExist(from, to)) {
+      RecordTick(statistics_.get(), GRAPH_EDGE_FILTER_USEFUL);
+      return Status::OK();
+    }
   }
-  if (filter_type_manual == FILTER_TYPE_CMS ||
-      (filter_type_manual == 0 && filter_type_ == FILTER_TYPE_CMS)) {
-    return cms_out.GetVertexCount(src) + cms_in.GetVertexCount(src);
-  } else if (filter_type_manual == FILTER_TYPE_MORRIS ||
-             (filter_type_manual == 0 && filter_type_ == FILTER_TYPE_MORRIS)) {
-    return mor.GetVertexCount(src);
+  Edges edges{.num_edges_out = 0, .num_edges_in = 0};
+  s = GetAllEdgesInternal(from, &edges);
+  if (s.IsNotFound()) return Status::OK();
+  if (!s.ok()) return s;
+  for (uint32_t i = 0; i < edges.num_edges_out; i++) {
+    if (edges.nxts_out[i].nxt == to) {
+      *exists = true;
+      break;
+    }
   }
-  return 0;
+  free_edges(&edges);
+  return Status::OK();
+}
+
+void RocksGraph::AddEdgeFilterCollector(ColumnFamilyOptions* adj_options) {
+  adj_options->table_properties_collector_factories.push_back(
+      NewEdgeFilterCollectorFactory(encoding_type_));
+}
+
+void RocksGraph::ConfigureAdjacencyBlobs(ColumnFamilyOptions* adj_options) {
+  adj_options->enable_blob_files = true;
+  // the two degrees and one id per neighbor; attributes make lists longer
+  // and encodings shorter, so the degree is approximate
+  adj_options->min_blob_size =
+      2 * sizeof(uint32_t) + uint64_t{blob_min_degree_} * sizeof(node_id_t);
+  // Routine compactions would relocate every live list of the oldest blob
+  // files, unchanged hub lists included; CollectBlobGarbage does it only
+  // where merges left garbage.
+  adj_options->enable_blob_garbage_collection = false;
+  // BlobSource serves lists from the block cache, and lists just flushed are
+  // the ones being updated and read.
+  auto table_options =
+      adj_options->table_factory->GetOptions<BlockBasedTableOptions>();
+  if (!adj_options->blob_cache && table_options != nullptr) {
+    adj_options->blob_cache = table_options->block_cache;
+  }
+  if (adj_options->blob_cache) {
+    adj_options->prepopulate_blob_cache = PrepopulateBlobCache::kFlushOnly;
+  }
+}
+
+Status RocksGraph::GetTopKNeighborsByWeight(
+    node_id_t src, size_t k, int direction,
+    std::vector<std::pair<node_id_t, float>>* neighbors) {
+  neighbors->clear();
+  Status s = ToInternalId(src, &src);
+  if (!s.ok()) return s;
+  std::string value;
+  EdgeListView view;
+  s = GetAdjacencyView(src, &value, &view);
+  if (!s.ok() || k == 0) return s;
+  using WeightedNeighbor = std::pair<node_id_t, float>;
+  auto heavier = [](const WeightedNeighbor& a, const WeightedNeighbor& b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  };
+  // heap of the k heaviest so far, the lightest on top
+  for (uint32_t i = 0; i < view.num_edges(direction); i++) {
+    WeightedNeighbor candidate(view.at(direction, i),
+                               view.weight(direction, i));
+    if (candidate.first < 0) continue;
+    if (neighbors->size() < k) {
+      neighbors->push_back(candidate);
+      std::push_heap(neighbors->begin(), neighbors->end(), heavier);
+    } else if (heavier(candidate, neighbors->front())) {
+      std::pop_heap(neighbors->begin(), neighbors->end(), heavier);
+      neighbors->back() = candidate;
+      std::push_heap(neighbors->begin(), neighbors->end(), heavier);
+    }
+  }
+  std::sort_heap(neighbors->begin(), neighbors->end(), heavier);
+  for (auto& neighbor : *neighbors) {
+    s = ToExternalId(neighbor.first, &neighbor.first);
+    if (!s.ok()) return s;
+  }
+  return Status::OK();
+}
+
+Status RocksGraph::GetNeighborsInTimeRange(node_id_t src, uint64_t start_time,
+                                           uint64_t end_time, int direction,
+                                           std::vector<node_id_t>* neighbors) {
+  neighbors->clear();
+  Status s = ToInternalId(src, &src);
+  if (!s.ok()) return s;
+  std::string value;
+  EdgeListView view;
+  s = GetAdjacencyView(src, &value, &view);
+  if (!s.ok()) return s;
+  for (uint32_t i = 0; i < view.num_edges(direction); i++) {
+    uint64_t timestamp = view.timestamp(direction, i);
+    if (timestamp < start_time || timestamp >= end_time) continue;
+    node_id_t neighbor = view.at(direction, i);
+    if (neighbor < 0) continue;
+    s = ToExternalId(neighbor, &neighbor);
+    if (!s.ok()) return s;
+    neighbors->push_back(neighbor);
+  }
+  return Status::OK();
+}
+
+Status RocksGraph::GetAdjacencyView(node_id_t src, std::string* value,
+                                    EdgeListView* view) {
+  value->clear();
+  bool found;
+  uint64_t index;
+  if (auto snapshot = ServedByCSRSnapshot(src, &found, &index)) {
+    if (!found) return Status::NotFound();
+    Edges edges;
+    snapshot->GetEdges(index, &edges);
+    encode_edges(&edges, value, ENCODING_TYPE_NONE);
+    free_edges(&edges);
+    view->Reset(value->data(), value->size(), ENCODING_TYPE_NONE);
+    return Status::OK();
+  }
+  std::string key;
+  encode_node(VertexKey{.id = src}, &key);
+  Status s = ReadAdjacency(key, value);
+  if (!s.ok()) return s;
+  view->Reset(value->data(), value->size(), encoding_type_);
+  return Status::OK();
+}
+
+namespace {
+// Copies the adjacency updates of a graph write batch into the history
+// column family, every key stamped with the same timestamp.
+class HistoryRecorder : public WriteBatch::Handler {
+ public:
+  HistoryRecorder(uint32_t adj_cf_id, ColumnFamilyHandle* history_cf,
+                  const Slice& ts, WriteBatch* history)
+      : adj_cf_id_(adj_cf_id),
+        history_cf_(history_cf),
+        ts_(ts),
+        history_(history) {}
+
+  Status PutCF(uint32_t cf, const Slice& key, const Slice& value) override {
+    if (cf != adj_cf_id_) return Status::OK();
+    return history_->Put(history_cf_, key, ts_, value);
+  }
+  Status MergeCF(uint32_t cf, const Slice& key, const Slice& value) override {
+    if (cf != adj_cf_id_) return Status::OK();
+    return history_->Merge(history_cf_, key, ts_, value);
+  }
+  Status DeleteCF(uint32_t cf, const Slice& key) override {
+    if (cf != adj_cf_id_) return Status::OK();
+    return history_->Delete(history_cf_, key, ts_);
+  }
+  Status SingleDeleteCF(uint32_t cf, const Slice& key) override {
+    return DeleteCF(cf, key);
+  }
+  Status DeleteRangeCF(uint32_t cf, const Slice& begin,
+                       const Slice& end) override {
+    if (cf != adj_cf_id_) return Status::OK();
+    return history_->DeleteRange(history_cf_, begin, end, ts_);
+  }
+
+ private:
+  uint32_t adj_cf_id_;
+  ColumnFamilyHandle* history_cf_;
+  Slice ts_;
+  WriteBatch* history_;
+};
+}  // namespace
+
+Status RocksGraph::OpenDB(
+    const Options& options,
+    const std::vector<ColumnFamilyDescriptor>& column_families,
+    const GraphTransactionDBOptions* txn_options,
+    const std::string* secondary_path,
+    std::vector<ColumnFamilyHandle*>* handles) {
+  Status s;
+  if (secondary_path) {
+    s = DB::OpenAsSecondary(options, db_path_, *secondary_path,
+                            column_families, handles, &db_);
+  } else if (!txn_options) {
+    s = DB::Open(options, db_path_, column_families, handles, &db_);
+  } else if (txn_options->optimistic) {
+    OptimisticTransactionDBOptions occ_options;
+    occ_options.occ_lock_buckets = txn_options->occ_lock_buckets;
+    s = OptimisticTransactionDB::Open(options, occ_options, db_path_,
+                                      column_families, handles, &occ_db_);
+    db_ = occ_db_;
+  } else {
+    TransactionDBOptions txn_db_options;
+    txn_db_options.num_stripes = txn_options->num_stripes;
+    txn_db_options.transaction_lock_timeout = txn_options->lock_timeout_ms;
+    // plain writes lock their keys for as long as transactions do
+    txn_db_options.default_lock_timeout = txn_options->lock_timeout_ms;
+    s = TransactionDB::Open(options, txn_db_options, db_path_,
+                            column_families, handles, &txn_db_);
+    db_ = txn_db_;
+  }
+  if (s.ok() && edge_filter_) {
+    edge_filter_cache_ = std::make_shared<EdgeFilterCache>(db_, (*handles)[0]);
+  }
+  return s;
+}
+
+Status RocksGraph::WriteGraph(WriteBatch* batch) {
+  if (history_cf_) {
+    uint64_t timestamp = write_timestamp_.load(std::memory_order_relaxed);
+    if (timestamp == 0) timestamp = SystemClock::Default()->NowMicros();
+    std::string ts_buf;
+    WriteBatch history;
+    HistoryRecorder recorder(adj_cf_->GetID(), history_cf_,
+                             EncodeU64Ts(timestamp, &ts_buf), &history);
+    Status s = batch->Iterate(&recorder);
+    if (s.ok() && history.Count() > 0) {
+      s = WriteBatchInternal::Append(batch, &history);
+    }
+    if (!s.ok()) return s;
+  }
+  if (meta_batches_.fetch_add(1, std::memory_order_relaxed) %
+          kMetaPublishBatches ==
+      kMetaPublishBatches - 1) {
+    // a writer already publishing covers this round
+    std::unique_lock<std::mutex> lock(meta_mu_, std::try_to_lock);
+    if (lock.owns_lock()) AppendPublishedMeta(batch);
+  }
+  std::shared_lock<std::shared_mutex> csr_lock(csr_write_mu_);
+  if (csr_tracking_.load()) MarkChanged(*batch);
+  return db_->Write(WriteOptions(), batch);
+}
+
+namespace {
+// graph_meta keys: the counts, then the degree sketch in fixed-size chunks
+// keyed by their index
+const char kMetaCountsKey[] = "counts";
+const char kMetaDegreesPrefix[] = "degrees/";
+constexpr size_t kMetaChunkBytes = 64 << 10;
+
+std::string MetaChunkKey(uint64_t index) {
+  std::string key(kMetaDegreesPrefix);
+  PutFixed64(&key, index);
+  return key;
+}
+}  // namespace
+
+void RocksGraph::AppendPublishedMeta(WriteBatch* batch) {
+  const std::vector<unsigned char> counters = mor.CopyCounters();
+  std::string counts;
+  PutFixed64(&counts, static_cast<uint64_t>(n));
+  PutFixed64(&counts, static_cast<uint64_t>(m));
+  PutFixed64(&counts, counters.size());
+  batch->Put(meta_cf_, kMetaCountsKey, counts);
+  size_t num_chunks = (counters.size() + kMetaChunkBytes - 1) / kMetaChunkBytes;
+  published_chunk_hashes_.resize(num_chunks, 0);
+  for (size_t i = 0; i < num_chunks; i++) {
+    size_t begin = i * kMetaChunkBytes;
+    Slice chunk(reinterpret_cast<const char*>(counters.data()) + begin,
+                std::min(kMetaChunkBytes, counters.size() - begin));
+    uint64_t hash = Hash64(chunk.data(), chunk.size());
+    if (hash == published_chunk_hashes_[i]) continue;
+    published_chunk_hashes_[i] = hash;
+    batch->Put(meta_cf_, MetaChunkKey(i), chunk);
+  }
+}
+
+Status RocksGraph::PublishMeta() {
+  if (secondary_) {
+    return Status::NotSupported("Secondaries read the primary's counts");
+  }
+  std::lock_guard<std::mutex> lock(meta_mu_);
+  WriteBatch batch;
+  AppendPublishedMeta(&batch);
+  Status s = db_->Write(WriteOptions(), &batch);
+  // the chunks may not have made it; send them all next time
+  if (!s.ok()) published_chunk_hashes_.clear();
+  return s;
+}
+
+Status RocksGraph::LoadPublishedMeta() {
+  std::lock_guard<std::mutex> lock(meta_mu_);
+  std::string counts;
+  Status s = db_->Get(ReadOptions(), meta_cf_, kMetaCountsKey, &counts);
+  if (s.IsNotFound()) return Status::OK();
+  if (!s.ok()) return s;
+  Slice input(counts);
+  uint64_t num_vertices, num_edges, num_counters;
+  if (!GetFixed64(&input, &num_vertices) || !GetFixed64(&input, &num_edges) ||
+      !GetFixed64(&input, &num_counters)) {
+    return Status::Corruption("Bad graph_meta counts");
+  }
+  n = static_cast<node_id_t>(num_vertices);
+  m = static_cast<node_id_t>(num_edges);
+  // the sketch only grows, so readers never see it shrink under them
+  mor.Reserve(static_cast<node_id_t>(num_counters));
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions(), meta_cf_));
+  for (iter->Seek(kMetaDegreesPrefix); iter->Valid(); iter->Next()) {
+    Slice key = iter->key();
+    if (!key.starts_with(kMetaDegreesPrefix)) break;
+    key.remove_prefix(sizeof(kMetaDegreesPrefix) - 1);
+    if (key.size() != sizeof(uint64_t)) continue;
+    size_t begin = DecodeFixed64(key.data()) * kMetaChunkBytes;
+    if (begin >= mor.counters.size()) continue;
+    Slice chunk = iter->value();
+    std::memcpy(mor.counters.data() + begin, chunk.data(),
+                std::min(chunk.size(), mor.counters.size() - begin));
+  }
+  return iter->status();
+}
+
+Status RocksGraph::OpenAsSecondary(Options& options,
+                                   const RocksGraphOptions& graph_options,
+                                   const std::string& secondary_path,
+                                   std::unique_ptr<RocksGraph>* graph,
+                                   uint64_t catch_up_interval_ms) {
+  graph->reset();
+  // a secondary must keep every table file open, or one the primary
+  // compacts away may be gone before it can open it
+  options.max_open_files = -1;
+  RocksGraphOptions secondary_options = graph_options;
+  secondary_options.auto_reinitialize = false;
+  secondary_options.blob_min_degree = 0;
+  secondary_options.txn_options = nullptr;
+  Status s;
+  std::unique_ptr<RocksGraph> secondary(
+      new RocksGraph(options, secondary_options, &secondary_path, &s));
+  if (!s.ok()) return s;
+  if (catch_up_interval_ms > 0) {
+    RocksGraph* g = secondary.get();
+    g->catch_up_thread_ = std::thread([g, catch_up_interval_ms]() {
+      std::unique_lock<std::mutex> lock(g->catch_up_mu_);
+      while (!g->catch_up_cv_.wait_for(
+          lock, std::chrono::milliseconds(catch_up_interval_ms),
+          [g]() { return g->stop_catch_up_; })) {
+        lock.unlock();
+        g->TryCatchUpWithPrimary();
+        lock.lock();
+      }
+    });
+  }
+  *graph = std::move(secondary);
+  return s;
+}
+
+Status RocksGraph::TryCatchUpWithPrimary() {
+  if (!secondary_) {
+    return Status::NotSupported("Only secondaries follow a primary");
+  }
+  Status s = db_->TryCatchUpWithPrimary();
+  if (!s.ok()) return s;
+  // the primary may have started relabeling since
+  LoadIdMapMeta();
+  return LoadPublishedMeta();
+}
+
+Status RocksGraph::MultiGetAdjacency(const ReadOptions& read_options,
+                                     const std::vector<node_id_t>& ids,
+                                     std::vector<PinnableSlice>* values,
+                                     std::vector<EdgeListView>* views) {
+  const size_t kBatchSize = 256;
+  values->clear();
+  values->resize(ids.size());
+  views->clear();
+  views->resize(ids.size());
+  // the CSR snapshot only holds the latest lists
+  const bool as_of = read_options.timestamp != nullptr;
+  ColumnFamilyHandle* cf = as_of ? history_cf_ : adj_cf_;
+  std::vector<size_t> pending;
+  for (size_t i = 0; i < ids.size(); i++) {
+    if (ids[i] < 0) continue;
+    bool found;
+    uint64_t index;
+    std::shared_ptr<CSRSnapshot> snapshot;
+    if (!as_of) snapshot = ServedByCSRSnapshot(ids[i], &found, &index);
+    if (!snapshot) {
+      pending.push_back(i);
+      continue;
+    }
+    if (!found) continue;
+    Edges edges;
+    snapshot->GetEdges(index, &edges);
+    PinnableSlice& value = (*values)[i];
+    encode_edges(&edges, value.GetSelf(), ENCODING_TYPE_NONE);
+    free_edges(&edges);
+    value.PinSelf();
+    (*views)[i].Reset(value.data(), value.size(), ENCODING_TYPE_NONE);
+  }
+
+  std::vector<std::string> key_bufs(kBatchSize);
+  std::vector<Slice> keys(kBatchSize);
+  std::vector<PinnableSlice> batch_values(kBatchSize);
+  std::vector<Status> statuses(kBatchSize);
+  uint64_t operands_before = adj_merge_operands;
+  for (size_t b = 0; b < pending.size(); b += kBatchSize) {
+    size_t batch = std::min(kBatchSize, pending.size() - b);
+    for (size_t i = 0; i < batch; i++) {
+      key_bufs[i].clear();
+      encode_node(VertexKey{.id = ids[pending[b + i]]}, &key_bufs[i]);
+      keys[i] = key_bufs[i];
+      batch_values[i].Reset();
+    }
+    db_->MultiGet(read_options, cf, batch, keys.data(), batch_values.data(),
+                  statuses.data());
+    for (size_t i = 0; i < batch; i++) {
+      if (statuses[i].IsNotFound()) continue;
+      if (!statuses[i].ok()) return statuses[i];
+      PinnableSlice& value = (*values)[pending[b + i]];
+      value = std::move(batch_values[i]);
+      (*views)[pending[b + i]].Reset(value.data(), value.size(),
+                                     encoding_type_);
+    }
+  }
+  uint64_t operands = adj_merge_operands - operands_before;
+  graph_stats_.adj_list_reads.fetch_add(pending.size(),
+                                        std::memory_order_relaxed);
+  graph_stats_.merge_operands.fetch_add(operands, std::memory_order_relaxed);
+  RecordTick(statistics_.get(), GRAPH_ADJ_LIST_READS, pending.size());
+  RecordTick(statistics_.get(), GRAPH_ADJ_MERGE_OPERANDS, operands);
+  return Status::OK();
+}
+
+namespace {
+// The live neighbors of one list, shaped for the intersection kernels: flat
+// single-direction lists are used in place, EFP ones are probed through
+// next_geq, and EDGE_DIRECTION_BOTH is merged into a deduplicated copy.
+struct NeighborSet {
+  EdgeListView* view = nullptr;
+  int direction = EDGE_DIRECTION_OUT;
+  const node_id_t* ids = nullptr;
+  size_t size = 0;
+  std::vector<node_id_t> merged;
+
+  void Reset(EdgeListView* list, int list_direction) {
+    view = nullptr;
+    direction = list_direction;
+    merged.clear();
+    if (direction == EDGE_DIRECTION_BOTH) {
+      size_t num_out = 0;
+      for (int d : {EDGE_DIRECTION_OUT, EDGE_DIRECTION_IN}) {
+        for (uint32_t i = 0; i < list->num_edges(d); i++) {
+          node_id_t id = list->at(d, i);
+          if (id >= 0) merged.push_back(id);
+        }
+        if (d == EDGE_DIRECTION_OUT) num_out = merged.size();
+      }
+      std::inplace_merge(merged.begin(), merged.begin() + num_out,
+                         merged.end());
+      merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+      ids = merged.data();
+      size = merged.size();
+      return;
+    }
+    size = list->num_edges(direction);
+    if (list->encoding_type() == ENCODING_TYPE_EFP) {
+      view = list;
+      return;
+    }
+    static_assert(sizeof(Edge) == sizeof(node_id_t), "Edge is a bare id");
+    const Edge* raw =
+        direction == EDGE_DIRECTION_IN ? list->raw_in() : list->raw_out();
+    const node_id_t* begin = reinterpret_cast<const node_id_t*>(raw);
+    // lazy deletes, stored as -(id + 1), sort ahead of every live id
+    ids = std::lower_bound(begin, begin + size, 0);
+    size -= ids - begin;
+  }
+
+  node_id_t at(size_t i) { return view ? view->at(direction, i) : ids[i]; }
+};
+
+// Calls fn for every id in both sets, in increasing order. The smaller set
+// is walked and each of its ids probes the larger one, which only moves
+// forward.
+template <typename F>
+void ForEachCommonNeighbor(NeighborSet* a, NeighborSet* b, const F& fn) {
+  if (a->size > b->size) std::swap(a, b);
+  if (!b->view) {
+    const node_id_t* pos = b->ids;
+    const node_id_t* end = b->ids + b->size;
+    for (size_t i = 0; i < a->size && pos < end; i++) {
+      node_id_t id = a->at(i);
+      pos = std::lower_bound(pos, end, id);
+      if (pos < end && *pos == id) fn(id);
+    }
+    return;
+  }
+  for (size_t i = 0; i < a->size; i++) {
+    node_id_t id = a->at(i);
+    node_id_t next = b->view->next_geq(b->direction, id);
+    if (next == std::numeric_limits<node_id_t>::max()) break;
+    if (next == id) fn(id);
+  }
+}
+
+uint64_t CountCommonNeighbors(NeighborSet* a, NeighborSet* b) {
+  if (!a->view && !b->view) {
+    return IntersectCount(a->ids, a->size, b->ids, b->size);
+  }
+  uint64_t count = 0;
+  ForEachCommonNeighbor(a, b, [&count](node_id_t) { count++; });
+  return count;
+}
+}  // namespace
+
+Status RocksGraph::CommonNeighbors(node_id_t u, node_id_t v, int direction,
+                                   uint64_t* count) {
+  std::vector<double> scores;
+  Status s = LinkPredictionScores({{u, v}}, kLinkCommonNeighbors, direction,
+                                  &scores);
+  *count = s.ok() ? static_cast<uint64_t>(scores[0]) : 0;
+  return s;
+}
+
+Status RocksGraph::CommonNeighbors(node_id_t u,
+                                   const std::vector<node_id_t>& vs,
+                                   int direction,
+                                   std::vector<uint64_t>* counts) {
+  std::vector<std::pair<node_id_t, node_id_t>> pairs;
+  for (node_id_t v : vs) pairs.emplace_back(u, v);
+  std::vector<double> scores;
+  Status s =
+      LinkPredictionScores(pairs, kLinkCommonNeighbors, direction, &scores);
+  counts->clear();
+  if (!s.ok()) return s;
+  for (double score : scores) counts->push_back(static_cast<uint64_t>(score));
+  return s;
+}
+
+Status RocksGraph::Jaccard(node_id_t u, const std::vector<node_id_t>& vs,
+                           int direction, std::vector<double>* scores) {
+  std::vector<std::pair<node_id_t, node_id_t>> pairs;
+  for (node_id_t v : vs) pairs.emplace_back(u, v);
+  return LinkPredictionScores(pairs, kLinkJaccard, direction, scores);
+}
+
+Status RocksGraph::AdamicAdar(node_id_t u, const std::vector<node_id_t>& vs,
+                              int direction, std::vector<double>* scores) {
+  std::vector<std::pair<node_id_t, node_id_t>> pairs;
+  for (node_id_t v : vs) pairs.emplace_back(u, v);
+  return LinkPredictionScores(pairs, kLinkAdamicAdar, direction, scores);
+}
+
+Status RocksGraph::LinkPredictionScores(
+    const std::vector<std::pair<node_id_t, node_id_t>>& pairs,
+    LinkPredictionMetric metric, int direction,
+    std::vector<double>* scores) {
+  if (!relabel_) return ScorePairs(pairs, metric, direction, scores);
+  // unknown vertices map to an id that never has an adjacency key
+  std::vector<std::pair<node_id_t, node_id_t>> internal(pairs);
+  for (auto& pair : internal) {
+    if (!ToInternalId(pair.first, &pair.first).ok()) pair.first = -1;
+    if (!ToInternalId(pair.second, &pair.second).ok()) pair.second = -1;
+  }
+  return ScorePairs(internal, metric, direction, scores);
+}
+
+Status RocksGraph::ScorePairs(
+    const std::vector<std::pair<node_id_t, node_id_t>>& pairs,
+    LinkPredictionMetric metric, int direction,
+    std::vector<double>* scores) {
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported(
+        "Link prediction needs one adjacency key per vertex");
+  }
+  if (!is_directed_) direction = EDGE_DIRECTION_OUT;
+  scores->assign(pairs.size(), 0);
+  // every distinct endpoint is read once
+  std::unordered_map<node_id_t, size_t> slots;
+  std::vector<node_id_t> ids;
+  for (const auto& pair : pairs) {
+    for (node_id_t id : {pair.first, pair.second}) {
+      if (slots.emplace(id, ids.size()).second) ids.push_back(id);
+    }
+  }
+  std::vector<PinnableSlice> values;
+  std::vector<EdgeListView> views;
+  Status s = MultiGetAdjacency(ReadOptions(), ids, &values, &views);
+  if (!s.ok()) return s;
+  std::vector<NeighborSet> sets(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) sets[i].Reset(&views[i], direction);
+
+  // Adamic-Adar needs the degree of every common neighbor, fetched in one
+  // more MultiGet once all pairs are intersected
+  std::vector<size_t> offsets(1, 0);
+  std::vector<node_id_t> common;
+  for (size_t i = 0; i < pairs.size(); i++) {
+    NeighborSet* a = &sets[slots[pairs[i].first]];
+    NeighborSet* b = &sets[slots[pairs[i].second]];
+    if (metric == kLinkAdamicAdar) {
+      ForEachCommonNeighbor(
+          a, b, [&common](node_id_t id) { common.push_back(id); });
+      offsets.push_back(common.size());
+      continue;
+    }
+    uint64_t count = CountCommonNeighbors(a, b);
+    if (metric == kLinkJaccard) {
+      uint64_t total = a->size + b->size - count;
+      (*scores)[i] = total > 0 ? static_cast<double>(count) / total : 0;
+    } else {
+      (*scores)[i] = static_cast<double>(count);
+    }
+  }
+  if (metric != kLinkAdamicAdar) return Status::OK();
+
+  std::vector<node_id_t> shared(common);
+  std::sort(shared.begin(), shared.end());
+  shared.erase(std::unique(shared.begin(), shared.end()), shared.end());
+  std::vector<PinnableSlice> shared_values;
+  std::vector<EdgeListView> shared_views;
+  s = MultiGetAdjacency(ReadOptions(), shared, &shared_values,
+                        &shared_views);
+  if (!s.ok()) return s;
+  std::unordered_map<node_id_t, double> inverse_log_degree;
+  for (size_t i = 0; i < shared.size(); i++) {
+    const EdgeListView& view = shared_views[i];
+    uint64_t degree =
+        static_cast<uint64_t>(view.num_edges_out()) + view.num_edges_in();
+    inverse_log_degree[shared[i]] =
+        degree > 1 ? 1.0 / std::log(static_cast<double>(degree)) : 0;
+  }
+  for (size_t i = 0; i < pairs.size(); i++) {
+    double score = 0;
+    for (size_t j = offsets[i]; j < offsets[i + 1]; j++) {
+      score += inverse_log_degree[common[j]];
+    }
+    (*scores)[i] = score;
+  }
+  return Status::OK();
+}
+
+Status RocksGraph::KHop(node_id_t start, uint32_t hops,
+                        std::vector<node_id_t>* reached) {
+  reached->clear();
+  Status s = ToInternalId(start, &start);
+  if (s.IsNotFound()) return Status::OK();
+  if (s.ok()) s = KHopInternal(start, hops, ReadOptions(), reached);
+  for (node_id_t& id : *reached) {
+    if (!s.ok()) break;
+    s = ToExternalId(id, &id);
+  }
+  return s;
+}
+
+Status RocksGraph::KHopAsOf(node_id_t start, uint32_t hops, uint64_t as_of,
+                            std::vector<node_id_t>* reached) {
+  reached->clear();
+  Status s = CheckAsOf(as_of);
+  if (!s.ok()) return s;
+  s = ToInternalId(start, &start);
+  if (s.IsNotFound()) return Status::OK();
+  std::string ts_buf;
+  Slice ts = EncodeU64Ts(as_of, &ts_buf);
+  ReadOptions read_options;
+  read_options.timestamp = &ts;
+  if (s.ok()) s = KHopInternal(start, hops, read_options, reached);
+  for (node_id_t& id : *reached) {
+    if (!s.ok()) break;
+    s = ToExternalId(id, &id);
+  }
+  return s;
+}
+
+Status RocksGraph::KHopInternal(node_id_t start, uint32_t hops,
+                                const ReadOptions& read_options,
+                                std::vector<node_id_t>* reached) {
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported("KHop needs one adjacency key per vertex");
+  }
+  std::unordered_set<node_id_t> seen{start};
+  reached->push_back(start);
+  std::vector<PinnableSlice> values;
+  std::vector<EdgeListView> views;
+  size_t level_begin = 0;
+  for (uint32_t hop = 0; hop < hops && level_begin < reached->size(); hop++) {
+    std::vector<node_id_t> frontier(reached->begin() + level_begin,
+                                    reached->end());
+    level_begin = reached->size();
+    Status s = MultiGetAdjacency(read_options, frontier, &values, &views);
+    if (!s.ok()) return s;
+    for (EdgeListView& view : views) {
+      for (uint32_t i = 0; i < view.num_edges_out(); i++) {
+        node_id_t id = view.out(i);
+        if (id >= 0 && seen.insert(id).second) reached->push_back(id);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status RocksGraph::GetAllEdgesAsOf(node_id_t src, uint64_t as_of,
+                                   Edges* edges) {
+  Status s = CheckAsOf(as_of);
+  if (s.ok()) s = ToInternalId(src, &src);
+  if (!s.ok()) return s;
+  std::string key, value, ts_buf;
+  encode_node(VertexKey{.id = src}, &key);
+  Slice ts = EncodeU64Ts(as_of, &ts_buf);
+  ReadOptions read_options;
+  read_options.timestamp = &ts;
+  s = db_->Get(read_options, history_cf_, key, &value);
+  if (!s.ok()) return s;
+  decode_edges(edges, value, encoding_type_);
+  return relabel_ ? TranslateEdges(edges) : Status::OK();
+}
+
+Status RocksGraph::CheckAsOf(uint64_t as_of) {
+  if (!history_cf_) {
+    return Status::NotSupported("The graph was not opened in temporal mode");
+  }
+  // compaction may already have folded the versions such a read needs
+  std::string low_buf;
+  uint64_t low = 0;
+  Status s = db_->GetFullHistoryTsLow(history_cf_, &low_buf);
+  if (s.ok() && !low_buf.empty()) s = DecodeU64Ts(low_buf, &low);
+  if (!s.ok()) return s;
+  if (as_of < low) {
+    return Status::InvalidArgument("as_of is older than the trimmed history");
+  }
+  return Status::OK();
+}
+
+Status RocksGraph::TrimHistory(uint64_t timestamp) {
+  if (!history_cf_) {
+    return Status::NotSupported("The graph was not opened in temporal mode");
+  }
+  std::string ts_buf;
+  EncodeU64Ts(timestamp, &ts_buf);
+  return db_->IncreaseFullHistoryTsLow(history_cf_, ts_buf);
+}
+
+Status RocksGraph::ShortestPath(node_id_t u, node_id_t v, uint32_t max_hops,
+                                std::vector<node_id_t>* path,
+                                const PathQueryOptions& options) {
+  path->clear();
+  Status s = ToInternalId(u, &u);
+  if (s.ok()) s = ToInternalId(v, &v);
+  if (s.IsNotFound()) return Status::OK();
+  if (!s.ok()) return s;
+  s = SearchPath(u, v, max_hops, options, path);
+  for (node_id_t& id : *path) {
+    if (!s.ok()) break;
+    s = ToExternalId(id, &id);
+  }
+  return s;
+}
+
+Status RocksGraph::Reachable(node_id_t u, node_id_t v, uint32_t max_hops,
+                             bool* reachable,
+                             const PathQueryOptions& options) {
+  std::vector<node_id_t> path;
+  Status s = ShortestPath(u, v, max_hops, &path, options);
+  *reachable = s.ok() && !path.empty();
+  return s;
+}
+
+Status RocksGraph::SearchPath(node_id_t u, node_id_t v, uint32_t max_hops,
+                              const PathQueryOptions& options,
+                              std::vector<node_id_t>* path) {
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported(
+        "Path queries need one adjacency key per vertex");
+  }
+  if (u == v) {
+    path->push_back(u);
+    return Status::OK();
+  }
+  SystemClock* clock = SystemClock::Default().get();
+  const uint64_t start_micros = clock->NowMicros();
+  // side 0 searches forward from u, side 1 backward from v; every reached
+  // vertex maps to its parent towards the side's root
+  std::unordered_map<node_id_t, node_id_t> parents[2] = {{{u, u}}, {{v, v}}};
+  std::vector<node_id_t> frontiers[2] = {{u}, {v}};
+  const int directions[2] = {
+      EDGE_DIRECTION_OUT,
+      is_directed_ ? EDGE_DIRECTION_IN : EDGE_DIRECTION_OUT};
+  ManagedSnapshot snapshot(db_);
+  if (snapshot.snapshot() == nullptr) {
+    return Status::NotSupported("path search needs DB snapshots");
+  }
+  ReadOptions read_options;
+  read_options.snapshot = snapshot.snapshot();
+  std::vector<PinnableSlice> values;
+  std::vector<EdgeListView> views;
+  uint64_t expanded = 0;
+  node_id_t meet = -1;
+  // Both frontiers are whole BFS levels, so the first vertex reached from
+  // both sides closes a shortest path.
+  for (uint32_t hops = 0; hops < max_hops && meet < 0; hops++) {
+    int side = frontiers[0].size() <= frontiers[1].size() ? 0 : 1;
+    std::vector<node_id_t>& frontier = frontiers[side];
+    if (frontier.empty()) break;
+    expanded += frontier.size();
+    if (options.max_expanded_vertices > 0 &&
+        expanded > options.max_expanded_vertices) {
+      return Status::Incomplete("Path query ran out of its vertex budget");
+    }
+    if (options.max_micros > 0 &&
+        clock->NowMicros() - start_micros > options.max_micros) {
+      return Status::Incomplete("Path query ran out of its time budget");
+    }
+    Status s = MultiGetAdjacency(read_options, frontier, &values, &views);
+    if (!s.ok()) return s;
+    auto& own = parents[side];
+    const auto& other = parents[1 - side];
+    const int direction = directions[side];
+    std::vector<node_id_t> next;
+    for (size_t i = 0; i < frontier.size() && meet < 0; i++) {
+      EdgeListView& view = views[i];
+      for (uint32_t j = 0; j < view.num_edges(direction); j++) {
+        node_id_t w = view.at(direction, j);
+        if (w < 0 || !own.emplace(w, frontier[i]).second) continue;
+        if (other.count(w)) {
+          meet = w;
+          break;
+        }
+        next.push_back(w);
+      }
+    }
+    frontier.swap(next);
+  }
+  if (meet < 0) return Status::OK();
+  for (node_id_t x = meet; x != u; x = parents[0][x]) path->push_back(x);
+  path->push_back(u);
+  std::reverse(path->begin(), path->end());
+  for (node_id_t x = meet; x != v;) {
+    x = parents[1][x];
+    path->push_back(x);
+  }
+  return Status::OK();
+}
+
+Status RocksGraph::GetAllEdgesInternal(node_id_t src, Edges* edges) {
+  VertexKey v{.id = src};
+  std::string key;
+  encode_node(v, &key);
+  std::string value;
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    std::string start;
+    std::string end;
+    encode_node(v, &start);
+    // start.push_back(static_cast<char>(0x00));
+    encode_node(v, &end);
+    std::string::iterator sit = end.begin();
+    for (; *(sit + 1) != 0; ++sit) {
+    }
+    *sit = *sit + 1;
+
+    // end.push_back(static_cast<char>(0xFF));
+    //  std::cout<<"start: "<< start << std::endl;
+    //  std::cout<<"end: "<< end << std::endl;
+    Slice lower_key((char*)start.c_str());
+    Slice upper_key((char*)end.c_str());
+
+    rocksdb::ReadOptions read_options;
+    read_options.iterate_lower_bound = &lower_key;
+    read_options.iterate_upper_bound = &upper_key;
+
+    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(read_options));
+    //int edge_count = 0;
+    for (it->Seek(start); it->Valid(); it->Next()) {
+      //edge_count++;
+      it->value();
+      // decode_edges(edges,  it->value().ToString(), encoding_type_);
+    }
+    // printf("edge_count: %d\t", edge_count);
+    return Status::OK();
+  }
+  bool found;
+  uint64_t index;
+  if (auto snapshot = ServedByCSRSnapshot(src, &found, &index)) {
+    if (!found) return Status::NotFound();
+    snapshot->GetEdges(index, edges);
+    return Status::OK();
+  }
+  Status s = ReadAdjacency(key, &value);
+  if (!s.ok()) {
+    return s;
+  }
+  bool timed = encoding_type_ == ENCODING_TYPE_EFP &&
+               (statistics_ ||
+                GetPerfLevel() >= PerfLevel::kEnableTimeExceptForMutex);
+  uint64_t start_nanos = timed ? SystemClock::Default()->NowNanos() : 0;
+  decode_edges(edges, value, encoding_type_);
+  RecordDecodedEdges(
+      *edges, timed ? SystemClock::Default()->NowNanos() - start_nanos : 0);
+  return Status::OK();
+  // if(edge_update_policy_ != EDGE_UPDATE_EAGER){
+  // GetMergeOperandsOptions merge_operands_info;
+  // int number_of_operands = 0;
+  // int maximum_levels = 10;
+  // merge_operands_info.expected_max_number_of_operands = maximum_levels;
+  // std::vector<PinnableSlice> values(maximum_levels);
+  // s = db_->GetMergeOperands(ReadOptions(), adj_cf_, key,
+  //                           values.data(), &merge_operands_info,
+  //                           &number_of_operands);
+  // }
+}
+
+node_id_t RocksGraph::GetOutDegree(node_id_t src) {
+  TraceOp(kGraphTraceGetOutDegree, src);
+  if (!ToInternalId(src, &src).ok()) return 0;
+  bool found;
+  uint64_t index;
+  if (auto snapshot = ServedByCSRSnapshot(src, &found, &index)) {
+    return found ? snapshot->out_degree(index) : 0;
+  }
+  VertexKey v{.id = src};
+  std::string key;
+  encode_node(v, &key);
+  std::string value;
+  Status s = ReadAdjacency(key, &value);
+  if (!s.ok() || value.size() < sizeof(uint32_t)) return 0;
+  return *reinterpret_cast<const uint32_t*>(value.data());
+}
+
+node_id_t RocksGraph::GetInDegree(node_id_t src) {
+  TraceOp(kGraphTraceGetInDegree, src);
+  if (!ToInternalId(src, &src).ok()) return 0;
+  // an undirected vertex's neighbors all sit in its out list
+  const bool in = is_directed_;
+  bool found;
+  uint64_t index;
+  if (auto snapshot = ServedByCSRSnapshot(src, &found, &index)) {
+    if (!found) return 0;
+    return in ? snapshot->in_degree(index) : snapshot->out_degree(index);
+  }
+  VertexKey v{.id = src};
+  std::string key;
+  encode_node(v, &key);
+  std::string value;
+  Status s = ReadAdjacency(key, &value);
+  const size_t offset = in ? sizeof(uint32_t) : 0;
+  if (!s.ok() || value.size() < offset + sizeof(uint32_t)) return 0;
+  return *reinterpret_cast<const uint32_t*>(value.data() + offset);
+}
+
+node_id_t RocksGraph::GetDegreeApproximate(node_id_t src,
+                                           int filter_type_manual) {
+  if (!ToInternalId(src, &src).ok()) return 0;
+  return GetDegreeApproximateInternal(src, filter_type_manual);
+}
+
+node_id_t RocksGraph::GetDegreeApproximateInternal(node_id_t src,
+                                                   int filter_type_manual) {
+  if (filter_type_manual > 0 && filter_type_ != FILTER_TYPE_ALL) {
+    printf(
+        "degree filter setting error: filter_type_manual > 0 should only be "
+        "set when FILTER_TYPE_ALL\n");
+  }
+  if (filter_type_manual == FILTER_TYPE_CMS ||
+      (filter_type_manual == 0 && filter_type_ == FILTER_TYPE_CMS)) {
+    return cms_out.GetVertexCount(src) + cms_in.GetVertexCount(src);
+  } else if (filter_type_manual == FILTER_TYPE_MORRIS ||
+             (filter_type_manual == 0 && filter_type_ == FILTER_TYPE_MORRIS)) {
+    return mor.GetVertexCount(src);
+  }
+  return 0;
+}
+
+// Per-(seed, hop, vertex) random stream, so what a vertex draws does not
+// depend on which thread or MultiGet batch it lands in.
+uint64_t inline SampleStreamSeed(uint64_t seed, size_t hop, node_id_t v) {
+  uint64_t h = seed ^ (0x9E3779B97F4A7C15ULL * (hop + 1));
+  h ^= static_cast<uint64_t>(v) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+  return h;
+}
+
+// Floyd's algorithm: k distinct positions out of [0, n) with exactly k draws.
+void inline SamplePositions(uint32_t n, uint32_t k, std::mt19937_64& rng,
+                            std::vector<uint32_t>* positions) {
+  positions->clear();
+  if (k >= n) {
+    for (uint32_t i = 0; i < n; i++) positions->push_back(i);
+    return;
+  }
+  for (uint32_t j = n - k; j < n; j++) {
+    std::uniform_int_distribution<uint32_t> dist(0, j);
+    uint32_t t = dist(rng);
+    if (std::find(positions->begin(), positions->end(), t) !=
+        positions->end()) {
+      t = j;
+    }
+    positions->push_back(t);
+  }
+}
+
+Status RocksGraph::SampleNeighbors(const std::vector<node_id_t>& seeds,
+                                   const std::vector<uint32_t>& fanouts,
+                                   int direction, uint64_t seed,
+                                   std::vector<SampledLayer>* layers,
+                                   int num_threads) {
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported(
+        "SampleNeighbors needs one adjacency key per vertex");
+  }
+  const size_t kBatchSize = 256;
+  num_threads = std::max(num_threads, 1);
+  if (!is_directed_) direction = EDGE_DIRECTION_OUT;
+  layers->clear();
+  std::vector<node_id_t> frontier(seeds);
+  for (node_id_t& v : frontier) {
+    // unknown seeds map to an id that never has an adjacency key
+    if (!ToInternalId(v, &v).ok()) v = -1;
+  }
+  for (size_t hop = 0; hop < fanouts.size(); hop++) {
+    layers->emplace_back();
+    SampledLayer& layer = layers->back();
+    layer.seeds = std::move(frontier);
+    const size_t num_seeds = layer.seeds.size();
+    const uint32_t fanout = fanouts[hop];
+    std::vector<uint32_t> counts(num_seeds, 0);
+    // each worker owns a contiguous seed range and appends to its own buffer,
+    // so the buffers concatenate into the CSR neighbor array in seed order
+    std::vector<std::vector<node_id_t>> picked(num_threads);
+    std::vector<Status> statuses(num_threads);
+    auto sample_range = [&](int t) {
+      size_t begin = num_seeds * t / num_threads;
+      size_t end = num_seeds * (t + 1) / num_threads;
+      std::vector<std::string> key_bufs(kBatchSize);
+      std::vector<Slice> keys(kBatchSize);
+      std::vector<PinnableSlice> values(kBatchSize);
+      std::vector<Status> get_statuses(kBatchSize);
+      std::vector<uint32_t> positions;
+      EdgeListView view;
+      for (size_t b = begin; b < end; b += kBatchSize) {
+        size_t batch = std::min(kBatchSize, end - b);
+        for (size_t i = 0; i < batch; i++) {
+          key_bufs[i].clear();
+          encode_node(VertexKey{.id = layer.seeds[b + i]}, &key_bufs[i]);
+          keys[i] = key_bufs[i];
+          values[i].Reset();
+        }
+        db_->MultiGet(ReadOptions(), adj_cf_, batch, keys.data(),
+                      values.data(), get_statuses.data());
+        for (size_t i = 0; i < batch; i++) {
+          if (get_statuses[i].IsNotFound()) continue;
+          if (!get_statuses[i].ok()) {
+            statuses[t] = get_statuses[i];
+            return;
+          }
+          view.Reset(values[i].data(), values[i].size(), encoding_type_);
+          std::mt19937_64 rng(SampleStreamSeed(seed, hop, layer.seeds[b + i]));
+          SamplePositions(view.num_edges(direction), fanout, rng, &positions);
+          for (uint32_t pos : positions) {
+            picked[t].push_back(view.at(direction, pos));
+          }
+          counts[b + i] = static_cast<uint32_t>(positions.size());
+        }
+      }
+    };
+    if (num_threads == 1) {
+      sample_range(0);
+    } else {
+      std::vector<std::thread> workers;
+      for (int t = 0; t < num_threads; t++) {
+        workers.emplace_back(sample_range, t);
+      }
+      for (auto& worker : workers) worker.join();
+    }
+    for (const auto& s : statuses) {
+      if (!s.ok()) return s;
+    }
+
+    layer.offsets.resize(num_seeds + 1);
+    layer.offsets[0] = 0;
+    for (size_t i = 0; i < num_seeds; i++) {
+      layer.offsets[i + 1] = layer.offsets[i] + counts[i];
+    }
+    layer.neighbors.reserve(layer.offsets[num_seeds]);
+    for (const auto& buf : picked) {
+      layer.neighbors.insert(layer.neighbors.end(), buf.begin(), buf.end());
+    }
+
+    frontier.clear();
+    std::unordered_set<node_id_t> seen;
+    for (node_id_t v : layer.neighbors) {
+      if (seen.insert(v).second) frontier.push_back(v);
+    }
+  }
+  if (relabel_) {
+    for (size_t hop = 0; hop < layers->size(); hop++) {
+      SampledLayer& layer = (*layers)[hop];
+      if (hop == 0) {
+        layer.seeds = seeds;
+      } else {
+        for (node_id_t& v : layer.seeds) ToExternalId(v, &v);
+      }
+      for (node_id_t& v : layer.neighbors) ToExternalId(v, &v);
+    }
+  }
+  return Status::OK();
+}
+
+Status RocksGraph::ParallelScan(const AdjacencyScanCallback& callback,
+                                int num_threads, size_t readahead_size) {
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported(
+        "ParallelScan needs one adjacency key per vertex");
+  }
+  num_threads = std::max(num_threads, 1);
+
+  // Candidate cut points are the first keys of the SST files. Several
+  // partitions per thread keep the workers busy when file sizes are skewed.
+  ColumnFamilyMetaData cf_meta;
+  db_->GetColumnFamilyMetaData(adj_cf_, &cf_meta);
+  std::vector<std::string> file_starts;
+  for (const auto& level : cf_meta.levels) {
+    for (const auto& file : level.files) {
+      file_starts.push_back(file.smallestkey);
+    }
+  }
+  std::sort(file_starts.begin(), file_starts.end());
+  file_starts.erase(std::unique(file_starts.begin(), file_starts.end()),
+                    file_starts.end());
+  size_t max_partitions = static_cast<size_t>(num_threads) * 4;
+  std::vector<std::string> cuts;
+  if (file_starts.size() > 1) {
+    size_t num_cuts = std::min(file_starts.size() - 1, max_partitions - 1);
+    for (size_t i = 1; i <= num_cuts; i++) {
+      cuts.push_back(file_starts[i * (file_starts.size() - 1) / num_cuts]);
+    }
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+  }
+  const size_t num_partitions = cuts.size() + 1;
+
+  const Snapshot* snapshot = db_->GetSnapshot();
+  if (snapshot == nullptr) {
+    return Status::NotSupported("parallel scans need DB snapshots");
+  }
+  std::atomic<size_t> next_partition{0};
+  std::vector<Status> statuses(num_threads);
+  auto scan = [&](int t) {
+    for (size_t p = next_partition++; p < num_partitions;
+         p = next_partition++) {
+      Slice lower, upper;
+      ReadOptions read_options;
+      read_options.snapshot = snapshot;
+      read_options.readahead_size = readahead_size;
+      read_options.fill_cache = false;
+      if (p > 0) {
+        lower = cuts[p - 1];
+        read_options.iterate_lower_bound = &lower;
+      }
+      if (p < cuts.size()) {
+        upper = cuts[p];
+        read_options.iterate_upper_bound = &upper;
+      }
+      std::unique_ptr<Iterator> it(db_->NewIterator(read_options, adj_cf_));
+      EdgeListView view;
+      for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        Slice key = it->key();
+        if (key.size() != sizeof(node_id_t)) continue;
+        node_id_t id;
+        std::memcpy(&id, key.data(), sizeof(node_id_t));
+        Slice value = it->value();
+        view.Reset(value.data(), value.size(), encoding_type_);
+        callback(id, view);
+      }
+      if (!it->status().ok()) {
+        statuses[t] = it->status();
+        return;
+      }
+    }
+  };
+  if (num_threads == 1) {
+    scan(0);
+  } else {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; t++) {
+      workers.emplace_back(scan, t);
+    }
+    for (auto& worker : workers) worker.join();
+  }
+  db_->ReleaseSnapshot(snapshot);
+  for (const auto& s : statuses) {
+    if (!s.ok()) return s;
+  }
+  return Status::OK();
+}
+
+namespace {
+// Collects the vertices whose adjacency key appears in a WAL write batch.
+class AdjacencyKeyCollector : public WriteBatch::Handler {
+ public:
+  AdjacencyKeyCollector(uint32_t adj_cf_id,
+                        std::unordered_set<node_id_t>* vertices)
+      : adj_cf_id_(adj_cf_id), vertices_(vertices) {}
+  Status PutCF(uint32_t cf, const Slice& key, const Slice&) override {
+    return Collect(cf, key);
+  }
+  Status MergeCF(uint32_t cf, const Slice& key, const Slice&) override {
+    return Collect(cf, key);
+  }
+  Status DeleteCF(uint32_t cf, const Slice& key) override {
+    return Collect(cf, key);
+  }
+  Status SingleDeleteCF(uint32_t cf, const Slice& key) override {
+    return Collect(cf, key);
+  }
+  Status DeleteRangeCF(uint32_t cf, const Slice&, const Slice&) override {
+    if (cf == adj_cf_id_) {
+      return Status::NotSupported("range deletion on the adjacency lists");
+    }
+    return Status::OK();
+  }
+
+ private:
+  Status Collect(uint32_t cf, const Slice& key) {
+    if (cf == adj_cf_id_ && key.size() >= sizeof(node_id_t)) {
+      node_id_t id;
+      std::memcpy(&id, key.data(), sizeof(node_id_t));
+      vertices_->insert(id);
+    }
+    return Status::OK();
+  }
+  uint32_t adj_cf_id_;
+  std::unordered_set<node_id_t>* vertices_;
+};
+}  // namespace
+
+Status RocksGraph::ExportCSRSnapshot(const std::string& path) {
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported(
+        "CSR snapshots need one adjacency key per vertex");
+  }
+  const Snapshot* snapshot = db_->GetSnapshot();
+  if (snapshot == nullptr) {
+    return Status::NotSupported("CSR snapshots need DB snapshots");
+  }
+  Status s = CSRSnapshot::Export(db_, adj_cf_, snapshot, encoding_type_,
+                                 db_->GetEnv(), path);
+  db_->ReleaseSnapshot(snapshot);
+  return s;
+}
+
+Status RocksGraph::AttachCSRSnapshot(const std::string& path) {
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported(
+        "CSR snapshots need one adjacency key per vertex");
+  }
+  std::unique_ptr<CSRSnapshot> snapshot;
+  Status s = CSRSnapshot::Open(db_->GetEnv(), path, &snapshot);
+  if (!s.ok()) return s;
+  std::lock_guard<std::mutex> attach_lock(csr_attach_mu_);
+  DetachCSRSnapshotLocked();
+  SequenceNumber covered_to;
+  {
+    // Writes in flight finish first; the WAL scan below then covers them,
+    // and every later write records its vertices as it is made.
+    std::unique_lock<std::shared_mutex> write_lock(csr_write_mu_);
+    csr_tracking_.store(true);
+    covered_to = db_->GetLatestSequenceNumber();
+  }
+  std::unordered_set<node_id_t> changed;
+  AdjacencyKeyCollector collector(adj_cf_->GetID(), &changed);
+  SequenceNumber next = snapshot->sequence() + 1;
+  // A scan reaching the WAL tail while other column families are written
+  // reports TryAgain; it resumes from the first sequence it has not seen.
+  while (s.ok() && next <= covered_to) {
+    const SequenceNumber start = next;
+    std::unique_ptr<TransactionLogIterator> iter;
+    s = db_->GetUpdatesSince(next, &iter);
+    for (; s.ok() && iter->Valid() && next <= covered_to; iter->Next()) {
+      BatchResult batch = iter->GetBatch();
+      if (next == start && batch.sequence > next) {
+        s = Status::Incomplete(
+            "WAL no longer covers the writes since the CSR snapshot");
+        break;
+      }
+      s = batch.writeBatchPtr->Iterate(&collector);
+      next = batch.sequence + batch.writeBatchPtr->Count();
+    }
+    if (s.ok() && next <= covered_to) {
+      Status tail = iter->status();
+      if (next == start) {
+        s = tail.ok() ? Status::Incomplete("WAL ends before the latest write")
+                      : tail;
+      } else if (!tail.ok() && !tail.IsTryAgain()) {
+        s = tail;
+      }
+    }
+  }
+  if (!s.ok()) {
+    DetachCSRSnapshotLocked();
+    return s;
+  }
+  std::lock_guard<std::mutex> lock(csr_mu_);
+  csr_changed_.insert(changed.begin(), changed.end());
+  std::atomic_store(&csr_snapshot_,
+                    std::shared_ptr<CSRSnapshot>(std::move(snapshot)));
+  return Status::OK();
+}
+
+void RocksGraph::DetachCSRSnapshot() {
+  std::lock_guard<std::mutex> attach_lock(csr_attach_mu_);
+  DetachCSRSnapshotLocked();
+}
+
+void RocksGraph::DetachCSRSnapshotLocked() {
+  std::lock_guard<std::mutex> lock(csr_mu_);
+  csr_tracking_.store(false);
+  std::atomic_store(&csr_snapshot_, std::shared_ptr<CSRSnapshot>());
+  csr_changed_.clear();
+}
+
+void RocksGraph::MarkChanged(const WriteBatch& batch) {
+  std::unordered_set<node_id_t> changed;
+  AdjacencyKeyCollector collector(adj_cf_->GetID(), &changed);
+  // the batch was built by the graph; nothing in it can fail to iterate
+  batch.Iterate(&collector);
+  std::lock_guard<std::mutex> lock(csr_mu_);
+  csr_changed_.insert(changed.begin(), changed.end());
+}
+
+Status RocksGraph::CollectBlobGarbage(double min_garbage_ratio) {
+  if (blob_min_degree_ == 0) return Status::OK();
+  for (ColumnFamilyHandle* cf : {adj_cf_, label_cf_}) {
+    ColumnFamilyMetaData cf_meta;
+    db_->GetColumnFamilyMetaData(cf, &cf_meta);
+    std::vector<BlobMetaData>& blobs = cf_meta.blob_files;
+    std::sort(blobs.begin(), blobs.end(),
+              [](const BlobMetaData& a, const BlobMetaData& b) {
+                return a.blob_file_number < b.blob_file_number;
+              });
+    // the newest blob file worth rewriting; older ones go with it
+    size_t cutoff = 0;
+    for (size_t i = 0; i < blobs.size(); i++) {
+      if (blobs[i].total_blob_bytes > 0 &&
+          blobs[i].garbage_blob_bytes >=
+              min_garbage_ratio * blobs[i].total_blob_bytes) {
+        cutoff = i + 1;
+      }
+    }
+    if (cutoff == 0) continue;
+    uint64_t last = blobs[cutoff - 1].blob_file_number;
+    std::string smallest, largest;
+    for (const auto& level : cf_meta.levels) {
+      for (const auto& file : level.files) {
+        if (file.oldest_blob_file_number == 0 ||
+            file.oldest_blob_file_number > last) {
+          continue;
+        }
+        if (smallest.empty() || file.smallestkey < smallest) {
+          smallest = file.smallestkey;
+        }
+        if (largest.empty() || file.largestkey > largest) {
+          largest = file.largestkey;
+        }
+      }
+    }
+    if (smallest.empty()) continue;
+    CompactRangeOptions compact_options;
+    compact_options.bottommost_level_compaction =
+        BottommostLevelCompaction::kForce;
+    compact_options.blob_garbage_collection_policy =
+        BlobGarbageCollectionPolicy::kForce;
+    compact_options.blob_garbage_collection_age_cutoff =
+        static_cast<double>(cutoff) / blobs.size();
+    Slice begin(smallest), end(largest);
+    Status s = db_->CompactRange(compact_options, cf, &begin, &end);
+    if (!s.ok()) return s;
+  }
+  return Status::OK();
+}
+
+std::shared_ptr<CSRSnapshot> RocksGraph::ServedByCSRSnapshot(
+    node_id_t id, bool* found, uint64_t* index) {
+  // the copy keeps the mapping alive through a concurrent detach
+  std::shared_ptr<CSRSnapshot> snapshot = std::atomic_load(&csr_snapshot_);
+  if (!snapshot) return nullptr;
+  {
+    std::lock_guard<std::mutex> lock(csr_mu_);
+    if (csr_changed_.count(id)) return nullptr;
+  }
+  *found = snapshot->Find(id, index);
+  return snapshot;
+}
+
+namespace {
+// id_map keys: 'e' + external id -> internal id, 'i' + internal id ->
+// external id, plus the next internal id to hand out.
+const char kIdMapNextKey[] = "next_id";
+
+std::string IdMapKey(char prefix, node_id_t id) {
+  std::string key(1, prefix);
+  key.append(reinterpret_cast<const char*>(&id), sizeof(node_id_t));
+  return key;
+}
+
+std::string IdMapValue(node_id_t id) {
+  return std::string(reinterpret_cast<const char*>(&id), sizeof(node_id_t));
+}
+}  // namespace
+
+Status RocksGraph::ReadAdjacency(const std::string& key, std::string* value) {
+  PerfLevel saved_level = GetPerfLevel();
+  bool timed = saved_level >= PerfLevel::kEnableTimeExceptForMutex;
+  uint64_t start_nanos = timed ? SystemClock::Default()->NowNanos() : 0;
+  uint64_t operands_before = adj_merge_operands;
+  Status s = db_->Get(ReadOptions(), adj_cf_, key, value);
+  uint64_t operands = adj_merge_operands - operands_before;
+
+  graph_stats_.adj_list_reads.fetch_add(1, std::memory_order_relaxed);
+  graph_stats_.merge_operands.fetch_add(operands, std::memory_order_relaxed);
+  graph_stats_.operand_depth[DepthBucket(operands)].fetch_add(
+      1, std::memory_order_relaxed);
+  UpdateMax(&graph_stats_.max_merge_operands, operands);
+  RecordTick(statistics_.get(), GRAPH_ADJ_LIST_READS);
+  RecordTick(statistics_.get(), GRAPH_ADJ_MERGE_OPERANDS, operands);
+  RecordInHistogram(statistics_.get(), GRAPH_ADJ_MERGE_OPERANDS_PER_READ,
+                    operands);
+  if (saved_level >= PerfLevel::kEnableCount) {
+    GraphPerfContext* perf = get_graph_perf_context();
+    perf->adj_list_read_count++;
+    perf->adj_merge_operand_count += operands;
+    perf->max_adj_merge_operands =
+        std::max(perf->max_adj_merge_operands, operands);
+    if (timed) {
+      perf->adj_list_read_nanos +=
+          SystemClock::Default()->NowNanos() - start_nanos;
+    }
+  }
+  return s;
+}
+
+void RocksGraph::RecordDecodedEdges(const Edges& edges,
+                                    uint64_t decode_nanos) {
+  uint64_t length = edges.num_edges_out + edges.num_edges_in;
+  graph_stats_.decoded_edges.fetch_add(length, std::memory_order_relaxed);
+  RecordTick(statistics_.get(), GRAPH_DECODED_EDGES, length);
+  RecordInHistogram(statistics_.get(), GRAPH_ADJ_LIST_LENGTH, length);
+  if (decode_nanos > 0) {
+    RecordInHistogram(statistics_.get(), GRAPH_EFP_DECODE_MICROS,
+                      decode_nanos / 1000);
+  }
+  if (GetPerfLevel() >= PerfLevel::kEnableCount) {
+    GraphPerfContext* perf = get_graph_perf_context();
+    perf->decoded_edge_count += length;
+    perf->efp_decode_nanos += decode_nanos;
+  }
+}
+
+void RocksGraph::RecordPolicyChoice(int policy) {
+  bool eager = policy == EDGE_UPDATE_EAGER;
+  (eager ? graph_stats_.eager_updates : graph_stats_.lazy_updates)
+      .fetch_add(1, std::memory_order_relaxed);
+  RecordTick(statistics_.get(), eager ? GRAPH_POLICY_EAGER : GRAPH_POLICY_LAZY);
+  if (GetPerfLevel() >= PerfLevel::kEnableCount) {
+    GraphPerfContext* perf = get_graph_perf_context();
+    (eager ? perf->eager_update_count : perf->lazy_update_count)++;
+  }
+}
+
+void RocksGraph::CountDegree(node_id_t v) {
+  if (!mor.AddCounter(v)) {
+    graph_stats_.morris_saturated.fetch_add(1, std::memory_order_relaxed);
+    RecordTick(statistics_.get(), GRAPH_MORRIS_SATURATED);
+  }
+}
+
+bool RocksGraph::GetIntProperty(const std::string& property,
+                                uint64_t* value) {
+  if (property == GraphProperties::kSketchMemory) {
+    *value = mor.CalcMemoryUsage() + cms_out.CalcMemoryUsage() +
+             cms_in.CalcMemoryUsage();
+    std::lock_guard<std::mutex> lock(label_mu_);
+    for (const auto& label_counter : label_degrees_) {
+      *value += label_counter.second->CalcMemoryUsage();
+    }
+  } else if (property == GraphProperties::kNumVertices) {
+    *value = static_cast<uint64_t>(n);
+  } else if (property == GraphProperties::kNumEdges) {
+    *value = static_cast<uint64_t>(m);
+  } else if (property == GraphProperties::kAdjListReads) {
+    *value = graph_stats_.adj_list_reads.load();
+  } else if (property == GraphProperties::kMaxMergeOperands) {
+    *value = graph_stats_.max_merge_operands.load();
+  } else if (property == GraphProperties::kMorrisSaturated) {
+    *value = graph_stats_.morris_saturated.load();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool RocksGraph::GetProperty(const std::string& property, std::string* value) {
+  std::ostringstream ss;
+  // prints non-empty buckets as "[lo,hi): count"
+  auto print_buckets = [&ss](const std::vector<uint64_t>& buckets) {
+    for (size_t b = 0; b < buckets.size(); b++) {
+      if (buckets[b] == 0) continue;
+      uint64_t lo = b == 0 ? 0 : uint64_t{1} << (b - 1);
+      ss << "  [" << lo << ",";
+      if (b + 1 < buckets.size()) {
+        ss << (uint64_t{1} << b);
+      } else {
+        ss << "inf";
+      }
+      ss << "): " << buckets[b] << "\n";
+    }
+  };
+  if (property == GraphProperties::kDegreeHistogram) {
+    std::vector<uint64_t> buckets(33, 0);
+    const std::vector<unsigned char> counters = mor.CopyCounters();
+    for (size_t v = 0; v < counters.size(); v++) {
+      if (counters[v] == 0) continue;
+      uint64_t degree =
+          static_cast<uint64_t>(mor.EstimateCount(counters[v]));
+      int b = 0;
+      while (degree > 0 && b < 32) {
+        degree >>= 1;
+        b++;
+      }
+      buckets[b]++;
+    }
+    ss << "estimated degree (vertices)\n";
+    print_buckets(buckets);
+  } else if (property == GraphProperties::kMergeOperandDepth) {
+    std::vector<uint64_t> buckets(GraphStats::kDepthBuckets);
+    for (int b = 0; b < GraphStats::kDepthBuckets; b++) {
+      buckets[b] = graph_stats_.operand_depth[b].load();
+    }
+    uint64_t reads = graph_stats_.adj_list_reads.load();
+    uint64_t operands = graph_stats_.merge_operands.load();
+    ss << "reads: " << reads << " operands: " << operands << " avg: "
+       << (reads ? static_cast<double>(operands) / reads : 0.0)
+       << " max: " << graph_stats_.max_merge_operands.load() << "\n";
+    print_buckets(buckets);
+  } else if (property == GraphProperties::kPolicyMix) {
+    uint64_t eager = graph_stats_.eager_updates.load();
+    uint64_t lazy = graph_stats_.lazy_updates.load();
+    ss << "eager: " << eager << " lazy: " << lazy << " eager_ratio: "
+       << (eager + lazy ? static_cast<double>(eager) / (eager + lazy) : 0.0)
+       << "\n";
+  } else if (property == GraphProperties::kStats) {
+    for (const auto* name :
+         {&GraphProperties::kNumVertices, &GraphProperties::kNumEdges,
+          &GraphProperties::kAdjListReads, &GraphProperties::kMaxMergeOperands,
+          &GraphProperties::kMorrisSaturated, &GraphProperties::kSketchMemory}) {
+      uint64_t v = 0;
+      GetIntProperty(*name, &v);
+      ss << *name << ": " << v << "\n";
+    }
+    ss << "decoded edges: " << graph_stats_.decoded_edges.load() << "\n";
+    for (const auto* name :
+         {&GraphProperties::kPolicyMix, &GraphProperties::kMergeOperandDepth,
+          &GraphProperties::kDegreeHistogram}) {
+      std::string section;
+      GetProperty(*name, &section);
+      ss << *name << ":\n" << section;
+    }
+  } else {
+    uint64_t int_value;
+    if (!GetIntProperty(property, &int_value)) return false;
+    ss << int_value;
+  }
+  *value = ss.str();
+  return true;
+}
+
+Status RocksGraph::StartTrace(const TraceOptions& trace_options,
+                              std::unique_ptr<TraceWriter>&& trace_writer) {
+  auto tracer = std::make_shared<GraphTracer>(
+      db_->GetEnv()->GetSystemClock().get(), trace_options,
+      std::move(trace_writer));
+  Status s = tracer->WriteHeader();
+  if (!s.ok()) return s;
+  std::shared_ptr<GraphTracer> running;
+  if (!std::atomic_compare_exchange_strong(&tracer_, &running, tracer)) {
+    return Status::Busy("a graph trace is already running");
+  }
+  tracing_.store(true);
+  return Status::OK();
+}
+
+Status RocksGraph::EndTrace() {
+  tracing_.store(false);
+  auto tracer = std::atomic_exchange(&tracer_, std::shared_ptr<GraphTracer>());
+  if (!tracer) return Status::OK();
+  // writers still holding a reference append after this and are dropped
+  return tracer->Close();
+}
+
+Status RocksGraph::GetChangesSince(SequenceNumber since,
+                                   std::unique_ptr<GraphChangeIterator>* iter,
+                                   size_t max_batch_changes) {
+  GraphChangeSource source;
+  source.adj_cf_id = adj_cf_->GetID();
+  source.vertex_prop_cf_id = vertex_prop_cf_->GetID();
+  source.edge_prop_cf_id = edge_prop_cf_->GetID();
+  source.encoding_type = encoding_type_;
+  source.is_directed = is_directed_;
+  source.to_external = [this](node_id_t internal, node_id_t* external) {
+    return ToExternalId(internal, external);
+  };
+  std::unique_ptr<TransactionLogIterator> wal;
+  // nothing written at or after `since` yet: an exhausted iterator
+  if (since <= db_->GetLatestSequenceNumber()) {
+    Status s = db_->GetUpdatesSince(since, &wal);
+    if (!s.ok()) return s;
+  }
+  iter->reset(new GraphChangeIterator(std::move(wal), source, since,
+                                      max_batch_changes));
+  return (*iter)->status();
+}
+
+void RocksGraph::WriteTrace(GraphTraceOp op, node_id_t src, node_id_t dst,
+                            const Property* prop, edge_label_t label) {
+  auto tracer = std::atomic_load(&tracer_);
+  if (tracer) tracer->Write(op, src, dst, prop, label);
+}
+
+void RocksGraph::LoadIdMapMeta() {
+  std::string value;
+  Status s = db_->Get(ReadOptions(), id_map_cf_, kIdMapNextKey, &value);
+  if (s.ok() && value.size() == sizeof(node_id_t)) {
+    std::memcpy(&next_internal_id_, value.data(), sizeof(node_id_t));
+    relabel_ = true;
+  }
+}
+
+Status RocksGraph::WriteIdMapping(WriteBatch* batch, node_id_t external,
+                                  node_id_t internal) {
+  Status s = batch->Put(id_map_cf_, IdMapKey('e', external),
+                        IdMapValue(internal));
+  if (!s.ok()) return s;
+  return batch->Put(id_map_cf_, IdMapKey('i', internal), IdMapValue(external));
+}
+
+Status RocksGraph::ToInternalId(node_id_t external, node_id_t* internal,
+                                bool create) {
+  if (!relabel_) {
+    *internal = external;
+    return Status::OK();
+  }
+  if (to_internal_cache_.Lookup(external, internal)) return Status::OK();
+  std::string key = IdMapKey('e', external);
+  std::string value;
+  Status s = db_->Get(ReadOptions(), id_map_cf_, key, &value);
+  if (s.IsNotFound() && create) {
+    std::lock_guard<std::mutex> lock(id_mu_);
+    // another writer may have created it while we were waiting
+    s = db_->Get(ReadOptions(), id_map_cf_, key, &value);
+    if (s.IsNotFound()) {
+      WriteBatch batch;
+      s = WriteIdMapping(&batch, external, next_internal_id_);
+      if (s.ok()) {
+        s = batch.Put(id_map_cf_, kIdMapNextKey,
+                      IdMapValue(next_internal_id_ + 1));
+      }
+      if (s.ok()) s = db_->Write(WriteOptions(), &batch);
+      if (!s.ok()) return s;
+      value = IdMapValue(next_internal_id_++);
+    }
+  }
+  if (!s.ok()) return s;
+  std::memcpy(internal, value.data(), sizeof(node_id_t));
+  to_internal_cache_.Insert(external, *internal);
+  to_external_cache_.Insert(*internal, external);
+  return Status::OK();
+}
+
+Status RocksGraph::ToExternalId(node_id_t internal, node_id_t* external) {
+  if (!relabel_) {
+    *external = internal;
+    return Status::OK();
+  }
+  if (to_external_cache_.Lookup(internal, external)) return Status::OK();
+  std::string value;
+  Status s =
+      db_->Get(ReadOptions(), id_map_cf_, IdMapKey('i', internal), &value);
+  if (!s.ok()) return s;
+  std::memcpy(external, value.data(), sizeof(node_id_t));
+  to_external_cache_.Insert(internal, *external);
+  return Status::OK();
+}
+
+namespace {
+// Sorts by neighbor id, permuting the attributes along.
+void SortEdgeList(Edge* nxts, EdgeAttr* attrs, uint32_t num) {
+  if (attrs == NULL) {
+    std::sort(nxts, nxts + num,
+              [](const Edge& a, const Edge& b) { return a.nxt < b.nxt; });
+    return;
+  }
+  std::vector<uint32_t> order(num);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [nxts](uint32_t a, uint32_t b) {
+    return nxts[a].nxt < nxts[b].nxt;
+  });
+  std::vector<Edge> sorted_nxts(num);
+  std::vector<EdgeAttr> sorted_attrs(num);
+  for (uint32_t i = 0; i < num; i++) {
+    sorted_nxts[i] = nxts[order[i]];
+    sorted_attrs[i] = attrs[order[i]];
+  }
+  std::copy(sorted_nxts.begin(), sorted_nxts.end(), nxts);
+  std::copy(sorted_attrs.begin(), sorted_attrs.end(), attrs);
+}
+}  // namespace
+
+Status RocksGraph::TranslateEdges(Edges* edges) {
+  for (uint32_t i = 0; i < edges->num_edges_out; i++) {
+    Status s = ToExternalId(edges->nxts_out[i].nxt, &edges->nxts_out[i].nxt);
+    if (!s.ok()) return s;
+  }
+  for (uint32_t i = 0; i < edges->num_edges_in; i++) {
+    Status s = ToExternalId(edges->nxts_in[i].nxt, &edges->nxts_in[i].nxt);
+    if (!s.ok()) return s;
+  }
+  SortEdgeList(edges->nxts_out, edges->attrs_out, edges->num_edges_out);
+  SortEdgeList(edges->nxts_in, edges->attrs_in, edges->num_edges_in);
+  return Status::OK();
+}
+
+Status RocksGraph::SetIdMapping(const std::vector<node_id_t>& order) {
+  if (relabel_ || n > 0) {
+    return Status::InvalidArgument("id mapping needs an empty graph");
+  }
+  const uint32_t kBatchSize = 4096;
+  WriteBatch batch;
+  Status s;
+  for (size_t r = 0; r < order.size(); r++) {
+    s = WriteIdMapping(&batch, order[r], RankToLocalityId(r, order.size()));
+    if (s.ok() && batch.Count() >= kBatchSize) {
+      s = db_->Write(WriteOptions(), &batch);
+      batch.Clear();
+    }
+    if (!s.ok()) return s;
+  }
+  node_id_t next = LocalityIdLimit(order.size());
+  s = batch.Put(id_map_cf_, kIdMapNextKey, IdMapValue(next));
+  if (s.ok()) s = db_->Write(WriteOptions(), &batch);
+  if (!s.ok()) return s;
+  next_internal_id_ = next;
+  to_internal_cache_.Clear();
+  to_external_cache_.Clear();
+  relabel_ = true;
+  return Status::OK();
+}
+
+Status RocksGraph::BulkLoadRelabeled(
+    const std::vector<std::pair<node_id_t, node_id_t>>& edges,
+    int order_type) {
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported(
+        "BulkLoadRelabeled needs one adjacency key per vertex");
+  }
+  std::vector<node_id_t> order = ComputeVertexOrder(edges, order_type);
+  Status s = SetIdMapping(order);
+  if (!s.ok()) return s;
+  std::unordered_map<node_id_t, size_t> rank;
+  rank.reserve(order.size());
+  for (size_t r = 0; r < order.size(); r++) rank[order[r]] = r;
+  auto internal = [&order](size_t r) {
+    return static_cast<node_id_t>(RankToLocalityId(r, order.size()));
+  };
+  std::vector<std::vector<node_id_t>> outs(order.size()), ins(order.size());
+  for (const auto& e : edges) {
+    size_t from = rank[e.first], to = rank[e.second];
+    outs[from].push_back(internal(to));
+    // undirected graphs keep both endpoints in one symmetric list
+    (is_directed_ ? ins : outs)[to].push_back(internal(from));
+  }
+
+  // ranks follow key order, so the batches below append to the key space
+  const size_t kBatchSize = 1024;
+  WriteBatch batch;
+  for (size_t r = 0; r < order.size(); r++) {
+    std::vector<node_id_t>& out = outs[r];
+    std::vector<node_id_t>& in = ins[r];
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    std::sort(in.begin(), in.end());
+    in.erase(std::unique(in.begin(), in.end()), in.end());
+    Edges list{.num_edges_out = static_cast<uint32_t>(out.size()),
+               .num_edges_in = static_cast<uint32_t>(in.size())};
+    list.nxts_out = new Edge[list.num_edges_out];
+    list.nxts_in = new Edge[list.num_edges_in];
+    for (uint32_t i = 0; i < list.num_edges_out; i++) {
+      list.nxts_out[i].nxt = out[i];
+    }
+    for (uint32_t i = 0; i < list.num_edges_in; i++) {
+      list.nxts_in[i].nxt = in[i];
+    }
+    node_id_t id = internal(r);
+    std::string key, value;
+    encode_node(VertexKey{.id = id}, &key);
+    encode_edges(&list, &value, encoding_type_);
+    free_edges(&list);
+    batch.Put(adj_cf_, key, value);
+    batch.Put(edge_prop_cf_, key, "");
+    batch.Put(vertex_prop_cf_, key, "");
+    n++;
+    m += static_cast<node_id_t>(
+        is_directed_ ? out.size()
+                     : out.end() - std::lower_bound(out.begin(), out.end(), id));
+    for (size_t i = 0; i < out.size() + in.size(); i++) CountDegree(id);
+    std::vector<node_id_t>().swap(out);
+    std::vector<node_id_t>().swap(in);
+    if ((r + 1) % kBatchSize == 0 || r + 1 == order.size()) {
+      s = WriteGraph(&batch);
+      if (!s.ok()) return s;
+      batch.Clear();
+    }
+  }
+  return Status::OK();
 }
 
 // node_id_t RocksGraph::GetOutDegreeApproximate(node_id_t src,
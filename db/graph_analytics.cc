@@ -0,0 +1,376 @@
+#include "rocksdb/graph_analytics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+#include "db/graph_set_ops.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+namespace {
+
+// Runs fn(begin, end) over [0, n) in chunks pulled from a shared counter so
+// skewed degree distributions still balance across threads.
+template <typename F>
+void ParallelFor(int num_threads, size_t n, const F& fn) {
+  size_t chunk = std::max<size_t>(1024, n / (num_threads * 16 + 1));
+  if (num_threads == 1 || n <= chunk) {
+    fn(0, n);
+    return;
+  }
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t begin = next.fetch_add(chunk); begin < n;
+         begin = next.fetch_add(chunk)) {
+      fn(begin, std::min(begin + chunk, n));
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int t = 0; t < num_threads; t++) {
+    workers.emplace_back(worker);
+  }
+  for (auto& w : workers) w.join();
+}
+
+template <typename F>
+double ParallelSum(int num_threads, size_t n, const F& fn) {
+  std::mutex mu;
+  double total = 0;
+  ParallelFor(num_threads, n, [&](size_t begin, size_t end) {
+    double local = 0;
+    for (size_t i = begin; i < end; i++) local += fn(i);
+    std::lock_guard<std::mutex> lock(mu);
+    total += local;
+  });
+  return total;
+}
+
+// Adjacency collected by one scan thread before it is stitched into the CSR.
+struct ScanBuffer {
+  std::vector<node_id_t> ids;
+  std::vector<uint32_t> out_degrees;
+  std::vector<uint32_t> in_degrees;
+  std::vector<node_id_t> out_neighbors;
+  std::vector<node_id_t> in_neighbors;
+};
+
+std::atomic<uint64_t> scan_generation{0};
+
+// Source vertices per PageRank pull segment: 256K contributions (2 MB of
+// doubles) stay resident in a typical last-level cache slice.
+const size_t kPageRankSegment = 256 * 1024;
+
+}  // namespace
+
+Status GraphAnalytics::LoadSnapshot() {
+  std::mutex mu;
+  std::vector<std::unique_ptr<ScanBuffer>> buffers;
+  const uint64_t generation = ++scan_generation;
+  Status s = graph_->ParallelScan(
+      [&](node_id_t id, EdgeListView& edges) {
+        // scan threads get a private buffer on their first vertex
+        thread_local uint64_t buffer_generation = 0;
+        thread_local ScanBuffer* buffer = nullptr;
+        if (buffer_generation != generation) {
+          std::lock_guard<std::mutex> lock(mu);
+          buffers.emplace_back(new ScanBuffer());
+          buffer = buffers.back().get();
+          buffer_generation = generation;
+        }
+        buffer->ids.push_back(id);
+        buffer->out_degrees.push_back(edges.num_edges_out());
+        buffer->in_degrees.push_back(edges.num_edges_in());
+        for (uint32_t i = 0; i < edges.num_edges_out(); i++) {
+          buffer->out_neighbors.push_back(edges.out(i));
+        }
+        for (uint32_t i = 0; i < edges.num_edges_in(); i++) {
+          buffer->in_neighbors.push_back(edges.in(i));
+        }
+      },
+      num_threads_);
+  if (!s.ok()) return s;
+
+  // (id, buffer, index in buffer, offset of out list, offset of in list)
+  struct Slot {
+    node_id_t id;
+    uint32_t buffer;
+    size_t out_begin;
+    size_t in_begin;
+    uint32_t out_size;
+    uint32_t in_size;
+  };
+  std::vector<Slot> slots;
+  for (uint32_t b = 0; b < buffers.size(); b++) {
+    const ScanBuffer& buf = *buffers[b];
+    size_t out_pos = 0, in_pos = 0;
+    for (size_t i = 0; i < buf.ids.size(); i++) {
+      slots.push_back(Slot{buf.ids[i], b, out_pos, in_pos, buf.out_degrees[i],
+                           buf.in_degrees[i]});
+      out_pos += buf.out_degrees[i];
+      in_pos += buf.in_degrees[i];
+    }
+  }
+  std::sort(slots.begin(), slots.end(),
+            [](const Slot& a, const Slot& b) { return a.id < b.id; });
+  if (slots.size() > std::numeric_limits<dense_id_t>::max()) {
+    return Status::NotSupported("too many vertices for a dense snapshot");
+  }
+
+  csr_ = GraphCSR();
+  const dense_id_t n = static_cast<dense_id_t>(slots.size());
+  csr_.num_vertices = n;
+  csr_.ids.resize(n);
+  for (dense_id_t d = 0; d < n; d++) csr_.ids[d] = slots[d].id;
+  const auto& ids = csr_.ids;
+  auto find_dense = [&ids](node_id_t id, dense_id_t* d) {
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) return false;
+    *d = static_cast<dense_id_t>(it - ids.begin());
+    return true;
+  };
+
+  // Two passes per direction: count the neighbors that map to a snapshot
+  // vertex, then fill. External lists are sorted, and renumbering preserves
+  // order, so the dense lists come out sorted too.
+  auto build = [&](bool out, std::vector<uint64_t>* offsets,
+                   std::vector<dense_id_t>* neighbors) {
+    offsets->assign(n + 1, 0);
+    ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+      dense_id_t d;
+      for (size_t v = begin; v < end; v++) {
+        const Slot& slot = slots[v];
+        const ScanBuffer& buf = *buffers[slot.buffer];
+        const node_id_t* list =
+            out ? buf.out_neighbors.data() + slot.out_begin
+                : buf.in_neighbors.data() + slot.in_begin;
+        uint32_t size = out ? slot.out_size : slot.in_size;
+        uint64_t count = 0;
+        for (uint32_t i = 0; i < size; i++) count += find_dense(list[i], &d);
+        (*offsets)[v + 1] = count;
+      }
+    });
+    for (dense_id_t v = 0; v < n; v++) (*offsets)[v + 1] += (*offsets)[v];
+    neighbors->resize((*offsets)[n]);
+    ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+      dense_id_t d;
+      for (size_t v = begin; v < end; v++) {
+        const Slot& slot = slots[v];
+        const ScanBuffer& buf = *buffers[slot.buffer];
+        const node_id_t* list =
+            out ? buf.out_neighbors.data() + slot.out_begin
+                : buf.in_neighbors.data() + slot.in_begin;
+        uint32_t size = out ? slot.out_size : slot.in_size;
+        uint64_t pos = (*offsets)[v];
+        for (uint32_t i = 0; i < size; i++) {
+          if (find_dense(list[i], &d)) (*neighbors)[pos++] = d;
+        }
+      }
+    });
+  };
+  build(true, &csr_.out_offsets, &csr_.out_neighbors);
+  if (graph_->is_directed_) {
+    build(false, &csr_.in_offsets, &csr_.in_neighbors);
+  } else {
+    // symmetric lists: every neighbor is both an in- and an out-neighbor
+    csr_.in_offsets = csr_.out_offsets;
+    csr_.in_neighbors = csr_.out_neighbors;
+  }
+  return Status::OK();
+}
+
+Status GraphAnalytics::PageRank(std::vector<double>* ranks, int max_iterations,
+                                double damping, double tolerance) {
+  const dense_id_t n = csr_.num_vertices;
+  ranks->assign(n, n > 0 ? 1.0 / n : 0.0);
+  if (n == 0) return Status::OK();
+  std::vector<double> contrib(n), next(n);
+  std::vector<uint64_t> cursor(n);
+  for (int iter = 0; iter < max_iterations; iter++) {
+    double dangling = ParallelSum(num_threads_, n, [&](size_t u) {
+      uint64_t deg = csr_.out_degree(static_cast<dense_id_t>(u));
+      contrib[u] = deg > 0 ? (*ranks)[u] / deg : 0;
+      return deg > 0 ? 0.0 : (*ranks)[u];
+    });
+    const double base = (1 - damping) / n + damping * dangling / n;
+    ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+      for (size_t v = begin; v < end; v++) {
+        next[v] = base;
+        cursor[v] = csr_.in_offsets[v];
+      }
+    });
+    // Pull in source segments so the contrib reads of one pass stay in
+    // cache; in-lists are sorted, so a per-vertex cursor resumes each list
+    // where the previous segment stopped.
+    for (size_t seg_begin = 0; seg_begin < n; seg_begin += kPageRankSegment) {
+      const dense_id_t seg_end = static_cast<dense_id_t>(
+          std::min<size_t>(seg_begin + kPageRankSegment, n));
+      ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+          uint64_t k = cursor[v];
+          const uint64_t k_end = csr_.in_offsets[v + 1];
+          double acc = 0;
+          for (; k < k_end && csr_.in_neighbors[k] < seg_end; k++) {
+            acc += contrib[csr_.in_neighbors[k]];
+          }
+          cursor[v] = k;
+          next[v] += damping * acc;
+        }
+      });
+    }
+    double delta = ParallelSum(num_threads_, n, [&](size_t v) {
+      return std::fabs(next[v] - (*ranks)[v]);
+    });
+    ranks->swap(next);
+    if (delta < tolerance) break;
+  }
+  return Status::OK();
+}
+
+Status GraphAnalytics::WeaklyConnectedComponents(
+    std::vector<node_id_t>* labels) {
+  const dense_id_t n = csr_.num_vertices;
+  // parent[x] <= x always holds, so every root is its component's minimum
+  std::vector<std::atomic<dense_id_t>> parent(n);
+  for (dense_id_t v = 0; v < n; v++) parent[v].store(v);
+  auto find = [&parent](dense_id_t x) {
+    for (;;) {
+      dense_id_t p = parent[x].load(std::memory_order_relaxed);
+      if (p == x) return x;
+      dense_id_t gp = parent[p].load(std::memory_order_relaxed);
+      // path halving
+      parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+      x = gp;
+    }
+  };
+  ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      for (uint64_t k = csr_.out_offsets[v]; k < csr_.out_offsets[v + 1];
+           k++) {
+        dense_id_t a = static_cast<dense_id_t>(v);
+        dense_id_t b = csr_.out_neighbors[k];
+        for (;;) {
+          a = find(a);
+          b = find(b);
+          if (a == b) break;
+          if (a < b) std::swap(a, b);
+          dense_id_t expected = a;
+          if (parent[a].compare_exchange_strong(expected, b)) break;
+        }
+      }
+    }
+  });
+  labels->resize(n);
+  ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      (*labels)[v] = csr_.ids[find(static_cast<dense_id_t>(v))];
+    }
+  });
+  return Status::OK();
+}
+
+Status GraphAnalytics::TriangleCount(uint64_t* total,
+                                     std::vector<uint64_t>* per_vertex) {
+  const dense_id_t n = csr_.num_vertices;
+  // Undirected degree: merge of the out and in lists without duplicates or
+  // self loops.
+  auto for_each_undirected = [this](dense_id_t v, auto&& fn) {
+    uint64_t i = csr_.out_offsets[v], i_end = csr_.out_offsets[v + 1];
+    uint64_t j = csr_.in_offsets[v], j_end = csr_.in_offsets[v + 1];
+    while (i < i_end || j < j_end) {
+      dense_id_t u;
+      if (j >= j_end ||
+          (i < i_end && csr_.out_neighbors[i] < csr_.in_neighbors[j])) {
+        u = csr_.out_neighbors[i++];
+      } else if (i >= i_end ||
+                 csr_.in_neighbors[j] < csr_.out_neighbors[i]) {
+        u = csr_.in_neighbors[j++];
+      } else {
+        u = csr_.out_neighbors[i++];
+        j++;
+      }
+      if (u != v) fn(u);
+    }
+  };
+  std::vector<uint64_t> degree(n);
+  ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      uint64_t d = 0;
+      for_each_undirected(static_cast<dense_id_t>(v), [&d](dense_id_t) { d++; });
+      degree[v] = d;
+    }
+  });
+  auto ranks_before = [&degree](dense_id_t a, dense_id_t b) {
+    return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+  };
+
+  // Keep only edges towards higher-ranked vertices; this bounds every
+  // oriented list by O(sqrt(m)) and counts each triangle exactly once.
+  std::vector<uint64_t> offsets(n + 1, 0);
+  ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      uint64_t d = 0;
+      dense_id_t dv = static_cast<dense_id_t>(v);
+      for_each_undirected(dv, [&](dense_id_t u) { d += ranks_before(dv, u); });
+      offsets[v + 1] = d;
+    }
+  });
+  for (dense_id_t v = 0; v < n; v++) offsets[v + 1] += offsets[v];
+  std::vector<dense_id_t> oriented(offsets[n]);
+  ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      uint64_t pos = offsets[v];
+      dense_id_t dv = static_cast<dense_id_t>(v);
+      for_each_undirected(dv, [&](dense_id_t u) {
+        if (ranks_before(dv, u)) oriented[pos++] = u;
+      });
+    }
+  });
+
+  std::vector<std::atomic<uint64_t>> counts(per_vertex ? n : 0);
+  for (auto& c : counts) c.store(0);
+  std::atomic<uint64_t> triangles{0};
+  ParallelFor(num_threads_, n, [&](size_t begin, size_t end) {
+    uint64_t local = 0;
+    for (size_t v = begin; v < end; v++) {
+      const dense_id_t* nv = oriented.data() + offsets[v];
+      const size_t sv = offsets[v + 1] - offsets[v];
+      for (size_t k = 0; k < sv; k++) {
+        const dense_id_t u = nv[k];
+        const dense_id_t* nu = oriented.data() + offsets[u];
+        const size_t su = offsets[u + 1] - offsets[u];
+        if (!per_vertex) {
+          local += IntersectCount(nv, sv, nu, su);
+          continue;
+        }
+        // per-vertex counts need the third vertex, so walk the merge
+        size_t i = 0, j = 0;
+        while (i < sv && j < su) {
+          if (nv[i] < nu[j]) {
+            i++;
+          } else if (nu[j] < nv[i]) {
+            j++;
+          } else {
+            counts[v].fetch_add(1, std::memory_order_relaxed);
+            counts[u].fetch_add(1, std::memory_order_relaxed);
+            counts[nv[i]].fetch_add(1, std::memory_order_relaxed);
+            local++;
+            i++;
+            j++;
+          }
+        }
+      }
+    }
+    triangles.fetch_add(local);
+  });
+  *total = triangles.load();
+  if (per_vertex) {
+    per_vertex->resize(n);
+    for (dense_id_t v = 0; v < n; v++) (*per_vertex)[v] = counts[v].load();
+  }
+  return Status::OK();
+}
+
+}  // namespace ROCKSDB_NAMESPACE
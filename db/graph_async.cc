@@ -0,0 +1,221 @@
+#include "rocksdb/graph_async.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace ROCKSDB_NAMESPACE {
+
+struct GraphAsyncReader::KHopState {
+  uint32_t hops;
+  uint32_t hop = 0;
+  std::vector<node_id_t>* reached;
+  Callback done;
+  std::unordered_set<node_id_t> seen;
+  // first vertex of the level being read
+  size_t level_begin = 0;
+  // out-neighbors of every frontier vertex, in frontier order, so levels are
+  // appended as KHop appends them whatever order the reads complete in
+  std::vector<std::vector<node_id_t>> lists;
+  std::mutex mu;
+  size_t pending = 0;
+  Status status;
+};
+
+GraphAsyncReader::GraphAsyncReader(RocksGraph* graph,
+                                   const GraphAsyncReadOptions& options)
+    : graph_(graph), options_(options) {
+  options_.num_threads = std::max<size_t>(options_.num_threads, 1);
+  options_.max_batch_size = std::max<size_t>(options_.max_batch_size, 1);
+  for (size_t i = 0; i < options_.num_threads; i++) {
+    workers_.emplace_back([this]() { Work(); });
+  }
+}
+
+GraphAsyncReader::~GraphAsyncReader() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void GraphAsyncReader::Submit(std::vector<Read>* reads) {
+  if (reads->empty()) return;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (Read& read : *reads) queue_.push_back(std::move(read));
+  }
+  reads->clear();
+  cv_.notify_all();
+}
+
+void GraphAsyncReader::Work() {
+  ReadOptions read_options;
+  read_options.async_io = options_.async_io;
+  read_options.optimize_multiget_for_io = options_.async_io;
+  std::vector<Read> batch;
+  std::vector<node_id_t> ids;
+  std::vector<PinnableSlice> values;
+  std::vector<EdgeListView> views;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_.wait(lock, [this]() {
+        return !queue_.empty() || (stop_ && running_ == 0);
+      });
+      if (queue_.empty()) break;
+      size_t n = std::min(queue_.size(), options_.max_batch_size);
+      for (size_t i = 0; i < n; i++) {
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+      running_ += n;
+    }
+    ids.clear();
+    for (const Read& read : batch) ids.push_back(read.id);
+    Status s = graph_->MultiGetAdjacency(read_options, ids, &values, &views);
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    reads_.fetch_add(batch.size(), std::memory_order_relaxed);
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (s.ok()) {
+        batch[i].done(s, &values[i], &views[i]);
+      } else {
+        batch[i].done(s, nullptr, nullptr);
+      }
+    }
+    size_t n = batch.size();
+    batch.clear();
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      running_ -= n;
+      if (!stop_ || running_ > 0 || !queue_.empty()) continue;
+    }
+    // the last reads are done; wake the workers waiting to exit
+    cv_.notify_all();
+  }
+}
+
+void GraphAsyncReader::GetAllEdgesAsync(node_id_t src, Edges* edges,
+                                        Callback done) {
+  edges->num_edges_out = 0;
+  edges->num_edges_in = 0;
+  if (graph_->edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    done(Status::NotSupported("Async reads need one key per vertex"));
+    return;
+  }
+  Status s = graph_->ToInternalId(src, &src);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+  RocksGraph* graph = graph_;
+  std::vector<Read> reads(1);
+  reads[0].id = src;
+  reads[0].done = [graph, edges, done](const Status& status,
+                                       const Slice* value,
+                                       EdgeListView* /*view*/) {
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+    if (value->empty()) {
+      done(Status::NotFound());
+      return;
+    }
+    decode_edges(edges, value->data(), value->size(), graph->encoding_type_);
+    done(graph->relabeled() ? graph->TranslateEdges(edges) : Status::OK());
+  };
+  Submit(&reads);
+}
+
+std::future<Status> GraphAsyncReader::GetAllEdgesAsync(node_id_t src,
+                                                       Edges* edges) {
+  auto promise = std::make_shared<std::promise<Status>>();
+  std::future<Status> result = promise->get_future();
+  GetAllEdgesAsync(src, edges,
+                   [promise](const Status& s) { promise->set_value(s); });
+  return result;
+}
+
+void GraphAsyncReader::KHopAsync(node_id_t start, uint32_t hops,
+                                 std::vector<node_id_t>* reached,
+                                 Callback done) {
+  reached->clear();
+  if (graph_->edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    done(Status::NotSupported("KHop needs one adjacency key per vertex"));
+    return;
+  }
+  Status s = graph_->ToInternalId(start, &start);
+  if (!s.ok()) {
+    done(s.IsNotFound() ? Status::OK() : s);
+    return;
+  }
+  auto state = std::make_shared<KHopState>();
+  state->hops = hops;
+  state->reached = reached;
+  state->done = std::move(done);
+  state->seen.insert(start);
+  reached->push_back(start);
+  ExpandLevel(state);
+}
+
+std::future<Status> GraphAsyncReader::KHopAsync(
+    node_id_t start, uint32_t hops, std::vector<node_id_t>* reached) {
+  auto promise = std::make_shared<std::promise<Status>>();
+  std::future<Status> result = promise->get_future();
+  KHopAsync(start, hops, reached,
+            [promise](const Status& s) { promise->set_value(s); });
+  return result;
+}
+
+void GraphAsyncReader::ExpandLevel(const std::shared_ptr<KHopState>& state) {
+  std::vector<node_id_t>* reached = state->reached;
+  if (!state->status.ok() || state->hop == state->hops ||
+      state->level_begin == reached->size()) {
+    Status s = state->status;
+    for (node_id_t& id : *reached) {
+      if (!s.ok()) break;
+      s = graph_->ToExternalId(id, &id);
+    }
+    state->done(s);
+    return;
+  }
+  size_t level_end = reached->size();
+  state->lists.assign(level_end - state->level_begin, {});
+  state->pending = state->lists.size();
+  std::vector<Read> reads(state->lists.size());
+  for (size_t i = 0; i < reads.size(); i++) {
+    reads[i].id = (*reached)[state->level_begin + i];
+    reads[i].done = [this, state, i](const Status& status,
+                                     const Slice* /*value*/,
+                                     EdgeListView* view) {
+      // decoded outside the state lock, so the reads of one level overlap
+      std::vector<node_id_t> list;
+      if (view) {
+        for (uint32_t j = 0; j < view->num_edges_out(); j++) {
+          node_id_t id = view->out(j);
+          if (id >= 0) list.push_back(id);
+        }
+      }
+      std::unique_lock<std::mutex> lock(state->mu);
+      if (!status.ok() && state->status.ok()) state->status = status;
+      state->lists[i].swap(list);
+      if (--state->pending > 0) return;
+      // last read of the level: append it in frontier order
+      state->level_begin = state->reached->size();
+      for (const auto& out : state->lists) {
+        for (node_id_t id : out) {
+          if (state->seen.insert(id).second) state->reached->push_back(id);
+        }
+      }
+      state->lists.clear();
+      state->hop++;
+      lock.unlock();
+      ExpandLevel(state);
+    };
+  }
+  Submit(&reads);
+}
+
+}  // namespace ROCKSDB_NAMESPACE
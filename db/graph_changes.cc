@@ -0,0 +1,249 @@
+#include "rocksdb/graph_changes.h"
+
+#include "util/coding.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+namespace {
+
+// Tag layout: magic, type, fixed64 src, fixed64 dst, fixed32 label. Tags
+// written before labels were reported end after dst.
+const char kGraphChangeMagic[] = "RGC";
+const size_t kGraphChangeMagicSize = sizeof(kGraphChangeMagic) - 1;
+const size_t kGraphChangeUnlabeledSize =
+    kGraphChangeMagicSize + 1 + 2 * sizeof(uint64_t);
+const size_t kGraphChangeRecordSize =
+    kGraphChangeUnlabeledSize + sizeof(uint32_t);
+
+// Collects the changes of one write batch, all still in storage ids.
+class ChangeCollector : public WriteBatch::Handler {
+ public:
+  ChangeCollector(const GraphChangeSource& source, SequenceNumber sequence)
+      : source_(source), sequence_(sequence) {}
+
+  void LogData(const Slice& blob) override {
+    if ((blob.size() != kGraphChangeRecordSize &&
+         blob.size() != kGraphChangeUnlabeledSize) ||
+        memcmp(blob.data(), kGraphChangeMagic, kGraphChangeMagicSize) != 0) {
+      return;
+    }
+    tagged_ = true;
+    const char* p = blob.data() + kGraphChangeMagicSize;
+    auto type = static_cast<GraphChangeType>(p[0]);
+    if (type < 0 || type >= kGraphChangeTypeMax) return;
+    node_id_t src = static_cast<node_id_t>(DecodeFixed64(p + 1));
+    node_id_t dst = static_cast<node_id_t>(DecodeFixed64(p + 9));
+    Add(&tags_, type, src, dst);
+    if (blob.size() == kGraphChangeRecordSize) {
+      tags_.back().label = DecodeFixed32(p + 17);
+    }
+  }
+
+  Status PutCF(uint32_t cf, const Slice& key, const Slice& value) override {
+    if (key.size() != sizeof(node_id_t)) return Status::OK();
+    node_id_t v = DecodeId(key);
+    if (cf == source_.adj_cf_id) {
+      // a full list: the vertex and its out-edges as of this write
+      Add(&adjacency_, kGraphChangeAddVertex, v);
+      AddEdges(v, value);
+    } else if (cf == source_.vertex_prop_cf_id && !value.empty()) {
+      std::string buf = value.ToString();
+      std::string::iterator it = buf.begin();
+      std::vector<Property> props;
+      decode_properties(it, props);
+      for (const Property& prop : props) {
+        Add(&properties_, kGraphChangeSetVertexProperty, v, 0, &prop);
+      }
+    } else if (cf == source_.edge_prop_cf_id) {
+      AddEdgeProperties(v, value);
+    }
+    return Status::OK();
+  }
+
+  Status MergeCF(uint32_t cf, const Slice& key, const Slice& value) override {
+    if (key.size() != sizeof(node_id_t)) return Status::OK();
+    node_id_t v = DecodeId(key);
+    if (cf == source_.adj_cf_id) {
+      AddEdges(v, value);
+    } else if (cf == source_.edge_prop_cf_id) {
+      AddEdgeProperties(v, value);
+    }
+    return Status::OK();
+  }
+
+  Status DeleteCF(uint32_t cf, const Slice& key) override {
+    if (cf == source_.adj_cf_id && key.size() == sizeof(node_id_t)) {
+      Add(&adjacency_, kGraphChangeDeleteVertex, DecodeId(key));
+    }
+    return Status::OK();
+  }
+
+  Status SingleDeleteCF(uint32_t cf, const Slice& key) override {
+    return DeleteCF(cf, key);
+  }
+
+  Status DeleteRangeCF(uint32_t /*cf*/, const Slice& /*begin*/,
+                       const Slice& /*end*/) override {
+    return Status::OK();
+  }
+
+  // Tags replace the decoded adjacency writes; property changes follow the
+  // structural ones.
+  void Finish(std::vector<GraphChange>* changes) {
+    std::vector<GraphChange>& structure = tagged_ ? tags_ : adjacency_;
+    for (GraphChange& change : structure) {
+      changes->push_back(std::move(change));
+    }
+    for (GraphChange& change : properties_) {
+      changes->push_back(std::move(change));
+    }
+  }
+
+ private:
+  static node_id_t DecodeId(const Slice& key) {
+    node_id_t id;
+    memcpy(&id, key.data(), sizeof(node_id_t));
+    return id;
+  }
+
+  void Add(std::vector<GraphChange>* changes, GraphChangeType type,
+           node_id_t src, node_id_t dst = 0, const Property* prop = nullptr) {
+    GraphChange change;
+    change.type = type;
+    change.sequence = sequence_;
+    change.src = src;
+    change.dst = dst;
+    if (prop) change.prop = *prop;
+    changes->push_back(std::move(change));
+  }
+
+  // Out-parts only: the in-parts are the reverse copies of the same edges.
+  // Undirected lists hold every edge twice, so only the copy at the smaller
+  // endpoint is reported.
+  void AddEdges(node_id_t v, const Slice& value) {
+    EdgeListView view(value.data(), value.size(), source_.encoding_type);
+    for (uint32_t i = 0; i < view.num_edges_out(); i++) {
+      node_id_t u = view.out(i);
+      bool deleted = u < 0;
+      if (deleted) u = -u - 1;
+      if (!source_.is_directed && u < v) continue;
+      Add(&adjacency_, deleted ? kGraphChangeDeleteEdge : kGraphChangeAddEdge,
+          v, u);
+    }
+  }
+
+  // Edge property values are a run of (neighbor, properties) entries.
+  void AddEdgeProperties(node_id_t v, const Slice& value) {
+    std::string buf = value.ToString();
+    std::string::iterator it = buf.begin();
+    while (buf.end() - it >= static_cast<ptrdiff_t>(sizeof(node_id_t))) {
+      node_id_t u = decode_id(it);
+      std::vector<Property> props;
+      decode_properties(it, props);
+      for (const Property& prop : props) {
+        Add(&properties_, kGraphChangeSetEdgeProperty, v, u, &prop);
+      }
+    }
+  }
+
+  const GraphChangeSource& source_;
+  SequenceNumber sequence_;
+  bool tagged_ = false;
+  std::vector<GraphChange> tags_;
+  std::vector<GraphChange> adjacency_;
+  std::vector<GraphChange> properties_;
+};
+
+}  // namespace
+
+const char* GraphChangeTypeName(GraphChangeType type) {
+  switch (type) {
+    case kGraphChangeAddVertex:
+      return "AddVertex";
+    case kGraphChangeDeleteVertex:
+      return "DeleteVertex";
+    case kGraphChangeAddEdge:
+      return "AddEdge";
+    case kGraphChangeDeleteEdge:
+      return "DeleteEdge";
+    case kGraphChangeSetVertexProperty:
+      return "SetVertexProperty";
+    case kGraphChangeSetEdgeProperty:
+      return "SetEdgeProperty";
+    case kGraphChangeAddLabeledEdge:
+      return "AddLabeledEdge";
+    case kGraphChangeDeleteLabeledEdge:
+      return "DeleteLabeledEdge";
+    default:
+      return "Unknown";
+  }
+}
+
+void PutGraphChangeRecord(WriteBatch* batch, GraphChangeType type,
+                          node_id_t src, node_id_t dst, edge_label_t label) {
+  batch->PutLogData(GraphChangeRecord(type, src, dst, label));
+}
+
+std::string GraphChangeRecord(GraphChangeType type, node_id_t src,
+                              node_id_t dst, edge_label_t label) {
+  std::string record(kGraphChangeMagic, kGraphChangeMagicSize);
+  record.push_back(static_cast<char>(type));
+  PutFixed64(&record, static_cast<uint64_t>(src));
+  PutFixed64(&record, static_cast<uint64_t>(dst));
+  PutFixed32(&record, label);
+  return record;
+}
+
+GraphChangeIterator::GraphChangeIterator(
+    std::unique_ptr<TransactionLogIterator>&& wal,
+    const GraphChangeSource& source, SequenceNumber since,
+    size_t max_batch_changes)
+    : wal_(std::move(wal)),
+      source_(source),
+      max_batch_changes_(max_batch_changes > 0 ? max_batch_changes : 1),
+      checkpoint_(since) {
+  Next();
+}
+
+void GraphChangeIterator::Next() {
+  changes_.clear();
+  valid_ = false;
+  while (status_.ok() && wal_ && wal_->Valid() &&
+         changes_.size() < max_batch_changes_) {
+    BatchResult batch = wal_->GetBatch();
+    SequenceNumber end = batch.sequence + batch.writeBatchPtr->Count();
+    // the first batch can start before the requested sequence
+    if (end > checkpoint_) {
+      size_t first = changes_.size();
+      ChangeCollector collector(source_, batch.sequence);
+      status_ = batch.writeBatchPtr->Iterate(&collector);
+      if (!status_.ok()) break;
+      collector.Finish(&changes_);
+      for (size_t i = first; status_.ok() && i < changes_.size(); i++) {
+        GraphChange& change = changes_[i];
+        status_ = source_.to_external(change.src, &change.src);
+        bool has_dst = change.type == kGraphChangeAddEdge ||
+                       change.type == kGraphChangeDeleteEdge ||
+                       change.type == kGraphChangeSetEdgeProperty ||
+                       change.type == kGraphChangeAddLabeledEdge ||
+                       change.type == kGraphChangeDeleteLabeledEdge;
+        if (status_.ok() && has_dst) {
+          status_ = source_.to_external(change.dst, &change.dst);
+        }
+      }
+      if (!status_.ok()) break;
+      checkpoint_ = end;
+    }
+    wal_->Next();
+  }
+  if (status_.ok() && wal_ && !wal_->Valid() && !wal_->status().ok()) {
+    status_ = wal_->status();
+  }
+  if (!status_.ok()) {
+    changes_.clear();
+    return;
+  }
+  valid_ = !changes_.empty();
+}
+
+}  // namespace ROCKSDB_NAMESPACE
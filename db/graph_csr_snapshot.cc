@@ -0,0 +1,175 @@
+#include "rocksdb/graph_csr_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+namespace ROCKSDB_NAMESPACE {
+
+Status CSRSnapshot::Open(Env* env, const std::string& path,
+                         std::unique_ptr<CSRSnapshot>* snapshot) {
+  uint64_t file_size = 0;
+  Status s = env->GetFileSize(path, &file_size);
+  if (!s.ok()) return s;
+  if (file_size < sizeof(CSRSnapshotHeader)) {
+    return Status::Corruption("CSR snapshot too small", path);
+  }
+  std::unique_ptr<CSRSnapshot> result(new CSRSnapshot());
+  EnvOptions env_options;
+  env_options.use_mmap_reads = true;
+  s = env->NewRandomAccessFile(path, &result->file_, env_options);
+  if (!s.ok()) return s;
+  // An mmap-backed file returns a slice into the mapping and leaves the
+  // scratch alone, so the header read tells whether the whole file can be
+  // served from the mapping.
+  CSRSnapshotHeader header_scratch;
+  Slice data;
+  s = result->file_->Read(0, sizeof(CSRSnapshotHeader), &data,
+                          reinterpret_cast<char*>(&header_scratch));
+  if (!s.ok()) return s;
+  if (data.data() != reinterpret_cast<const char*>(&header_scratch)) {
+    s = result->file_->Read(0, file_size, &data, nullptr);
+    if (!s.ok()) return s;
+  } else {
+    // no mapping: load the file piece by piece
+    const size_t kChunkSize = 4 << 20;
+    result->buffer_.reset(new char[file_size]);
+    uint64_t offset = 0;
+    for (; offset < file_size; offset += data.size()) {
+      size_t n = static_cast<size_t>(
+          std::min<uint64_t>(kChunkSize, file_size - offset));
+      char* dst = result->buffer_.get() + offset;
+      s = result->file_->Read(offset, n, &data, dst);
+      if (!s.ok()) return s;
+      if (data.empty()) break;
+      if (data.data() != dst) std::memcpy(dst, data.data(), data.size());
+    }
+    data = Slice(result->buffer_.get(), offset);
+  }
+  if (data.size() != file_size) {
+    return Status::Corruption("short read of CSR snapshot", path);
+  }
+
+  const char* p = data.data();
+  result->header_ = reinterpret_cast<const CSRSnapshotHeader*>(p);
+  const CSRSnapshotHeader& h = *result->header_;
+  if (h.magic != kCSRSnapshotMagic || h.version != kCSRSnapshotVersion) {
+    return Status::Corruption("not a CSR snapshot", path);
+  }
+  uint64_t expected_size =
+      sizeof(CSRSnapshotHeader) +
+      sizeof(node_id_t) * (h.num_vertices + h.num_out_edges + h.num_in_edges) +
+      sizeof(uint64_t) * 2 * (h.num_vertices + 1);
+  if (expected_size != file_size) {
+    return Status::Corruption("CSR snapshot size mismatch", path);
+  }
+  p += sizeof(CSRSnapshotHeader);
+  result->ids_ = reinterpret_cast<const node_id_t*>(p);
+  p += sizeof(node_id_t) * h.num_vertices;
+  result->out_offsets_ = reinterpret_cast<const uint64_t*>(p);
+  p += sizeof(uint64_t) * (h.num_vertices + 1);
+  result->out_neighbors_ = reinterpret_cast<const node_id_t*>(p);
+  p += sizeof(node_id_t) * h.num_out_edges;
+  result->in_offsets_ = reinterpret_cast<const uint64_t*>(p);
+  p += sizeof(uint64_t) * (h.num_vertices + 1);
+  result->in_neighbors_ = reinterpret_cast<const node_id_t*>(p);
+  *snapshot = std::move(result);
+  return Status::OK();
+}
+
+bool CSRSnapshot::Find(node_id_t id, uint64_t* index) const {
+  const node_id_t* end = ids_ + header_->num_vertices;
+  const node_id_t* it = std::lower_bound(ids_, end, id);
+  if (it == end || *it != id) return false;
+  *index = static_cast<uint64_t>(it - ids_);
+  return true;
+}
+
+void CSRSnapshot::GetEdges(uint64_t index, Edges* edges) const {
+  edges->num_edges_out = out_degree(index);
+  edges->num_edges_in = in_degree(index);
+  edges->nxts_out = new Edge[edges->num_edges_out];
+  edges->nxts_in = new Edge[edges->num_edges_in];
+  std::memcpy(edges->nxts_out, out_neighbors_ + out_offsets_[index],
+              edges->num_edges_out * sizeof(Edge));
+  std::memcpy(edges->nxts_in, in_neighbors_ + in_offsets_[index],
+              edges->num_edges_in * sizeof(Edge));
+}
+
+Status CSRSnapshot::Export(DB* db, ColumnFamilyHandle* adj_cf,
+                           const Snapshot* db_snapshot, int encoding_type,
+                           Env* env, const std::string& path) {
+  // Keys are stored little-endian, so iteration order is not id order;
+  // collect everything, then emit the sections through an id-sorted
+  // permutation.
+  std::vector<node_id_t> ids;
+  std::vector<uint64_t> out_begin, in_begin;
+  std::vector<node_id_t> out_neighbors, in_neighbors;
+  ReadOptions read_options;
+  read_options.snapshot = db_snapshot;
+  read_options.fill_cache = false;
+  read_options.readahead_size = 2 * 1024 * 1024;
+  std::unique_ptr<Iterator> it(db->NewIterator(read_options, adj_cf));
+  EdgeListView view;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    Slice key = it->key();
+    if (key.size() != sizeof(node_id_t)) continue;
+    node_id_t id;
+    std::memcpy(&id, key.data(), sizeof(node_id_t));
+    view.Reset(it->value().data(), it->value().size(), encoding_type);
+    ids.push_back(id);
+    out_begin.push_back(out_neighbors.size());
+    in_begin.push_back(in_neighbors.size());
+    for (uint32_t i = 0; i < view.num_edges_out(); i++) {
+      out_neighbors.push_back(view.out(i));
+    }
+    for (uint32_t i = 0; i < view.num_edges_in(); i++) {
+      in_neighbors.push_back(view.in(i));
+    }
+  }
+  if (!it->status().ok()) return it->status();
+  out_begin.push_back(out_neighbors.size());
+  in_begin.push_back(in_neighbors.size());
+
+  std::vector<size_t> order(ids.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&ids](size_t a, size_t b) { return ids[a] < ids[b]; });
+
+  std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out) return Status::IOError("cannot create CSR snapshot", tmp_path);
+    CSRSnapshotHeader header{};
+    header.magic = kCSRSnapshotMagic;
+    header.version = kCSRSnapshotVersion;
+    header.sequence = db_snapshot->GetSequenceNumber();
+    header.num_vertices = ids.size();
+    header.num_out_edges = out_neighbors.size();
+    header.num_in_edges = in_neighbors.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t v : order) {
+      out.write(reinterpret_cast<const char*>(&ids[v]), sizeof(node_id_t));
+    }
+    auto write_section = [&](const std::vector<uint64_t>& begin,
+                             const std::vector<node_id_t>& neighbors) {
+      uint64_t offset = 0;
+      out.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+      for (size_t v : order) {
+        offset += begin[v + 1] - begin[v];
+        out.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+      }
+      for (size_t v : order) {
+        out.write(reinterpret_cast<const char*>(neighbors.data() + begin[v]),
+                  (begin[v + 1] - begin[v]) * sizeof(node_id_t));
+      }
+    };
+    write_section(out_begin, out_neighbors);
+    write_section(in_begin, in_neighbors);
+    if (!out) return Status::IOError("failed writing CSR snapshot", tmp_path);
+  }
+  return env->RenameFile(tmp_path, path);
+}
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,252 @@
+#include "rocksdb/graph_edge_filter.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+#include "db/column_family.h"
+#include "db/db_impl/db_impl.h"
+#include "db/version_set.h"
+#include "file/filename.h"
+#include "file/random_access_file_reader.h"
+#include "rocksdb/filter_policy.h"
+#include "table/block_based/block_based_table_builder.h"
+#include "table/block_based/filter_policy_internal.h"
+#include "table/format.h"
+#include "table/meta_blocks.h"
+#include "util/cast_util.h"
+#include "util/coding.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+const std::string kEdgeFilterBlockName = "rocksgraph.edge.filter";
+
+namespace {
+
+// stands for every neighbor of a vertex whose list is in a blob file
+constexpr node_id_t kAnyNeighbor = std::numeric_limits<node_id_t>::min();
+
+std::string EdgeFilterKey(node_id_t from, node_id_t to) {
+  std::string key;
+  PutFixed64(&key, static_cast<uint64_t>(from));
+  PutFixed64(&key, static_cast<uint64_t>(to));
+  return key;
+}
+
+class EdgeFilterCollector : public TablePropertiesCollector {
+ public:
+  EdgeFilterCollector(int encoding_type, double bits_per_key,
+                      int level_at_creation)
+      : encoding_type_(encoding_type),
+        // Bloom for flushed files, which are compacted away soon; the
+        // smaller Ribbon for everything below L0
+        policy_(NewRibbonFilterPolicy(bits_per_key, 1)) {
+    FilterBuildingContext context(table_options_);
+    context.level_at_creation = level_at_creation;
+    builder_.reset(policy_->GetBuilderWithContext(context));
+  }
+
+  Status AddUserKey(const Slice& key, const Slice& value, EntryType type,
+                    SequenceNumber /*seq*/, uint64_t /*file_size*/) override {
+    if (!usable_) return Status::OK();
+    if (type == kEntryDelete || type == kEntrySingleDelete) {
+      return Status::OK();
+    }
+    if (type == kEntryBlobIndex && key.size() == sizeof(node_id_t)) {
+      builder_->AddKey(EdgeFilterKey(decode_node(key),
+                                     kAnyNeighbor));
+      return Status::OK();
+    }
+    // hashed FULL_LAZY keys carry no decodable list
+    if ((type != kEntryPut && type != kEntryMerge) ||
+        key.size() != sizeof(node_id_t)) {
+      usable_ = false;
+      return Status::OK();
+    }
+    node_id_t from = decode_node(key);
+    EdgeListView view(value.data(), value.size(), encoding_type_);
+    for (uint32_t i = 0; i < view.num_edges_out(); i++) {
+      node_id_t to = view.out(i);
+      // lazy deletes, encoded as -(id + 1), never make an edge exist
+      if (to < 0) continue;
+      builder_->AddKey(EdgeFilterKey(from, to));
+      num_edges_++;
+    }
+    return Status::OK();
+  }
+
+  Status FinishMetaBlocks(
+      std::vector<std::pair<std::string, std::string>>* blocks) override {
+    if (!usable_ || !builder_) return Status::OK();
+    std::unique_ptr<const char[]> buf;
+    Slice filter = builder_->Finish(&buf);
+    blocks->emplace_back(kEdgeFilterBlockName, filter.ToString());
+    return Status::OK();
+  }
+
+  Status Finish(UserCollectedProperties* /*properties*/) override {
+    return Status::OK();
+  }
+
+  UserCollectedProperties GetReadableProperties() const override {
+    return {{kEdgeFilterBlockName + ".edges", std::to_string(num_edges_)}};
+  }
+
+  const char* Name() const override { return "EdgeFilterCollector"; }
+
+ private:
+  int encoding_type_;
+  BlockBasedTableOptions table_options_;
+  std::unique_ptr<const FilterPolicy> policy_;
+  std::unique_ptr<FilterBitsBuilder> builder_;
+  uint64_t num_edges_ = 0;
+  bool usable_ = true;
+};
+
+class EdgeFilterCollectorFactory : public TablePropertiesCollectorFactory {
+ public:
+  EdgeFilterCollectorFactory(int encoding_type, double bits_per_key)
+      : encoding_type_(encoding_type), bits_per_key_(bits_per_key) {}
+
+  TablePropertiesCollector* CreateTablePropertiesCollector(
+      TablePropertiesCollectorFactory::Context context) override {
+    return new EdgeFilterCollector(encoding_type_, bits_per_key_,
+                                   context.level_at_creation);
+  }
+
+  const char* Name() const override { return "EdgeFilterCollectorFactory"; }
+
+ private:
+  int encoding_type_;
+  double bits_per_key_;
+};
+
+}  // namespace
+
+std::shared_ptr<TablePropertiesCollectorFactory> NewEdgeFilterCollectorFactory(
+    int encoding_type, double bits_per_key) {
+  return std::make_shared<EdgeFilterCollectorFactory>(encoding_type,
+                                                      bits_per_key);
+}
+
+struct EdgeFilterCache::FileFilter {
+  // empty, with no reader, for a file written without the filter
+  std::string data;
+  std::unique_ptr<FilterBitsReader> reader;
+
+  bool MayMatch(node_id_t from, node_id_t to) const {
+    if (!reader) return true;
+    return reader->MayMatch(EdgeFilterKey(from, to)) ||
+           reader->MayMatch(EdgeFilterKey(from, kAnyNeighbor));
+  }
+};
+
+EdgeFilterCache::EdgeFilterCache(DB* db, ColumnFamilyHandle* adj_cf)
+    : db_(db), adj_cf_(adj_cf) {}
+
+EdgeFilterCache::~EdgeFilterCache() {}
+
+bool EdgeFilterCache::EdgeMayExist(node_id_t from, node_id_t to) {
+  std::string key;
+  encode_node(VertexKey{.id = from}, &key);
+  auto db_impl = static_cast_with_check<DBImpl>(db_->GetRootDB());
+  ColumnFamilyData* cfd =
+      static_cast_with_check<ColumnFamilyHandleImpl>(adj_cf_)->cfd();
+  // memtables and files of one super version, so a flush between the two
+  // checks cannot hide a write
+  SuperVersion* sv = db_impl->GetAndRefSuperVersion(cfd);
+  SequenceNumber seq;
+  bool found = false, is_blob_index = false;
+  Status s = db_impl->GetLatestSequenceForKey(
+      sv, key, true /* cache_only */, 0 /* lower_bound_seq */, &seq,
+      nullptr /* timestamp */, &found, &is_blob_index);
+  bool may_exist = !s.ok() || found;
+
+  const Comparator* ucmp = cfd->user_comparator();
+  const VersionStorageInfo* vstorage = sv->current->storage_info();
+  size_t num_files = 0;
+  for (int level = 0; level < vstorage->num_non_empty_levels(); level++) {
+    const std::vector<FileMetaData*>& files = vstorage->LevelFiles(level);
+    num_files += files.size();
+    std::vector<const FileMetaData*> candidates;
+    if (level == 0) {
+      for (const FileMetaData* f : files) {
+        if (ucmp->Compare(key, f->smallest.user_key()) >= 0 &&
+            ucmp->Compare(key, f->largest.user_key()) <= 0) {
+          candidates.push_back(f);
+        }
+      }
+    } else {
+      auto it = std::lower_bound(
+          files.begin(), files.end(), key,
+          [ucmp](const FileMetaData* f, const std::string& k) {
+            return ucmp->Compare(f->largest.user_key(), k) < 0;
+          });
+      if (it != files.end() &&
+          ucmp->Compare(key, (*it)->smallest.user_key()) >= 0) {
+        candidates.push_back(*it);
+      }
+    }
+    for (size_t i = 0; !may_exist && i < candidates.size(); i++) {
+      const FileDescriptor& fd = candidates[i]->fd;
+      std::shared_ptr<FileFilter> filter =
+          GetFileFilter(fd.GetNumber(), fd.GetPathId(), fd.GetFileSize());
+      may_exist = !filter || filter->MayMatch(from, to);
+    }
+  }
+
+  // drop the filters of files compacted away
+  std::lock_guard<std::mutex> lock(mu_);
+  if (filters_.size() > 2 * num_files + 64) {
+    std::unordered_set<uint64_t> live;
+    for (int level = 0; level < vstorage->num_non_empty_levels(); level++) {
+      for (const FileMetaData* f : vstorage->LevelFiles(level)) {
+        live.insert(f->fd.GetNumber());
+      }
+    }
+    for (auto it = filters_.begin(); it != filters_.end();) {
+      it = live.count(it->first) ? std::next(it) : filters_.erase(it);
+    }
+  }
+  db_impl->ReturnAndCleanupSuperVersion(cfd, sv);
+  return may_exist;
+}
+
+std::shared_ptr<EdgeFilterCache::FileFilter> EdgeFilterCache::GetFileFilter(
+    uint64_t number, uint32_t path_id, uint64_t file_size) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = filters_.find(number);
+    if (it != filters_.end()) return it->second;
+  }
+  const ImmutableOptions& ioptions =
+      *static_cast_with_check<ColumnFamilyHandleImpl>(adj_cf_)
+           ->cfd()
+           ->ioptions();
+  std::string path = TableFileName(ioptions.cf_paths, number, path_id);
+  std::unique_ptr<FSRandomAccessFile> file;
+  IOStatus io_s =
+      ioptions.fs->NewRandomAccessFile(path, FileOptions(), &file, nullptr);
+  if (!io_s.ok()) return nullptr;
+  RandomAccessFileReader reader(std::move(file), path);
+  BlockContents contents;
+  Status s = ReadMetaBlock(&reader, nullptr /* prefetch_buffer */, file_size,
+                           kBlockBasedTableMagicNumber, ioptions,
+                           ReadOptions(), kEdgeFilterBlockName,
+                           BlockType::kMetaIndex, &contents);
+  auto filter = std::make_shared<FileFilter>();
+  if (s.ok()) {
+    filter->data = contents.data.ToString();
+    filter->reader.reset(
+        BuiltinFilterPolicy::GetBuiltinFilterBitsReader(filter->data));
+  } else if (!s.IsCorruption()) {
+    // a file without the block, or of another table format, reads as
+    // corruption and is remembered as unfiltered; other errors may pass
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  filters_[number] = filter;
+  return filter;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
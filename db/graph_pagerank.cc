@@ -0,0 +1,463 @@
+#include "rocksdb/graph_pagerank.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "rocksdb/graph_changes.h"
+#include "util/coding.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+namespace {
+
+// Sorts after every 8-byte vertex key and the meta key.
+const std::string kRankMetaKey = "meta";
+const std::string kRankKeyEnd(sizeof(node_id_t) + 1, '\xff');
+
+// State layout: fixed64 p bits, fixed64 r bits, fixed32 out, fixed32 in.
+const size_t kRankStateSize = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+uint64_t DoubleBits(double d) {
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return bits;
+}
+
+double BitsDouble(uint64_t bits) {
+  double d;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+// The ids in `after` missing from `before`; both sorted.
+std::vector<node_id_t> Difference(const std::vector<node_id_t>& after,
+                                  const std::vector<node_id_t>& before) {
+  std::vector<node_id_t> result;
+  std::set_difference(after.begin(), after.end(), before.begin(),
+                      before.end(), std::back_inserter(result));
+  return result;
+}
+
+}  // namespace
+
+IncrementalPageRank::IncrementalPageRank(RocksGraph* graph,
+                                         const IncrementalRankOptions& options)
+    : graph_(graph), options_(options) {
+  std::string value;
+  Status s = graph_->get_raw_db()->Get(ReadOptions(), graph_->get_rank_cf(),
+                                       kRankMetaKey, &value);
+  if (s.ok() && value.size() == sizeof(uint64_t)) {
+    num_vertices_ = DecodeFixed64(value.data());
+  }
+}
+
+IncrementalPageRank::~IncrementalPageRank() {
+  if (snapshot_) graph_->get_raw_db()->ReleaseSnapshot(snapshot_);
+}
+
+Status IncrementalPageRank::Rebuild() {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (graph_->edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported("FULL_LAZY graphs are not ranked");
+  }
+  DB* db = graph_->get_raw_db();
+  if (snapshot_) db->ReleaseSnapshot(snapshot_);
+  snapshot_ = db->GetSnapshot();
+  if (snapshot_ == nullptr) {
+    return Status::NotSupported("ranking needs DB snapshots");
+  }
+  checkpoint_ = snapshot_->GetSequenceNumber() + 1;
+  states_.clear();
+  out_lists_.clear();
+  num_vertices_ = 0;
+  fresh_ = true;
+
+  ReadOptions read_options;
+  read_options.snapshot = snapshot_;
+  read_options.fill_cache = false;
+  std::unique_ptr<Iterator> it(
+      db->NewIterator(read_options, db->DefaultColumnFamily()));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    if (it->key().size() != sizeof(node_id_t)) continue;
+    node_id_t id;
+    memcpy(&id, it->key().data(), sizeof(node_id_t));
+    EdgeListView view(it->value().data(), it->value().size(),
+                      graph_->encoding_type_);
+    std::vector<node_id_t>& out = out_lists_[id];
+    for (uint32_t i = 0; i < view.num_edges_out(); i++) {
+      if (view.out(i) >= 0) out.push_back(view.out(i));
+    }
+    RankState* state;
+    Status s = State(id, &state);
+    if (!s.ok()) {
+      Abandon();
+      return s;
+    }
+    state->out_degree = static_cast<uint32_t>(out.size());
+    if (graph_->is_directed_) {
+      for (uint32_t i = 0; i < view.num_edges_in(); i++) {
+        if (view.in(i) >= 0) state->in_degree++;
+      }
+    } else {
+      state->in_degree = state->out_degree;
+    }
+  }
+  Status s = it->status();
+  it.reset();
+  if (s.ok()) {
+    for (auto& entry : states_) Enqueue(entry.first, entry.second);
+    s = Push();
+  }
+  if (s.ok()) s = Flush({}, true);
+  fresh_ = false;
+  if (!s.ok()) {
+    Abandon();
+    return s;
+  }
+  rebuilds_++;
+  return s;
+}
+
+Status IncrementalPageRank::CatchUp() {
+  if (graph_->edge_update_policy_ == EDGE_UPDATE_FULL_LAZY) {
+    return Status::NotSupported("FULL_LAZY graphs are not ranked");
+  }
+  std::unique_lock<std::mutex> lock(mu_);
+  if (!snapshot_) {
+    lock.unlock();
+    return Rebuild();
+  }
+  DB* db = graph_->get_raw_db();
+  const Snapshot* next = db->GetSnapshot();
+  if (next == nullptr) {
+    return Status::NotSupported("ranking needs DB snapshots");
+  }
+  SequenceNumber until = next->GetSequenceNumber();
+
+  // A purged WAL shows up as a first batch past the checkpoint rather than
+  // as an error.
+  std::unique_ptr<GraphChangeIterator> changes;
+  Status s;
+  if (checkpoint_ <= until) {
+    std::unique_ptr<TransactionLogIterator> wal;
+    s = db->GetUpdatesSince(checkpoint_, &wal);
+    if (s.ok() && (!wal->Valid() || wal->GetBatch().sequence > checkpoint_)) {
+      s = Status::NotFound("change stream does not reach the checkpoint");
+    }
+    if (s.ok()) {
+      s = graph_->GetChangesSince(checkpoint_, &changes,
+                                  options_.max_batch_changes);
+    }
+  }
+  if (!s.ok()) {
+    db->ReleaseSnapshot(next);
+    lock.unlock();
+    return Rebuild();
+  }
+
+  // Every vertex whose out-list may differ between the two snapshots.
+  std::unordered_set<node_id_t> touched;
+  for (; changes && changes->Valid(); changes->Next()) {
+    for (const GraphChange& change : changes->changes()) {
+      if (change.sequence > until) break;
+      bool vertex = change.type == kGraphChangeAddVertex ||
+                    change.type == kGraphChangeDeleteVertex;
+      bool edge = change.type == kGraphChangeAddEdge ||
+                  change.type == kGraphChangeDeleteEdge;
+      if (!vertex && !edge) continue;
+      // ids never mapped cannot have lists
+      node_id_t src, dst;
+      s = graph_->ToInternalId(change.src, &src);
+      if (s.IsNotFound()) {
+        s = Status::OK();
+        continue;
+      }
+      if (!s.ok()) break;
+      touched.insert(src);
+      if (vertex) {
+        // the lists that held the vertex lose it too
+        std::vector<node_id_t> out, in;
+        bool exists;
+        s = ReadLists(snapshot_, src, &out, &in, &exists);
+        if (!s.ok()) break;
+        touched.insert(in.begin(), in.end());
+        if (!graph_->is_directed_) touched.insert(out.begin(), out.end());
+      } else if (!graph_->is_directed_) {
+        s = graph_->ToInternalId(change.dst, &dst);
+        if (s.IsNotFound()) {
+          s = Status::OK();
+          continue;
+        }
+        if (!s.ok()) break;
+        touched.insert(dst);
+      }
+    }
+    if (!s.ok()) break;
+  }
+  if (s.ok() && changes) s = changes->status();
+  if (!s.ok()) {
+    db->ReleaseSnapshot(next);
+    return s;
+  }
+
+  std::unordered_set<node_id_t> deleted;
+  for (node_id_t id : touched) {
+    std::vector<node_id_t> before, after, in;
+    bool existed, exists;
+    s = ReadLists(snapshot_, id, &before, &in, &existed);
+    if (s.ok()) s = ReadLists(next, id, &after, &in, &exists);
+    if (s.ok()) s = Relink(id, before, after);
+    if (!s.ok()) {
+      db->ReleaseSnapshot(next);
+      Abandon();
+      return s;
+    }
+    if (!exists) {
+      deleted.insert(id);
+    } else {
+      out_lists_[id] = std::move(after);
+    }
+  }
+  db->ReleaseSnapshot(snapshot_);
+  snapshot_ = next;
+  checkpoint_ = until + 1;
+  s = Push();
+  if (s.ok()) s = Flush(deleted, false);
+  if (!s.ok()) Abandon();
+  return s;
+}
+
+Status IncrementalPageRank::GetScore(node_id_t id, double* score) {
+  Status s = graph_->ToInternalId(id, &id);
+  if (!s.ok()) return s;
+  std::string key, value;
+  encode_node(id, &key);
+  s = graph_->get_raw_db()->Get(ReadOptions(), graph_->get_rank_cf(), key,
+                                &value);
+  if (!s.ok()) return s;
+  if (value.size() != kRankStateSize) {
+    return Status::Corruption("bad rank state");
+  }
+  *score = BitsDouble(DecodeFixed64(value.data()));
+  return Status::OK();
+}
+
+Status IncrementalPageRank::GetDegreeCentrality(node_id_t id, int direction,
+                                                double* centrality) {
+  Status s = graph_->ToInternalId(id, &id);
+  if (!s.ok()) return s;
+  std::string key, value;
+  encode_node(id, &key);
+  s = graph_->get_raw_db()->Get(ReadOptions(), graph_->get_rank_cf(), key,
+                                &value);
+  if (!s.ok()) return s;
+  if (value.size() != kRankStateSize) {
+    return Status::Corruption("bad rank state");
+  }
+  uint64_t out_degree = DecodeFixed32(value.data() + 2 * sizeof(uint64_t));
+  uint64_t in_degree =
+      DecodeFixed32(value.data() + 2 * sizeof(uint64_t) + sizeof(uint32_t));
+  uint64_t degree = out_degree;
+  if (graph_->is_directed_ && direction == EDGE_DIRECTION_IN) {
+    degree = in_degree;
+  } else if (graph_->is_directed_ && direction == EDGE_DIRECTION_BOTH) {
+    degree = out_degree + in_degree;
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  uint64_t n = num_vertices_;
+  *centrality = n > 1 ? static_cast<double>(degree) / (n - 1) : 0;
+  return Status::OK();
+}
+
+void IncrementalPageRank::Abandon() {
+  if (snapshot_) graph_->get_raw_db()->ReleaseSnapshot(snapshot_);
+  snapshot_ = nullptr;
+  states_.clear();
+  out_lists_.clear();
+  queue_.clear();
+  queued_.clear();
+}
+
+Status IncrementalPageRank::ReadLists(const Snapshot* snapshot, node_id_t id,
+                                      std::vector<node_id_t>* out,
+                                      std::vector<node_id_t>* in,
+                                      bool* exists) {
+  out->clear();
+  in->clear();
+  ReadOptions read_options;
+  read_options.snapshot = snapshot;
+  std::string key, value;
+  encode_node(id, &key);
+  DB* db = graph_->get_raw_db();
+  Status s = db->Get(read_options, db->DefaultColumnFamily(), key, &value);
+  *exists = s.ok();
+  if (s.IsNotFound()) return Status::OK();
+  if (!s.ok()) return s;
+  EdgeListView view(value.data(), value.size(), graph_->encoding_type_);
+  for (uint32_t i = 0; i < view.num_edges_out(); i++) {
+    if (view.out(i) >= 0) out->push_back(view.out(i));
+  }
+  for (uint32_t i = 0; i < view.num_edges_in(); i++) {
+    if (view.in(i) >= 0) in->push_back(view.in(i));
+  }
+  // Relink diffs the lists
+  std::sort(out->begin(), out->end());
+  return Status::OK();
+}
+
+Status IncrementalPageRank::State(node_id_t id, RankState** state) {
+  auto found = states_.find(id);
+  if (found != states_.end()) {
+    *state = &found->second;
+    return Status::OK();
+  }
+  RankState loaded;
+  bool stored = false;
+  if (!fresh_) {
+    std::string key, value;
+    encode_node(id, &key);
+    Status s = graph_->get_raw_db()->Get(ReadOptions(), graph_->get_rank_cf(),
+                                         key, &value);
+    if (!s.ok() && !s.IsNotFound()) return s;
+    if (s.ok() && value.size() == kRankStateSize) {
+      const char* p = value.data();
+      loaded.p = BitsDouble(DecodeFixed64(p));
+      loaded.r = BitsDouble(DecodeFixed64(p + sizeof(uint64_t)));
+      loaded.out_degree = DecodeFixed32(p + 2 * sizeof(uint64_t));
+      loaded.in_degree =
+          DecodeFixed32(p + 2 * sizeof(uint64_t) + sizeof(uint32_t));
+      stored = true;
+    }
+  }
+  if (!stored) {
+    // an unseen vertex starts with its whole teleport mass unpushed
+    loaded.r = 1 - options_.damping;
+    num_vertices_++;
+  }
+  *state = &states_.emplace(id, loaded).first->second;
+  return Status::OK();
+}
+
+void IncrementalPageRank::Enqueue(node_id_t id, const RankState& state) {
+  if (std::fabs(state.r) <= options_.tolerance) return;
+  if (queued_.insert(id).second) queue_.push_back(id);
+}
+
+Status IncrementalPageRank::Relink(node_id_t id,
+                                   const std::vector<node_id_t>& before,
+                                   const std::vector<node_id_t>& after) {
+  RankState* state;
+  Status s = State(id, &state);
+  if (!s.ok()) return s;
+  std::vector<node_id_t> added = Difference(after, before);
+  std::vector<node_id_t> removed = Difference(before, after);
+  double old_share = 0, new_share = 0;
+  if (!before.empty()) {
+    old_share = options_.damping * state->p / before.size();
+    if (!after.empty()) {
+      // keep the share of the neighbors that stay
+      double p = state->p * after.size() / before.size();
+      state->r -= p - state->p;
+      state->p = p;
+      new_share = old_share;
+    }
+  } else if (!after.empty()) {
+    new_share = options_.damping * state->p / after.size();
+  }
+  state->out_degree = static_cast<uint32_t>(after.size());
+  if (!graph_->is_directed_) state->in_degree = state->out_degree;
+  Enqueue(id, *state);
+
+  for (int pass = 0; pass < 2; pass++) {
+    const std::vector<node_id_t>& neighbors = pass == 0 ? added : removed;
+    for (node_id_t u : neighbors) {
+      RankState* neighbor;
+      s = State(u, &neighbor);
+      if (!s.ok()) return s;
+      if (pass == 0) {
+        neighbor->r += new_share;
+        if (graph_->is_directed_) neighbor->in_degree++;
+      } else {
+        neighbor->r -= old_share;
+        if (graph_->is_directed_ && neighbor->in_degree > 0) {
+          neighbor->in_degree--;
+        }
+      }
+      Enqueue(u, *neighbor);
+    }
+  }
+  return Status::OK();
+}
+
+Status IncrementalPageRank::Push() {
+  while (!queue_.empty()) {
+    node_id_t id = queue_.front();
+    queue_.pop_front();
+    queued_.erase(id);
+    RankState* state;
+    Status s = State(id, &state);
+    if (!s.ok()) return s;
+    double r = state->r;
+    if (std::fabs(r) <= options_.tolerance) continue;
+    state->p += r;
+    state->r = 0;
+    pushes_++;
+    // dangling vertices drop the mass they would pass on
+    if (state->out_degree == 0) continue;
+    auto cached = out_lists_.find(id);
+    if (cached == out_lists_.end()) {
+      std::vector<node_id_t> out, in;
+      bool exists;
+      s = ReadLists(snapshot_, id, &out, &in, &exists);
+      if (!s.ok()) return s;
+      cached = out_lists_.emplace(id, std::move(out)).first;
+    }
+    if (cached->second.empty()) continue;
+    double share = options_.damping * r / cached->second.size();
+    for (node_id_t u : cached->second) {
+      RankState* neighbor;
+      s = State(u, &neighbor);
+      if (!s.ok()) return s;
+      neighbor->r += share;
+      Enqueue(u, *neighbor);
+    }
+  }
+  return Status::OK();
+}
+
+Status IncrementalPageRank::Flush(const std::unordered_set<node_id_t>& deleted,
+                                  bool reset) {
+  ColumnFamilyHandle* cf = graph_->get_rank_cf();
+  WriteBatch batch;
+  Status s;
+  if (reset) s = batch.DeleteRange(cf, Slice(), kRankKeyEnd);
+  for (auto& entry : states_) {
+    if (!s.ok()) break;
+    std::string key;
+    encode_node(entry.first, &key);
+    if (deleted.count(entry.first)) {
+      num_vertices_--;
+      s = batch.Delete(cf, key);
+      continue;
+    }
+    const RankState& state = entry.second;
+    std::string value;
+    PutFixed64(&value, DoubleBits(state.p));
+    PutFixed64(&value, DoubleBits(state.r));
+    PutFixed32(&value, state.out_degree);
+    PutFixed32(&value, state.in_degree);
+    s = batch.Put(cf, key, value);
+  }
+  if (s.ok()) {
+    std::string meta;
+    PutFixed64(&meta, num_vertices_);
+    s = batch.Put(cf, kRankMetaKey, meta);
+  }
+  states_.clear();
+  out_lists_.clear();
+  if (!s.ok()) return s;
+  return graph_->get_raw_db()->Write(WriteOptions(), &batch);
+}
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,182 @@
+#include "rocksdb/graph_partitioner.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+namespace ROCKSDB_NAMESPACE {
+
+namespace {
+
+size_t PartitionOfPosition(const std::vector<uint64_t>& positions,
+                           uint64_t position) {
+  return std::upper_bound(positions.begin(), positions.end(), position) -
+         positions.begin();
+}
+
+class VertexRangePartitioner : public SstPartitioner {
+ public:
+  explicit VertexRangePartitioner(
+      std::shared_ptr<const std::vector<uint64_t>> positions)
+      : positions_(std::move(positions)) {}
+
+  const char* Name() const override { return "VertexRangePartitioner"; }
+
+  PartitionerResult ShouldPartition(
+      const PartitionerRequest& request) override {
+    return Partition(*request.prev_user_key) !=
+                   Partition(*request.current_user_key)
+               ? kRequired
+               : kNotRequired;
+  }
+
+  bool CanDoTrivialMove(const Slice& smallest_user_key,
+                        const Slice& largest_user_key) override {
+    return Partition(smallest_user_key) == Partition(largest_user_key);
+  }
+
+ private:
+  size_t Partition(const Slice& key) const {
+    return PartitionOfPosition(*positions_, VertexKeyPosition(key));
+  }
+
+  std::shared_ptr<const std::vector<uint64_t>> positions_;
+};
+
+uint64_t IdPosition(node_id_t id) {
+  std::string key;
+  encode_node(id, &key);
+  return VertexKeyPosition(key);
+}
+
+}  // namespace
+
+uint64_t VertexKeyPosition(const Slice& key) {
+  uint64_t position = 0;
+  for (size_t i = 0; i < sizeof(node_id_t); i++) {
+    uint8_t byte = i < key.size() ? static_cast<uint8_t>(key[i]) : 0;
+    position = (position << 8) | byte;
+  }
+  return position;
+}
+
+VertexRangePartitionerFactory::VertexRangePartitionerFactory(
+    const std::vector<node_id_t>& boundaries) {
+  SetBoundaries(boundaries);
+}
+
+std::unique_ptr<SstPartitioner>
+VertexRangePartitionerFactory::CreatePartitioner(
+    const SstPartitioner::Context& /*context*/) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return std::unique_ptr<SstPartitioner>(
+      new VertexRangePartitioner(positions_));
+}
+
+void VertexRangePartitionerFactory::SetBoundaries(
+    const std::vector<node_id_t>& boundaries) {
+  std::vector<std::pair<uint64_t, node_id_t>> sorted;
+  for (node_id_t id : boundaries) sorted.emplace_back(IdPosition(id), id);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  auto positions = std::make_shared<std::vector<uint64_t>>();
+  std::vector<node_id_t> ids;
+  for (auto& boundary : sorted) {
+    positions->push_back(boundary.first);
+    ids.push_back(boundary.second);
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  boundaries_.swap(ids);
+  positions_ = std::move(positions);
+}
+
+std::vector<node_id_t> VertexRangePartitionerFactory::boundaries() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return boundaries_;
+}
+
+size_t VertexRangePartitionerFactory::PartitionOf(node_id_t id) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return PartitionOfPosition(*positions_, IdPosition(id));
+}
+
+std::shared_ptr<VertexRangePartitionerFactory>
+NewVertexRangePartitionerFactory(const std::vector<node_id_t>& boundaries) {
+  return std::make_shared<VertexRangePartitionerFactory>(boundaries);
+}
+
+Status ComputeVertexRangeBoundaries(RocksGraph* graph, uint32_t num_partitions,
+                                    bool degree_weighted,
+                                    std::vector<node_id_t>* boundaries) {
+  boundaries->clear();
+  if (num_partitions == 0) {
+    return Status::InvalidArgument("num_partitions must be positive");
+  }
+  DB* db = graph->get_raw_db();
+  ManagedSnapshot snapshot(db);
+  if (snapshot.snapshot() == nullptr) {
+    return Status::NotSupported("partitioning needs DB snapshots");
+  }
+  ReadOptions read_options;
+  read_options.snapshot = snapshot.snapshot();
+  read_options.fill_cache = false;
+
+  // Walks the vertices in key order as (id, weight) runs of keys sharing
+  // the vertex prefix.
+  auto for_each_vertex = [&](const std::function<void(node_id_t, uint64_t)>&
+                                 fn) {
+    std::unique_ptr<Iterator> it(
+        db->NewIterator(read_options, db->DefaultColumnFamily()));
+    bool open = false;
+    node_id_t current = 0;
+    uint64_t weight = 0;
+    EdgeListView view;
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      Slice key = it->key();
+      if (key.size() < sizeof(node_id_t)) continue;
+      node_id_t id;
+      memcpy(&id, key.data(), sizeof(node_id_t));
+      if (open && id != current) {
+        fn(current, weight);
+        weight = 0;
+      }
+      open = true;
+      current = id;
+      if (!degree_weighted) {
+        weight = 1;
+      } else if (key.size() == sizeof(node_id_t)) {
+        view.Reset(it->value().data(), it->value().size(),
+                   graph->encoding_type_);
+        weight += view.num_edges_out() + view.num_edges_in();
+      } else {
+        weight++;
+      }
+    }
+    if (open) fn(current, weight);
+    return it->status();
+  };
+
+  uint64_t total = 0;
+  Status s = for_each_vertex([&](node_id_t, uint64_t weight) {
+    total += weight;
+  });
+  if (!s.ok() || total == 0) return s;
+  // a boundary opens range k once the ranges before it hold k / n of the
+  // total
+  uint64_t seen = 0;
+  uint32_t next = 1;
+  s = for_each_vertex([&](node_id_t id, uint64_t weight) {
+    if (next < num_partitions && seen > 0 &&
+        seen * num_partitions >= total * next) {
+      boundaries->push_back(id);
+      while (next < num_partitions && seen * num_partitions >= total * next) {
+        next++;
+      }
+    }
+    seen += weight;
+  });
+  if (!s.ok()) boundaries->clear();
+  return s;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,42 @@
+#include "rocksdb/graph_perf_context.h"
+
+#include <sstream>
+
+namespace ROCKSDB_NAMESPACE {
+
+#define DEF_GRAPH_PERF_CONTEXT_METRICS(def) \
+  def(adj_list_read_count)                  \
+  def(adj_merge_operand_count)              \
+  def(max_adj_merge_operands)               \
+  def(adj_list_read_nanos)                  \
+  def(decoded_edge_count)                   \
+  def(efp_decode_nanos)                     \
+  def(eager_update_count)                   \
+  def(lazy_update_count)
+
+namespace {
+thread_local GraphPerfContext graph_perf_context;
+}  // namespace
+
+GraphPerfContext* get_graph_perf_context() { return &graph_perf_context; }
+
+void GraphPerfContext::Reset() {
+#define GRAPH_PERF_CONTEXT_RESET(counter) counter = 0;
+  DEF_GRAPH_PERF_CONTEXT_METRICS(GRAPH_PERF_CONTEXT_RESET)
+#undef GRAPH_PERF_CONTEXT_RESET
+}
+
+std::string GraphPerfContext::ToString(bool exclude_zero_counters) const {
+  std::ostringstream ss;
+#define GRAPH_PERF_CONTEXT_OUTPUT(counter)       \
+  if (!exclude_zero_counters || (counter > 0)) { \
+    ss << #counter << " = " << counter << ", ";  \
+  }
+  DEF_GRAPH_PERF_CONTEXT_METRICS(GRAPH_PERF_CONTEXT_OUTPUT)
+#undef GRAPH_PERF_CONTEXT_OUTPUT
+  std::string str = ss.str();
+  str.erase(str.find_last_not_of(", ") + 1);
+  return str;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
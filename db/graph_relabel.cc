@@ -0,0 +1,190 @@
+#include "rocksdb/graph_relabel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <queue>
+
+namespace ROCKSDB_NAMESPACE {
+
+namespace {
+
+// Undirected, deduplicated adjacency over vertices 0..ids.size()-1, where
+// ids[d] is the external id of dense vertex d.
+struct RelabelGraph {
+  std::vector<int64_t> ids;
+  std::vector<uint64_t> offsets;
+  std::vector<uint32_t> neighbors;
+
+  uint32_t num_vertices() const { return static_cast<uint32_t>(ids.size()); }
+  uint64_t degree(uint32_t v) const { return offsets[v + 1] - offsets[v]; }
+};
+
+void BuildRelabelGraph(const std::vector<std::pair<int64_t, int64_t>>& edges,
+                       RelabelGraph* g) {
+  g->ids.reserve(edges.size() * 2);
+  for (const auto& e : edges) {
+    g->ids.push_back(e.first);
+    g->ids.push_back(e.second);
+  }
+  std::sort(g->ids.begin(), g->ids.end());
+  g->ids.erase(std::unique(g->ids.begin(), g->ids.end()), g->ids.end());
+  auto dense = [g](int64_t id) {
+    return static_cast<uint32_t>(
+        std::lower_bound(g->ids.begin(), g->ids.end(), id) - g->ids.begin());
+  };
+  std::vector<std::pair<uint32_t, uint32_t>> arcs;
+  arcs.reserve(edges.size() * 2);
+  for (const auto& e : edges) {
+    uint32_t a = dense(e.first), b = dense(e.second);
+    if (a == b) continue;
+    arcs.emplace_back(a, b);
+    arcs.emplace_back(b, a);
+  }
+  std::sort(arcs.begin(), arcs.end());
+  arcs.erase(std::unique(arcs.begin(), arcs.end()), arcs.end());
+  g->offsets.assign(g->ids.size() + 1, 0);
+  for (const auto& a : arcs) g->offsets[a.first + 1]++;
+  for (size_t v = 0; v < g->ids.size(); v++) {
+    g->offsets[v + 1] += g->offsets[v];
+  }
+  g->neighbors.resize(arcs.size());
+  for (size_t i = 0; i < arcs.size(); i++) g->neighbors[i] = arcs[i].second;
+}
+
+std::vector<uint32_t> VerticesByDegree(const RelabelGraph& g,
+                                       bool descending) {
+  std::vector<uint32_t> order(g.num_vertices());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&g, descending](uint32_t a, uint32_t b) {
+                     return descending ? g.degree(a) > g.degree(b)
+                                       : g.degree(a) < g.degree(b);
+                   });
+  return order;
+}
+
+// BFS over every component; roots are taken in `roots` order and, with
+// by_degree, each vertex's unvisited neighbors are queued lowest degree
+// first (the Cuthill-McKee rule).
+std::vector<uint32_t> BreadthFirstOrder(const RelabelGraph& g,
+                                        const std::vector<uint32_t>& roots,
+                                        bool by_degree) {
+  std::vector<uint32_t> order;
+  order.reserve(g.num_vertices());
+  std::vector<bool> visited(g.num_vertices(), false);
+  std::vector<uint32_t> next;
+  for (uint32_t root : roots) {
+    if (visited[root]) continue;
+    visited[root] = true;
+    size_t head = order.size();
+    order.push_back(root);
+    while (head < order.size()) {
+      uint32_t v = order[head++];
+      next.clear();
+      for (uint64_t i = g.offsets[v]; i < g.offsets[v + 1]; i++) {
+        uint32_t u = g.neighbors[i];
+        if (!visited[u]) {
+          visited[u] = true;
+          next.push_back(u);
+        }
+      }
+      if (by_degree) {
+        std::stable_sort(next.begin(), next.end(), [&g](uint32_t a, uint32_t b) {
+          return g.degree(a) < g.degree(b);
+        });
+      }
+      order.insert(order.end(), next.begin(), next.end());
+    }
+  }
+  return order;
+}
+
+// Greedy Gorder: repeatedly place the vertex sharing the most edges with the
+// last kWindow placed vertices. Scores live in a lazy max-heap; neighbor
+// updates of hubs above sqrt(n) are skipped, which keeps the cost near
+// O(m log n) at a small loss in quality.
+std::vector<uint32_t> GreedyWindowOrder(const RelabelGraph& g) {
+  const size_t kWindow = 5;
+  uint32_t n = g.num_vertices();
+  uint64_t hub_degree =
+      std::max<uint64_t>(16, static_cast<uint64_t>(std::sqrt(double(n))));
+  std::vector<int64_t> score(n, 0);
+  std::vector<bool> placed(n, false);
+  std::priority_queue<std::pair<int64_t, uint32_t>> heap;
+  std::vector<uint32_t> by_degree = VerticesByDegree(g, true);
+  size_t degree_cursor = 0;
+  std::deque<uint32_t> window;
+  std::vector<uint32_t> order;
+  order.reserve(n);
+
+  auto adjust = [&](uint32_t v, int64_t delta) {
+    if (g.degree(v) > hub_degree) return;
+    for (uint64_t i = g.offsets[v]; i < g.offsets[v + 1]; i++) {
+      uint32_t u = g.neighbors[i];
+      if (placed[u]) continue;
+      score[u] += delta;
+      if (delta > 0) heap.emplace(score[u], u);
+    }
+  };
+
+  while (order.size() < n) {
+    uint32_t v = n;
+    while (!heap.empty()) {
+      auto top = heap.top();
+      heap.pop();
+      if (!placed[top.second] && score[top.second] == top.first &&
+          top.first > 0) {
+        v = top.second;
+        break;
+      }
+    }
+    if (v == n) {
+      while (placed[by_degree[degree_cursor]]) degree_cursor++;
+      v = by_degree[degree_cursor];
+    }
+    placed[v] = true;
+    order.push_back(v);
+    adjust(v, 1);
+    window.push_back(v);
+    if (window.size() > kWindow) {
+      adjust(window.front(), -1);
+      window.pop_front();
+    }
+  }
+  return order;
+}
+
+}  // namespace
+
+std::vector<int64_t> ComputeVertexOrder(
+    const std::vector<std::pair<int64_t, int64_t>>& edges, int order_type) {
+  RelabelGraph g;
+  BuildRelabelGraph(edges, &g);
+  std::vector<uint32_t> order;
+  switch (order_type) {
+    case RELABEL_ORDER_DEGREE:
+      order = VerticesByDegree(g, true);
+      break;
+    case RELABEL_ORDER_BFS:
+      order = BreadthFirstOrder(g, VerticesByDegree(g, true), false);
+      break;
+    case RELABEL_ORDER_RCM:
+      order = BreadthFirstOrder(g, VerticesByDegree(g, false), true);
+      std::reverse(order.begin(), order.end());
+      break;
+    case RELABEL_ORDER_GORDER:
+      order = GreedyWindowOrder(g);
+      break;
+    default:
+      order.resize(g.num_vertices());
+      std::iota(order.begin(), order.end(), 0);
+      break;
+  }
+  std::vector<int64_t> result(order.size());
+  for (size_t r = 0; r < order.size(); r++) result[r] = g.ids[order[r]];
+  return result;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,124 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "rocksdb/rocksdb_namespace.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// Sorted-set intersection kernels shared by the graph analytics and
+// neighborhood queries. Inputs must be strictly increasing.
+
+// When one side is much shorter, probing it into the longer side with an
+// exponential search beats a linear merge.
+const size_t kGallopRatio = 32;
+
+template <typename T>
+size_t inline GallopIntersectCount(const T* small, size_t ns, const T* large,
+                                   size_t nl) {
+  size_t count = 0;
+  size_t lo = 0;
+  for (size_t i = 0; i < ns && lo < nl; i++) {
+    size_t step = 1;
+    size_t hi = lo;
+    while (hi < nl && large[hi] < small[i]) {
+      lo = hi;
+      hi += step;
+      step <<= 1;
+    }
+    hi = std::min(hi + 1, nl);
+    lo = std::lower_bound(large + lo, large + hi, small[i]) - large;
+    if (lo < nl && large[lo] == small[i]) {
+      count++;
+      lo++;
+    }
+  }
+  return count;
+}
+
+template <typename T>
+size_t inline ScalarIntersectCount(const T* a, size_t na, const T* b,
+                                   size_t nb) {
+  size_t count = 0;
+  size_t i = 0, j = 0;
+  while (i < na && j < nb) {
+    // branch-free advance; both pointers move on a match
+    T x = a[i], y = b[j];
+    count += (x == y);
+    i += (x <= y);
+    j += (y <= x);
+  }
+  return count;
+}
+
+// |a ∩ b| for sorted 32-bit id lists. With AVX2, blocks of 8 are compared
+// all-to-all through lane rotations and the pointer whose block ends lower
+// advances, so each pair of blocks is visited at most once.
+size_t inline IntersectCount(const uint32_t* a, size_t na, const uint32_t* b,
+                             size_t nb) {
+  if (na > nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  if (na == 0) return 0;
+  if (nb / na >= kGallopRatio) return GallopIntersectCount(a, na, b, nb);
+  size_t count = 0;
+  size_t i = 0, j = 0;
+#ifdef __AVX2__
+  const __m256i rotate = _mm256_set_epi32(0, 7, 6, 5, 4, 3, 2, 1);
+  while (i + 8 <= na && j + 8 <= nb) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+    __m256i match = _mm256_cmpeq_epi32(va, vb);
+    for (int r = 1; r < 8; r++) {
+      vb = _mm256_permutevar8x32_epi32(vb, rotate);
+      match = _mm256_or_si256(match, _mm256_cmpeq_epi32(va, vb));
+    }
+    count += __builtin_popcount(
+        static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(match))));
+    uint32_t a_max = a[i + 7], b_max = b[j + 7];
+    i += (a_max <= b_max) ? 8 : 0;
+    j += (b_max <= a_max) ? 8 : 0;
+  }
+#endif
+  return count + ScalarIntersectCount(a + i, na - i, b + j, nb - j);
+}
+
+// |a ∩ b| for sorted 64-bit id lists, such as adjacency lists read in place.
+// With AVX2, blocks of 4 are compared all-to-all the same way.
+size_t inline IntersectCount(const int64_t* a, size_t na, const int64_t* b,
+                             size_t nb) {
+  if (na > nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  if (na == 0) return 0;
+  if (nb / na >= kGallopRatio) return GallopIntersectCount(a, na, b, nb);
+  size_t count = 0;
+  size_t i = 0, j = 0;
+#ifdef __AVX2__
+  while (i + 4 <= na && j + 4 <= nb) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+    __m256i match = _mm256_cmpeq_epi64(va, vb);
+    for (int r = 1; r < 4; r++) {
+      vb = _mm256_permute4x64_epi64(vb, 0x39);
+      match = _mm256_or_si256(match, _mm256_cmpeq_epi64(va, vb));
+    }
+    count += __builtin_popcount(
+        static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(match))));
+    int64_t a_max = a[i + 3], b_max = b[j + 3];
+    i += (a_max <= b_max) ? 4 : 0;
+    j += (b_max <= a_max) ? 4 : 0;
+  }
+#endif
+  return count + ScalarIntersectCount(a + i, na - i, b + j, nb - j);
+}
+
+}  // namespace ROCKSDB_NAMESPACE
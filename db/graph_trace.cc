@@ -0,0 +1,361 @@
+#include "rocksdb/graph_trace.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "trace_replay/trace_replay.h"
+#include "util/coding.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+namespace {
+
+const std::string kGraphTraceMagic = "rocksgraph_trace";
+const uint32_t kGraphTraceVersion = 2;
+// records buffered per replay thread before the reader blocks
+const size_t kMaxQueuedRecords = 4096;
+
+bool HasDst(GraphTraceOp op) {
+  switch (op) {
+    case kGraphTraceAddEdge:
+    case kGraphTraceAddEdgeLazy:
+    case kGraphTraceDeleteEdge:
+    case kGraphTraceAddEdgeProperty:
+    case kGraphTraceGetEdgeProperty:
+    case kGraphTraceHasEdge:
+    case kGraphTraceAddLabeledEdge:
+    case kGraphTraceDeleteLabeledEdge:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool HasLabel(GraphTraceOp op) {
+  return op == kGraphTraceAddLabeledEdge || op == kGraphTraceDeleteLabeledEdge;
+}
+
+bool HasProperty(GraphTraceOp op) {
+  return op == kGraphTraceAddVertexProperty ||
+         op == kGraphTraceAddEdgeProperty;
+}
+
+}  // namespace
+
+const char* GraphTraceOpName(GraphTraceOp op) {
+  switch (op) {
+    case kGraphTraceAddVertex:
+      return "add_vertex";
+    case kGraphTraceAddEdge:
+      return "add_edge";
+    case kGraphTraceAddEdgeLazy:
+      return "add_edge_lazy";
+    case kGraphTraceDeleteEdge:
+      return "delete_edge";
+    case kGraphTraceAddVertexProperty:
+      return "add_vertex_property";
+    case kGraphTraceAddEdgeProperty:
+      return "add_edge_property";
+    case kGraphTraceGetAllEdges:
+      return "get_all_edges";
+    case kGraphTraceGetOutDegree:
+      return "get_out_degree";
+    case kGraphTraceGetInDegree:
+      return "get_in_degree";
+    case kGraphTraceGetVertexProperty:
+      return "get_vertex_property";
+    case kGraphTraceGetEdgeProperty:
+      return "get_edge_property";
+    case kGraphTraceHasEdge:
+      return "has_edge";
+    case kGraphTraceDeleteVertex:
+      return "delete_vertex";
+    case kGraphTraceAddLabeledEdge:
+      return "add_labeled_edge";
+    case kGraphTraceDeleteLabeledEdge:
+      return "delete_labeled_edge";
+    default:
+      return "unknown";
+  }
+}
+
+bool IsGraphTraceWrite(GraphTraceOp op) {
+  return op <= kGraphTraceAddEdgeProperty || op == kGraphTraceDeleteVertex ||
+         HasLabel(op);
+}
+
+GraphTracer::GraphTracer(SystemClock* clock, const TraceOptions& trace_options,
+                         std::unique_ptr<TraceWriter>&& trace_writer)
+    : clock_(clock),
+      trace_options_(trace_options),
+      trace_writer_(std::move(trace_writer)) {}
+
+GraphTracer::~GraphTracer() { Close(); }
+
+Status GraphTracer::WriteHeader() {
+  Trace trace;
+  trace.ts = clock_->NowMicros();
+  trace.type = kTraceBegin;
+  PutLengthPrefixedSlice(&trace.payload, kGraphTraceMagic);
+  PutFixed32(&trace.payload, kGraphTraceVersion);
+  std::string encoded_trace;
+  TracerHelper::EncodeTrace(trace, &encoded_trace);
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!trace_writer_) return Status::Aborted("graph tracer closed");
+  return trace_writer_->Write(encoded_trace);
+}
+
+Status GraphTracer::Write(GraphTraceOp op, node_id_t src, node_id_t dst,
+                          const Property* prop, edge_label_t label) {
+  uint64_t filter_mask =
+      IsGraphTraceWrite(op) ? kTraceFilterWrite : kTraceFilterGet;
+  if (trace_options_.filter & filter_mask) return Status::OK();
+  Trace trace;
+  trace.ts = clock_->NowMicros();
+  trace.type = kGraphTrace;
+  trace.payload.push_back(static_cast<char>(op));
+  PutVarint64(&trace.payload, static_cast<uint64_t>(src));
+  if (HasDst(op)) PutVarint64(&trace.payload, static_cast<uint64_t>(dst));
+  if (HasProperty(op)) {
+    assert(prop != nullptr);
+    PutLengthPrefixedSlice(&trace.payload, prop->name);
+    PutLengthPrefixedSlice(&trace.payload, prop->value);
+  }
+  if (HasLabel(op)) PutVarint32(&trace.payload, label);
+  std::string encoded_trace;
+  TracerHelper::EncodeTrace(trace, &encoded_trace);
+
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!trace_writer_) return Status::OK();
+  if (++trace_request_count_ < trace_options_.sampling_frequency) {
+    return Status::OK();
+  }
+  trace_request_count_ = 0;
+  if (trace_writer_->GetFileSize() > trace_options_.max_trace_file_size) {
+    return Status::OK();
+  }
+  return trace_writer_->Write(encoded_trace);
+}
+
+Status GraphTracer::Close() {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!trace_writer_) return Status::OK();
+  Trace trace;
+  trace.ts = clock_->NowMicros();
+  trace.type = kTraceEnd;
+  std::string encoded_trace;
+  TracerHelper::EncodeTrace(trace, &encoded_trace);
+  Status s = trace_writer_->Write(encoded_trace);
+  Status close_status = trace_writer_->Close();
+  trace_writer_.reset();
+  return s.ok() ? close_status : s;
+}
+
+GraphTraceReader::GraphTraceReader(std::unique_ptr<TraceReader>&& reader)
+    : trace_reader_(std::move(reader)) {}
+
+Status GraphTraceReader::ReadHeader(uint64_t* start_time) {
+  std::string encoded_trace;
+  Status s = trace_reader_->Read(&encoded_trace);
+  if (!s.ok()) return s;
+  Trace trace;
+  s = TracerHelper::DecodeTrace(encoded_trace, &trace);
+  if (!s.ok()) return s;
+  Slice payload(trace.payload);
+  Slice magic;
+  uint32_t version;
+  if (trace.type != kTraceBegin || !GetLengthPrefixedSlice(&payload, &magic) ||
+      magic.ToString() != kGraphTraceMagic) {
+    return Status::Corruption("not a graph trace");
+  }
+  if (!GetFixed32(&payload, &version) || version > kGraphTraceVersion) {
+    return Status::NotSupported("unknown graph trace version");
+  }
+  *start_time = trace.ts;
+  return Status::OK();
+}
+
+Status GraphTraceReader::Read(GraphTraceRecord* record) {
+  std::string encoded_trace;
+  Status s = trace_reader_->Read(&encoded_trace);
+  if (!s.ok()) return s;
+  Trace trace;
+  s = TracerHelper::DecodeTrace(encoded_trace, &trace);
+  if (!s.ok()) return s;
+  if (trace.type == kTraceEnd) return Status::Incomplete();
+  if (trace.type != kGraphTrace || trace.payload.empty()) {
+    return Status::Corruption("unexpected record in graph trace");
+  }
+  Slice payload(trace.payload);
+  record->timestamp = trace.ts;
+  record->op = static_cast<GraphTraceOp>(payload[0]);
+  payload.remove_prefix(1);
+  if (record->op >= kGraphTraceOpMax) {
+    return Status::Corruption("unknown graph trace op");
+  }
+  uint64_t src = 0, dst = 0;
+  bool ok = GetVarint64(&payload, &src);
+  if (ok && HasDst(record->op)) ok = GetVarint64(&payload, &dst);
+  record->src = static_cast<node_id_t>(src);
+  record->dst = static_cast<node_id_t>(dst);
+  record->prop = Property();
+  if (ok && HasProperty(record->op)) {
+    Slice name, value;
+    ok = GetLengthPrefixedSlice(&payload, &name) &&
+         GetLengthPrefixedSlice(&payload, &value);
+    record->prop.name = name.ToString();
+    record->prop.value = value.ToString();
+  }
+  record->label = 0;
+  if (ok && HasLabel(record->op)) ok = GetVarint32(&payload, &record->label);
+  return ok ? Status::OK() : Status::Corruption("truncated graph trace record");
+}
+
+Status ExecuteGraphTraceRecord(RocksGraph* graph,
+                               const GraphTraceRecord& record) {
+  Status s;
+  switch (record.op) {
+    case kGraphTraceAddVertex:
+      return graph->AddVertex(record.src);
+    case kGraphTraceAddEdge:
+      return graph->AddEdge(record.src, record.dst);
+    case kGraphTraceAddEdgeLazy:
+      return graph->AddEdgeLazy(record.src, record.dst);
+    case kGraphTraceDeleteEdge:
+      return graph->DeleteEdge(record.src, record.dst);
+    case kGraphTraceDeleteVertex:
+      s = graph->DeleteVertex(record.src);
+      break;
+    case kGraphTraceAddLabeledEdge:
+      return graph->AddEdge(record.src, record.dst, record.label);
+    case kGraphTraceDeleteLabeledEdge:
+      return graph->DeleteEdge(record.src, record.dst, record.label);
+    case kGraphTraceAddVertexProperty:
+      return graph->AddVertexProperty(record.src, record.prop);
+    case kGraphTraceAddEdgeProperty:
+      return graph->AddEdgeProperty(record.src, record.dst, record.prop);
+    case kGraphTraceGetAllEdges: {
+      Edges edges{.num_edges_out = 0, .num_edges_in = 0};
+      edges.nxts_out = nullptr;
+      edges.nxts_in = nullptr;
+      s = graph->GetAllEdges(record.src, &edges);
+      if (s.ok()) free_edges(&edges);
+      break;
+    }
+    case kGraphTraceGetOutDegree:
+      graph->GetOutDegree(record.src);
+      break;
+    case kGraphTraceGetInDegree:
+      graph->GetInDegree(record.src);
+      break;
+    case kGraphTraceGetVertexProperty: {
+      std::vector<Property> props;
+      s = graph->GetVertexProperty(record.src, props);
+      break;
+    }
+    case kGraphTraceGetEdgeProperty: {
+      std::vector<Property> props;
+      s = graph->GetEdgeProperty(record.src, record.dst, props);
+      break;
+    }
+    case kGraphTraceHasEdge: {
+      bool exists;
+      s = graph->HasEdge(record.src, record.dst, &exists);
+      break;
+    }
+    default:
+      return Status::InvalidArgument("unknown graph trace op");
+  }
+  return s.IsNotFound() ? Status::OK() : s;
+}
+
+struct GraphTraceReplayer::Worker {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::deque<GraphTraceRecord> queue;
+  bool done = false;
+};
+
+GraphTraceReplayer::GraphTraceReplayer(RocksGraph* graph,
+                                       std::unique_ptr<TraceReader>&& reader)
+    : graph_(graph),
+      reader_(std::move(reader)),
+      clock_(SystemClock::Default().get()) {}
+
+void GraphTraceReplayer::Issue(const GraphTraceRecord& record,
+                               uint64_t trace_start, uint64_t replay_start,
+                               double fast_forward) {
+  if (fast_forward > 0 && record.timestamp > trace_start) {
+    uint64_t due = replay_start + static_cast<uint64_t>(
+                                      (record.timestamp - trace_start) /
+                                      fast_forward);
+    uint64_t now = clock_->NowMicros();
+    if (due > now) {
+      clock_->SleepForMicroseconds(static_cast<int>(due - now));
+    }
+  }
+  Status s = ExecuteGraphTraceRecord(graph_, record);
+  ops_replayed_++;
+  if (!s.ok()) {
+    ops_failed_++;
+    std::lock_guard<std::mutex> lock(status_mu_);
+    if (first_error_.ok()) first_error_ = s;
+  }
+}
+
+Status GraphTraceReplayer::Replay(const GraphReplayOptions& options) {
+  if (options.num_threads <= 0 || options.fast_forward < 0) {
+    return Status::InvalidArgument("bad graph replay options");
+  }
+  uint64_t trace_start;
+  Status s = reader_.ReadHeader(&trace_start);
+  if (!s.ok()) return s;
+  uint64_t replay_start = clock_->NowMicros();
+  GraphTraceRecord record;
+
+  if (options.num_threads == 1) {
+    while ((s = reader_.Read(&record)).ok()) {
+      Issue(record, trace_start, replay_start, options.fast_forward);
+    }
+  } else {
+    std::vector<Worker> workers(options.num_threads);
+    std::vector<std::thread> threads;
+    for (auto& w : workers) {
+      threads.emplace_back([&, worker = &w]() {
+        std::unique_lock<std::mutex> lock(worker->mu);
+        for (;;) {
+          worker->cv.wait(lock, [worker]() {
+            return worker->done || !worker->queue.empty();
+          });
+          if (worker->queue.empty()) break;
+          GraphTraceRecord next = std::move(worker->queue.front());
+          worker->queue.pop_front();
+          worker->cv.notify_all();
+          lock.unlock();
+          Issue(next, trace_start, replay_start, options.fast_forward);
+          lock.lock();
+        }
+      });
+    }
+    while ((s = reader_.Read(&record)).ok()) {
+      Worker& w = workers[static_cast<uint64_t>(record.src) % workers.size()];
+      std::unique_lock<std::mutex> lock(w.mu);
+      w.cv.wait(lock, [&w]() { return w.queue.size() < kMaxQueuedRecords; });
+      w.queue.push_back(std::move(record));
+      w.cv.notify_all();
+    }
+    for (auto& w : workers) {
+      std::lock_guard<std::mutex> lock(w.mu);
+      w.done = true;
+      w.cv.notify_all();
+    }
+    for (auto& t : threads) t.join();
+  }
+  if (!s.IsIncomplete()) return s;
+  std::lock_guard<std::mutex> lock(status_mu_);
+  return first_error_;
+}
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,279 @@
+#include "rocksdb/graph_transaction.h"
+
+#include <algorithm>
+
+#include "rocksdb/graph_changes.h"
+#include "rocksdb/utilities/optimistic_transaction_db.h"
+#include "rocksdb/utilities/transaction_db.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+Status RocksGraph::BeginTransaction(std::unique_ptr<GraphTransaction>* txn) {
+  txn->reset();
+  if (!txn_db_ && !occ_db_) {
+    return Status::NotSupported("The graph was not opened for transactions");
+  }
+  if (edge_update_policy_ == EDGE_UPDATE_FULL_LAZY || history_cf_) {
+    return Status::NotSupported(
+        "Transactions need one list per vertex and no history");
+  }
+  // folded merge operands keep the sequence number conflict checks compare
+  if (db_->GetOptions(adj_cf_).inplace_merge_support) {
+    return Status::NotSupported(
+        "inplace_merge_support is incompatible with transactions");
+  }
+  Transaction* t;
+  if (txn_db_) {
+    TransactionOptions txn_options;
+    // vertices locked in opposite orders would otherwise wait out the
+    // lock timeout
+    txn_options.deadlock_detect = true;
+    t = txn_db_->BeginTransaction(WriteOptions(), txn_options);
+  } else {
+    t = occ_db_->BeginTransaction(WriteOptions());
+  }
+  txn->reset(new GraphTransaction(this, t));
+  return Status::OK();
+}
+
+GraphTransaction::GraphTransaction(RocksGraph* graph, Transaction* txn)
+    : graph_(graph), txn_(txn) {}
+
+GraphTransaction::~GraphTransaction() {
+  if (!done_) txn_->Rollback();
+  delete txn_;
+}
+
+Status GraphTransaction::ReadList(node_id_t v, std::string* value,
+                                  bool* found) {
+  std::string key;
+  encode_node(VertexKey{.id = v}, &key);
+  Status s = txn_->GetForUpdate(ReadOptions(), graph_->adj_cf_, key, value);
+  *found = s.ok();
+  return s.IsNotFound() ? Status::OK() : s;
+}
+
+Status GraphTransaction::UpdateList(node_id_t v, int direction, node_id_t u,
+                                    bool add, const EdgeAttr* attr,
+                                    bool* changed) {
+  touched_.push_back(v);
+  const int encoding_type = graph_->encoding_type_;
+  const bool out = direction == EDGE_DIRECTION_OUT;
+  std::string key, value;
+  encode_node(VertexKey{.id = v}, &key);
+  int policy = graph_->edge_update_policy_;
+  if (policy == EDGE_UPDATE_ADAPTIVE) {
+    policy = graph_->AdaptPolicy(v, graph_->update_ratio_,
+                                 graph_->lookup_ratio_);
+  }
+  if (policy == EDGE_UPDATE_LAZY &&
+      (add || encoding_type != ENCODING_TYPE_EFP)) {
+    *changed = add;
+    Edges edges{.num_edges_out = 0, .num_edges_in = 0};
+    Edge* list = new Edge[1];
+    list[0].nxt = add ? u : -(u + 1);
+    EdgeAttr* attrs = add && attr ? new EdgeAttr[1]{*attr} : NULL;
+    if (out) {
+      edges.num_edges_out = 1;
+      edges.nxts_out = list;
+      edges.attrs_out = attrs;
+    } else {
+      edges.num_edges_in = 1;
+      edges.nxts_in = list;
+      edges.attrs_in = attrs;
+    }
+    encode_edges(&edges, &value, encoding_type);
+    free_edges(&edges);
+    // Optimistic commits validate the lists they read for update whoever
+    // wrote them, so a blind operand needs no tracking of its own and
+    // writers that only append to a hub never conflict with each other.
+    if (graph_->occ_db_) {
+      return txn_->MergeUntracked(graph_->adj_cf_, key, value);
+    }
+    return txn_->Merge(graph_->adj_cf_, key, value);
+  }
+
+  bool found;
+  Status s = ReadList(v, &value, &found);
+  if (!s.ok()) return s;
+  Edges edges{.num_edges_out = 0, .num_edges_in = 0};
+  if (found) decode_edges(&edges, value.data(), value.size(), encoding_type);
+  Edge*& list = out ? edges.nxts_out : edges.nxts_in;
+  EdgeAttr*& list_attrs = out ? edges.attrs_out : edges.attrs_in;
+  uint32_t& num = out ? edges.num_edges_out : edges.num_edges_in;
+  std::vector<Edge> ids(list, list + num);
+  // attributes are carried over when the list or the insert has any
+  const bool has_attrs = list_attrs != NULL || (add && attr != NULL);
+  std::vector<EdgeAttr> attrs;
+  if (list_attrs != NULL) {
+    attrs.assign(list_attrs, list_attrs + num);
+  } else if (has_attrs) {
+    attrs.resize(num);
+  }
+  auto pos = std::lower_bound(
+      ids.begin(), ids.end(), u,
+      [](const Edge& edge, node_id_t id) { return edge.nxt < id; });
+  size_t i = pos - ids.begin();
+  bool present = pos != ids.end() && pos->nxt == u;
+  *changed = add != present;
+  if (add) {
+    if (!present) {
+      ids.insert(pos, Edge{.nxt = u});
+      if (has_attrs) attrs.insert(attrs.begin() + i, EdgeAttr());
+    }
+    // re-adding an edge replaces its attributes
+    if (has_attrs) attrs[i] = attr ? *attr : EdgeAttr();
+  } else if (present) {
+    ids.erase(pos);
+    if (has_attrs) attrs.erase(attrs.begin() + i);
+  }
+  if (!*changed && !(add && has_attrs)) {
+    free_edges(&edges);
+    return Status::OK();
+  }
+  delete[] list;
+  delete[] list_attrs;
+  num = static_cast<uint32_t>(ids.size());
+  list = new Edge[num];
+  std::copy(ids.begin(), ids.end(), list);
+  list_attrs = NULL;
+  if (has_attrs) {
+    list_attrs = new EdgeAttr[num];
+    std::copy(attrs.begin(), attrs.end(), list_attrs);
+  }
+  value.clear();
+  encode_edges(&edges, &value, encoding_type);
+  free_edges(&edges);
+  return txn_->Put(graph_->adj_cf_, key, value);
+}
+
+Status GraphTransaction::AddEdge(node_id_t from, node_id_t to,
+                                 const EdgeAttr* attr) {
+  if (done_) return Status::InvalidArgument("The transaction has finished");
+  Status s = graph_->ToInternalId(from, &from, true);
+  if (s.ok()) s = graph_->ToInternalId(to, &to, true);
+  if (!s.ok()) return s;
+  // undirected lists keep every neighbor on the out side
+  const bool directed = graph_->is_directed_;
+  bool is_new = false, changed = false;
+  s = UpdateList(from, EDGE_DIRECTION_OUT, to, true, attr, &is_new);
+  if (!s.ok()) return s;
+  if (is_new) counted_.push_back(from);
+  if (directed || from != to) {
+    s = UpdateList(to, directed ? EDGE_DIRECTION_IN : EDGE_DIRECTION_OUT,
+                   from, true, attr, &changed);
+    if (!s.ok()) return s;
+    if (changed) counted_.push_back(to);
+  }
+  if (is_new) edge_delta_++;
+  txn_->PutLogData(GraphChangeRecord(kGraphChangeAddEdge, from, to));
+  return Status::OK();
+}
+
+Status GraphTransaction::DeleteEdge(node_id_t from, node_id_t to) {
+  if (done_) return Status::InvalidArgument("The transaction has finished");
+  Status s = graph_->ToInternalId(from, &from);
+  if (s.ok()) s = graph_->ToInternalId(to, &to);
+  if (!s.ok()) return s;
+  const bool directed = graph_->is_directed_;
+  bool removed = false, changed = false;
+  s = UpdateList(from, EDGE_DIRECTION_OUT, to, false, NULL, &removed);
+  if (!s.ok()) return s;
+  if (removed) decayed_.push_back(from);
+  if (directed || from != to) {
+    s = UpdateList(to, directed ? EDGE_DIRECTION_IN : EDGE_DIRECTION_OUT,
+                   from, false, NULL, &changed);
+    if (!s.ok()) return s;
+    if (changed && !directed) decayed_.push_back(to);
+  }
+  if (removed) edge_delta_--;
+  txn_->PutLogData(GraphChangeRecord(kGraphChangeDeleteEdge, from, to));
+  return Status::OK();
+}
+
+Status GraphTransaction::HasEdge(node_id_t from, node_id_t to,
+                                 bool* exists) {
+  *exists = false;
+  if (done_) return Status::InvalidArgument("The transaction has finished");
+  Status s = graph_->ToInternalId(from, &from);
+  if (s.ok()) s = graph_->ToInternalId(to, &to);
+  if (s.IsNotFound()) return Status::OK();
+  if (!s.ok()) return s;
+  std::string value;
+  bool found;
+  s = ReadList(from, &value, &found);
+  if (!s.ok() || !found) return s;
+  EdgeListView view(value.data(), value.size(), graph_->encoding_type_);
+  for (uint32_t i = 0; i < view.num_edges_out() && !*exists; i++) {
+    *exists = view.out(i) == to;
+  }
+  return Status::OK();
+}
+
+Status GraphTransaction::GetAllEdges(node_id_t src, Edges* edges) {
+  if (done_) return Status::InvalidArgument("The transaction has finished");
+  Status s = graph_->ToInternalId(src, &src);
+  if (!s.ok()) return s;
+  std::string value;
+  bool found;
+  s = ReadList(src, &value, &found);
+  if (!s.ok()) return s;
+  if (!found) return Status::NotFound();
+  decode_edges(edges, value.data(), value.size(), graph_->encoding_type_);
+  return graph_->relabeled() ? graph_->TranslateEdges(edges) : Status::OK();
+}
+
+Status GraphTransaction::AddVertexProperty(node_id_t id,
+                                           const Property& prop) {
+  if (done_) return Status::InvalidArgument("The transaction has finished");
+  Status s = graph_->ToInternalId(id, &id);
+  if (!s.ok()) return s;
+  std::string key, value;
+  encode_node(VertexKey{.id = id}, &key);
+  concatenate_property(prop, &value);
+  return txn_->Put(graph_->vertex_prop_cf_, key, value);
+}
+
+Status GraphTransaction::AddEdgeProperty(node_id_t from, node_id_t to,
+                                         const Property& prop) {
+  if (done_) return Status::InvalidArgument("The transaction has finished");
+  Status s = graph_->ToInternalId(from, &from);
+  if (s.ok()) s = graph_->ToInternalId(to, &to);
+  if (!s.ok()) return s;
+  std::string key, value;
+  encode_node(VertexKey{.id = from}, &key);
+  encode_node(to, &value);
+  concatenate_property(prop, &value);
+  if (graph_->occ_db_) {
+    return txn_->MergeUntracked(graph_->edge_prop_cf_, key, value);
+  }
+  return txn_->Merge(graph_->edge_prop_cf_, key, value);
+}
+
+Status GraphTransaction::Commit() {
+  if (done_) return Status::InvalidArgument("The transaction has finished");
+  Status s;
+  {
+    // like WriteGraph, so an attaching CSR snapshot sees the lists either in
+    // the WAL or marked changed
+    std::shared_lock<std::shared_mutex> csr_lock(graph_->csr_write_mu_);
+    if (graph_->csr_tracking_.load()) {
+      for (node_id_t v : touched_) graph_->MarkChanged(v);
+    }
+    s = txn_->Commit();
+  }
+  if (!s.ok()) return s;
+  done_ = true;
+  graph_->m += edge_delta_;
+  for (node_id_t v : counted_) graph_->CountDegree(v);
+  for (node_id_t v : decayed_) graph_->mor.DecayCounter(v);
+  return s;
+}
+
+Status GraphTransaction::Rollback() {
+  if (done_) return Status::InvalidArgument("The transaction has finished");
+  done_ = true;
+  return txn_->Rollback();
+}
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -59,6 +59,7 @@ ImmutableMemTableOptions::ImmutableMemTableOptions(
           mutable_cf_options.memtable_whole_key_filtering),
       inplace_update_support(ioptions.inplace_update_support),
       inplace_update_num_locks(mutable_cf_options.inplace_update_num_locks),
+      inplace_merge_support(ioptions.inplace_merge_support),
       inplace_callback(ioptions.inplace_callback),
       max_successive_merges(mutable_cf_options.max_successive_merges),
       statistics(ioptions.stats),
@@ -105,7 +106,7 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
       creation_seq_(latest_seq),
       mem_next_logfile_number_(0),
       min_prep_log_referenced_(0),
-      locks_(moptions_.inplace_update_support
+      locks_(moptions_.inplace_update_support || moptions_.inplace_merge_support
                  ? moptions_.inplace_update_num_locks
                  : 0),
       prefix_extractor_(mutable_cf_options.prefix_extractor.get()),
@@ -161,7 +162,8 @@ size_t MemTable::ApproximateMemoryUsage() {
   autovector<size_t> usages = {
       arena_.ApproximateMemoryUsage(), table_->ApproximateMemoryUsage(),
       range_del_table_->ApproximateMemoryUsage(),
-      ROCKSDB_NAMESPACE::ApproximateMemoryUsage(insert_hints_)};
+      ROCKSDB_NAMESPACE::ApproximateMemoryUsage(insert_hints_),
+      merge_room_usage_.load(std::memory_order_relaxed)};
   size_t total_usage = 0;
   for (size_t usage : usages) {
     // If usage + total_usage >= kMaxSizet, return kMaxSizet.
@@ -198,7 +200,8 @@ bool MemTable::ShouldFlushNow() {
   // shouldn't flush.
   auto allocated_memory = table_->ApproximateMemoryUsage() +
                           range_del_table_->ApproximateMemoryUsage() +
-                          arena_.MemoryAllocatedBytes();
+                          arena_.MemoryAllocatedBytes() +
+                          merge_room_usage_.load(std::memory_order_relaxed);
 
   approximate_memory_usage_.store(allocated_memory, std::memory_order_relaxed);
 
@@ -374,6 +377,11 @@ class MemTableIterator : public InternalIterator {
         status_(Status::OK()),
         logger_(mem.moptions_.info_log),
         ts_sz_(mem.ts_sz_) {
+    if (mem.moptions_.inplace_merge_support && !use_range_del_table) {
+      mem.live_iterators_.fetch_add(1);
+      MutexLock fold_lock(&mem.fold_mu_);
+      live_iterators_ = &mem.live_iterators_;
+    }
     if (use_range_del_table) {
       iter_ = mem.range_del_table_->GetIterator(arena);
     } else if (prefix_extractor_ != nullptr && !read_options.total_order_seek &&
@@ -401,6 +409,7 @@ class MemTableIterator : public InternalIterator {
     } else {
       delete iter_;
     }
+    if (live_iterators_ != nullptr) live_iterators_->fetch_sub(1);
   }
 
 #ifndef NDEBUG
@@ -527,6 +536,8 @@ class MemTableIterator : public InternalIterator {
   Status status_;
   Logger* logger_;
   size_t ts_sz_;
+  // MemTable::live_iterators_ while this iterator keeps operands unfolded
+  std::atomic<int>* live_iterators_ = nullptr;
 
   void VerifyEntryChecksum() {
     if (protection_bytes_per_key_ > 0 && Valid()) {
@@ -705,6 +716,13 @@ Status MemTable::Add(SequenceNumber s, ValueType type,
   //  value_size   : varint32 of value.size()
   //  value bytes  : char[value.size()]
   //  checksum     : char[moptions_.protection_bytes_per_key]
+  //  room         : char[reserve], only behind foldable merge operands
+  uint32_t reserve = 0;
+  if (type == kTypeMerge && moptions_.inplace_merge_support &&
+      !allow_concurrent && kv_prot_info == nullptr &&
+      FoldMergeOperand(s, key, value, &reserve)) {
+    return Status::OK();
+  }
   uint32_t key_size = static_cast<uint32_t>(key.size());
   uint32_t val_size = static_cast<uint32_t>(value.size());
   uint32_t internal_key_size = key_size + 8;
@@ -714,7 +732,7 @@ Status MemTable::Add(SequenceNumber s, ValueType type,
   char* buf = nullptr;
   std::unique_ptr<MemTableRep>& table =
       type == kTypeRangeDeletion ? range_del_table_ : table_;
-  KeyHandle handle = table->Allocate(encoded_len, &buf);
+  KeyHandle handle = table->Allocate(encoded_len + reserve, &buf);
 
   char* p = EncodeVarint32(buf, internal_key_size);
   memcpy(p, key.data(), key_size);
@@ -757,6 +775,13 @@ Status MemTable::Add(SequenceNumber s, ValueType type,
       }
     }
 
+    if (reserve > 0) {
+      merge_room_[buf] = VarintLength(val_size) + val_size + reserve;
+      merge_room_usage_.store(
+          ROCKSDB_NAMESPACE::ApproximateMemoryUsage(merge_room_),
+          std::memory_order_relaxed);
+    }
+
     // this is a bit ugly, but is the way to avoid locked instructions
     // when incrementing an atomic
     num_entries_.store(num_entries_.load(std::memory_order_relaxed) + 1,
@@ -887,6 +912,7 @@ struct Saver {
   Logger* logger;
   Statistics* statistics;
   bool inplace_update_support;
+  bool inplace_merge_support;
   bool do_merge;
   SystemClock* clock;
 
@@ -1178,10 +1204,17 @@ static bool SaveValue(void* arg, const char* entry) {
           *(s->found_final_value) = true;
           return false;
         }
+        if (s->inplace_merge_support) {
+          s->mem->GetLock(s->key->user_key())->ReadLock();
+        }
         Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
         *(s->merge_in_progress) = true;
         merge_context->PushOperand(
-            v, s->inplace_update_support == false /* operand_pinned */);
+            v, !s->inplace_update_support &&
+                   !s->inplace_merge_support /* operand_pinned */);
+        if (s->inplace_merge_support) {
+          s->mem->GetLock(s->key->user_key())->ReadUnlock();
+        }
         PERF_COUNTER_ADD(internal_merge_point_lookup_count, 1);
 
         if (s->do_merge && merge_operator->ShouldMerge(
@@ -1320,6 +1353,7 @@ void MemTable::GetFromTable(const LookupKey& key,
   saver.merge_operator = moptions_.merge_operator;
   saver.logger = moptions_.info_log;
   saver.inplace_update_support = moptions_.inplace_update_support;
+  saver.inplace_merge_support = moptions_.inplace_merge_support;
   saver.statistics = moptions_.statistics;
   saver.clock = clock_;
   saver.callback_ = callback;
@@ -1492,6 +1526,68 @@ Status MemTable::Update(SequenceNumber seq, ValueType value_type,
   return Add(seq, value_type, key, value, kv_prot_info);
 }
 
+bool MemTable::FoldMergeOperand(SequenceNumber seq, const Slice& key,
+                                const Slice& value, uint32_t* reserve) {
+  *reserve = 0;
+  if (ts_sz_ > 0 || moptions_.protection_bytes_per_key > 0 ||
+      moptions_.merge_operator == nullptr ||
+      !is_range_del_table_empty_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  LookupKey lkey(key, kMaxSequenceNumber);
+  std::unique_ptr<MemTableRep::Iterator> iter(
+      table_->GetDynamicPrefixIterator());
+  iter->Seek(lkey.internal_key(), lkey.memtable_key().data());
+  if (!iter->Valid()) {
+    return false;
+  }
+  // Refer to comments under MemTable::Add() for entry format.
+  const char* entry = iter->key();
+  uint32_t key_length = 0;
+  const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+  if (!comparator_.comparator.user_comparator()->Equal(
+          Slice(key_ptr, key_length - 8), key)) {
+    return false;
+  }
+  const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+  ValueType type;
+  SequenceNumber existing_seq;
+  UnPackSequenceAndType(tag, &existing_seq, &type);
+  // Entries of one write batch may share a sequence number, and MemPurge
+  // adds the operands of a key newest first.
+  if (type != kTypeMerge || existing_seq >= seq) {
+    return false;
+  }
+  // An open iterator may hold the operand; it keeps its own entry.
+  MutexLock fold_lock(&fold_mu_);
+  if (live_iterators_.load() > 0) {
+    return false;
+  }
+  Slice existing = GetLengthPrefixedSlice(key_ptr + key_length);
+  std::string merged;
+  if (!moptions_.merge_operator->PartialMerge(key, existing, value, &merged,
+                                               moptions_.info_log)) {
+    return false;
+  }
+  uint32_t merged_size = static_cast<uint32_t>(merged.size());
+  auto room = merge_room_.find(entry);
+  if (room != merge_room_.end() &&
+      VarintLength(merged_size) + merged_size <= room->second) {
+    // `seq` is swallowed and `existing_seq` prevails.
+    WriteLock wl(GetLock(lkey.user_key()));
+    char* p = EncodeVarint32(const_cast<char*>(key_ptr) + key_length,
+                             merged_size);
+    memcpy(p, merged.data(), merged_size);
+    RecordTick(moptions_.statistics, NUMBER_KEYS_UPDATED);
+    return true;
+  }
+  // The key is merged successively: leave about the room the folded
+  // operands take so far, so a hot key needs few entries.
+  *reserve = static_cast<uint32_t>(
+      std::min<size_t>(merged_size, kArenaBlockSize / 4));
+  return false;
+}
+
 Status MemTable::UpdateCallback(SequenceNumber seq, const Slice& key,
                                 const Slice& delta,
                                 const ProtectionInfoKVOS64* kv_prot_info) {
@@ -13,6 +13,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -49,6 +50,7 @@ struct ImmutableMemTableOptions {
   bool memtable_whole_key_filtering;
   bool inplace_update_support;
   size_t inplace_update_num_locks;
+  bool inplace_merge_support;
   UpdateStatus (*inplace_callback)(char* existing_value,
                                    uint32_t* existing_value_size,
                                    Slice delta_value,
@@ -474,7 +476,9 @@ class MemTable {
   // return true if the current MemTableRep supports snapshots.
   // inplace update prevents snapshots,
   bool IsSnapshotSupported() const {
-    return table_->IsSnapshotSupported() && !moptions_.inplace_update_support;
+    return table_->IsSnapshotSupported() &&
+           !moptions_.inplace_update_support &&
+           !moptions_.inplace_merge_support;
   }
 
   struct MemTableStats {
@@ -610,6 +614,18 @@ class MemTable {
   // rw locks for inplace updates
   std::vector<port::RWMutex> locks_;
 
+  // Merge operands that later operands of their key can be folded into,
+  // mapped to the bytes reserved for the value length and value. Only
+  // touched by non-concurrent writers, see inplace_merge_support.
+  std::unordered_map<const char*, uint32_t> merge_room_;
+  // ApproximateMemoryUsage(merge_room_), for readers other than the writer
+  std::atomic<size_t> merge_room_usage_{0};
+  // Iterators open over the memtable, which see entries without the
+  // inplace locks; operands are not folded while there are any. A new
+  // iterator takes fold_mu_ once to wait out a fold that missed it.
+  mutable std::atomic<int> live_iterators_{0};
+  mutable port::Mutex fold_mu_;
+
   const SliceTransform* const prefix_extractor_;
   std::unique_ptr<DynamicBloom> bloom_filter_;
 
@@ -697,6 +713,12 @@ class MemTable {
                            SequenceNumber s, char* checksum_ptr);
 
   void MaybeUpdateNewestUDT(const Slice& user_key);
+
+  // Folds merge operand `value` written at `seq` into the newest entry of
+  // `key` and returns true if inplace_merge_support allows it. Otherwise
+  // sets `*reserve` to the room to leave behind `value` when adding it.
+  bool FoldMergeOperand(SequenceNumber seq, const Slice& key,
+                        const Slice& value, uint32_t* reserve);
 };
 
 extern const char* EncodeKey(std::string* scratch, const Slice& target);
@@ -36,6 +36,12 @@ class IntTblPropCollector {
   virtual UserCollectedProperties GetReadableProperties() const = 0;
 
   virtual bool NeedCompact() const { return false; }
+
+  // See TablePropertiesCollector::FinishMetaBlocks.
+  virtual Status FinishMetaBlocks(
+      std::vector<std::pair<std::string, std::string>>* /*blocks*/) {
+    return Status::OK();
+  }
 };
 
 // Factory for internal table properties collector.
@@ -83,6 +89,11 @@ class UserKeyTablePropertiesCollector : public IntTblPropCollector {
     return collector_->NeedCompact();
   }
 
+  Status FinishMetaBlocks(
+      std::vector<std::pair<std::string, std::string>>* blocks) override {
+    return collector_->FinishMetaBlocks(blocks);
+  }
+
  protected:
   std::unique_ptr<TablePropertiesCollector> collector_;
 };
@@ -200,6 +200,7 @@ struct FileMetaData {
   uint64_t raw_key_size = 0;    // total uncompressed key size.
   uint64_t raw_value_size = 0;  // total uncompressed value size.
   uint64_t num_range_deletions = 0;
+  uint64_t num_merge_operands = 0;
   // This is computed during Flush/Compaction, and is added to
   // `compensated_file_size`. Currently, this estimates the size of keys in the
   // next level covered by range tombstones in this file.
@@ -1804,6 +1804,7 @@ void Version::GetColumnFamilyMetaData(ColumnFamilyMetaData* cf_meta) {
           file->file_checksum, file->file_checksum_func_name);
       files.back().num_entries = file->num_entries;
       files.back().num_deletions = file->num_deletions;
+      files.back().num_merge_operands = file->num_merge_operands;
       files.back().smallest = file->smallest.Encode().ToString();
       files.back().largest = file->largest.Encode().ToString();
       level_size += file->fd.GetFileSize();
@@ -3105,6 +3106,7 @@ bool Version::MaybeInitializeFileMetaData(const ReadOptions& read_options,
   file_meta->raw_value_size = tp->raw_value_size;
   file_meta->raw_key_size = tp->raw_key_size;
   file_meta->num_range_deletions = tp->num_range_deletions;
+  file_meta->num_merge_operands = tp->num_merge_operands;
   return true;
 }
 
@@ -3830,6 +3832,20 @@ bool CompareCompensatedSizeDescending(const Fsize& first, const Fsize& second) {
   return (first.file->compensated_file_size >
           second.file->compensated_file_size);
 }
+
+// Files whose stats are not loaded yet count as holding no merge operands.
+double MergeOperandDensity(const FileMetaData* file) {
+  if (file->num_entries == 0) return 0;
+  return static_cast<double>(file->num_merge_operands) / file->num_entries;
+}
+
+bool CompareMergeOperandDensityDescending(const Fsize& first,
+                                          const Fsize& second) {
+  double first_density = MergeOperandDensity(first.file);
+  double second_density = MergeOperandDensity(second.file);
+  if (first_density != second_density) return first_density > second_density;
+  return CompareCompensatedSizeDescending(first, second);
+}
 }  // anonymous namespace
 
 void VersionStorageInfo::AddFile(int level, FileMetaData* f) {
@@ -4082,6 +4098,10 @@ void VersionStorageInfo::UpdateFilesByCompactionPri(
         SortFileByRoundRobin(*internal_comparator_, &compact_cursor_,
                              level0_non_overlapping_, level, &temp);
         break;
+      case kMergeOperandDensity:
+        std::sort(temp.begin(), temp.end(),
+                  CompareMergeOperandDensityDescending);
+        break;
       default:
         assert(false);
     }
@@ -7045,6 +7065,7 @@ void VersionSet::GetLiveFilesMetaData(std::vector<LiveFileMetaData>* metadata) {
         filemetadata.being_compacted = file->being_compacted;
         filemetadata.num_entries = file->num_entries;
         filemetadata.num_deletions = file->num_deletions;
+        filemetadata.num_merge_operands = file->num_merge_operands;
         filemetadata.oldest_blob_file_number = file->oldest_blob_file_number;
         filemetadata.file_checksum = file->file_checksum;
         filemetadata.file_checksum_func_name = file->file_checksum_func_name;
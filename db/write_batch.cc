@@ -2457,6 +2457,9 @@ class MemTableInserter : public WriteBatch::Handler {
 
     MemTable* mem = cf_mems_->GetMemTable();
     auto* moptions = mem->GetImmutableMemTableOptions();
+    // inplace_merge_support is inconsistent with snapshots as well, see
+    // PutCFImpl()
+    assert(!seq_per_batch_ || !moptions->inplace_merge_support);
     if (moptions->merge_operator == nullptr) {
       return Status::InvalidArgument(
           "Merge requires `ColumnFamilyOptions::merge_operator != nullptr`");
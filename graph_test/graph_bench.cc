@@ -0,0 +1,162 @@
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "graph_benchmark_new.h"
+#include "graph_workload.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/graph_trace.h"
+#include "rocksdb/options.h"
+#include "rocksdb/statistics.h"
+#include "rocksdb/table.h"
+
+DEFINE_bool(is_directed, true, "Use a directed graph");
+DEFINE_bool(reinit, true, "Destroy existing DB and load a fresh graph");
+DEFINE_int32(update_policy, EDGE_UPDATE_ADAPTIVE, "Edge update policy");
+DEFINE_int32(encoding_type, ENCODING_TYPE_NONE, "Edge encoding type");
+DEFINE_string(load_mode, "random", "Initial graph: none | random | powerlaw");
+DEFINE_int32(load_vertices, 20000, "Number of vertices to load");
+DEFINE_int32(load_edges, 200000, "Number of edges to load (random mode)");
+DEFINE_double(powerlaw_alpha, 2.0, "Alpha for the power-law loader");
+DEFINE_int32(threads, 4, "Number of client threads");
+DEFINE_uint64(ops_per_thread, 100000,
+              "Operations per client thread (0: run for -duration)");
+DEFINE_int32(duration, 0, "Seconds to run (0: run for -ops_per_thread)");
+DEFINE_string(op_mix,
+              "add=20,delete=5,get=40,degree=10,khop=10,walk=5,prop_get=5,"
+              "prop_set=5",
+              "Relative op weights as name=weight pairs");
+DEFINE_string(key_dist, "uniform", "Vertex skew: uniform | zipfian | powerlaw");
+DEFINE_double(skew, 0.99, "Zipfian theta or power-law exponent");
+DEFINE_int32(khop_hops, 2, "Hops per k-hop op");
+DEFINE_int32(khop_max_vertices, 1000, "Visited vertices cap per k-hop op");
+DEFINE_int32(walk_length, 10, "Steps per walk op");
+DEFINE_int32(report_interval, 1, "Seconds between throughput samples");
+DEFINE_int32(perf_level, rocksdb::PerfLevel::kEnableTimeExceptForMutex,
+             "PerfLevel for the per-op PerfContext breakdown");
+DEFINE_int32(cache_mb, 8, "Block cache size in MB");
+DEFINE_uint64(seed, 42, "Workload seed");
+DEFINE_string(trace_file, "", "Record the workload's graph ops to this trace");
+DEFINE_string(replay_trace, "",
+              "Replay this graph trace instead of the synthetic workload");
+DEFINE_int32(replay_threads, 1, "Threads for -replay_trace");
+DEFINE_double(replay_speed, 1.0,
+              "Speed-up over the traced timing (0: as fast as possible)");
+
+int ReplayTrace(rocksdb::RocksGraph* graph) {
+  std::unique_ptr<rocksdb::TraceReader> reader;
+  rocksdb::Status s = rocksdb::NewFileTraceReader(
+      rocksdb::Env::Default(), rocksdb::EnvOptions(), FLAGS_replay_trace,
+      &reader);
+  if (!s.ok()) {
+    std::cerr << "open trace error: " << s.ToString() << std::endl;
+    return 1;
+  }
+  rocksdb::GraphTraceReplayer replayer(graph, std::move(reader));
+  rocksdb::GraphReplayOptions replay_options;
+  replay_options.num_threads = FLAGS_replay_threads;
+  replay_options.fast_forward = FLAGS_replay_speed;
+  auto start = std::chrono::steady_clock::now();
+  s = replayer.Replay(replay_options);
+  double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  std::cout << "replayed " << replayer.ops_replayed() << " ops ("
+            << replayer.ops_failed() << " failed) in " << secs << " s, "
+            << replayer.ops_replayed() / std::max(secs, 1e-9) << " ops/s"
+            << std::endl;
+  if (!s.ok()) {
+    std::cerr << "replay error: " << s.ToString() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  rocksdb::GraphWorkloadOptions workload;
+  rocksdb::Status s = rocksdb::ParseGraphOpMix(FLAGS_op_mix,
+                                               &workload.op_weights);
+  if (!s.ok()) {
+    std::cerr << s.ToString() << std::endl;
+    return 1;
+  }
+  if (FLAGS_key_dist == "uniform") {
+    workload.key_distribution = KEY_DIST_UNIFORM;
+  } else if (FLAGS_key_dist == "zipfian") {
+    workload.key_distribution = KEY_DIST_ZIPFIAN;
+  } else if (FLAGS_key_dist == "powerlaw") {
+    workload.key_distribution = KEY_DIST_POWERLAW;
+  } else {
+    std::cerr << "Unknown key distribution: " << FLAGS_key_dist << std::endl;
+    return 1;
+  }
+  workload.num_threads = FLAGS_threads;
+  workload.ops_per_thread = FLAGS_ops_per_thread;
+  workload.duration_sec = FLAGS_duration;
+  workload.num_vertices = FLAGS_load_vertices;
+  workload.skew = FLAGS_skew;
+  workload.khop_hops = FLAGS_khop_hops;
+  workload.khop_max_vertices = FLAGS_khop_max_vertices;
+  workload.walk_length = FLAGS_walk_length;
+  workload.report_interval_sec = FLAGS_report_interval;
+  workload.perf_level = static_cast<rocksdb::PerfLevel>(FLAGS_perf_level);
+  workload.seed = FLAGS_seed;
+
+  rocksdb::Options options;
+  options.level_compaction_dynamic_level_bytes = false;
+  options.create_if_missing = true;
+  options.statistics = rocksdb::CreateDBStatistics();
+  options.write_buffer_size = 4 * 1024 * 1024;
+  options.max_bytes_for_level_base =
+      options.write_buffer_size * options.max_bytes_for_level_multiplier;
+  rocksdb::BlockBasedTableOptions table_options;
+  table_options.block_cache =
+      rocksdb::NewLRUCache(static_cast<size_t>(FLAGS_cache_mb) << 20);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+  rocksdb::GraphBenchmarkTool tool(options, FLAGS_is_directed,
+                                   FLAGS_update_policy, FLAGS_encoding_type,
+                                   FLAGS_reinit);
+  if (FLAGS_reinit && FLAGS_load_mode == "random") {
+    tool.LoadRandomGraph(FLAGS_load_vertices, FLAGS_load_edges);
+  } else if (FLAGS_reinit && FLAGS_load_mode == "powerlaw") {
+    tool.LoadPowerLawGraph(FLAGS_load_vertices, FLAGS_powerlaw_alpha);
+  }
+
+  if (!FLAGS_replay_trace.empty()) {
+    return ReplayTrace(tool.graph());
+  }
+  if (!FLAGS_trace_file.empty()) {
+    std::unique_ptr<rocksdb::TraceWriter> writer;
+    s = rocksdb::NewFileTraceWriter(rocksdb::Env::Default(),
+                                    rocksdb::EnvOptions(), FLAGS_trace_file,
+                                    &writer);
+    if (s.ok()) s = tool.graph()->StartTrace(rocksdb::TraceOptions(),
+                                              std::move(writer));
+    if (!s.ok()) {
+      std::cerr << "start trace error: " << s.ToString() << std::endl;
+      return 1;
+    }
+  }
+
+  rocksdb::GraphWorkloadDriver driver(tool.graph(), workload);
+  s = driver.Run();
+  if (!FLAGS_trace_file.empty()) tool.graph()->EndTrace();
+  std::cout << driver.ToString();
+  std::string graph_stats;
+  if (tool.graph()->GetProperty(rocksdb::GraphProperties::kStats,
+                                &graph_stats)) {
+    std::cout << graph_stats;
+  }
+  if (!s.ok()) {
+    std::cerr << "workload error: " << s.ToString() << std::endl;
+    return 1;
+  }
+  return 0;
+}
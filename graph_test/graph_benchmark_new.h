@@ -5,18 +5,35 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <random>
+#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 using namespace std::chrono;
 
+#include "monitoring/histogram.h"
+#include "rocksdb/convenience.h"
 #include "rocksdb/db.h"
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/graph.h"
+#include "rocksdb/graph_analytics.h"
+#include "rocksdb/graph_async.h"
+#include "rocksdb/graph_changes.h"
+#include "rocksdb/graph_pagerank.h"
+#include "rocksdb/graph_partitioner.h"
+#include "rocksdb/graph_perf_context.h"
+#include "rocksdb/graph_trace.h"
+#include "rocksdb/graph_transaction.h"
 #include "rocksdb/options.h"
+#include "rocksdb/perf_context.h"
+#include "rocksdb/perf_level.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/table.h"
 
@@ -34,8 +51,13 @@ int generatePowerLawDegree(double alpha, int minDegree, int maxDegree,
 
 RocksGraph* CreateRocksGraph(Options& options, int policy,
                              int encoding = ENCODING_TYPE_NONE,
-                             bool reinit = true) {
-  return new RocksGraph(options, policy, encoding, reinit);
+                             bool reinit = true, bool is_directed = true) {
+  RocksGraphOptions graph_options;
+  graph_options.edge_update_policy = policy;
+  graph_options.encoding_type = encoding;
+  graph_options.auto_reinitialize = reinit;
+  graph_options.is_directed = is_directed;
+  return new RocksGraph(options, graph_options);
 }
 
 struct Timer {
@@ -51,44 +73,28 @@ class GraphBenchProfiler {
  public:
   GraphBenchProfiler() {}
   void AddStat(const std::string& name, double value) {
-    if (stats_.find(name) == stats_.end()) {
-      stats_[name] = std::vector<double>();
+    auto& hist = stats_[name];
+    if (!hist) {
+      hist.reset(new HistogramImpl());
     }
-    stats_[name].push_back(value);
+    hist->Add(static_cast<uint64_t>(value));
   }
   std::string ToString() const {
     std::stringstream ss;
     for (auto& key : stats_) {
-      auto sum = get_sum(key.second);
-      auto std = get_std(key.second);
-      auto mean = sum / key.second.size();
-      auto _50_percentile = mean;
-      auto _95_percentile = mean + 1.645 * std;
-      auto _99_percentile = mean + 2.326 * std;
-      ss << key.first << ".micros  P50: " << _50_percentile
-         << " P95: " << _95_percentile << " P99: " << _99_percentile
-         << " SUM: " << sum << " COUNT: " << key.second.size() << std::endl;
+      HistogramData data;
+      key.second->Data(&data);
+      ss << key.first << ".micros  P50: " << data.median
+         << " P95: " << data.percentile95 << " P99: " << data.percentile99
+         << " P99.9: " << key.second->Percentile(99.9)
+         << " MAX: " << data.max << " SUM: " << data.sum
+         << " COUNT: " << data.count << std::endl;
     }
     return ss.str();
   }
 
  private:
-  double get_sum(const std::vector<double>& values) const {
-    double sum = 0;
-    for (auto v : values) {
-      sum += v;
-    }
-    return sum;
-  }
-  double get_std(const std::vector<double>& values) const {
-    double mean = get_sum(values) / values.size();
-    double sum = 0;
-    for (auto v : values) {
-      sum += (v - mean) * (v - mean);
-    }
-    return sqrt(sum / values.size());
-  }
-  std::unordered_map<std::string, std::vector<double>> stats_;
+  std::unordered_map<std::string, std::unique_ptr<HistogramImpl>> stats_;
 };
 class GraphBenchmarkTool {
  public:
@@ -118,7 +124,19 @@ class GraphBenchmarkTool {
         policy_(policy),
         encoding_(encoding),
         reinit_(reinit) {
-    graph_ = CreateRocksGraph(options, policy_, encoding_, reinit_);
+    graph_ = CreateRocksGraph(options, policy_, encoding_, reinit_,
+                              is_directed_);
+  }
+
+  // A fresh graph at the main one's path plus `suffix`, opened like it.
+  RocksGraphOptions ScratchGraphOptions(const std::string& suffix) const {
+    RocksGraphOptions graph_options;
+    graph_options.edge_update_policy = policy_;
+    graph_options.encoding_type = encoding_;
+    graph_options.auto_reinitialize = true;
+    graph_options.db_path = graph_->db_path_ + suffix;
+    graph_options.is_directed = is_directed_;
+    return graph_options;
   }
 
   void LoadGraph(const std::string& graph_file) {
@@ -129,23 +147,10 @@ class GraphBenchmarkTool {
       std::stringstream ss(line);
       node_id_t from, to;
       ss >> from >> to;
-      if (is_directed_) {
-        s = graph_->AddEdge(from, to);
-        if (!s.ok()) {
-          std::cout << "add error: " << s.ToString() << std::endl;
-          exit(0);
-        }
-      } else {
-        s = graph_->AddEdge(from, to);
-        if (!s.ok()) {
-          std::cout << "add error: " << s.ToString() << std::endl;
-          exit(0);
-        }
-        s = graph_->AddEdge(to, from);
-        if (!s.ok()) {
-          std::cout << "add error: " << s.ToString() << std::endl;
-          exit(0);
-        }
+      s = graph_->AddEdge(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
       }
     }
   }
@@ -180,23 +185,10 @@ class GraphBenchmarkTool {
       from = from % n;
       to = (static_cast<node_id_t>(rand()) << (sizeof(int) * 8)) | rand();
       to = to % n;
-      if (is_directed_) {
-        s = graph_->AddEdge(from, to);
-        if (!s.ok()) {
-          std::cout << "add error: " << s.ToString() << std::endl;
-          exit(0);
-        }
-      } else {
-        s = graph_->AddEdge(from, to);
-        if (!s.ok()) {
-          std::cout << "add error: " << s.ToString() << std::endl;
-          exit(0);
-        }
-        s = graph_->AddEdge(to, from);
-        if (!s.ok()) {
-          std::cout << "add error: " << s.ToString() << std::endl;
-          exit(0);
-        }
+      s = graph_->AddEdge(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
       }
     }
     printf("\n");
@@ -448,23 +440,10 @@ class GraphBenchmarkTool {
         from = j;
         to = j + i;
         to = to % n;
-        if (is_directed_) {
-          s = graph_->AddEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-        } else {
-          s = graph_->AddEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-          s = graph_->AddEdge(to, from);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
+        s = graph_->AddEdge(from, to);
+        if (!s.ok()) {
+          std::cout << "add error: " << s.ToString() << std::endl;
+          exit(0);
         }
       }
     }
@@ -477,44 +456,18 @@ class GraphBenchmarkTool {
         from = j;
         to = j + i + d;
         to = to % n;
-        if (is_directed_) {
-          s = graph_->AddEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-        } else {
-          s = graph_->AddEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-          s = graph_->AddEdge(to, from);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
+        s = graph_->AddEdge(from, to);
+        if (!s.ok()) {
+          std::cout << "add error: " << s.ToString() << std::endl;
+          exit(0);
         }
         from = j;
         to = j - i + d / 2;
         to = to % n;
-        if (is_directed_) {
-          s = graph_->DeleteEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-        } else {
-          s = graph_->DeleteEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-          s = graph_->DeleteEdge(to, from);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
+        s = graph_->DeleteEdge(from, to);
+        if (!s.ok()) {
+          std::cout << "add error: " << s.ToString() << std::endl;
+          exit(0);
         }
       }
     }
@@ -534,23 +487,10 @@ class GraphBenchmarkTool {
         from = j;
         to = j + i;
         to = to % n;
-        if (is_directed_) {
-          s = graph_->AddEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-        } else {
-          s = graph_->AddEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-          s = graph_->AddEdge(to, from);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
+        s = graph_->AddEdge(from, to);
+        if (!s.ok()) {
+          std::cout << "add error: " << s.ToString() << std::endl;
+          exit(0);
         }
       }
     }
@@ -626,23 +566,10 @@ class GraphBenchmarkTool {
         from = j;
         to = j + i;
         to = to % n;
-        if (is_directed_) {
-          s = graph_->AddEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-        } else {
-          s = graph_->AddEdge(from, to);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-          s = graph_->AddEdge(to, from);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
+        s = graph_->AddEdge(from, to);
+        if (!s.ok()) {
+          std::cout << "add error: " << s.ToString() << std::endl;
+          exit(0);
         }
       }
     }
@@ -814,9 +741,14 @@ class GraphBenchmarkTool {
         expected_out;
     std::unordered_map<node_id_t, std::unordered_set<node_id_t>> expected_in;
 
+    // undirected graphs keep a single symmetric list, reported as out edges
     auto apply_add = [&](node_id_t from, node_id_t to) {
       expected_out[from].insert(to);
-      expected_in[to].insert(from);
+      if (is_directed_) {
+        expected_in[to].insert(from);
+      } else {
+        expected_out[to].insert(from);
+      }
     };
     auto apply_delete = [&](node_id_t from, node_id_t to) {
       auto out_it = expected_out.find(from);
@@ -827,6 +759,12 @@ class GraphBenchmarkTool {
       if (in_it != expected_in.end()) {
         in_it->second.erase(from);
       }
+      if (!is_directed_) {
+        auto back_it = expected_out.find(to);
+        if (back_it != expected_out.end()) {
+          back_it->second.erase(from);
+        }
+      }
     };
 
     for (const auto& op : ops) {
@@ -838,14 +776,6 @@ class GraphBenchmarkTool {
           exit(0);
         }
         apply_add(op.from, op.to);
-        if (!is_directed_) {
-          s = graph_->AddEdge(op.to, op.from);
-          if (!s.ok()) {
-            std::cout << "add error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-          apply_add(op.to, op.from);
-        }
       } else {
         s = graph_->DeleteEdge(op.from, op.to);
         if (!s.ok()) {
@@ -853,14 +783,6 @@ class GraphBenchmarkTool {
           exit(0);
         }
         apply_delete(op.from, op.to);
-        if (!is_directed_) {
-          s = graph_->DeleteEdge(op.to, op.from);
-          if (!s.ok()) {
-            std::cout << "delete error: " << s.ToString() << std::endl;
-            exit(0);
-          }
-          apply_delete(op.to, op.from);
-        }
       }
     }
 
@@ -1214,6 +1136,7 @@ class GraphBenchmarkTool {
     }
   }
   ~GraphBenchmarkTool() { delete graph_; }
+  RocksGraph* graph() { return graph_; }
   void GetRocksGraphStats(std::string& stat) {
     graph_->GetRocksDBStats(stat);
     stat += "\n" + profiler_.ToString();
@@ -1514,6 +1437,2651 @@ class GraphBenchmarkTool {
     }
   }
 
+  void SampleNeighborsTest(node_id_t n, node_id_t m) {
+    if (n <= 0 || m <= 0) {
+      std::cout << "SampleNeighborsTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    InitNodes(n);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::unordered_map<node_id_t, std::unordered_set<node_id_t>> expected_out;
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng);
+      node_id_t to = dist(rng);
+      Status s = graph_->AddEdge(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      expected_out[from].insert(to);
+      if (!is_directed_) expected_out[to].insert(from);
+    }
+
+    std::vector<node_id_t> seeds;
+    for (node_id_t v = 0; v < std::min<node_id_t>(n, 1000); v++) {
+      seeds.push_back(v);
+    }
+    std::vector<uint32_t> fanouts{10, 5};
+    std::vector<SampledLayer> layers, layers_mt;
+    Status s = graph_->SampleNeighbors(seeds, fanouts, EDGE_DIRECTION_OUT, 7,
+                                       &layers, 1);
+    Status s_mt = graph_->SampleNeighbors(seeds, fanouts, EDGE_DIRECTION_OUT,
+                                          7, &layers_mt, 4);
+    bool passed = s.ok() && s_mt.ok() && layers.size() == fanouts.size();
+    if (!passed) {
+      std::cout << "sample error: " << s.ToString() << " / "
+                << s_mt.ToString() << std::endl;
+    }
+    size_t bad_samples = 0;
+    for (size_t hop = 0; passed && hop < layers.size(); hop++) {
+      const SampledLayer& layer = layers[hop];
+      if (layer.neighbors != layers_mt[hop].neighbors ||
+          layer.offsets != layers_mt[hop].offsets) {
+        std::cout << "  FAIL: hop " << hop
+                  << " differs between 1 and 4 threads" << std::endl;
+        passed = false;
+      }
+      for (size_t i = 0; i < layer.seeds.size(); i++) {
+        const auto& exp = expected_out[layer.seeds[i]];
+        size_t want = std::min<size_t>(exp.size(), fanouts[hop]);
+        std::unordered_set<node_id_t> got(
+            layer.neighbors.begin() + layer.offsets[i],
+            layer.neighbors.begin() + layer.offsets[i + 1]);
+        if (layer.offsets[i + 1] - layer.offsets[i] != want ||
+            got.size() != want) {
+          bad_samples++;
+          continue;
+        }
+        for (node_id_t nb : got) {
+          if (exp.find(nb) == exp.end()) {
+            bad_samples++;
+            break;
+          }
+        }
+      }
+    }
+
+    std::cout << "SampleNeighborsTest result: seeds=" << seeds.size()
+              << " hops=" << layers.size()
+              << " bad_samples=" << bad_samples << std::endl;
+    if (passed && bad_samples == 0) {
+      std::cout << "SampleNeighborsTest: PASS" << std::endl;
+    } else {
+      std::cout << "SampleNeighborsTest: FAIL" << std::endl;
+    }
+  }
+
+  void ParallelScanTest(node_id_t n, node_id_t m, int num_threads) {
+    if (n <= 0 || m <= 0) {
+      std::cout << "ParallelScanTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    InitNodes(n);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::unordered_map<node_id_t, std::unordered_set<node_id_t>> expected_out;
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng);
+      node_id_t to = dist(rng);
+      Status s = graph_->AddEdge(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      expected_out[from].insert(to);
+      if (!is_directed_) expected_out[to].insert(from);
+      // flush periodically so the scan has several SST files to split on
+      if (i % (m / 8 + 1) == 0) {
+        graph_->get_raw_db()->Flush(FlushOptions());
+      }
+    }
+
+    std::mutex mu;
+    std::unordered_map<node_id_t, size_t> visits;
+    size_t mismatch_nodes = 0;
+    Status s = graph_->ParallelScan(
+        [&](node_id_t id, EdgeListView& edges) {
+          std::unordered_set<node_id_t> got;
+          for (uint32_t i = 0; i < edges.num_edges_out(); i++) {
+            got.insert(edges.out(i));
+          }
+          std::lock_guard<std::mutex> lock(mu);
+          visits[id]++;
+          if (got != expected_out[id]) mismatch_nodes++;
+        },
+        num_threads);
+    if (!s.ok()) {
+      std::cout << "scan error: " << s.ToString() << std::endl;
+      exit(0);
+    }
+
+    size_t missing_nodes = 0;
+    size_t repeated_nodes = 0;
+    for (const auto& kv : expected_out) {
+      if (visits.find(kv.first) == visits.end()) missing_nodes++;
+    }
+    for (const auto& kv : visits) {
+      if (kv.second > 1) repeated_nodes++;
+    }
+    std::cout << "ParallelScanTest result: threads=" << num_threads
+              << " visited=" << visits.size()
+              << " missing_nodes=" << missing_nodes
+              << " repeated_nodes=" << repeated_nodes
+              << " mismatched_nodes=" << mismatch_nodes << std::endl;
+    if (missing_nodes == 0 && repeated_nodes == 0 && mismatch_nodes == 0) {
+      std::cout << "ParallelScanTest: PASS" << std::endl;
+    } else {
+      std::cout << "ParallelScanTest: FAIL" << std::endl;
+    }
+  }
+
+  void AnalyticsTest(int num_threads) {
+    std::cout << "=== AnalyticsTest ===" << std::endl;
+    bool passed = true;
+
+    // Two triangles sharing vertex 2, a separate edge 5->6 and isolated 7
+    std::vector<std::pair<node_id_t, node_id_t>> edges{
+        {0, 1}, {1, 2}, {2, 0}, {2, 3}, {3, 4}, {4, 2}, {5, 6}};
+    for (const auto& e : edges) {
+      Status s = graph_->AddEdge(e.first, e.second);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+    }
+    graph_->AddVertex(7);
+
+    GraphAnalytics analytics(graph_, num_threads);
+    Status s = analytics.LoadSnapshot();
+    if (!s.ok() || analytics.csr().num_vertices != 8) {
+      std::cout << "  FAIL: snapshot has " << analytics.csr().num_vertices
+                << " vertices, expected 8 (" << s.ToString() << ")"
+                << std::endl;
+      std::cout << "AnalyticsTest: FAIL" << std::endl;
+      return;
+    }
+
+    uint64_t triangles = 0;
+    std::vector<uint64_t> per_vertex;
+    analytics.TriangleCount(&triangles, &per_vertex);
+    uint64_t triangles_simd = 0;
+    analytics.TriangleCount(&triangles_simd);
+    std::vector<uint64_t> expected_per_vertex{1, 1, 2, 1, 1, 0, 0, 0};
+    if (triangles != 2 || triangles_simd != 2 ||
+        per_vertex != expected_per_vertex) {
+      std::cout << "  FAIL: triangles=" << triangles
+                << " (count-only " << triangles_simd << "), expected 2"
+                << std::endl;
+      passed = false;
+    }
+
+    std::vector<node_id_t> labels;
+    analytics.WeaklyConnectedComponents(&labels);
+    std::vector<node_id_t> expected_labels{0, 0, 0, 0, 0, 5, 5, 7};
+    if (labels != expected_labels) {
+      std::cout << "  FAIL: unexpected component labels" << std::endl;
+      passed = false;
+    }
+
+    std::vector<double> ranks;
+    analytics.PageRank(&ranks, 100);
+    double sum = 0;
+    for (double r : ranks) sum += r;
+    // undirected, 5 and 6 are symmetric
+    bool sink_ranked = is_directed_ ? ranks[6] > ranks[5]
+                                    : std::fabs(ranks[6] - ranks[5]) < 1e-9;
+    if (std::fabs(sum - 1.0) > 1e-6 || !(ranks[2] > ranks[0]) ||
+        !sink_ranked) {
+      std::cout << "  FAIL: pagerank sum=" << sum << std::endl;
+      passed = false;
+    }
+
+    analytics.WriteVertexProperty("wcc", labels);
+    std::vector<Property> props;
+    graph_->GetVertexProperty(6, props);
+    if (props.size() != 1 || props[0].name != "wcc" || props[0].value != "5") {
+      std::cout << "  FAIL: wcc property of vertex 6 not written" << std::endl;
+      passed = false;
+    }
+
+    if (passed) {
+      std::cout << "AnalyticsTest: PASS" << std::endl;
+    } else {
+      std::cout << "AnalyticsTest: FAIL" << std::endl;
+    }
+  }
+
+  void CSRSnapshotTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "CSRSnapshotTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    InitNodes(n);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::unordered_map<node_id_t, std::unordered_set<node_id_t>> expected_out;
+    std::unordered_map<node_id_t, std::unordered_set<node_id_t>> expected_in;
+    auto add_edge = [&](node_id_t from, node_id_t to) {
+      Status s = graph_->AddEdge(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      expected_out[from].insert(to);
+      // undirected lists hold every edge at both ends, in the out part
+      if (is_directed_) {
+        expected_in[to].insert(from);
+      } else {
+        expected_out[to].insert(from);
+      }
+    };
+    for (node_id_t i = 0; i < m; i++) {
+      add_edge(dist(rng), dist(rng));
+    }
+
+    std::string path = graph_->db_path_ + "/graph.csr";
+    Status s = graph_->ExportCSRSnapshot(path);
+    if (!s.ok()) {
+      std::cout << "export error: " << s.ToString() << std::endl;
+      exit(0);
+    }
+    // written after the export, must be picked up from the WAL on attach
+    add_edge(0, n - 1);
+    s = graph_->AttachCSRSnapshot(path);
+    if (!s.ok()) {
+      std::cout << "attach error: " << s.ToString() << std::endl;
+      exit(0);
+    }
+    // written after the attach, must bypass the snapshot
+    add_edge(1, n - 2);
+    size_t mismatch_nodes = CountCSRMismatches(n, expected_out, expected_in);
+
+    // A writer racing attaches and detaches: the snapshot attached while it
+    // ran must still hide every list it changed, and readers must never be
+    // left on a detached mapping.
+    std::atomic<bool> writing{true};
+    std::thread writer([&]() {
+      for (node_id_t i = 0; i < m / 4; i++) add_edge(dist(rng), dist(rng));
+      writing = false;
+    });
+    std::thread reader([&]() {
+      std::mt19937 reader_rng(7);
+      while (writing) {
+        Edges edges;
+        if (graph_->GetAllEdges(dist(reader_rng), &edges).ok()) {
+          free_edges(&edges);
+        }
+      }
+    });
+    size_t attaches = 0;
+    while (writing) {
+      graph_->DetachCSRSnapshot();
+      s = graph_->AttachCSRSnapshot(path);
+      if (!s.ok()) {
+        std::cout << "attach error: " << s.ToString() << std::endl;
+        break;
+      }
+      attaches++;
+    }
+    writer.join();
+    reader.join();
+    mismatch_nodes += CountCSRMismatches(n, expected_out, expected_in);
+    graph_->DetachCSRSnapshot();
+
+    std::cout << "CSRSnapshotTest result: nodes=" << n << " edges=" << m
+              << " racing_attaches=" << attaches
+              << " mismatched_nodes=" << mismatch_nodes << std::endl;
+    if (mismatch_nodes == 0 && s.ok()) {
+      std::cout << "CSRSnapshotTest: PASS" << std::endl;
+    } else {
+      std::cout << "CSRSnapshotTest: FAIL" << std::endl;
+    }
+  }
+
+  size_t CountCSRMismatches(
+      node_id_t n,
+      std::unordered_map<node_id_t, std::unordered_set<node_id_t>>&
+          expected_out,
+      std::unordered_map<node_id_t, std::unordered_set<node_id_t>>&
+          expected_in) {
+    size_t mismatch_nodes = 0;
+    for (node_id_t node = 0; node < n; ++node) {
+      Edges edges_read;
+      Status s = graph_->GetAllEdges(node, &edges_read);
+      std::unordered_set<node_id_t> got_out, got_in;
+      if (s.ok()) {
+        for (uint32_t i = 0; i < edges_read.num_edges_out; ++i) {
+          got_out.insert(edges_read.nxts_out[i].nxt);
+        }
+        for (uint32_t i = 0; i < edges_read.num_edges_in; ++i) {
+          got_in.insert(edges_read.nxts_in[i].nxt);
+        }
+        free_edges(&edges_read);
+      }
+      if (got_out != expected_out[node] || got_in != expected_in[node] ||
+          static_cast<size_t>(graph_->GetOutDegree(node)) != got_out.size() ||
+          static_cast<size_t>(graph_->GetInDegree(node)) !=
+              (is_directed_ ? got_in : got_out).size()) {
+        if (mismatch_nodes < 10) {
+          std::cout << "Mismatch node " << node << std::endl;
+        }
+        mismatch_nodes++;
+      }
+    }
+    return mismatch_nodes;
+  }
+
+  void RelabelTest(node_id_t n, node_id_t m, int order_type) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "RelabelTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    // sparse external ids, so the translation has something to do
+    auto external = [](node_id_t i) { return i * 7919 + 13; };
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::vector<std::pair<node_id_t, node_id_t>> edges;
+    std::unordered_set<node_id_t> vertices;
+    std::unordered_map<node_id_t, std::unordered_set<node_id_t>> expected_out;
+    std::unordered_map<node_id_t, std::unordered_set<node_id_t>> expected_in;
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = external(dist(rng)), to = external(dist(rng));
+      edges.emplace_back(from, to);
+      vertices.insert(from);
+      vertices.insert(to);
+      expected_out[from].insert(to);
+      if (is_directed_) {
+        expected_in[to].insert(from);
+      } else {
+        expected_out[to].insert(from);
+      }
+    }
+    Status s = graph_->BulkLoadRelabeled(edges, order_type);
+    if (!s.ok()) {
+      std::cout << "bulk load error: " << s.ToString() << std::endl;
+      exit(0);
+    }
+    // a vertex unknown to the load gets a fresh internal id
+    s = graph_->AddEdge(external(n), external(0));
+    if (!s.ok()) {
+      std::cout << "add error: " << s.ToString() << std::endl;
+      exit(0);
+    }
+    expected_out[external(n)].insert(external(0));
+    if (is_directed_) {
+      expected_in[external(0)].insert(external(n));
+    } else {
+      expected_out[external(0)].insert(external(n));
+    }
+
+    size_t mismatch_nodes = 0;
+    for (node_id_t node = 0; node <= n; ++node) {
+      node_id_t id = external(node);
+      Edges edges_read;
+      s = graph_->GetAllEdges(id, &edges_read);
+      std::unordered_set<node_id_t> got_out, got_in;
+      if (s.ok()) {
+        for (uint32_t i = 0; i < edges_read.num_edges_out; ++i) {
+          got_out.insert(edges_read.nxts_out[i].nxt);
+        }
+        for (uint32_t i = 0; i < edges_read.num_edges_in; ++i) {
+          got_in.insert(edges_read.nxts_in[i].nxt);
+        }
+        free_edges(&edges_read);
+      }
+      if (got_out != expected_out[id] || got_in != expected_in[id] ||
+          static_cast<size_t>(graph_->GetOutDegree(id)) != got_out.size()) {
+        if (mismatch_nodes < 10) {
+          std::cout << "Mismatch node " << id << std::endl;
+        }
+        mismatch_nodes++;
+      }
+    }
+
+    // bulk-loaded vertices must appear in key order exactly by rank
+    uint64_t num_loaded = vertices.size();
+    node_id_t limit = LocalityIdLimit(num_loaded);
+    std::vector<node_id_t> scanned;
+    s = graph_->ParallelScan(
+        [&](node_id_t id, EdgeListView&) {
+          if (id < limit) scanned.push_back(id);
+        },
+        1);
+    size_t out_of_order = 0;
+    for (uint64_t r = 0; r < num_loaded; r++) {
+      if (r >= scanned.size() || scanned[r] != RankToLocalityId(r, num_loaded)) {
+        out_of_order++;
+      }
+    }
+    if (!s.ok() || scanned.size() != num_loaded) out_of_order++;
+
+    std::cout << "RelabelTest result: nodes=" << num_loaded << " edges=" << m
+              << " order=" << order_type
+              << " mismatched_nodes=" << mismatch_nodes
+              << " out_of_order=" << out_of_order << std::endl;
+    if (mismatch_nodes == 0 && out_of_order == 0) {
+      std::cout << "RelabelTest: PASS" << std::endl;
+    } else {
+      std::cout << "RelabelTest: FAIL" << std::endl;
+    }
+  }
+
+  void TraceReplayTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "TraceReplayTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    std::string trace_path = graph_->db_path_ + "_graph.trace";
+    std::unique_ptr<TraceWriter> writer;
+    Status s = NewFileTraceWriter(Env::Default(), EnvOptions(), trace_path,
+                                  &writer);
+    if (s.ok()) s = graph_->StartTrace(TraceOptions(), std::move(writer));
+    if (!s.ok()) {
+      std::cout << "start trace error: " << s.ToString() << std::endl;
+      exit(0);
+    }
+    uint64_t traced_ops = policy_ != EDGE_UPDATE_EAGER ? n : 0;
+    InitNodes(n);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::vector<std::pair<node_id_t, node_id_t>> added;
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      s = graph_->AddEdge(from, to);
+      added.emplace_back(from, to);
+      if (s.ok() && i % 5 == 4) {
+        auto victim = added[rng() % added.size()];
+        s = graph_->DeleteEdge(victim.first, victim.second);
+        traced_ops++;
+      }
+      if (s.ok() && i % 3 == 0) {
+        Edges edges;
+        if (graph_->GetAllEdges(from, &edges).ok()) free_edges(&edges);
+        traced_ops++;
+      }
+      if (s.ok() && i % 50 == 0) {
+        s = graph_->AddVertexProperty(from, Property{"tag", std::to_string(i)});
+        traced_ops++;
+      }
+      if (s.ok() && i % 20 == 0) {
+        s = graph_->AddEdge(from, to, static_cast<edge_label_t>(i % 3));
+        traced_ops++;
+      }
+      if (!s.ok()) {
+        std::cout << "traced op error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      traced_ops++;
+    }
+    s = graph_->EndTrace();
+    if (!s.ok()) {
+      std::cout << "end trace error: " << s.ToString() << std::endl;
+      exit(0);
+    }
+
+    auto replay = [&](int num_threads, uint64_t* replayed,
+                      uint64_t* failed) -> RocksGraph* {
+      Options options;
+      options.create_if_missing = true;
+      RocksGraph* replica =
+          new RocksGraph(options, ScratchGraphOptions("_replay"));
+      std::unique_ptr<TraceReader> reader;
+      Status rs = NewFileTraceReader(Env::Default(), EnvOptions(), trace_path,
+                                     &reader);
+      if (!rs.ok()) {
+        std::cout << "open trace error: " << rs.ToString() << std::endl;
+        exit(0);
+      }
+      GraphTraceReplayer replayer(replica, std::move(reader));
+      GraphReplayOptions replay_options;
+      replay_options.num_threads = num_threads;
+      replay_options.fast_forward = 0;
+      rs = replayer.Replay(replay_options);
+      if (!rs.ok()) {
+        std::cout << "replay error: " << rs.ToString() << std::endl;
+      }
+      *replayed = replayer.ops_replayed();
+      *failed = replayer.ops_failed();
+      return replica;
+    };
+
+    // a single-threaded replay reproduces the graph exactly
+    uint64_t replayed, failed;
+    RocksGraph* replica = replay(1, &replayed, &failed);
+    size_t mismatch_nodes = 0;
+    // lazy-delete markers must never reach a read
+    size_t markers = 0;
+    for (node_id_t node = 0; node < n; ++node) {
+      std::unordered_set<node_id_t> lists[2][2];
+      RocksGraph* graphs[2] = {graph_, replica};
+      for (int g = 0; g < 2; g++) {
+        Edges edges_read;
+        if (!graphs[g]->GetAllEdges(node, &edges_read).ok()) continue;
+        for (uint32_t i = 0; i < edges_read.num_edges_out; ++i) {
+          if (edges_read.nxts_out[i].nxt < 0) markers++;
+          lists[g][0].insert(edges_read.nxts_out[i].nxt);
+        }
+        for (uint32_t i = 0; i < edges_read.num_edges_in; ++i) {
+          if (edges_read.nxts_in[i].nxt < 0) markers++;
+          lists[g][1].insert(edges_read.nxts_in[i].nxt);
+        }
+        free_edges(&edges_read);
+      }
+      std::vector<Property> props[2];
+      graph_->GetVertexProperty(node, props[0]);
+      replica->GetVertexProperty(node, props[1]);
+      bool same_props = props[0].size() == props[1].size();
+      for (size_t i = 0; same_props && i < props[0].size(); i++) {
+        same_props = props[0][i].name == props[1][i].name &&
+                     props[0][i].value == props[1][i].value;
+      }
+      bool same_labeled = true;
+      for (edge_label_t label = 0; same_labeled && label < 3; label++) {
+        same_labeled = graph_->GetOutDegree(node, label) ==
+                       replica->GetOutDegree(node, label);
+      }
+      if (lists[0][0] != lists[1][0] || lists[0][1] != lists[1][1] ||
+          !same_props || !same_labeled) {
+        if (mismatch_nodes < 10) {
+          std::cout << "Mismatch node " << node << std::endl;
+        }
+        mismatch_nodes++;
+      }
+    }
+    delete replica;
+
+    // a partitioned replay issues the same operations
+    uint64_t parallel_replayed, parallel_failed;
+    replica = replay(4, &parallel_replayed, &parallel_failed);
+    delete replica;
+
+    std::cout << "TraceReplayTest result: traced_ops=" << traced_ops
+              << " replayed=" << replayed << " failed=" << failed
+              << " parallel_replayed=" << parallel_replayed
+              << " parallel_failed=" << parallel_failed
+              << " mismatched_nodes=" << mismatch_nodes
+              << " markers=" << markers << std::endl;
+    if (replayed == traced_ops && failed == 0 && mismatch_nodes == 0 &&
+        markers == 0 && parallel_replayed == traced_ops &&
+        parallel_failed == 0) {
+      std::cout << "TraceReplayTest: PASS" << std::endl;
+    } else {
+      std::cout << "TraceReplayTest: FAIL" << std::endl;
+    }
+  }
+
+  void GraphStatsTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "GraphStatsTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    InitNodes(n);
+    SetPerfLevel(PerfLevel::kEnableTimeExceptForMutex);
+    GraphPerfContext* perf = get_graph_perf_context();
+    perf->Reset();
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    for (node_id_t i = 0; i < m; i++) {
+      Status s = graph_->AddEdge(dist(rng), dist(rng));
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+    }
+    // a burst of lazy edges on one vertex leaves operands in the memtable
+    const node_id_t hub = 0;
+    const node_id_t burst = 10;
+    for (node_id_t i = 1; i <= burst; i++) {
+      graph_->AddEdgeLazy(hub, i);
+    }
+    GraphPerfContext before = *perf;
+    Edges edges;
+    Status s = graph_->GetAllEdges(hub, &edges);
+    uint32_t hub_edges = 0;
+    if (s.ok()) {
+      hub_edges = edges.num_edges_out + edges.num_edges_in;
+      free_edges(&edges);
+    }
+    uint64_t operands = perf->adj_merge_operand_count -
+                        before.adj_merge_operand_count;
+    uint64_t decoded = perf->decoded_edge_count - before.decoded_edge_count;
+    size_t failures = 0;
+    if (perf->adj_list_read_count != before.adj_list_read_count + 1 ||
+        operands == 0 || decoded != hub_edges) {
+      std::cout << "perf context mismatch: " << perf->ToString() << std::endl;
+      failures++;
+    }
+
+    uint64_t reads = 0, max_operands = 0;
+    std::string stats, bogus;
+    if (!graph_->GetIntProperty(GraphProperties::kAdjListReads, &reads) ||
+        !graph_->GetIntProperty(GraphProperties::kMaxMergeOperands,
+                                &max_operands) ||
+        !graph_->GetProperty(GraphProperties::kStats, &stats) ||
+        graph_->GetProperty("rocksgraph.bogus", &bogus) ||
+        reads < perf->adj_list_read_count || max_operands < operands ||
+        stats.find(GraphProperties::kPolicyMix) == std::string::npos) {
+      std::cout << "property mismatch: reads=" << reads
+                << " max_operands=" << max_operands << std::endl;
+      failures++;
+    }
+    auto statistics = graph_->get_raw_db()->GetOptions().statistics;
+    if (statistics &&
+        statistics->getTickerCount(GRAPH_ADJ_LIST_READS) != reads) {
+      std::cout << "ticker mismatch: "
+                << statistics->getTickerCount(GRAPH_ADJ_LIST_READS)
+                << std::endl;
+      failures++;
+    }
+    if (policy_ == EDGE_UPDATE_ADAPTIVE &&
+        perf->eager_update_count + perf->lazy_update_count == 0) {
+      std::cout << "adaptive policy choices were not counted" << std::endl;
+      failures++;
+    }
+    SetPerfLevel(PerfLevel::kDisable);
+
+    std::cout << stats;
+    std::cout << "GraphStatsTest result: " << perf->ToString(true)
+              << " failures=" << failures << std::endl;
+    if (failures == 0) {
+      std::cout << "GraphStatsTest: PASS" << std::endl;
+    } else {
+      std::cout << "GraphStatsTest: FAIL" << std::endl;
+    }
+  }
+
+  void EdgeFilterTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "EdgeFilterTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "EdgeFilterTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    Options options;
+    options.create_if_missing = true;
+    options.statistics = CreateDBStatistics();
+    RocksGraphOptions graph_options = ScratchGraphOptions("_efilter");
+    graph_options.edge_filter = true;
+    RocksGraph* graph = new RocksGraph(options, graph_options);
+    std::set<std::pair<node_id_t, node_id_t>> model;
+    auto add = [&](node_id_t from, node_id_t to) {
+      model.insert({from, to});
+      if (!is_directed_) model.insert({to, from});
+    };
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    for (node_id_t i = 0; i < n; i++) graph->AddVertex(i);
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      Status s = graph->AddEdge(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      add(from, to);
+    }
+    // deletes are checked through a flushed file as well
+    std::vector<std::pair<node_id_t, node_id_t>> deleted(model.begin(),
+                                                         model.end());
+    std::shuffle(deleted.begin(), deleted.end(), rng);
+    deleted.resize(std::min<size_t>(deleted.size(), m / 20));
+    for (auto& edge : deleted) {
+      if (model.count(edge) == 0) continue;
+      graph->DeleteEdge(edge.first, edge.second);
+      model.erase(edge);
+      if (!is_directed_) model.erase({edge.second, edge.first});
+    }
+    graph->get_raw_db()->Flush(FlushOptions());
+    // a few unflushed edges must not be hidden by the filters
+    for (node_id_t i = 0; i < 10; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      graph->AddEdge(from, to);
+      add(from, to);
+    }
+
+    size_t mismatched = 0, absent_checked = 0;
+    auto check = [&]() {
+      for (auto& edge : model) {
+        bool exists = false;
+        Status s = graph->HasEdge(edge.first, edge.second, &exists);
+        if (!s.ok() || !exists) mismatched++;
+      }
+      for (node_id_t i = 0; i < m; i++) {
+        node_id_t from = dist(rng), to = dist(rng);
+        if (model.count({from, to})) continue;
+        bool exists = true;
+        Status s = graph->HasEdge(from, to, &exists);
+        if (!s.ok() || exists) mismatched++;
+        absent_checked++;
+      }
+      bool missing_vertex = true;
+      graph->HasEdge(n + 1, 0, &missing_vertex);
+      if (missing_vertex) mismatched++;
+    };
+    check();
+    // the compacted files replace the ones whose filters are cached
+    graph->get_raw_db()->CompactRange(CompactRangeOptions(), nullptr, nullptr);
+    check();
+
+    uint64_t checked =
+        options.statistics->getTickerCount(GRAPH_EDGE_FILTER_CHECKED);
+    uint64_t useful =
+        options.statistics->getTickerCount(GRAPH_EDGE_FILTER_USEFUL);
+    delete graph;
+    std::cout << "EdgeFilterTest result: present=" << model.size()
+              << " absent=" << absent_checked << " filter_checked=" << checked
+              << " filter_useful=" << useful << " mismatched=" << mismatched
+              << std::endl;
+    if (mismatched == 0 && useful > 0) {
+      std::cout << "EdgeFilterTest: PASS" << std::endl;
+    } else {
+      std::cout << "EdgeFilterTest: FAIL" << std::endl;
+    }
+  }
+
+  void WeightedEdgeTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "WeightedEdgeTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "WeightedEdgeTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    InitNodes(n);
+    // expected attributes by (from, to); the last write wins
+    std::map<std::pair<node_id_t, node_id_t>, EdgeAttr> model;
+    auto store = [&](node_id_t from, node_id_t to, const EdgeAttr& attr) {
+      model[{from, to}] = attr;
+      if (!is_directed_) model[{to, from}] = attr;
+    };
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::uniform_real_distribution<float> weight_dist(0.0f, 100.0f);
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      EdgeAttr attr;
+      Status s;
+      // a tenth of the edges go in without attributes
+      if (i % 10 == 0) {
+        s = graph_->AddEdge(from, to);
+      } else {
+        attr.weight = weight_dist(rng);
+        attr.timestamp = static_cast<uint64_t>(i);
+        attr.label = static_cast<uint32_t>(i % 4);
+        s = graph_->AddEdge(from, to, attr);
+      }
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      store(from, to, attr);
+      if (i == m / 2) graph_->get_raw_db()->Flush(FlushOptions());
+    }
+    for (node_id_t i = 0; i < m / 20; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      graph_->DeleteEdge(from, to);
+      model.erase({from, to});
+      if (!is_directed_) model.erase({to, from});
+    }
+    graph_->get_raw_db()->CompactRange(CompactRangeOptions(), nullptr,
+                                       nullptr);
+
+    const size_t k = 5;
+    const uint64_t start_time = static_cast<uint64_t>(m / 4);
+    const uint64_t end_time = static_cast<uint64_t>(m / 2);
+    size_t mismatched = 0, checked = 0;
+    std::vector<int> directions = {EDGE_DIRECTION_OUT};
+    if (is_directed_) directions.push_back(EDGE_DIRECTION_IN);
+    for (node_id_t v = 0; v < std::min<node_id_t>(n, 200); v++) {
+      for (int direction : directions) {
+        std::vector<std::pair<node_id_t, float>> expected_top;
+        std::vector<node_id_t> expected_range;
+        for (auto& entry : model) {
+          node_id_t self = direction == EDGE_DIRECTION_OUT
+                               ? entry.first.first
+                               : entry.first.second;
+          node_id_t other = direction == EDGE_DIRECTION_OUT
+                                ? entry.first.second
+                                : entry.first.first;
+          if (self != v) continue;
+          expected_top.emplace_back(other, entry.second.weight);
+          if (entry.second.timestamp >= start_time &&
+              entry.second.timestamp < end_time) {
+            expected_range.push_back(other);
+          }
+        }
+        std::sort(expected_top.begin(), expected_top.end(),
+                  [](const std::pair<node_id_t, float>& a,
+                     const std::pair<node_id_t, float>& b) {
+                    return a.second != b.second ? a.second > b.second
+                                                : a.first < b.first;
+                  });
+        if (expected_top.size() > k) expected_top.resize(k);
+        std::sort(expected_range.begin(), expected_range.end());
+
+        std::vector<std::pair<node_id_t, float>> top;
+        std::vector<node_id_t> range;
+        Status s = graph_->GetTopKNeighborsByWeight(v, k, direction, &top);
+        if (s.ok()) {
+          s = graph_->GetNeighborsInTimeRange(v, start_time, end_time,
+                                              direction, &range);
+        }
+        if (s.IsNotFound()) {
+          top.clear();
+          range.clear();
+        } else if (!s.ok()) {
+          std::cout << "query error: " << s.ToString() << std::endl;
+          exit(0);
+        }
+        std::sort(range.begin(), range.end());
+        if (top != expected_top || range != expected_range) mismatched++;
+        checked++;
+      }
+    }
+
+    std::cout << "WeightedEdgeTest result: edges=" << model.size()
+              << " checked=" << checked << " mismatched=" << mismatched
+              << std::endl;
+    if (mismatched == 0) {
+      std::cout << "WeightedEdgeTest: PASS" << std::endl;
+    } else {
+      std::cout << "WeightedEdgeTest: FAIL" << std::endl;
+    }
+  }
+
+  void LabeledEdgeTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "LabeledEdgeTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    InitNodes(n);
+    const edge_label_t num_labels = 4;
+    // expected (from, to) pairs per label, stored as out lists
+    std::map<edge_label_t, std::set<std::pair<node_id_t, node_id_t>>> model;
+    auto add = [&](edge_label_t label, node_id_t from, node_id_t to) {
+      model[label].insert({from, to});
+      if (!is_directed_) model[label].insert({to, from});
+    };
+    auto remove = [&](edge_label_t label, node_id_t from, node_id_t to) {
+      model[label].erase({from, to});
+      if (!is_directed_) model[label].erase({to, from});
+    };
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::uniform_int_distribution<edge_label_t> label_dist(0, num_labels - 1);
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      edge_label_t label = label_dist(rng);
+      Status s = graph_->AddEdge(from, to, label);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      add(label, from, to);
+      if (i == m / 2) graph_->get_raw_db()->Flush(FlushOptions());
+    }
+    for (node_id_t i = 0; i < m / 10; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      edge_label_t label = label_dist(rng);
+      graph_->DeleteEdge(from, to, label);
+      remove(label, from, to);
+    }
+    size_t mismatched = 0, checked = 0;
+    // the attribute label cannot disagree with the list's
+    EdgeAttr other_label;
+    other_label.label = 1;
+    if (!graph_->AddEdge(0, 1, 2, &other_label).IsInvalidArgument()) {
+      mismatched++;
+    }
+
+    auto expected_list = [&](edge_label_t label, node_id_t v, bool out) {
+      std::vector<node_id_t> list;
+      for (auto& edge : model[label]) {
+        if (out && edge.first == v) list.push_back(edge.second);
+        if (!out && edge.second == v) list.push_back(edge.first);
+      }
+      std::sort(list.begin(), list.end());
+      return list;
+    };
+    auto to_vector = [](const Edge* list, uint32_t num) {
+      std::vector<node_id_t> ids;
+      for (uint32_t i = 0; i < num; i++) ids.push_back(list[i].nxt);
+      return ids;
+    };
+    for (node_id_t v = 0; v < std::min<node_id_t>(n, 200); v++) {
+      std::vector<LabeledEdges> lists;
+      Status s = graph_->GetAllLabeledEdges(v, &lists);
+      if (!s.ok()) {
+        std::cout << "prefix scan error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      for (edge_label_t label = 0; label < num_labels; label++) {
+        std::vector<node_id_t> out = expected_list(label, v, true);
+        std::vector<node_id_t> in;
+        if (is_directed_) in = expected_list(label, v, false);
+        Edges edges;
+        s = graph_->GetAllEdges(v, label, &edges);
+        if (!s.ok() && !s.IsNotFound()) {
+          std::cout << "get error: " << s.ToString() << std::endl;
+          exit(0);
+        }
+        node_id_t out_degree = static_cast<node_id_t>(out.size());
+        node_id_t in_degree =
+            static_cast<node_id_t>(is_directed_ ? in.size() : out.size());
+        if (to_vector(edges.nxts_out, edges.num_edges_out) != out ||
+            to_vector(edges.nxts_in, edges.num_edges_in) != in ||
+            graph_->GetOutDegree(v, label) != out_degree ||
+            graph_->GetInDegree(v, label) != in_degree) {
+          mismatched++;
+        }
+        for (uint32_t i = 0; edges.attrs_out && i < edges.num_edges_out; i++) {
+          if (edges.attrs_out[i].label != label) mismatched++;
+        }
+        free_edges(&edges);
+        // the prefix scan returns the same lists
+        auto scanned = std::find_if(
+            lists.begin(), lists.end(),
+            [label](const LabeledEdges& l) { return l.label == label; });
+        std::vector<node_id_t> scanned_out, scanned_in;
+        if (scanned != lists.end()) {
+          scanned_out = to_vector(scanned->edges.nxts_out,
+                                  scanned->edges.num_edges_out);
+          scanned_in = to_vector(scanned->edges.nxts_in,
+                                 scanned->edges.num_edges_in);
+        }
+        if (scanned_out != out || scanned_in != in) mismatched++;
+        checked++;
+      }
+      for (auto& list : lists) free_edges(&list.edges);
+      // labeled edges stay out of the unlabeled list
+      Edges unlabeled;
+      if (graph_->GetAllEdges(v, &unlabeled).ok()) {
+        if (unlabeled.num_edges_out + unlabeled.num_edges_in != 0) {
+          mismatched++;
+        }
+        free_edges(&unlabeled);
+      }
+    }
+    node_id_t estimate = 0;
+    for (node_id_t v = 0; v < n && estimate == 0; v++) {
+      estimate = graph_->GetLabelDegreeApproximate(v, 0);
+    }
+    if (!model[0].empty() && estimate == 0) mismatched++;
+
+    size_t num_edges = 0;
+    for (auto& label_edges : model) num_edges += label_edges.second.size();
+    std::cout << "LabeledEdgeTest result: labeled_lists=" << num_edges
+              << " checked=" << checked << " mismatched=" << mismatched
+              << std::endl;
+    if (mismatched == 0) {
+      std::cout << "LabeledEdgeTest: PASS" << std::endl;
+    } else {
+      std::cout << "LabeledEdgeTest: FAIL" << std::endl;
+    }
+  }
+
+  void DeleteVertexTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "DeleteVertexTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      graph_->AddEdge(0, 1);
+      bool refused = graph_->DeleteVertex(0).IsNotSupported();
+      std::cout << "DeleteVertexTest: " << (refused ? "PASS" : "FAIL")
+                << std::endl;
+      return;
+    }
+    for (node_id_t i = 0; i < n; i++) graph_->AddVertex(i);
+    std::set<std::pair<node_id_t, node_id_t>> model;
+    std::set<std::pair<node_id_t, node_id_t>> labeled_model;
+    auto insert = [&](std::set<std::pair<node_id_t, node_id_t>>& edges,
+                      node_id_t from, node_id_t to) {
+      edges.insert({from, to});
+      if (!is_directed_) edges.insert({to, from});
+    };
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      Status s = graph_->AddEdge(from, to);
+      if (s.ok() && i % 4 == 0) {
+        s = graph_->AddEdge(from, to, static_cast<edge_label_t>(1));
+        insert(labeled_model, from, to);
+      }
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      insert(model, from, to);
+      if (i == m / 2) graph_->get_raw_db()->Flush(FlushOptions());
+    }
+    std::vector<node_id_t> victims;
+    for (node_id_t i = 0; i < std::max<node_id_t>(1, n / 50); i++) {
+      victims.push_back(dist(rng));
+    }
+    std::sort(victims.begin(), victims.end());
+    victims.erase(std::unique(victims.begin(), victims.end()), victims.end());
+    graph_->AddVertexProperty(victims[0], Property{"name", "victim"});
+    node_id_t vertices_before = graph_->CountVertex();
+    for (node_id_t v : victims) {
+      Status s = graph_->DeleteVertex(v);
+      if (!s.ok()) {
+        std::cout << "delete vertex error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+    }
+    std::set<node_id_t> deleted(victims.begin(), victims.end());
+    for (auto* edges : {&model, &labeled_model}) {
+      for (auto it = edges->begin(); it != edges->end();) {
+        if (deleted.count(it->first) || deleted.count(it->second)) {
+          it = edges->erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+    auto expected = [](const std::set<std::pair<node_id_t, node_id_t>>& edges,
+                       node_id_t v, bool out) {
+      std::vector<node_id_t> list;
+      for (auto& edge : edges) {
+        if (out && edge.first == v) list.push_back(edge.second);
+        if (!out && edge.second == v) list.push_back(edge.first);
+      }
+      std::sort(list.begin(), list.end());
+      return list;
+    };
+    auto to_vector = [](const Edge* list, uint32_t num) {
+      std::vector<node_id_t> ids;
+      for (uint32_t i = 0; i < num; i++) ids.push_back(list[i].nxt);
+      return ids;
+    };
+    size_t mismatched = 0;
+    auto check = [&]() {
+      for (node_id_t v = 0; v < n; v++) {
+        Edges edges;
+        Status s = graph_->GetAllEdges(v, &edges);
+        if (deleted.count(v)) {
+          if (!s.IsNotFound()) mismatched++;
+          if (s.ok()) free_edges(&edges);
+          std::vector<Property> props;
+          s = graph_->GetVertexProperty(v, props);
+          if (s.ok() && !props.empty()) mismatched++;
+          continue;
+        }
+        if (!s.ok() ||
+            to_vector(edges.nxts_out, edges.num_edges_out) !=
+                expected(model, v, true) ||
+            (is_directed_ && to_vector(edges.nxts_in, edges.num_edges_in) !=
+                                 expected(model, v, false))) {
+          mismatched++;
+        }
+        if (s.ok()) free_edges(&edges);
+        s = graph_->GetAllEdges(v, 1, &edges);
+        if (to_vector(edges.nxts_out, edges.num_edges_out) !=
+            expected(labeled_model, v, true)) {
+          mismatched++;
+        }
+        if (s.ok()) free_edges(&edges);
+      }
+    };
+    check();
+    // the delete operands survive flush and compaction
+    graph_->get_raw_db()->Flush(FlushOptions());
+    graph_->get_raw_db()->CompactRange(CompactRangeOptions(), nullptr,
+                                       nullptr);
+    check();
+    if (graph_->CountVertex() !=
+        vertices_before - static_cast<node_id_t>(victims.size())) {
+      mismatched++;
+    }
+
+    std::cout << "DeleteVertexTest result: deleted=" << victims.size()
+              << " remaining_edges=" << model.size()
+              << " mismatched=" << mismatched << std::endl;
+    if (mismatched == 0) {
+      std::cout << "DeleteVertexTest: PASS" << std::endl;
+    } else {
+      std::cout << "DeleteVertexTest: FAIL" << std::endl;
+    }
+  }
+
+  void CommonNeighborsTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "CommonNeighborsTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "CommonNeighborsTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    InitNodes(n);
+    std::vector<std::set<node_id_t>> out(n), in(n);
+    auto insert = [&](node_id_t from, node_id_t to) {
+      out[from].insert(to);
+      if (is_directed_) {
+        in[to].insert(from);
+      } else {
+        out[to].insert(from);
+      }
+    };
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::vector<std::pair<node_id_t, node_id_t>> added;
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      Status s = graph_->AddEdge(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      insert(from, to);
+      added.emplace_back(from, to);
+      if (i == m / 2) graph_->get_raw_db()->Flush(FlushOptions());
+    }
+    // delete edges that exist so no delete operand outlives compaction
+    for (node_id_t i = 0; i < m / 20; i++) {
+      auto edge = added[dist(rng) % added.size()];
+      if (!out[edge.first].count(edge.second)) continue;
+      graph_->DeleteEdge(edge.first, edge.second);
+      out[edge.first].erase(edge.second);
+      if (is_directed_) {
+        in[edge.second].erase(edge.first);
+      } else {
+        out[edge.second].erase(edge.first);
+      }
+    }
+    graph_->get_raw_db()->CompactRange(CompactRangeOptions(), nullptr,
+                                       nullptr);
+
+    auto neighborhood = [&](node_id_t v, int direction) {
+      std::set<node_id_t> ids;
+      if (direction != EDGE_DIRECTION_IN || !is_directed_) ids = out[v];
+      if (direction != EDGE_DIRECTION_OUT && is_directed_) {
+        ids.insert(in[v].begin(), in[v].end());
+      }
+      return ids;
+    };
+    size_t mismatched = 0, pairs = 0;
+    uint64_t common_total = 0;
+    std::vector<int> directions = {EDGE_DIRECTION_OUT};
+    if (is_directed_) {
+      directions.push_back(EDGE_DIRECTION_IN);
+      directions.push_back(EDGE_DIRECTION_BOTH);
+    }
+    for (node_id_t u = 0; u < std::min<node_id_t>(n, 100); u++) {
+      // two-hop candidates share at least one neighbor
+      std::set<node_id_t> candidates;
+      for (node_id_t w : neighborhood(u, EDGE_DIRECTION_BOTH)) {
+        for (node_id_t v : neighborhood(w, EDGE_DIRECTION_BOTH)) {
+          if (candidates.size() < 40) candidates.insert(v);
+        }
+      }
+      for (int i = 0; i < 5; i++) candidates.insert(dist(rng));
+      std::vector<node_id_t> vs(candidates.begin(), candidates.end());
+      vs.push_back(n + 1);  // unknown vertex
+      for (int direction : directions) {
+        std::vector<uint64_t> counts;
+        std::vector<double> jaccard, adamic_adar;
+        Status s = graph_->CommonNeighbors(u, vs, direction, &counts);
+        if (s.ok()) s = graph_->Jaccard(u, vs, direction, &jaccard);
+        if (s.ok()) s = graph_->AdamicAdar(u, vs, direction, &adamic_adar);
+        if (!s.ok() || counts.size() != vs.size() ||
+            jaccard.size() != vs.size() || adamic_adar.size() != vs.size()) {
+          mismatched++;
+          continue;
+        }
+        std::set<node_id_t> nu = neighborhood(u, direction);
+        for (size_t i = 0; i < vs.size(); i++) {
+          std::set<node_id_t> nv;
+          if (vs[i] < n) nv = neighborhood(vs[i], direction);
+          uint64_t common = 0;
+          double aa = 0;
+          for (node_id_t w : nu) {
+            if (!nv.count(w)) continue;
+            common++;
+            size_t degree = out[w].size() + in[w].size();
+            if (degree > 1) aa += 1.0 / std::log(static_cast<double>(degree));
+          }
+          size_t total = nu.size() + nv.size() - common;
+          double expected_jaccard =
+              total > 0 ? static_cast<double>(common) / total : 0;
+          if (counts[i] != common ||
+              std::abs(jaccard[i] - expected_jaccard) > 1e-9 ||
+              std::abs(adamic_adar[i] - aa) > 1e-9) {
+            mismatched++;
+          }
+          common_total += common;
+          pairs++;
+        }
+      }
+    }
+    // pair batches agree with the per-source calls
+    std::vector<std::pair<node_id_t, node_id_t>> batch;
+    for (int i = 0; i < 200; i++) batch.emplace_back(dist(rng), dist(rng));
+    std::vector<double> batch_scores;
+    Status s = graph_->LinkPredictionScores(batch, kLinkCommonNeighbors,
+                                            EDGE_DIRECTION_OUT, &batch_scores);
+    for (size_t i = 0; s.ok() && i < batch.size(); i++) {
+      uint64_t count = 0;
+      s = graph_->CommonNeighbors(batch[i].first, batch[i].second,
+                                  EDGE_DIRECTION_OUT, &count);
+      if (count != static_cast<uint64_t>(batch_scores[i])) mismatched++;
+    }
+    if (!s.ok()) mismatched++;
+
+    std::cout << "CommonNeighborsTest result: pairs=" << pairs
+              << " common=" << common_total << " mismatched=" << mismatched
+              << std::endl;
+    if (mismatched == 0) {
+      std::cout << "CommonNeighborsTest: PASS" << std::endl;
+    } else {
+      std::cout << "CommonNeighborsTest: FAIL" << std::endl;
+    }
+  }
+
+  void PathQueryTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "PathQueryTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "PathQueryTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    InitNodes(n);
+    std::vector<std::set<node_id_t>> out(n);
+    std::mt19937 rng(29);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    // sparse enough that many pairs are several hops apart
+    for (node_id_t i = 0; i < std::min<node_id_t>(m, n * 2); i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      Status s = graph_->AddEdge(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      out[from].insert(to);
+      if (!is_directed_) out[to].insert(from);
+      if (i == n) graph_->get_raw_db()->Flush(FlushOptions());
+    }
+    auto distance = [&](node_id_t u, node_id_t v) {
+      std::vector<int> hops(n, -1);
+      std::vector<node_id_t> queue = {u};
+      hops[u] = 0;
+      for (size_t i = 0; i < queue.size(); i++) {
+        for (node_id_t w : out[queue[i]]) {
+          if (hops[w] >= 0) continue;
+          hops[w] = hops[queue[i]] + 1;
+          queue.push_back(w);
+        }
+      }
+      return hops[v];
+    };
+
+    const uint32_t kMaxHops = 6;
+    size_t mismatched = 0, found = 0;
+    node_id_t far_u = -1, far_v = -1;
+    for (int i = 0; i < 300; i++) {
+      node_id_t u = dist(rng), v = dist(rng);
+      int expected = distance(u, v);
+      std::vector<node_id_t> path;
+      bool reachable = false;
+      Status s = graph_->ShortestPath(u, v, kMaxHops, &path);
+      if (s.ok()) s = graph_->Reachable(u, v, kMaxHops, &reachable);
+      if (!s.ok()) {
+        mismatched++;
+        continue;
+      }
+      if (expected < 0 || expected > static_cast<int>(kMaxHops)) {
+        if (!path.empty() || reachable) mismatched++;
+        continue;
+      }
+      bool valid = reachable &&
+                   path.size() == static_cast<size_t>(expected) + 1 &&
+                   path.front() == u && path.back() == v;
+      for (size_t j = 0; valid && j + 1 < path.size(); j++) {
+        valid = out[path[j]].count(path[j + 1]) > 0;
+      }
+      if (!valid) mismatched++;
+      found++;
+      if (expected >= 3) {
+        far_u = u;
+        far_v = v;
+      }
+    }
+    // a budget below what the search needs stops it early
+    if (far_u >= 0) {
+      PathQueryOptions options;
+      options.max_expanded_vertices = 1;
+      std::vector<node_id_t> path;
+      Status s = graph_->ShortestPath(far_u, far_v, kMaxHops, &path, options);
+      if (!s.IsIncomplete()) mismatched++;
+    }
+
+    std::cout << "PathQueryTest result: found=" << found
+              << " budget_checked=" << (far_u >= 0)
+              << " mismatched=" << mismatched << std::endl;
+    if (mismatched == 0) {
+      std::cout << "PathQueryTest: PASS" << std::endl;
+    } else {
+      std::cout << "PathQueryTest: FAIL" << std::endl;
+    }
+  }
+
+  void TemporalTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "TemporalTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "TemporalTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    Options options;
+    options.create_if_missing = true;
+    RocksGraphOptions graph_options = ScratchGraphOptions("_temporal");
+    graph_options.temporal = true;
+    RocksGraph* graph = new RocksGraph(options, graph_options);
+    using EdgeSet = std::set<std::pair<node_id_t, node_id_t>>;
+    // the edge set after each epoch, written at timestamp 100 * (epoch + 1)
+    std::vector<EdgeSet> epochs;
+    EdgeSet model;
+    std::mt19937 rng(31);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    graph->SetWriteTimestamp(10);
+    for (node_id_t i = 0; i < n; i++) graph->AddVertex(i);
+    for (int epoch = 0; epoch < 3; epoch++) {
+      graph->SetWriteTimestamp(100 * (epoch + 1));
+      for (node_id_t i = 0; i < m / 3; i++) {
+        node_id_t from = dist(rng), to = dist(rng);
+        Status s = graph->AddEdge(from, to);
+        if (!s.ok()) {
+          std::cout << "add error: " << s.ToString() << std::endl;
+          exit(0);
+        }
+        model.insert({from, to});
+        if (!is_directed_) model.insert({to, from});
+      }
+      if (epoch > 0) {
+        std::vector<std::pair<node_id_t, node_id_t>> edges(model.begin(),
+                                                           model.end());
+        std::shuffle(edges.begin(), edges.end(), rng);
+        edges.resize(edges.size() / 10);
+        for (auto& edge : edges) {
+          if (!model.count(edge)) continue;
+          graph->DeleteEdge(edge.first, edge.second);
+          model.erase(edge);
+          if (!is_directed_) model.erase({edge.second, edge.first});
+        }
+      }
+      epochs.push_back(model);
+      graph->get_raw_db()->Flush(FlushOptions());
+    }
+    graph->SetWriteTimestamp(0);
+
+    auto expected = [](const EdgeSet& edges, node_id_t v, bool out) {
+      std::vector<node_id_t> list;
+      for (auto& edge : edges) {
+        if (out && edge.first == v) list.push_back(edge.second);
+        if (!out && edge.second == v) list.push_back(edge.first);
+      }
+      std::sort(list.begin(), list.end());
+      return list;
+    };
+    auto live = [](const Edge* list, uint32_t num) {
+      std::vector<node_id_t> ids;
+      for (uint32_t i = 0; i < num; i++) {
+        if (list[i].nxt >= 0) ids.push_back(list[i].nxt);
+      }
+      return ids;
+    };
+    size_t mismatched = 0, checked = 0;
+    auto check = [&](uint64_t as_of, const EdgeSet& edges) {
+      for (node_id_t v = 0; v < std::min<node_id_t>(n, 200); v++) {
+        Edges list;
+        Status s = graph->GetAllEdgesAsOf(v, as_of, &list);
+        if (!s.ok()) {
+          mismatched++;
+          continue;
+        }
+        if (live(list.nxts_out, list.num_edges_out) !=
+                expected(edges, v, true) ||
+            (is_directed_ && live(list.nxts_in, list.num_edges_in) !=
+                                 expected(edges, v, false))) {
+          mismatched++;
+        }
+        free_edges(&list);
+        checked++;
+      }
+      // two hops over out-edges from a few vertices
+      for (node_id_t v = 0; v < std::min<node_id_t>(n, 20); v++) {
+        std::set<node_id_t> want = {v};
+        std::set<node_id_t> frontier = {v};
+        for (int hop = 0; hop < 2; hop++) {
+          std::set<node_id_t> next;
+          for (node_id_t x : frontier) {
+            for (node_id_t y : expected(edges, x, true)) {
+              if (want.insert(y).second) next.insert(y);
+            }
+          }
+          frontier.swap(next);
+        }
+        std::vector<node_id_t> reached;
+        Status s = graph->KHopAsOf(v, 2, as_of, &reached);
+        if (!s.ok() ||
+            std::set<node_id_t>(reached.begin(), reached.end()) != want ||
+            reached.size() != want.size()) {
+          mismatched++;
+        }
+      }
+    };
+    check(50, EdgeSet());
+    check(150, epochs[0]);
+    check(200, epochs[1]);
+    check(1000, epochs[2]);
+
+    // the latest lists agree with the newest history
+    for (node_id_t v = 0; v < std::min<node_id_t>(n, 20); v++) {
+      std::vector<node_id_t> latest, historical;
+      Status s = graph->KHop(v, 2, &latest);
+      if (s.ok()) s = graph->KHopAsOf(v, 2, 1000, &historical);
+      if (!s.ok() || latest != historical) mismatched++;
+    }
+
+    // versions before the cutoff collapse; reads there are refused
+    Status s = graph->TrimHistory(200);
+    if (!s.ok()) mismatched++;
+    graph->get_raw_db()->CompactRange(CompactRangeOptions(), nullptr,
+                                      nullptr);
+    check(1000, epochs[2]);
+    Edges list;
+    s = graph->GetAllEdgesAsOf(0, 150, &list);
+    if (s.ok()) {
+      free_edges(&list);
+      mismatched++;
+    }
+    delete graph;
+
+    std::cout << "TemporalTest result: checked=" << checked
+              << " mismatched=" << mismatched << std::endl;
+    if (mismatched == 0) {
+      std::cout << "TemporalTest: PASS" << std::endl;
+    } else {
+      std::cout << "TemporalTest: FAIL" << std::endl;
+    }
+  }
+
+  void ChangeStreamTest(node_id_t n, node_id_t m) {
+    if (n <= 2 || m <= 0) {
+      std::cout << "ChangeStreamTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    Options options;
+    options.create_if_missing = true;
+    // keep the WAL files the flush below makes obsolete
+    options.WAL_ttl_seconds = 3600;
+    RocksGraph* graph =
+        new RocksGraph(options, ScratchGraphOptions("_changes"));
+    DB* db = graph->get_raw_db();
+    SequenceNumber since = db->GetLatestSequenceNumber() + 1;
+
+    using EdgeSet = std::set<std::pair<node_id_t, node_id_t>>;
+    EdgeSet model;
+    auto add_to = [&](EdgeSet* edges, node_id_t from, node_id_t to) {
+      edges->insert({from, to});
+      if (!is_directed_) edges->insert({to, from});
+    };
+    auto erase_from = [&](EdgeSet* edges, node_id_t from, node_id_t to) {
+      edges->erase({from, to});
+      if (!is_directed_) edges->erase({to, from});
+    };
+    std::mt19937 rng(47);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    size_t vertex_props = 0, edge_props = 0;
+    for (node_id_t i = 0; i < n; i++) graph->AddVertex(i);
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      Status s = i % 2 ? graph->AddEdge(from, to)
+                       : graph->AddEdgeLazy(from, to);
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+      add_to(&model, from, to);
+      if (i % 50 == 0) {
+        graph->AddEdgeProperty(from, to, Property{"w", std::to_string(i)});
+        edge_props++;
+      }
+      if (i == m / 2) db->Flush(FlushOptions());
+    }
+    for (node_id_t i = 0; i < n; i += 10) {
+      graph->AddVertexProperty(i, Property{"name", std::to_string(i)});
+      vertex_props++;
+    }
+    // FULL_LAZY cannot delete edges
+    if (policy_ != EDGE_UPDATE_FULL_LAZY) {
+      std::vector<std::pair<node_id_t, node_id_t>> edges(model.begin(),
+                                                         model.end());
+      std::shuffle(edges.begin(), edges.end(), rng);
+      edges.resize(edges.size() / 10);
+      for (auto& edge : edges) {
+        if (!model.count(edge)) continue;
+        graph->DeleteEdge(edge.first, edge.second);
+        erase_from(&model, edge.first, edge.second);
+      }
+    }
+    std::map<edge_label_t, EdgeSet> labeled_model, labeled_replayed;
+    for (node_id_t i = 0; i < m / 10; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      edge_label_t label = static_cast<edge_label_t>(i % 3 + 1);
+      graph->AddEdge(from, to, label);
+      add_to(&labeled_model[label], from, to);
+      if (i % 4 == 3) {
+        graph->DeleteEdge(from, to, label);
+        erase_from(&labeled_model[label], from, to);
+      }
+    }
+
+    // replay the stream in small groups, reopening at every checkpoint
+    EdgeSet replayed;
+    std::set<node_id_t> vertices;
+    size_t changes = 0, groups = 0, errors = 0, seen_vertex_props = 0,
+           seen_edge_props = 0;
+    SequenceNumber checkpoint = since;
+    while (true) {
+      std::unique_ptr<GraphChangeIterator> iter;
+      Status s = graph->GetChangesSince(checkpoint, &iter, 100);
+      if (!s.ok()) {
+        std::cout << "stream error: " << s.ToString() << std::endl;
+        errors++;
+        break;
+      }
+      if (!iter->Valid()) break;
+      for (const GraphChange& change : iter->changes()) {
+        changes++;
+        if (change.sequence < since) errors++;
+        switch (change.type) {
+          case kGraphChangeAddVertex:
+            vertices.insert(change.src);
+            break;
+          case kGraphChangeDeleteVertex:
+            vertices.erase(change.src);
+            break;
+          case kGraphChangeAddEdge:
+            add_to(&replayed, change.src, change.dst);
+            break;
+          case kGraphChangeDeleteEdge:
+            erase_from(&replayed, change.src, change.dst);
+            break;
+          case kGraphChangeSetVertexProperty:
+            seen_vertex_props++;
+            break;
+          case kGraphChangeSetEdgeProperty:
+            seen_edge_props++;
+            break;
+          case kGraphChangeAddLabeledEdge:
+            add_to(&labeled_replayed[change.label], change.src, change.dst);
+            break;
+          case kGraphChangeDeleteLabeledEdge:
+            erase_from(&labeled_replayed[change.label], change.src,
+                       change.dst);
+            break;
+          default:
+            errors++;
+        }
+      }
+      if (iter->checkpoint() <= checkpoint) errors++;
+      checkpoint = iter->checkpoint();
+      groups++;
+    }
+    if (checkpoint != db->GetLatestSequenceNumber() + 1) errors++;
+    size_t mismatched = 0;
+    if (replayed != model || labeled_replayed != labeled_model) {
+      mismatched++;
+    }
+    if (vertices.size() != static_cast<size_t>(n)) mismatched++;
+    if (seen_vertex_props != vertex_props || seen_edge_props != edge_props) {
+      mismatched++;
+    }
+    delete graph;
+
+    std::cout << "ChangeStreamTest result: changes=" << changes
+              << " groups=" << groups << " edges=" << replayed.size() << "/"
+              << model.size() << " mismatched=" << mismatched
+              << " errors=" << errors << std::endl;
+    if (mismatched == 0 && errors == 0) {
+      std::cout << "ChangeStreamTest: PASS" << std::endl;
+    } else {
+      std::cout << "ChangeStreamTest: FAIL" << std::endl;
+    }
+  }
+
+  void IncrementalPageRankTest(node_id_t n, node_id_t m, int rounds) {
+    if (n <= 2 || m <= 0 || rounds <= 0) {
+      std::cout << "IncrementalPageRankTest skipped: invalid sizes."
+                << std::endl;
+      return;
+    }
+    Options options;
+    options.create_if_missing = true;
+    RocksGraph* graph =
+        new RocksGraph(options, ScratchGraphOptions("_pagerank"));
+    IncrementalRankOptions rank_options;
+    rank_options.tolerance = 1e-7;
+    IncrementalPageRank rank(graph, rank_options);
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      bool refused = rank.Rebuild().IsNotSupported();
+      delete graph;
+      std::cout << "IncrementalPageRankTest result: FULL_LAZY refused="
+                << refused << std::endl;
+      std::cout << "IncrementalPageRankTest: " << (refused ? "PASS" : "FAIL")
+                << std::endl;
+      return;
+    }
+
+    using EdgeSet = std::set<std::pair<node_id_t, node_id_t>>;
+    EdgeSet model;
+    std::set<node_id_t> vertices;
+    auto add_to = [&](node_id_t from, node_id_t to) {
+      model.insert({from, to});
+      if (!is_directed_) model.insert({to, from});
+    };
+    auto erase_from = [&](node_id_t from, node_id_t to) {
+      model.erase({from, to});
+      if (!is_directed_) model.erase({to, from});
+    };
+    std::mt19937 rng(43);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    for (node_id_t i = 0; i < n; i++) {
+      graph->AddVertex(i);
+      vertices.insert(i);
+    }
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      graph->AddEdge(from, to);
+      add_to(from, to);
+    }
+
+    // power iteration over the model, against the scores and degrees
+    const double damping = rank_options.damping;
+    size_t errors = 0;
+    double max_error = 0;
+    auto check = [&]() {
+      std::map<node_id_t, uint32_t> out_degree, in_degree;
+      for (auto& edge : model) {
+        out_degree[edge.first]++;
+        in_degree[edge.second]++;
+      }
+      std::map<node_id_t, double> x, next;
+      for (node_id_t v : vertices) x[v] = 1;
+      for (int iter = 0; iter < 200; iter++) {
+        for (node_id_t v : vertices) next[v] = 1 - damping;
+        for (auto& edge : model) {
+          next[edge.second] += damping * x[edge.first] / out_degree[edge.first];
+        }
+        x.swap(next);
+      }
+      if (rank.num_vertices() != vertices.size()) errors++;
+      for (node_id_t v : vertices) {
+        double score, centrality;
+        Status s = rank.GetScore(v, &score);
+        if (s.ok()) s = rank.GetDegreeCentrality(v, EDGE_DIRECTION_OUT,
+                                                 &centrality);
+        if (!s.ok()) {
+          errors++;
+          continue;
+        }
+        max_error = std::max(max_error, std::fabs(score - x[v]));
+        double expected = 1.0 * out_degree[v] / (vertices.size() - 1);
+        if (std::fabs(centrality - expected) > 1e-9) errors++;
+        if (!is_directed_) continue;
+        s = rank.GetDegreeCentrality(v, EDGE_DIRECTION_IN, &centrality);
+        expected = 1.0 * in_degree[v] / (vertices.size() - 1);
+        if (!s.ok() || std::fabs(centrality - expected) > 1e-9) errors++;
+      }
+    };
+
+    Status s = rank.Rebuild();
+    if (!s.ok()) {
+      std::cout << "rebuild error: " << s.ToString() << std::endl;
+      errors++;
+    }
+    uint64_t rebuild_pushes = rank.pushes();
+    check();
+
+    // small batches of edge updates and one vertex deletion per round
+    uint64_t max_round_pushes = 0;
+    node_id_t next_vertex = n;
+    for (int round = 0; round < rounds; round++) {
+      uint64_t before = rank.pushes();
+      for (node_id_t i = 0; i < m / 100 + 1; i++) {
+        node_id_t from = dist(rng), to = dist(rng);
+        if (!vertices.count(from) || !vertices.count(to)) continue;
+        if (i % 3 == 0 && model.count({from, to})) {
+          graph->DeleteEdge(from, to);
+          erase_from(from, to);
+        } else {
+          graph->AddEdge(from, to);
+          add_to(from, to);
+        }
+      }
+      node_id_t victim = dist(rng);
+      if (vertices.count(victim)) {
+        graph->DeleteVertex(victim);
+        vertices.erase(victim);
+        for (auto it = model.begin(); it != model.end();) {
+          bool linked = it->first == victim || it->second == victim;
+          it = linked ? model.erase(it) : std::next(it);
+        }
+      }
+      graph->AddVertex(next_vertex);
+      vertices.insert(next_vertex);
+      node_id_t to = dist(rng);
+      if (vertices.count(to)) {
+        graph->AddEdge(next_vertex, to);
+        add_to(next_vertex, to);
+      }
+      next_vertex++;
+      s = rank.CatchUp();
+      if (!s.ok()) {
+        std::cout << "catch up error: " << s.ToString() << std::endl;
+        errors++;
+      }
+      max_round_pushes = std::max(max_round_pushes, rank.pushes() - before);
+      double score;
+      if (!rank.GetScore(victim, &score).IsNotFound()) errors++;
+      check();
+    }
+    uint64_t rebuilds = rank.rebuilds();
+    delete graph;
+
+    std::cout << "IncrementalPageRankTest result: vertices=" << vertices.size()
+              << " edges=" << model.size() << " max_error=" << max_error
+              << " rebuild_pushes=" << rebuild_pushes
+              << " max_round_pushes=" << max_round_pushes
+              << " rebuilds=" << rebuilds << " errors=" << errors << std::endl;
+    if (errors == 0 && max_error < 1e-3 && rebuilds == 1 &&
+        max_round_pushes < rebuild_pushes) {
+      std::cout << "IncrementalPageRankTest: PASS" << std::endl;
+    } else {
+      std::cout << "IncrementalPageRankTest: FAIL" << std::endl;
+    }
+  }
+
+  void VertexRangePartitionerTest(node_id_t n, node_id_t m,
+                                  uint32_t num_partitions) {
+    if (n <= 2 || m <= 0 || num_partitions < 2) {
+      std::cout << "VertexRangePartitionerTest skipped: invalid sizes."
+                << std::endl;
+      return;
+    }
+    auto partitioner = NewVertexRangePartitionerFactory();
+    Options options;
+    options.create_if_missing = true;
+    options.sst_partitioner_factory = partitioner;
+    RocksGraph* graph =
+        new RocksGraph(options, ScratchGraphOptions("_partition"));
+    DB* db = graph->get_raw_db();
+    std::mt19937 rng(44);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    std::vector<std::set<node_id_t>> out(n), in(n);
+    for (node_id_t i = 0; i < n; i++) graph->AddVertex(i);
+    for (node_id_t i = 0; i < m; i++) {
+      // skewed sources, so degree weighting has something to balance
+      node_id_t from = dist(rng) % (n / 4 + 1), to = dist(rng);
+      graph->AddEdge(from, to);
+      out[from].insert(to);
+      (is_directed_ ? in : out)[to].insert(from);
+    }
+    db->Flush(FlushOptions());
+
+    size_t errors = 0;
+    std::vector<node_id_t> boundaries;
+    Status s = ComputeVertexRangeBoundaries(graph, num_partitions, true,
+                                            &boundaries);
+    if (!s.ok() || boundaries.size() != num_partitions - 1) {
+      std::cout << "boundaries error: " << s.ToString() << " ("
+                << boundaries.size() << ")" << std::endl;
+      errors++;
+    }
+    partitioner->SetBoundaries(boundaries);
+    CompactRangeOptions compact_options;
+    compact_options.bottommost_level_compaction =
+        BottommostLevelCompaction::kForce;
+    s = db->CompactRange(compact_options, nullptr, nullptr);
+    if (!s.ok()) {
+      std::cout << "compact error: " << s.ToString() << std::endl;
+      errors++;
+    }
+
+    // no file may straddle a boundary
+    ColumnFamilyMetaData meta;
+    db->GetColumnFamilyMetaData(&meta);
+    size_t files = 0, straddling = 0;
+    std::set<size_t> covered;
+    for (const auto& level : meta.levels) {
+      for (const auto& file : level.files) {
+        files++;
+        size_t first = partitioner->PartitionOf(decode_node(file.smallestkey));
+        size_t last = partitioner->PartitionOf(decode_node(file.largestkey));
+        if (first != last) straddling++;
+        covered.insert(first);
+      }
+    }
+    if (straddling > 0 || covered.size() != num_partitions) errors++;
+
+    // ranges hold about the same number of edges
+    std::vector<uint64_t> weights(num_partitions);
+    uint64_t total = 0;
+    for (node_id_t v = 0; v < n; v++) {
+      uint64_t degree = out[v].size() + in[v].size();
+      weights[partitioner->PartitionOf(v)] += degree;
+      total += degree;
+    }
+    double imbalance = *std::max_element(weights.begin(), weights.end()) *
+                       static_cast<double>(num_partitions) / total;
+    if (imbalance > 1.5) errors++;
+
+    // dropping one range's files leaves exactly that range empty
+    size_t dropped = 0, mismatched = 0;
+    if (boundaries.size() >= 2 && policy_ != EDGE_UPDATE_FULL_LAZY) {
+      std::string begin, end;
+      encode_node(boundaries[0], &begin);
+      encode_node(boundaries[1], &end);
+      Slice begin_slice(begin), end_slice(end);
+      s = DeleteFilesInRange(db, db->DefaultColumnFamily(), &begin_slice,
+                             &end_slice, false);
+      if (!s.ok()) errors++;
+      for (node_id_t v = 0; v < n; v++) {
+        Edges edges;
+        bool found = graph->GetAllEdges(v, &edges).ok();
+        size_t degree = found ? edges.num_edges_out : 0;
+        if (found) free_edges(&edges);
+        if (partitioner->PartitionOf(v) == 1) {
+          if (found) mismatched++;
+          dropped++;
+        } else if (!found || degree != out[v].size()) {
+          mismatched++;
+        }
+      }
+      if (dropped == 0) errors++;
+    }
+    delete graph;
+
+    std::cout << "VertexRangePartitionerTest result: partitions="
+              << num_partitions << " files=" << files
+              << " straddling=" << straddling
+              << " imbalance=" << imbalance << " dropped=" << dropped
+              << " mismatched=" << mismatched << " errors=" << errors
+              << std::endl;
+    if (errors == 0 && mismatched == 0) {
+      std::cout << "VertexRangePartitionerTest: PASS" << std::endl;
+    } else {
+      std::cout << "VertexRangePartitionerTest: FAIL" << std::endl;
+    }
+  }
+
+  void MergeOperandPriorityTest(node_id_t n, node_id_t m) {
+    if (n <= 10 || m <= 0) {
+      std::cout << "MergeOperandPriorityTest skipped: invalid sizes."
+                << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "MergeOperandPriorityTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    // the same skewed load under the default priority and the new one
+    std::vector<CompactionPri> priorities{kMinOverlappingRatio,
+                                          kMergeOperandDensity};
+    std::vector<double> operands_per_read;
+    size_t mismatched = 0, operand_files = 0;
+    for (CompactionPri priority : priorities) {
+      Options options;
+      options.create_if_missing = true;
+      options.compaction_pri = priority;
+      options.write_buffer_size = 64 << 10;
+      options.target_file_size_base = 64 << 10;
+      options.max_bytes_for_level_base = 256 << 10;
+      options.max_bytes_for_level_multiplier = 4;
+      options.level0_file_num_compaction_trigger = 2;
+      RocksGraph* graph =
+          new RocksGraph(options, ScratchGraphOptions("_operand_pri"));
+      DB* db = graph->get_raw_db();
+      std::mt19937 rng(45);
+      std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+      std::vector<std::set<node_id_t>> out(n);
+      for (node_id_t i = 0; i < n; i++) graph->AddVertex(i);
+      for (node_id_t i = 0; i < m; i++) {
+        // nine edges in ten leave the first tenth of the vertices
+        node_id_t from = i % 10 ? dist(rng) % (n / 10) : dist(rng);
+        node_id_t to = dist(rng);
+        graph->AddEdge(from, to);
+        out[from].insert(to);
+        if (!is_directed_) out[to].insert(from);
+      }
+      db->WaitForCompact(WaitForCompactOptions());
+
+      ColumnFamilyMetaData meta;
+      db->GetColumnFamilyMetaData(&meta);
+      for (const auto& level : meta.levels) {
+        for (const auto& file : level.files) {
+          if (file.num_merge_operands > 0) operand_files++;
+        }
+      }
+      SetPerfLevel(PerfLevel::kEnableCount);
+      get_graph_perf_context()->Reset();
+      for (node_id_t v = 0; v < n; v++) {
+        Edges edges;
+        std::set<node_id_t> got;
+        if (graph->GetAllEdges(v, &edges).ok()) {
+          for (uint32_t i = 0; i < edges.num_edges_out; i++) {
+            got.insert(edges.nxts_out[i].nxt);
+          }
+          free_edges(&edges);
+        }
+        if (got != out[v]) mismatched++;
+      }
+      operands_per_read.push_back(
+          1.0 * get_graph_perf_context()->adj_merge_operand_count / n);
+      SetPerfLevel(PerfLevel::kDisable);
+      delete graph;
+    }
+    // eager updates write whole lists, not operands
+    bool merging = policy_ != EDGE_UPDATE_EAGER;
+
+    std::cout << "MergeOperandPriorityTest result: operands_per_read "
+              << "min_overlapping=" << operands_per_read[0]
+              << " operand_density=" << operands_per_read[1]
+              << " operand_files=" << operand_files
+              << " mismatched=" << mismatched << std::endl;
+    if (mismatched == 0 && (!merging || operand_files > 0)) {
+      std::cout << "MergeOperandPriorityTest: PASS" << std::endl;
+    } else {
+      std::cout << "MergeOperandPriorityTest: FAIL" << std::endl;
+    }
+  }
+
+  void InplaceMergeFoldTest(node_id_t n, node_id_t m) {
+    if (n <= 10 || m <= 0) {
+      std::cout << "InplaceMergeFoldTest skipped: invalid sizes."
+                << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "InplaceMergeFoldTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    // the same skewed load added entry by entry and folded
+    uint64_t entries[2] = {0, 0}, mem_bytes[2] = {0, 0};
+    size_t mismatched = 0;
+    bool snapshots_off = false, iterator_stable = false;
+    for (int fold = 0; fold < 2; fold++) {
+      Options options;
+      options.create_if_missing = true;
+      options.disable_auto_compactions = true;
+      options.inplace_merge_support = fold == 1;
+      RocksGraph* graph =
+          new RocksGraph(options, ScratchGraphOptions("_inplace_merge"));
+      DB* db = graph->get_raw_db();
+      std::mt19937 rng(46);
+      std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+      std::vector<std::set<node_id_t>> out(n);
+      for (node_id_t i = 0; i < n; i++) graph->AddVertex(i);
+      for (node_id_t i = 0; i < m; i++) {
+        // nine edges in ten leave the first hundredth of the vertices
+        node_id_t from = i % 10 ? dist(rng) % (n / 100 + 1) : dist(rng);
+        node_id_t to = dist(rng);
+        if (i % 7 == 0 && !out[from].empty()) {
+          // markers fold like additions
+          to = *out[from].begin();
+          graph->DeleteEdge(from, to);
+          out[from].erase(to);
+          if (!is_directed_) out[to].erase(from);
+          continue;
+        }
+        graph->AddEdge(from, to);
+        out[from].insert(to);
+        if (!is_directed_) out[to].insert(from);
+      }
+      db->GetIntProperty(DB::Properties::kNumEntriesActiveMemTable,
+                         &entries[fold]);
+      db->GetIntProperty(DB::Properties::kCurSizeActiveMemTable,
+                         &mem_bytes[fold]);
+      if (fold == 1) {
+        const Snapshot* snapshot = db->GetSnapshot();
+        snapshots_off = snapshot == nullptr;
+        if (snapshot) db->ReleaseSnapshot(snapshot);
+        // an iterator opened before more operands of the hub arrive keeps
+        // the list it was opened on
+        std::string key, before;
+        encode_node(0, &key);
+        db->Get(ReadOptions(), key, &before);
+        Iterator* it = db->NewIterator(ReadOptions());
+        for (node_id_t to = 1; to <= 3; to++) {
+          graph->AddEdge(0, to);
+          out[0].insert(to);
+          if (!is_directed_) out[to].insert(0);
+        }
+        it->Seek(key);
+        iterator_stable = it->Valid() && it->key() == Slice(key) &&
+                          it->value() == Slice(before);
+        delete it;
+      }
+      // read once from the memtable and once from the flushed files
+      for (int pass = 0; pass < 2; pass++) {
+        for (node_id_t v = 0; v < n; v++) {
+          Edges edges;
+          std::set<node_id_t> got;
+          if (graph->GetAllEdges(v, &edges).ok()) {
+            for (uint32_t i = 0; i < edges.num_edges_out; i++) {
+              got.insert(edges.nxts_out[i].nxt);
+            }
+            free_edges(&edges);
+          }
+          if (got != out[v]) mismatched++;
+        }
+        if (pass == 0) db->Flush(FlushOptions());
+      }
+      delete graph;
+    }
+    // eager updates write whole lists, not operands
+    bool merging = policy_ != EDGE_UPDATE_EAGER;
+
+    std::cout << "InplaceMergeFoldTest result: memtable_entries "
+              << entries[0] << " -> " << entries[1] << " memtable_bytes "
+              << mem_bytes[0] << " -> " << mem_bytes[1]
+              << " snapshots_off=" << snapshots_off
+              << " iterator_stable=" << iterator_stable
+              << " mismatched=" << mismatched << std::endl;
+    if (mismatched == 0 && snapshots_off && iterator_stable &&
+        (!merging || entries[1] < entries[0])) {
+      std::cout << "InplaceMergeFoldTest: PASS" << std::endl;
+    } else {
+      std::cout << "InplaceMergeFoldTest: FAIL" << std::endl;
+    }
+  }
+
+  void BlobAdjacencyTest(node_id_t n, node_id_t m) {
+    const node_id_t kHubs = 16;
+    const uint32_t kHubDegree = 8192, kBlobMinDegree = 256;
+    if (n <= kHubDegree || m <= 0) {
+      std::cout << "BlobAdjacencyTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "BlobAdjacencyTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    // Hubs get their lists up front; the edges that follow only touch the
+    // other vertices, so compactions keep moving the unchanged hub lists,
+    // inline in the first run and as blob references in the second.
+    uint64_t compaction_bytes[2] = {0, 0};
+    size_t blob_files = 0, mismatched = 0, filter_misses = 0;
+    uint64_t blob_reads = 0, blob_cache_hits = 0;
+    uint64_t blob_garbage[2] = {0, 0};
+    for (int blobs = 0; blobs < 2; blobs++) {
+      Options options;
+      options.create_if_missing = true;
+      options.statistics = CreateDBStatistics();
+      options.write_buffer_size = 256 << 10;
+      options.target_file_size_base = 256 << 10;
+      options.max_bytes_for_level_base = 1 << 20;
+      options.level0_file_num_compaction_trigger = 2;
+      RocksGraphOptions graph_options = ScratchGraphOptions("_blob");
+      graph_options.edge_filter = true;
+      graph_options.blob_min_degree = blobs ? kBlobMinDegree : 0;
+      RocksGraph* graph = new RocksGraph(options, graph_options);
+      DB* db = graph->get_raw_db();
+      std::mt19937 rng(47);
+      std::uniform_int_distribution<node_id_t> dist(kHubs, n - 1);
+      std::vector<std::set<node_id_t>> out(n);
+      for (node_id_t hub = 0; hub < kHubs; hub++) {
+        // stored as given, without the reverse edges
+        while (out[hub].size() < kHubDegree) out[hub].insert(dist(rng));
+        std::vector<node_id_t> outs(out[hub].begin(), out[hub].end());
+        std::vector<node_id_t> ins;
+        graph->AddVertexWithEdges(hub, outs, ins);
+      }
+      for (node_id_t i = kHubs; i < n; i++) graph->AddVertex(i);
+      db->Flush(FlushOptions());
+      db->WaitForCompact(WaitForCompactOptions());
+      Statistics* stats = options.statistics.get();
+      uint64_t loaded = stats->getTickerCount(COMPACT_WRITE_BYTES);
+      for (node_id_t i = 0; i < m; i++) {
+        node_id_t from = dist(rng);
+        node_id_t to = dist(rng);
+        graph->AddEdge(from, to);
+        out[from].insert(to);
+        if (!is_directed_) out[to].insert(from);
+      }
+      db->WaitForCompact(WaitForCompactOptions());
+      // sst and blob bytes alike
+      compaction_bytes[blobs] =
+          stats->getTickerCount(COMPACT_WRITE_BYTES) - loaded;
+      ColumnFamilyMetaData meta;
+      db->GetColumnFamilyMetaData(&meta);
+      if (blobs) {
+        blob_files = meta.blob_files.size();
+        // one more edge on every other hub leaves the old copies of their
+        // lists as garbage next to the live lists of the others
+        for (node_id_t hub = 0; hub < kHubs; hub += 2) {
+          node_id_t to = dist(rng);
+          graph->AddEdge(hub, to);
+          out[hub].insert(to);
+          if (!is_directed_) out[to].insert(hub);
+        }
+        db->Flush(FlushOptions());
+        db->CompactRange(CompactRangeOptions(), nullptr, nullptr);
+        auto garbage = [&]() {
+          ColumnFamilyMetaData after;
+          db->GetColumnFamilyMetaData(&after);
+          uint64_t bytes = 0;
+          for (const auto& blob : after.blob_files) {
+            bytes += blob.garbage_blob_bytes;
+          }
+          return bytes;
+        };
+        blob_garbage[0] = garbage();
+        if (!graph->CollectBlobGarbage(0.25).ok()) mismatched++;
+        blob_garbage[1] = garbage();
+      }
+
+      SetPerfLevel(PerfLevel::kEnableCount);
+      get_perf_context()->Reset();
+      for (node_id_t v = 0; v < n; v++) {
+        Edges edges;
+        std::set<node_id_t> got;
+        if (graph->GetAllEdges(v, &edges).ok()) {
+          for (uint32_t i = 0; i < edges.num_edges_out; i++) {
+            got.insert(edges.nxts_out[i].nxt);
+          }
+          free_edges(&edges);
+        }
+        if (got != out[v]) mismatched++;
+      }
+      if (blobs) {
+        blob_reads = get_perf_context()->blob_read_count;
+        blob_cache_hits = get_perf_context()->blob_cache_hit_count;
+      }
+      SetPerfLevel(PerfLevel::kDisable);
+      // the edge filters must still admit the edges of lists in blob files
+      for (node_id_t hub = 0; hub < kHubs; hub++) {
+        size_t probes = 0;
+        for (node_id_t to : out[hub]) {
+          bool exists = false;
+          if (!graph->HasEdge(hub, to, &exists).ok() || !exists) {
+            filter_misses++;
+          }
+          if (++probes == 64) break;
+        }
+      }
+      delete graph;
+    }
+
+    std::cout << "BlobAdjacencyTest result: compaction_bytes "
+              << compaction_bytes[0] << " -> " << compaction_bytes[1]
+              << " blob_files=" << blob_files << " blob_garbage "
+              << blob_garbage[0] << " -> " << blob_garbage[1]
+              << " blob_reads=" << blob_reads
+              << " blob_cache_hits=" << blob_cache_hits
+              << " filter_misses=" << filter_misses
+              << " mismatched=" << mismatched << std::endl;
+    if (mismatched == 0 && filter_misses == 0 && blob_files > 0 &&
+        compaction_bytes[1] < compaction_bytes[0] &&
+        blob_garbage[1] < std::max<uint64_t>(blob_garbage[0], 1)) {
+      std::cout << "BlobAdjacencyTest: PASS" << std::endl;
+    } else {
+      std::cout << "BlobAdjacencyTest: FAIL" << std::endl;
+    }
+  }
+
+  void AsyncReadTest(node_id_t n, node_id_t m) {
+    if (n <= 0 || m <= 0) {
+      std::cout << "AsyncReadTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "AsyncReadTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    InitNodes(n);
+    std::mt19937 rng(48);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    for (node_id_t i = 0; i < m; i++) {
+      Status s = graph_->AddEdge(dist(rng), dist(rng));
+      if (!s.ok()) {
+        std::cout << "add error: " << s.ToString() << std::endl;
+        exit(0);
+      }
+    }
+    graph_->get_raw_db()->Flush(FlushOptions());
+    auto ids = [](const Edges& edges) {
+      std::vector<node_id_t> list;
+      for (uint32_t i = 0; i < edges.num_edges_out; i++) {
+        list.push_back(edges.nxts_out[i].nxt);
+      }
+      list.push_back(-1);
+      for (uint32_t i = 0; i < edges.num_edges_in; i++) {
+        list.push_back(edges.nxts_in[i].nxt);
+      }
+      return list;
+    };
+
+    // every list read one at a time, then all queued at once
+    std::vector<std::vector<node_id_t>> expected(n);
+    auto start = std::chrono::steady_clock::now();
+    for (node_id_t v = 0; v < n; v++) {
+      Edges edges;
+      if (graph_->GetAllEdges(v, &edges).ok()) {
+        expected[v] = ids(edges);
+        free_edges(&edges);
+      }
+    }
+    double sync_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    size_t mismatched = 0;
+    GraphAsyncReader reader(graph_);
+    start = std::chrono::steady_clock::now();
+    std::vector<Edges> results(n);
+    std::vector<std::future<Status>> futures;
+    for (node_id_t v = 0; v < n; v++) {
+      futures.push_back(reader.GetAllEdgesAsync(v, &results[v]));
+    }
+    for (node_id_t v = 0; v < n; v++) {
+      Status s = futures[v].get();
+      if (s.ok()) {
+        if (ids(results[v]) != expected[v]) mismatched++;
+        free_edges(&results[v]);
+      } else if (!s.IsNotFound() || !expected[v].empty()) {
+        mismatched++;
+      }
+    }
+    double async_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    uint64_t list_batches = reader.batches();
+
+    // concurrent traversals share batches level by level
+    const size_t kStarts = 64;
+    std::vector<std::vector<node_id_t>> reached(kStarts);
+    std::vector<std::future<Status>> hops;
+    for (size_t i = 0; i < kStarts; i++) {
+      hops.push_back(reader.KHopAsync(i % n, 2, &reached[i]));
+    }
+    for (size_t i = 0; i < kStarts; i++) {
+      std::vector<node_id_t> want;
+      Status s = hops[i].get();
+      if (!s.ok() || !graph_->KHop(i % n, 2, &want).ok() ||
+          want != reached[i]) {
+        mismatched++;
+      }
+    }
+    uint64_t khop_batches = reader.batches() - list_batches;
+
+    std::cout << "AsyncReadTest result: sync_ms " << sync_ms << " async_ms "
+              << async_ms << " list_batches=" << list_batches
+              << " khop_batches=" << khop_batches
+              << " reads=" << reader.reads() << " mismatched=" << mismatched
+              << std::endl;
+    // one batch per vertex would mean nothing was in flight together
+    if (mismatched == 0 && list_batches < static_cast<uint64_t>(n) &&
+        khop_batches < kStarts * 2) {
+      std::cout << "AsyncReadTest: PASS" << std::endl;
+    } else {
+      std::cout << "AsyncReadTest: FAIL" << std::endl;
+    }
+  }
+
+  void TransactionTest(node_id_t n, node_id_t m) {
+    if (n <= 4 || m <= 0) {
+      std::cout << "TransactionTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "TransactionTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    const int kThreads = 4;
+    const node_id_t kHub = 0;
+    // Every write adds an edge and links its source to the hub, from four
+    // threads at once, through transactions and then as plain AddEdge calls.
+    auto run = [&](RocksGraph* graph, bool txn, size_t* retries) {
+      graph->ReserveVertices(n);
+      std::vector<std::set<std::pair<node_id_t, node_id_t>>> added(kThreads);
+      std::vector<std::thread> threads;
+      std::mutex mu;
+      for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+          std::mt19937 rng(49 + t);
+          std::uniform_int_distribution<node_id_t> dist(1, n - 1);
+          for (node_id_t i = 0; i < m / kThreads; i++) {
+            node_id_t from = dist(rng), to = dist(rng);
+            if (!txn) {
+              graph->AddEdge(from, to);
+              graph->AddEdge(kHub, from);
+            } else {
+              while (true) {
+                std::unique_ptr<GraphTransaction> tx;
+                Status s = graph->BeginTransaction(&tx);
+                if (s.ok()) s = tx->AddEdge(from, to);
+                if (s.ok()) s = tx->AddEdge(kHub, from);
+                if (s.ok()) s = tx->Commit();
+                if (s.ok()) break;
+                std::lock_guard<std::mutex> lock(mu);
+                (*retries)++;
+              }
+            }
+            added[t].emplace(from, to);
+            added[t].emplace(kHub, from);
+          }
+        });
+      }
+      for (auto& thread : threads) thread.join();
+      std::vector<std::set<node_id_t>> out(n);
+      for (const auto& edges : added) {
+        for (const auto& edge : edges) {
+          out[edge.first].insert(edge.second);
+          if (!is_directed_) out[edge.second].insert(edge.first);
+        }
+      }
+      size_t lost = 0;
+      for (node_id_t v = 0; v < n; v++) {
+        Edges edges;
+        std::set<node_id_t> got;
+        if (graph->GetAllEdges(v, &edges).ok()) {
+          for (uint32_t i = 0; i < edges.num_edges_out; i++) {
+            got.insert(edges.nxts_out[i].nxt);
+          }
+          free_edges(&edges);
+        }
+        for (node_id_t u : out[v]) lost += got.count(u) == 0;
+      }
+      return lost;
+    };
+
+    Options options;
+    options.create_if_missing = true;
+    GraphTransactionDBOptions txn_options;
+    txn_options.lock_timeout_ms = 50;
+    size_t mismatched = 0, plain_lost = 0, conflicts = 0;
+    // pessimistic, optimistic
+    size_t retries[2] = {0, 0};
+    for (int optimistic = 0; optimistic < 2; optimistic++) {
+      txn_options.optimistic = optimistic;
+      RocksGraphOptions graph_options = ScratchGraphOptions("_txn");
+      graph_options.txn_options = &txn_options;
+      RocksGraph* graph = new RocksGraph(options, graph_options);
+      for (node_id_t v = 0; v < n; v++) graph->AddVertex(v);
+      mismatched += run(graph, true, &retries[optimistic]);
+
+      // a move is atomic, and a rollback leaves nothing behind
+      std::unique_ptr<GraphTransaction> t;
+      bool exists = false;
+      Status s = graph->BeginTransaction(&t);
+      if (s.ok()) s = t->AddEdge(1, 2);
+      if (s.ok()) s = t->Commit();
+      if (s.ok()) s = graph->BeginTransaction(&t);
+      if (s.ok()) s = t->HasEdge(1, 2, &exists);
+      if (s.ok() && exists) s = t->DeleteEdge(1, 2);
+      if (s.ok()) s = t->AddEdge(1, 3);
+      if (s.ok()) s = t->Commit();
+      if (s.ok()) s = graph->BeginTransaction(&t);
+      if (s.ok()) s = t->AddEdge(1, 4);
+      if (s.ok()) s = t->Rollback();
+      bool has2 = true, has3 = false, has4 = true;
+      if (s.ok()) s = graph->HasEdge(1, 2, &has2);
+      if (s.ok()) s = graph->HasEdge(1, 3, &has3);
+      if (s.ok()) s = graph->HasEdge(1, 4, &has4);
+      if (!s.ok() || !exists || has2 || !has3 || has4) mismatched++;
+
+      // two writers of vertex 1: locked out, or refused at commit
+      std::unique_ptr<GraphTransaction> t1, t2;
+      graph->BeginTransaction(&t1);
+      graph->BeginTransaction(&t2);
+      s = t1->AddEdge(1, 2);
+      Status s2 = t2->AddEdge(1, 4);
+      if (s.ok()) s = t1->HasEdge(1, 3, &exists);
+      if (s2.ok()) s2 = t2->Commit();
+      if (s.ok()) s = t1->Commit();
+      if (optimistic ? s2.ok() && s.IsBusy()
+                     : (s2.IsTimedOut() || s2.IsBusy()) && s.ok()) {
+        conflicts++;
+      }
+      t.reset();
+      t1.reset();
+      t2.reset();
+      delete graph;
+    }
+    {
+      RocksGraph* graph =
+          new RocksGraph(options, ScratchGraphOptions("_txn"));
+      for (node_id_t v = 0; v < n; v++) graph->AddVertex(v);
+      plain_lost = run(graph, false, nullptr);
+      delete graph;
+    }
+
+    std::cout << "TransactionTest result: txn_lost=" << mismatched
+              << " plain_lost=" << plain_lost << " retries=" << retries[0]
+              << "/" << retries[1]
+              << " conflicts=" << conflicts << std::endl;
+    if (mismatched == 0 && conflicts == 2) {
+      std::cout << "TransactionTest: PASS" << std::endl;
+    } else {
+      std::cout << "TransactionTest: FAIL" << std::endl;
+    }
+  }
+
+  void UndirectedCountTest(node_id_t n, node_id_t m) {
+    if (n <= 1 || m <= 0) {
+      std::cout << "UndirectedCountTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "UndirectedCountTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    Options options;
+    options.create_if_missing = true;
+    RocksGraphOptions graph_options = ScratchGraphOptions("_undirected_count");
+    graph_options.is_directed = false;
+    RocksGraph* graph = new RocksGraph(options, graph_options);
+    std::mt19937 rng(31);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    // few vertices, so edges are re-added in both orientations
+    std::set<std::pair<node_id_t, node_id_t>> edges;
+    for (node_id_t i = 0; i < m; i++) {
+      node_id_t from = dist(rng), to = dist(rng);
+      if (from == to) continue;
+      if (i % 5 == 0 && !edges.empty()) {
+        auto it = edges.lower_bound({std::min(from, to), 0});
+        if (it == edges.end()) it = edges.begin();
+        if (i % 2) {
+          graph->DeleteEdge(it->first, it->second);
+        } else {
+          graph->DeleteEdge(it->second, it->first);
+        }
+        edges.erase(it);
+        continue;
+      }
+      graph->AddEdge(from, to);
+      edges.insert({std::min(from, to), std::max(from, to)});
+    }
+    // every edge of the deleted vertex counts once, whichever endpoint
+    // holds the counted copy
+    node_id_t victim = dist(rng);
+    graph->DeleteVertex(victim);
+    for (auto it = edges.begin(); it != edges.end();) {
+      bool touches = it->first == victim || it->second == victim;
+      it = touches ? edges.erase(it) : std::next(it);
+    }
+    // lazy duplicates and deletes are taken out of the count as the lists
+    // are read, so read each once
+    size_t mismatched = 0;
+    for (node_id_t v = 0; v < n; v++) {
+      std::set<node_id_t> expected, got;
+      for (const auto& e : edges) {
+        if (e.first == v) expected.insert(e.second);
+        if (e.second == v) expected.insert(e.first);
+      }
+      Edges list;
+      if (graph->GetAllEdges(v, &list).ok()) {
+        for (uint32_t i = 0; i < list.num_edges_out; i++) {
+          got.insert(list.nxts_out[i].nxt);
+        }
+        free_edges(&list);
+      }
+      if (got != expected) mismatched++;
+    }
+    node_id_t counted = graph->CountEdge();
+    delete graph;
+
+    std::cout << "UndirectedCountTest result: edges=" << edges.size()
+              << " counted=" << counted << " mismatched=" << mismatched
+              << std::endl;
+    if (mismatched == 0 && counted == static_cast<node_id_t>(edges.size())) {
+      std::cout << "UndirectedCountTest: PASS" << std::endl;
+    } else {
+      std::cout << "UndirectedCountTest: FAIL" << std::endl;
+    }
+  }
+
+  void SecondaryTest(node_id_t n, node_id_t m) {
+    if (n <= 0 || m <= 0) {
+      std::cout << "SecondaryTest skipped: invalid sizes." << std::endl;
+      return;
+    }
+    if (policy_ == EDGE_UPDATE_FULL_LAZY) {
+      std::cout << "SecondaryTest skipped: FULL_LAZY keeps no lists."
+                << std::endl;
+      return;
+    }
+    Options options;
+    options.create_if_missing = true;
+    RocksGraphOptions graph_options = ScratchGraphOptions("_primary");
+    const std::string path = graph_options.db_path;
+    RocksGraph* primary = new RocksGraph(options, graph_options);
+    std::mt19937 rng(50);
+    std::uniform_int_distribution<node_id_t> dist(0, n - 1);
+    // distinct edges only: lazy reads that drop a duplicate move the
+    // primary's counts after they were published
+    std::set<std::pair<node_id_t, node_id_t>> added;
+    auto add_edges = [&](node_id_t count) {
+      for (node_id_t i = 0; i < count;) {
+        node_id_t from = dist(rng), to = dist(rng);
+        if (from == to || added.count({from, to})) continue;
+        added.insert({from, to});
+        if (!is_directed_) added.insert({to, from});
+        primary->AddEdge(from, to);
+        i++;
+      }
+    };
+    // lists, degree estimates and counts the secondary disagrees on
+    auto mismatches = [&](RocksGraph* secondary) {
+      size_t bad = primary->m != secondary->m;
+      for (node_id_t v = 0; v < n; v++) {
+        Edges want, got;
+        Status s1 = primary->GetAllEdges(v, &want);
+        Status s2 = secondary->GetAllEdges(v, &got);
+        bool same = s1.code() == s2.code();
+        if (s1.ok() && s2.ok()) {
+          same = want.num_edges_out == got.num_edges_out &&
+                 want.num_edges_in == got.num_edges_in;
+          for (uint32_t i = 0; same && i < want.num_edges_out; i++) {
+            same = want.nxts_out[i].nxt == got.nxts_out[i].nxt;
+          }
+        }
+        if (s1.ok()) free_edges(&want);
+        if (s2.ok()) free_edges(&got);
+        bad += !same;
+        bad += primary->GetDegreeApproximate(v) !=
+               secondary->GetDegreeApproximate(v);
+      }
+      return bad;
+    };
+
+    for (node_id_t v = 0; v < n; v++) primary->AddVertex(v);
+    add_edges(m / 2);
+    primary->get_raw_db()->Flush(FlushOptions());
+    primary->PublishMeta();
+    std::unique_ptr<RocksGraph> secondary;
+    Options secondary_options;
+    Status s = RocksGraph::OpenAsSecondary(
+        secondary_options, graph_options, path + "_secondary", &secondary, 0);
+    if (!s.ok()) {
+      std::cout << "SecondaryTest open failed: " << s.ToString() << std::endl;
+      std::cout << "SecondaryTest: FAIL" << std::endl;
+      delete primary;
+      return;
+    }
+    size_t opened = mismatches(secondary.get());
+
+    // half in SSTs, half only in the primary's WAL and memtable
+    add_edges(m / 4);
+    primary->get_raw_db()->Flush(FlushOptions());
+    add_edges(m / 4);
+    primary->PublishMeta();
+    size_t stale = mismatches(secondary.get());
+    s = secondary->TryCatchUpWithPrimary();
+    size_t caught_up = s.ok() ? mismatches(secondary.get()) : n;
+
+    // a second secondary catching up on its own
+    std::unique_ptr<RocksGraph> follower;
+    Options follower_options;
+    s = RocksGraph::OpenAsSecondary(follower_options, graph_options,
+                                    path + "_follower", &follower, 20);
+    add_edges(m / 4);
+    primary->PublishMeta();
+    size_t followed = n;
+    for (int i = 0; s.ok() && i < 100 && followed > 0; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      followed = mismatches(follower.get());
+    }
+
+    bool write_refused = !secondary->AddEdge(0, 1).ok() &&
+                         !secondary->PublishMeta().ok();
+    secondary.reset();
+    follower.reset();
+    // the primary writes GraphMeta.log only when it closes
+    bool meta_log_written =
+        primary->get_raw_db()->GetEnv()->FileExists(path + "/GraphMeta.log")
+            .ok();
+    delete primary;
+
+    std::cout << "SecondaryTest result: opened=" << opened
+              << " stale=" << stale << " caught_up=" << caught_up
+              << " followed=" << followed
+              << " write_refused=" << write_refused
+              << " meta_log_written=" << meta_log_written << std::endl;
+    if (opened == 0 && stale > 0 && caught_up == 0 && followed == 0 &&
+        write_refused && !meta_log_written) {
+      std::cout << "SecondaryTest: PASS" << std::endl;
+    } else {
+      std::cout << "SecondaryTest: FAIL" << std::endl;
+    }
+  }
+
  private:
   RocksGraph* graph_;
   GraphBenchProfiler profiler_;
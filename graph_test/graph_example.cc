@@ -28,6 +28,58 @@ DEFINE_bool(run_degree_query_test, false,
             "Run GetOutDegree/GetInDegree verification test");
 DEFINE_bool(run_add_edge_lazy_test, false,
             "Run AddEdgeLazy verification test");
+DEFINE_bool(run_sample_neighbors_test, false,
+            "Run SampleNeighbors verification test");
+DEFINE_bool(run_parallel_scan_test, false,
+            "Run ParallelScan verification test");
+DEFINE_bool(run_analytics_test, false,
+            "Run PageRank/WCC/triangle count verification test");
+DEFINE_bool(run_csr_snapshot_test, false,
+            "Run CSR snapshot export/serving verification test");
+DEFINE_bool(run_relabel_test, false,
+            "Run relabeled bulk-load test (uses -relabel_order)");
+DEFINE_int32(relabel_order, RELABEL_ORDER_RCM,
+             "Vertex ordering for the relabel test: 1 degree, 2 BFS, 3 RCM, "
+             "4 Gorder");
+DEFINE_bool(run_trace_replay_test, false, "Run graph trace record/replay test");
+DEFINE_bool(run_graph_stats_test, false,
+            "Run graph perf context / property test");
+DEFINE_bool(run_edge_filter_test, false,
+            "Check HasEdge against the per-file edge filters");
+DEFINE_bool(run_weighted_edge_test, false,
+            "Check top-k by weight and time-filtered neighbor scans");
+DEFINE_bool(run_labeled_edge_test, false,
+            "Check label-scoped edge lists and prefix scans");
+DEFINE_bool(run_delete_vertex_test, false,
+            "Check DeleteVertex removes the vertex and its reverse edges");
+DEFINE_bool(run_common_neighbors_test, false,
+            "Check CommonNeighbors, Jaccard and AdamicAdar against a model");
+DEFINE_bool(run_path_query_test, false,
+            "Check ShortestPath and Reachable against an in-memory BFS");
+DEFINE_bool(run_temporal_test, false,
+            "Check as-of reads of a temporal graph against per-epoch models");
+DEFINE_bool(run_change_stream_test, false,
+            "Check the WAL change stream against the applied updates");
+DEFINE_bool(run_incremental_pagerank_test, false,
+            "Check incremental PageRank against power iteration as edges "
+            "change");
+DEFINE_bool(run_vertex_range_partitioner_test, false,
+            "Check that compaction outputs follow vertex range boundaries");
+DEFINE_bool(run_merge_operand_priority_test, false,
+            "Compare merge operands per read under kMergeOperandDensity");
+DEFINE_bool(run_inplace_merge_fold_test, false,
+            "Compare memtable entries with and without inplace_merge_support");
+DEFINE_bool(run_blob_adjacency_test, false,
+            "Compare compaction bytes with hub lists inline and in blobs");
+DEFINE_bool(run_async_read_test, false,
+            "Check batched asynchronous list reads and k-hop expansion");
+DEFINE_bool(run_transaction_test, false,
+            "Compare concurrent edge writes with and without transactions");
+DEFINE_bool(run_secondary_test, false,
+            "Follow a writing primary from read-only secondaries");
+DEFINE_bool(run_undirected_count_test, false,
+            "Check the edge count of an undirected graph with duplicates "
+            "and deletes");
 DEFINE_bool(edge_test_mix_delete, false,
             "Mix 20% deletes during edge interface test");
 DEFINE_double(update_ratio, 0.5, "Update ratio for adaptive policy");
@@ -36,6 +88,7 @@ DEFINE_int32(update_policy, EDGE_UPDATE_ADAPTIVE, "Edge update policy");
 DEFINE_int32(encoding_type, ENCODING_TYPE_NONE, "Edge encoding type");
 DEFINE_int32(load_vertices, 20000, "Number of vertices to load");
 DEFINE_int32(load_edges, 200000, "Number of edges to load (random mode)");
+DEFINE_int32(scan_threads, 4, "Number of threads for ParallelScan");
 DEFINE_int32(lookup_count, 100, "Number of random lookups to run");
 DEFINE_string(load_mode, "tiny",
               "Load mode: tiny | random | powerlaw");
@@ -103,6 +156,124 @@ int main(int argc, char* argv[]) {
     return 0;
   }
 
+  if (FLAGS_run_sample_neighbors_test) {
+    tool.SampleNeighborsTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_parallel_scan_test) {
+    tool.ParallelScanTest(FLAGS_load_vertices, FLAGS_load_edges,
+                          FLAGS_scan_threads);
+    return 0;
+  }
+
+  if (FLAGS_run_analytics_test) {
+    tool.AnalyticsTest(FLAGS_scan_threads);
+    return 0;
+  }
+
+  if (FLAGS_run_csr_snapshot_test) {
+    tool.CSRSnapshotTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_relabel_test) {
+    tool.RelabelTest(FLAGS_load_vertices, FLAGS_load_edges,
+                     FLAGS_relabel_order);
+    return 0;
+  }
+
+  if (FLAGS_run_trace_replay_test) {
+    tool.TraceReplayTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_graph_stats_test) {
+    tool.GraphStatsTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_edge_filter_test) {
+    tool.EdgeFilterTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_weighted_edge_test) {
+    tool.WeightedEdgeTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_labeled_edge_test) {
+    tool.LabeledEdgeTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_delete_vertex_test) {
+    tool.DeleteVertexTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_common_neighbors_test) {
+    tool.CommonNeighborsTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_path_query_test) {
+    tool.PathQueryTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_temporal_test) {
+    tool.TemporalTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_change_stream_test) {
+    tool.ChangeStreamTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_incremental_pagerank_test) {
+    tool.IncrementalPageRankTest(FLAGS_load_vertices, FLAGS_load_edges, 5);
+    return 0;
+  }
+
+  if (FLAGS_run_vertex_range_partitioner_test) {
+    tool.VertexRangePartitionerTest(FLAGS_load_vertices, FLAGS_load_edges, 8);
+    return 0;
+  }
+
+  if (FLAGS_run_merge_operand_priority_test) {
+    tool.MergeOperandPriorityTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_inplace_merge_fold_test) {
+    tool.InplaceMergeFoldTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_blob_adjacency_test) {
+    tool.BlobAdjacencyTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+
+  if (FLAGS_run_async_read_test) {
+    tool.AsyncReadTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+  if (FLAGS_run_transaction_test) {
+    tool.TransactionTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+  if (FLAGS_run_secondary_test) {
+    tool.SecondaryTest(FLAGS_load_vertices, FLAGS_load_edges);
+    return 0;
+  }
+  if (FLAGS_run_undirected_count_test) {
+    tool.UndirectedCountTest(FLAGS_load_vertices / 100, FLAGS_load_edges / 100);
+    return 0;
+  }
   if (FLAGS_run_morris_counter_test) {
     tool.MorrisCounterTest();
     return 0;
@@ -0,0 +1,472 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "monitoring/histogram.h"
+#include "rocksdb/graph.h"
+#include "rocksdb/iostats_context.h"
+#include "rocksdb/perf_context.h"
+#include "rocksdb/perf_level.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+enum GraphOpType {
+  kGraphOpAdd = 0,
+  kGraphOpDelete,
+  kGraphOpGet,
+  kGraphOpDegree,
+  kGraphOpKHop,
+  kGraphOpWalk,
+  kGraphOpPropertyGet,
+  kGraphOpPropertySet,
+  kGraphOpNum
+};
+
+const char* const kGraphOpNames[kGraphOpNum] = {
+    "add", "delete", "get", "degree", "khop", "walk", "prop_get", "prop_set"};
+
+#define KEY_DIST_UNIFORM 0x0
+#define KEY_DIST_ZIPFIAN 0x1
+#define KEY_DIST_POWERLAW 0x2
+
+struct GraphWorkloadOptions {
+  int num_threads = 4;
+  // each thread stops after ops_per_thread operations or duration_sec
+  // seconds, whichever comes first (0 disables a limit)
+  uint64_t ops_per_thread = 100000;
+  int duration_sec = 0;
+  // vertex ids are drawn from [0, num_vertices)
+  node_id_t num_vertices = 20000;
+  // relative weights indexed by GraphOpType
+  std::vector<double> op_weights = {20, 5, 40, 10, 10, 5, 5, 5};
+  int key_distribution = KEY_DIST_UNIFORM;
+  // zipfian theta, or the exponent of the power law
+  double skew = 0.99;
+  int khop_hops = 2;
+  // k-hop stops expanding once this many vertices were visited
+  size_t khop_max_vertices = 1000;
+  int walk_length = 10;
+  int report_interval_sec = 1;
+  PerfLevel perf_level = PerfLevel::kEnableTimeExceptForMutex;
+  uint64_t seed = 42;
+};
+
+// Parses "add=20,get=40,..." into per-op weights; unknown names are errors.
+inline Status ParseGraphOpMix(const std::string& spec,
+                              std::vector<double>* weights) {
+  weights->assign(kGraphOpNum, 0);
+  std::stringstream ss(spec);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    size_t eq = item.find('=');
+    if (eq == std::string::npos) {
+      return Status::InvalidArgument("expected op=weight", item);
+    }
+    std::string name = item.substr(0, eq);
+    int op = 0;
+    while (op < kGraphOpNum && name != kGraphOpNames[op]) op++;
+    if (op == kGraphOpNum) {
+      return Status::InvalidArgument("unknown graph op", name);
+    }
+    (*weights)[op] = std::stod(item.substr(eq + 1));
+  }
+  return Status::OK();
+}
+
+// Draws vertex ids with the configured skew. Zipfian follows the YCSB
+// generator (Gray et al.); power law inverts the continuous CDF of
+// rank^-skew. Ranks are scrambled so hot vertices spread over the id space.
+class GraphKeyGenerator {
+ public:
+  GraphKeyGenerator(const GraphWorkloadOptions& options, uint64_t seed)
+      : n_(static_cast<uint64_t>(options.num_vertices)),
+        distribution_(options.key_distribution),
+        skew_(options.skew),
+        rng_(seed) {
+    if (distribution_ == KEY_DIST_ZIPFIAN) {
+      zeta_n_ = Zeta(n_, skew_);
+      double zeta_2 = Zeta(2, skew_);
+      alpha_ = 1.0 / (1.0 - skew_);
+      eta_ = (1 - std::pow(2.0 / n_, 1 - skew_)) / (1 - zeta_2 / zeta_n_);
+    }
+  }
+
+  node_id_t Next() {
+    double u = uniform_(rng_);
+    uint64_t rank;
+    if (distribution_ == KEY_DIST_ZIPFIAN) {
+      double uz = u * zeta_n_;
+      if (uz < 1.0) {
+        rank = 0;
+      } else if (uz < 1.0 + std::pow(0.5, skew_)) {
+        rank = 1;
+      } else {
+        rank = static_cast<uint64_t>(n_ *
+                                     std::pow(eta_ * u - eta_ + 1, alpha_));
+      }
+    } else if (distribution_ == KEY_DIST_POWERLAW) {
+      double e = 1.0 - skew_;
+      double k = std::abs(e) < 1e-9
+                     ? std::pow(double(n_), u)
+                     : std::pow((std::pow(double(n_), e) - 1) * u + 1, 1 / e);
+      rank = static_cast<uint64_t>(k) - 1;
+    } else {
+      return static_cast<node_id_t>(rng_() % n_);
+    }
+    if (rank >= n_) rank = n_ - 1;
+    return static_cast<node_id_t>(Scramble(rank) % n_);
+  }
+
+  uint64_t NextUint64() { return rng_(); }
+  double NextDouble() { return uniform_(rng_); }
+
+ private:
+  // The zeta sums are cached per (n, theta); every thread needs the same one.
+  static double Zeta(uint64_t n, double theta) {
+    static std::mutex mu;
+    static std::vector<std::pair<std::pair<uint64_t, double>, double>> cache;
+    std::lock_guard<std::mutex> lock(mu);
+    for (const auto& entry : cache) {
+      if (entry.first.first == n && entry.first.second == theta) {
+        return entry.second;
+      }
+    }
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++) sum += 1.0 / std::pow(double(i), theta);
+    cache.push_back({{n, theta}, sum});
+    return sum;
+  }
+
+  static uint64_t Scramble(uint64_t x) {
+    // FNV-1a over the 8 bytes of the rank
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < 8; i++) {
+      h ^= (x >> (i * 8)) & 0xFF;
+      h *= 0x100000001B3ULL;
+    }
+    return h;
+  }
+
+  uint64_t n_;
+  int distribution_;
+  double skew_;
+  double zeta_n_ = 0, alpha_ = 0, eta_ = 0;
+  std::mt19937_64 rng_;
+  std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+};
+
+// Engine-side cost of one op type, summed from PerfContext and
+// IOStatsContext after every call.
+struct GraphOpBreakdown {
+  uint64_t block_cache_hit_count = 0;
+  uint64_t block_read_count = 0;
+  uint64_t block_read_byte = 0;
+  uint64_t block_read_time = 0;
+  uint64_t get_from_memtable_time = 0;
+  uint64_t get_from_output_files_time = 0;
+  uint64_t merge_operator_time_nanos = 0;
+  uint64_t write_wal_time = 0;
+  uint64_t write_memtable_time = 0;
+  uint64_t io_bytes_read = 0;
+  uint64_t io_bytes_written = 0;
+  uint64_t io_read_nanos = 0;
+
+  void AddCurrentThread() {
+    const PerfContext* perf = get_perf_context();
+    block_cache_hit_count += perf->block_cache_hit_count;
+    block_read_count += perf->block_read_count;
+    block_read_byte += perf->block_read_byte;
+    block_read_time += perf->block_read_time;
+    get_from_memtable_time += perf->get_from_memtable_time;
+    get_from_output_files_time += perf->get_from_output_files_time;
+    merge_operator_time_nanos += perf->merge_operator_time_nanos;
+    write_wal_time += perf->write_wal_time;
+    write_memtable_time += perf->write_memtable_time;
+    const IOStatsContext* io = get_iostats_context();
+    io_bytes_read += io->bytes_read;
+    io_bytes_written += io->bytes_written;
+    io_read_nanos += io->read_nanos;
+  }
+
+  void Merge(const GraphOpBreakdown& o) {
+    block_cache_hit_count += o.block_cache_hit_count;
+    block_read_count += o.block_read_count;
+    block_read_byte += o.block_read_byte;
+    block_read_time += o.block_read_time;
+    get_from_memtable_time += o.get_from_memtable_time;
+    get_from_output_files_time += o.get_from_output_files_time;
+    merge_operator_time_nanos += o.merge_operator_time_nanos;
+    write_wal_time += o.write_wal_time;
+    write_memtable_time += o.write_memtable_time;
+    io_bytes_read += o.io_bytes_read;
+    io_bytes_written += o.io_bytes_written;
+    io_read_nanos += o.io_read_nanos;
+  }
+};
+
+// Closed-loop multi-client driver: every thread issues ops back to back,
+// drawing the op type from op_weights and the vertices from the key
+// generator, and records per-op latencies in its own HistogramImpl.
+// RocksGraph writes are not safe to run concurrently, so add, delete and
+// prop_set ops hold the graph exclusively while reads share it; measured
+// latencies include the wait for the graph.
+class GraphWorkloadDriver {
+ public:
+  GraphWorkloadDriver(RocksGraph* graph, const GraphWorkloadOptions& options)
+      : graph_(graph), options_(options) {}
+
+  Status Run() {
+    if (options_.num_threads < 1 || options_.num_vertices < 1) {
+      return Status::InvalidArgument("need threads and vertices");
+    }
+    double total_weight = 0;
+    for (double w : options_.op_weights) total_weight += w;
+    if (options_.op_weights.size() != kGraphOpNum || total_weight <= 0) {
+      return Status::InvalidArgument("op mix needs a positive weight");
+    }
+    if (options_.ops_per_thread == 0 && options_.duration_sec <= 0) {
+      return Status::InvalidArgument("need an op count or a duration");
+    }
+    if (options_.key_distribution == KEY_DIST_ZIPFIAN &&
+        (options_.skew <= 0 || options_.skew == 1.0)) {
+      return Status::InvalidArgument("zipfian theta must be in (0, 1)");
+    }
+    graph_->ReserveVertices(options_.num_vertices);
+    threads_.clear();
+    for (int t = 0; t < options_.num_threads; t++) {
+      threads_.emplace_back(new ThreadState());
+    }
+    throughput_.clear();
+    done_threads_ = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options_.num_threads; t++) {
+      workers.emplace_back(&GraphWorkloadDriver::ClientLoop, this, t);
+    }
+    std::thread reporter(&GraphWorkloadDriver::ReportLoop, this, start);
+    for (auto& worker : workers) worker.join();
+    {
+      std::lock_guard<std::mutex> lock(report_mu_);
+      done_threads_ = options_.num_threads;
+    }
+    report_cv_.notify_all();
+    reporter.join();
+    elapsed_sec_ = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    for (const auto& state : threads_) {
+      if (!state->status.ok()) return state->status;
+    }
+    return Status::OK();
+  }
+
+  std::string ToString() const {
+    std::stringstream ss;
+    uint64_t total_ops = 0;
+    for (int op = 0; op < kGraphOpNum; op++) {
+      HistogramImpl hist;
+      GraphOpBreakdown breakdown;
+      for (const auto& state : threads_) {
+        hist.Merge(state->latency[op]);
+        breakdown.Merge(state->breakdown[op]);
+      }
+      if (hist.num() == 0) continue;
+      total_ops += hist.num();
+      double n = static_cast<double>(hist.num());
+      ss << std::fixed << std::setprecision(2) << kGraphOpNames[op]
+         << ".micros  COUNT: " << hist.num() << " AVG: " << hist.Average()
+         << " P50: " << hist.Median() << " P99: " << hist.Percentile(99)
+         << " P99.9: " << hist.Percentile(99.9) << " MAX: " << hist.max()
+         << std::endl;
+      ss << "  per op: cache_hits " << breakdown.block_cache_hit_count / n
+         << " block_reads " << breakdown.block_read_count / n
+         << " block_read_bytes " << breakdown.block_read_byte / n
+         << " block_read_us " << breakdown.block_read_time / n / 1000
+         << " memtable_us " << breakdown.get_from_memtable_time / n / 1000
+         << " sst_us " << breakdown.get_from_output_files_time / n / 1000
+         << " merge_us " << breakdown.merge_operator_time_nanos / n / 1000
+         << " wal_us " << breakdown.write_wal_time / n / 1000
+         << " memtable_write_us " << breakdown.write_memtable_time / n / 1000
+         << " io_read_bytes " << breakdown.io_bytes_read / n
+         << " io_write_bytes " << breakdown.io_bytes_written / n
+         << " io_read_us " << breakdown.io_read_nanos / n / 1000
+         << std::endl;
+    }
+    ss << "throughput: " << total_ops << " ops in " << elapsed_sec_
+       << " s = " << (elapsed_sec_ > 0 ? total_ops / elapsed_sec_ : 0)
+       << " ops/s" << std::endl;
+    ss << "throughput over time (ops/s per " << options_.report_interval_sec
+       << " s):";
+    for (double t : throughput_) ss << " " << t;
+    ss << std::endl;
+    return ss.str();
+  }
+
+ private:
+  struct ThreadState {
+    HistogramImpl latency[kGraphOpNum];
+    GraphOpBreakdown breakdown[kGraphOpNum];
+    std::atomic<uint64_t> ops{0};
+    Status status;
+  };
+
+  void ClientLoop(int t) {
+    ThreadState& state = *threads_[t];
+    GraphKeyGenerator keys(options_, options_.seed * 1000003 + t);
+    std::discrete_distribution<int> pick_op(options_.op_weights.begin(),
+                                            options_.op_weights.end());
+    std::mt19937_64 op_rng(options_.seed ^ (0x9E3779B97F4A7C15ULL * (t + 1)));
+    SetPerfLevel(options_.perf_level);
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(options_.duration_sec);
+    for (uint64_t i = 0;
+         options_.ops_per_thread == 0 || i < options_.ops_per_thread; i++) {
+      if (options_.duration_sec > 0 && (i & 63) == 0 &&
+          std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+      int op = pick_op(op_rng);
+      get_perf_context()->Reset();
+      get_iostats_context()->Reset();
+      auto begin = std::chrono::steady_clock::now();
+      Status s = RunOp(op, &keys);
+      auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - begin)
+                        .count();
+      if (!s.ok() && !s.IsNotFound()) {
+        state.status = s;
+        break;
+      }
+      state.latency[op].Add(static_cast<uint64_t>(micros));
+      state.breakdown[op].AddCurrentThread();
+      state.ops.fetch_add(1, std::memory_order_relaxed);
+    }
+    SetPerfLevel(PerfLevel::kDisable);
+  }
+
+  Status RunOp(int op, GraphKeyGenerator* keys) {
+    if (op == kGraphOpAdd || op == kGraphOpDelete ||
+        op == kGraphOpPropertySet) {
+      std::unique_lock<std::shared_mutex> lock(graph_mu_);
+      return RunOpLocked(op, keys);
+    }
+    std::shared_lock<std::shared_mutex> lock(graph_mu_);
+    return RunOpLocked(op, keys);
+  }
+
+  Status RunOpLocked(int op, GraphKeyGenerator* keys) {
+    node_id_t v = keys->Next();
+    switch (op) {
+      case kGraphOpAdd:
+        return graph_->AddEdge(v, keys->Next());
+      case kGraphOpDelete:
+        return graph_->DeleteEdge(v, keys->Next());
+      case kGraphOpGet: {
+        Edges edges;
+        Status s = graph_->GetAllEdges(v, &edges);
+        free_edges(&edges);
+        return s;
+      }
+      case kGraphOpDegree:
+        graph_->GetOutDegree(v);
+        graph_->GetInDegree(v);
+        return Status::OK();
+      case kGraphOpKHop:
+        return KHop(v);
+      case kGraphOpWalk:
+        return Walk(v, keys);
+      case kGraphOpPropertyGet: {
+        std::vector<Property> props;
+        return graph_->GetVertexProperty(v, props);
+      }
+      case kGraphOpPropertySet:
+        return graph_->AddVertexProperty(
+            v, Property{"bench", std::to_string(keys->NextUint64() % 1000)});
+    }
+    return Status::InvalidArgument("unknown graph op");
+  }
+
+  Status KHop(node_id_t start) {
+    std::unordered_set<node_id_t> visited{start};
+    std::vector<node_id_t> frontier{start}, next;
+    for (int hop = 0; hop < options_.khop_hops && !frontier.empty(); hop++) {
+      next.clear();
+      for (node_id_t v : frontier) {
+        Edges edges;
+        Status s = graph_->GetAllEdges(v, &edges);
+        if (!s.ok() && !s.IsNotFound()) return s;
+        for (uint32_t i = 0; i < edges.num_edges_out; i++) {
+          node_id_t u = edges.nxts_out[i].nxt;
+          if (visited.size() < options_.khop_max_vertices &&
+              visited.insert(u).second) {
+            next.push_back(u);
+          }
+        }
+        free_edges(&edges);
+      }
+      frontier.swap(next);
+    }
+    return Status::OK();
+  }
+
+  Status Walk(node_id_t start, GraphKeyGenerator* keys) {
+    node_id_t cur = start;
+    for (int step = 0; step < options_.walk_length; step++) {
+      Edges edges;
+      Status s = graph_->GetAllEdges(cur, &edges);
+      if (!s.ok() || edges.num_edges_out == 0) {
+        free_edges(&edges);
+        return s.IsNotFound() ? Status::OK() : s;
+      }
+      cur = edges.nxts_out[keys->NextUint64() % edges.num_edges_out].nxt;
+      free_edges(&edges);
+    }
+    return Status::OK();
+  }
+
+  void ReportLoop(std::chrono::steady_clock::time_point start) {
+    if (options_.report_interval_sec <= 0) return;
+    auto interval = std::chrono::seconds(options_.report_interval_sec);
+    auto next = start + interval;
+    uint64_t last_ops = 0;
+    std::unique_lock<std::mutex> lock(report_mu_);
+    while (!report_cv_.wait_until(lock, next, [this] {
+      return done_threads_ == options_.num_threads;
+    })) {
+      uint64_t ops = 0;
+      for (const auto& state : threads_) {
+        ops += state->ops.load(std::memory_order_relaxed);
+      }
+      throughput_.push_back(static_cast<double>(ops - last_ops) /
+                            options_.report_interval_sec);
+      last_ops = ops;
+      next += interval;
+    }
+  }
+
+  RocksGraph* graph_;
+  GraphWorkloadOptions options_;
+  // writes exclusive, reads shared; see the class comment
+  std::shared_mutex graph_mu_;
+  std::vector<std::unique_ptr<ThreadState>> threads_;
+  std::vector<double> throughput_;
+  std::mutex report_mu_;
+  std::condition_variable report_cv_;
+  int done_threads_ = 0;
+  double elapsed_sec_ = 0;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -57,6 +57,11 @@ enum CompactionPri : char {
   // level. The file picking process will cycle through all the files in a
   // round-robin manner.
   kRoundRobin = 0x4,
+  // First compact files with the most merge operands per entry, from the
+  // table properties, larger files first on ties. Suits merge-heavy
+  // workloads, such as lazily updated graph adjacency lists, where a key's
+  // read cost grows with the operands stacked above its base value.
+  kMergeOperandDensity = 0x5,
 };
 
 // Compression options for different compression algorithms like Zlib
@@ -387,11 +392,35 @@ struct AdvancedColumnFamilyOptions {
   bool inplace_update_support = false;
 
   // Number of locks used for inplace update
-  // Default: 10000, if inplace_update_support = true, else 0.
+  // Default: 10000, if inplace_update_support or inplace_merge_support =
+  // true, else 0.
   //
   // Dynamically changeable through SetOptions() API
   size_t inplace_update_num_locks = 10000;
 
+  // Allows folding a Merge(key, operand) into the newest merge operand of the
+  // key in the active memtable instead of adding an entry for it. The two are
+  // combined with MergeOperator::PartialMerge, so operand order and any base
+  // value below them are kept. The operand is folded iff
+  //   * the newest entry of the key in the memtable is a merge operand
+  //     written by an earlier write batch
+  //   * PartialMerge succeeds and the result fits the room reserved behind
+  //     that entry. Room is only reserved when a key is merged again while
+  //     its newest entry is still a merge operand, so a hot key ends up with
+  //     a few entries holding many operands and cold keys pay nothing.
+  //   * the memtable holds no range deletion, the write carries no
+  //     protection info, and neither user-defined timestamps nor
+  //     memtable_protection_bytes_per_key are in use
+  // Merges inserted by parallel memtable writers are added, not folded.
+  // The folded entry keeps its sequence number, so like
+  // inplace_update_support this disables snapshots, and TransactionDB and
+  // OptimisticTransactionDB refuse to open with it. Nothing is folded while
+  // an iterator over the memtable is open, so iterators keep the view they
+  // were created with; point lookups lock the operand while reading it (see
+  // inplace_update_num_locks).
+  // Default: false.
+  bool inplace_merge_support = false;
+
   // [experimental]
   // Used to activate or deactive the Mempurge feature (memtable garbage
   // collection). (deactivated by default). At every flush, the total useful
@@ -7,6 +7,7 @@
 #include <deque>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <random>
 #include <string>
 #include <vector>
@@ -104,6 +105,9 @@ class MorrisCounter {
   int mantissa_bits = 5;
   std::random_device rd;
   std::mt19937 rand_gen;
+  // Guards counters and rand_gen: merges, compactions and committing
+  // transactions update the counters from different threads.
+  mutable std::mutex mu;
 
   MorrisCounter(vertex_id_t n) : rand_gen(rd()) { counters.resize(n, 0); }
 
@@ -111,20 +115,30 @@ class MorrisCounter {
 
   ~MorrisCounter() {}
 
-  void AddCounter(vertex_id_t v) {
+  // Grows the counter array to hold ids below n without touching counts.
+  void Reserve(vertex_id_t n) {
+    std::lock_guard<std::mutex> lock(mu);
+    if (static_cast<size_t>(n) > counters.size()) counters.resize(n, 0);
+  }
+
+  // Returns false if the counter is saturated and the increment is lost.
+  bool AddCounter(vertex_id_t v) {
+    std::lock_guard<std::mutex> lock(mu);
     while (static_cast<size_t>(v) >= counters.size()) {
       vertex_id_t new_size = counters.size() * 2;
       counters.resize(new_size, 0);
     }
-    if(counters[v] == UCHAR_MAX) return;
+    if(counters[v] == UCHAR_MAX) return false;
     int exponent = ExtractExponent(counters[v]);
     std::uniform_int_distribution<> dist(1, 1 << exponent);
     if (dist(rand_gen) == 1) {
       counters[v]++;
     }
+    return true;
   }
 
   void DecayCounter(vertex_id_t v) {
+    std::lock_guard<std::mutex> lock(mu);
     if(static_cast<size_t>(v) >= counters.size()) return;
     int exponent = ExtractExponent(counters[v]);
     std::uniform_int_distribution<> dist(1, 1 << exponent);
@@ -146,17 +160,34 @@ class MorrisCounter {
   }
 
   int GetVertexCount(vertex_id_t v) {
+    std::lock_guard<std::mutex> lock(mu);
     if (static_cast<size_t>(v) >= counters.size()) {
       return 0;
     }
-    if(counters[v] == UCHAR_MAX) return INT_MAX;
-    int exponent = ExtractExponent(counters[v]);
-    int mantissa = ExtractMantissa(counters[v]);
+    return EstimateCount(counters[v]);
+  }
+
+  // The count a raw counter value stands for.
+  int EstimateCount(unsigned char counter) {
+    if(counter == UCHAR_MAX) return INT_MAX;
+    int exponent = ExtractExponent(counter);
+    int mantissa = ExtractMantissa(counter);
     return ((1 << exponent) - 1) * (1 << mantissa_bits) +
            (1 << exponent) * mantissa;
   }
 
+  void ResetCounter(vertex_id_t v) {
+    std::lock_guard<std::mutex> lock(mu);
+    if (static_cast<size_t>(v) < counters.size()) counters[v] = 0;
+  }
+
+  std::vector<unsigned char> CopyCounters() const {
+    std::lock_guard<std::mutex> lock(mu);
+    return counters;
+  }
+
   size_t CalcMemoryUsage(){
+    std::lock_guard<std::mutex> lock(mu);
     return calculateMemoryUsage(counters);
   }
 };
@@ -1,8 +1,19 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "rocksdb/advanced_options.h"
 #include "rocksdb/db.h"
@@ -10,13 +21,17 @@
 #include "rocksdb/env.h"
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/graph_encoder.h"
+#include "rocksdb/graph_relabel.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/options.h"
+#include "rocksdb/slice_transform.h"
 #include "rocksdb/table.h"
+#include "rocksdb/trace_reader_writer.h"
 
 namespace ROCKSDB_NAMESPACE {
 using node_id_t = int64_t;
 using edge_id_t = int64_t;
+using edge_label_t = uint32_t;
 
 #define EDGE_UPDATE_EAGER 0x0
 #define EDGE_UPDATE_LAZY 0x1
@@ -34,6 +49,10 @@ using edge_id_t = int64_t;
 #define FILTER_TYPE_MORRIS 0x2
 #define FILTER_TYPE_ALL 0x3  // this option is purely for comparison test
 
+#define EDGE_DIRECTION_OUT 0x0
+#define EDGE_DIRECTION_IN 0x1
+#define EDGE_DIRECTION_BOTH 0x2
+
 // a 4 byte value
 union Value {
   uint32_t val;
@@ -47,12 +66,27 @@ struct Edge {
 };
 // using Edge = int64_t;
 
+// Fixed-width attributes of one edge. A list that carries them stores one
+// column per field after the neighbor ids (timestamps, then weights, then
+// labels), so the id column stays dense. Edges written without attributes
+// into such a list get the defaults.
+struct EdgeAttr {
+  float weight = 1.0f;
+  // On a label-scoped list, always that list's label.
+  edge_label_t label = 0;
+  uint64_t timestamp = 0;
+};
+#define EDGE_ATTR_BYTES 16  // per edge: 8 timestamp + 4 weight + 4 label
+
 // 4+12x bytes
 struct Edges {
   uint32_t num_edges_out = 0;
   uint32_t num_edges_in = 0;
   Edge* nxts_out = NULL;
   Edge* nxts_in = NULL;
+  // parallel to nxts_out / nxts_in; both NULL if the list has no attributes
+  EdgeAttr* attrs_out = NULL;
+  EdgeAttr* attrs_in = NULL;
 };
 
 struct EdgesEncodedEF {
@@ -109,6 +143,28 @@ void inline encode_node_hash(VertexKey v, node_id_t edge, std::string* key) {
   // std::cout << "key: " << key << std::endl;
 }
 
+// Key of a labeled adjacency list: vertex || label || direction. The label is
+// big-endian so one vertex's lists sort by label and share the vertex prefix.
+#define LABELED_KEY_SIZE (sizeof(node_id_t) + sizeof(edge_label_t) + 1)
+
+void inline encode_labeled_node(node_id_t v, edge_label_t label,
+                                int direction, std::string* key) {
+  encode_node(v, key);
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    key->push_back(static_cast<char>((label >> shift) & 0xFF));
+  }
+  key->push_back(static_cast<char>(direction));
+}
+
+edge_label_t inline decode_label(const char* key) {
+  edge_label_t label = 0;
+  for (size_t i = 0; i < sizeof(edge_label_t); i++) {
+    label = (label << 8) |
+            static_cast<unsigned char>(key[sizeof(node_id_t) + i]);
+  }
+  return label;
+}
+
 void inline decode_node(VertexKey* v, const std::string& key) {
   if (key.size() < sizeof(VertexKey)) {
     v->id = 0;
@@ -117,7 +173,7 @@ void inline decode_node(VertexKey* v, const std::string& key) {
   std::memcpy(v, key.data(), sizeof(VertexKey));
 }
 
-node_id_t inline decode_node(const std::string& key) {
+node_id_t inline decode_node(const Slice& key) {
   if (key.size() < sizeof(node_id_t)) {
     return 0;
   }
@@ -126,6 +182,87 @@ node_id_t inline decode_node(const std::string& key) {
   return id;
 }
 
+// Byte offset at which the id columns of an encoded adjacency value end.
+size_t inline edge_ids_end(const char* data, size_t data_size,
+                           int encoding_type) {
+  if (data_size < sizeof(uint32_t) * 2) return data_size;
+  uint32_t num_out = *reinterpret_cast<const uint32_t*>(data);
+  uint32_t num_in = *reinterpret_cast<const uint32_t*>(data + sizeof(uint32_t));
+  size_t offset = sizeof(uint32_t) * 2;
+  if (encoding_type == ENCODING_TYPE_NONE) {
+    return offset + (static_cast<size_t>(num_out) + num_in) * sizeof(Edge);
+  }
+  for (uint32_t num : {num_out, num_in}) {
+    if (num == 0) continue;
+    if (offset + sizeof(uint64_t) > data_size) return data_size;
+    uint64_t bits = *reinterpret_cast<const uint64_t*>(data + offset);
+    offset += sizeof(uint64_t) * (detail::words_for(bits) + 1);
+  }
+  return offset;
+}
+
+// Start of the attribute columns, or nullptr if the value carries none.
+inline const char* edge_attrs_data(const char* data, size_t data_size,
+                                    int encoding_type) {
+  if (data_size < sizeof(uint32_t) * 2) return nullptr;
+  size_t total = static_cast<size_t>(*reinterpret_cast<const uint32_t*>(data)) +
+                 *reinterpret_cast<const uint32_t*>(data + sizeof(uint32_t));
+  size_t offset = edge_ids_end(data, data_size, encoding_type);
+  if (total == 0 || offset + total * EDGE_ATTR_BYTES > data_size) {
+    return nullptr;
+  }
+  return data + offset;
+}
+
+void inline encode_edge_attrs(const Edges* edges, std::string* value) {
+  if (edges->attrs_out == NULL && edges->attrs_in == NULL) return;
+  uint32_t total = edges->num_edges_out + edges->num_edges_in;
+  auto attr = [edges](uint32_t p) {
+    if (p < edges->num_edges_out) {
+      return edges->attrs_out ? edges->attrs_out[p] : EdgeAttr();
+    }
+    p -= edges->num_edges_out;
+    return edges->attrs_in ? edges->attrs_in[p] : EdgeAttr();
+  };
+  value->reserve(value->size() + total * EDGE_ATTR_BYTES);
+  for (uint32_t p = 0; p < total; p++) {
+    uint64_t timestamp = attr(p).timestamp;
+    value->append(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+  }
+  for (uint32_t p = 0; p < total; p++) {
+    float weight = attr(p).weight;
+    value->append(reinterpret_cast<const char*>(&weight), sizeof(weight));
+  }
+  for (uint32_t p = 0; p < total; p++) {
+    uint32_t label = attr(p).label;
+    value->append(reinterpret_cast<const char*>(&label), sizeof(label));
+  }
+}
+
+void inline decode_edge_attrs(Edges* edges, const char* data,
+                              size_t data_size, int encoding_type) {
+  edges->attrs_out = nullptr;
+  edges->attrs_in = nullptr;
+  const char* attrs = edge_attrs_data(data, data_size, encoding_type);
+  if (attrs == nullptr) return;
+  size_t total =
+      static_cast<size_t>(edges->num_edges_out) + edges->num_edges_in;
+  edges->attrs_out = new EdgeAttr[edges->num_edges_out];
+  edges->attrs_in = new EdgeAttr[edges->num_edges_in];
+  for (size_t p = 0; p < total; p++) {
+    EdgeAttr& attr = p < edges->num_edges_out
+                         ? edges->attrs_out[p]
+                         : edges->attrs_in[p - edges->num_edges_out];
+    memcpy(&attr.timestamp, attrs + p * sizeof(uint64_t), sizeof(uint64_t));
+    memcpy(&attr.weight, attrs + total * sizeof(uint64_t) + p * sizeof(float),
+           sizeof(float));
+    memcpy(&attr.label,
+           attrs + total * (sizeof(uint64_t) + sizeof(float)) +
+               p * sizeof(uint32_t),
+           sizeof(uint32_t));
+  }
+}
+
 void inline encode_edge(const Edge* edge, std::string* value) {
   // int byte_to_fill = sizeof(Value);
   // for (int i = byte_to_fill - 1; i >= 0; i--) {
@@ -199,6 +336,7 @@ void inline encode_edges(
       }
     }
   }
+  encode_edge_attrs(edges, value);
 }
 
 void inline decode_edges(
@@ -251,6 +389,7 @@ void inline decode_edges(
       }
     }
   }
+  decode_edge_attrs(edges, data, data_size, encoding_type);
 }
 
 void inline decode_edges(
@@ -262,10 +401,192 @@ void inline decode_edges(
 void inline free_edges(Edges* edges) {
   delete[] edges->nxts_out;
   delete[] edges->nxts_in;
+  delete[] edges->attrs_out;
+  delete[] edges->attrs_in;
   edges->nxts_out = nullptr;
   edges->nxts_in = nullptr;
+  edges->attrs_out = nullptr;
+  edges->attrs_in = nullptr;
 }
 
+// Read-only random access over an encoded adjacency value. With
+// ENCODING_TYPE_NONE the neighbor arrays are read in place from the value
+// buffer; with ENCODING_TYPE_EFP each list is opened as an enumerator and
+// single positions are decoded on demand, so callers that only touch a few
+// neighbors never pay for a full decode_edges().
+class EdgeListView {
+ public:
+  EdgeListView() {}
+  EdgeListView(const char* data, size_t data_size, int encoding_type,
+               node_id_t universe = std::numeric_limits<uint32_t>::max()) {
+    Reset(data, data_size, encoding_type, universe);
+  }
+
+  void Reset(const char* data, size_t data_size, int encoding_type,
+             node_id_t universe = std::numeric_limits<uint32_t>::max()) {
+    data_ = data;
+    encoding_type_ = encoding_type;
+    universe_ = universe;
+    num_edges_out_ = 0;
+    num_edges_in_ = 0;
+    attrs_ = nullptr;
+    bv_out_.reset();
+    bv_in_.reset();
+    if (data_size < sizeof(uint32_t) * 2) {
+      return;
+    }
+    num_edges_out_ = *reinterpret_cast<const uint32_t*>(data);
+    num_edges_in_ = *reinterpret_cast<const uint32_t*>(data + sizeof(uint32_t));
+    attrs_ = edge_attrs_data(data, data_size, encoding_type_);
+    if (encoding_type_ == ENCODING_TYPE_EFP) {
+      size_t out_offset = 0;
+      if (num_edges_out_ > 0) {
+        bit_vector_builder bvb_out;
+        bvb_out.decode(data, data_size, sizeof(uint32_t) * 2);
+        out_offset = bvb_out.get_offset();
+        bv_out_.reset(new bit_vector(&bvb_out));
+        enum_out_ = efp_enumerator(*bv_out_, 0, universe_, num_edges_out_,
+                                   params_);
+      }
+      if (num_edges_in_ > 0) {
+        bit_vector_builder bvb_in;
+        bvb_in.decode(data, data_size, sizeof(uint32_t) * 2 + out_offset);
+        bv_in_.reset(new bit_vector(&bvb_in));
+        enum_in_ =
+            efp_enumerator(*bv_in_, 0, universe_, num_edges_in_, params_);
+      }
+    }
+  }
+
+  uint32_t num_edges_out() const { return num_edges_out_; }
+  uint32_t num_edges_in() const { return num_edges_in_; }
+
+  // EDGE_DIRECTION_BOTH addresses the out list followed by the in list.
+  uint32_t num_edges(int direction) const {
+    if (direction == EDGE_DIRECTION_OUT) return num_edges_out_;
+    if (direction == EDGE_DIRECTION_IN) return num_edges_in_;
+    return num_edges_out_ + num_edges_in_;
+  }
+
+  node_id_t out(uint32_t i) {
+    if (encoding_type_ == ENCODING_TYPE_EFP) {
+      return static_cast<node_id_t>(enum_out_.move(i).second);
+    }
+    return raw_out()[i].nxt;
+  }
+
+  node_id_t in(uint32_t i) {
+    if (encoding_type_ == ENCODING_TYPE_EFP) {
+      return static_cast<node_id_t>(enum_in_.move(i).second);
+    }
+    return raw_in()[i].nxt;
+  }
+
+  node_id_t at(int direction, uint32_t i) {
+    if (direction == EDGE_DIRECTION_IN) return in(i);
+    if (direction == EDGE_DIRECTION_BOTH && i >= num_edges_out_) {
+      return in(i - num_edges_out_);
+    }
+    return out(i);
+  }
+
+  // Smallest id >= lower_bound in the out or in list, or the largest
+  // node_id_t if there is none. EFP lists skip ahead through their index
+  // instead of decoding every id, so a forward sequence of probes is cheap.
+  node_id_t next_geq(int direction, node_id_t lower_bound) {
+    const node_id_t none = std::numeric_limits<node_id_t>::max();
+    uint32_t n = direction == EDGE_DIRECTION_IN ? num_edges_in_
+                                                : num_edges_out_;
+    if (n == 0) return none;
+    if (encoding_type_ == ENCODING_TYPE_EFP) {
+      if (lower_bound < 0) lower_bound = 0;
+      auto found = direction == EDGE_DIRECTION_IN
+                       ? enum_in_.next_geq(lower_bound)
+                       : enum_out_.next_geq(lower_bound);
+      return found.first < n ? static_cast<node_id_t>(found.second) : none;
+    }
+    const Edge* begin = direction == EDGE_DIRECTION_IN ? raw_in() : raw_out();
+    const Edge* it =
+        std::lower_bound(begin, begin + n, lower_bound,
+                         [](const Edge& e, node_id_t v) { return e.nxt < v; });
+    return it == begin + n ? none : it->nxt;
+  }
+
+  int encoding_type() const { return encoding_type_; }
+
+  // In-place neighbor arrays; only valid for ENCODING_TYPE_NONE.
+  const Edge* raw_out() const {
+    return reinterpret_cast<const Edge*>(data_ + sizeof(uint32_t) * 2);
+  }
+  const Edge* raw_in() const { return raw_out() + num_edges_out_; }
+
+  // Edge attributes read in place from their columns, positioned as in
+  // at(). Lists without attributes report the EdgeAttr defaults.
+  bool has_attrs() const { return attrs_ != nullptr; }
+
+  uint64_t timestamp(int direction, uint32_t i) const {
+    uint64_t timestamp = EdgeAttr().timestamp;
+    if (attrs_) {
+      memcpy(&timestamp, attrs_ + attr_pos(direction, i) * sizeof(uint64_t),
+             sizeof(timestamp));
+    }
+    return timestamp;
+  }
+
+  float weight(int direction, uint32_t i) const {
+    float weight = EdgeAttr().weight;
+    if (attrs_) {
+      memcpy(&weight,
+             attrs_ + num_attrs() * sizeof(uint64_t) +
+                 attr_pos(direction, i) * sizeof(float),
+             sizeof(weight));
+    }
+    return weight;
+  }
+
+  uint32_t label(int direction, uint32_t i) const {
+    uint32_t label = EdgeAttr().label;
+    if (attrs_) {
+      memcpy(&label,
+             attrs_ + num_attrs() * (sizeof(uint64_t) + sizeof(float)) +
+                 attr_pos(direction, i) * sizeof(uint32_t),
+             sizeof(label));
+    }
+    return label;
+  }
+
+  EdgeAttr attr(int direction, uint32_t i) const {
+    EdgeAttr attr;
+    attr.timestamp = timestamp(direction, i);
+    attr.weight = weight(direction, i);
+    attr.label = label(direction, i);
+    return attr;
+  }
+
+ private:
+  size_t num_attrs() const {
+    return static_cast<size_t>(num_edges_out_) + num_edges_in_;
+  }
+  size_t attr_pos(int direction, uint32_t i) const {
+    return direction == EDGE_DIRECTION_IN ? num_edges_out_ + i : i;
+  }
+
+  using efp_enumerator =
+      typename uniform_partitioned_sequence<indexed_sequence>::enumerator;
+
+  const char* data_ = nullptr;
+  const char* attrs_ = nullptr;
+  int encoding_type_ = ENCODING_TYPE_NONE;
+  node_id_t universe_ = std::numeric_limits<uint32_t>::max();
+  uint32_t num_edges_out_ = 0;
+  uint32_t num_edges_in_ = 0;
+  global_parameters params_;
+  std::unique_ptr<bit_vector> bv_out_;
+  std::unique_ptr<bit_vector> bv_in_;
+  efp_enumerator enum_out_;
+  efp_enumerator enum_in_;
+};
+
 void inline concatenate_properties(const std::vector<Property>& props,
                                    std::string* value) {
   for (const auto& prop : props) {
@@ -367,18 +688,146 @@ std::vector<std::string> inline split_strings(const std::string& concatenated) {
   return strings;
 }
 
+// One hop of a sampled neighborhood in CSR form: the neighbors drawn for
+// seeds[i] are neighbors[offsets[i], offsets[i + 1]).
+struct SampledLayer {
+  std::vector<node_id_t> seeds;
+  std::vector<uint64_t> offsets;
+  std::vector<node_id_t> neighbors;
+};
+
+// Called for every stored vertex during a scan. The view points into iterator
+// memory and is only valid for the duration of the call; scans with more than
+// one thread invoke the callback concurrently.
+using AdjacencyScanCallback =
+    std::function<void(node_id_t id, EdgeListView& edges)>;
+
+class CSRSnapshot;
+class EdgeFilterCache;
+class GraphChangeIterator;
+class GraphTracer;
+class GraphTransaction;
+struct GraphTransactionDBOptions;
+class OptimisticTransactionDB;
+class Statistics;
+class TransactionDB;
+enum GraphTraceOp : char;
+
 struct GraphMeta {
   node_id_t n = 0;
   node_id_t m = 0;
+  // -1 when the file predates the flag
+  int8_t is_directed = -1;
+  int8_t temporal = -1;
+  int64_t blob_min_degree = -1;
+};
+
+// How a graph is opened; each field sets the RocksGraph member of the same
+// name. is_directed, temporal and blob_min_degree shape what is written, so
+// they are kept in GraphMeta.log and reopening with other values fails.
+struct RocksGraphOptions {
+  int edge_update_policy = EDGE_UPDATE_ADAPTIVE;
+  int encoding_type = ENCODING_TYPE_NONE;
+  bool auto_reinitialize = false;
+  std::string db_path = "/tmp/demo";
+  bool is_directed = true;
+  bool edge_filter = false;
+  bool temporal = false;
+  uint32_t blob_min_degree = 0;
+  // Opens the DB for transactions; see rocksdb/graph_transaction.h.
+  const GraphTransactionDBOptions* txn_options = nullptr;
+};
+
+// One label's lists of a vertex, as returned by GetAllLabeledEdges.
+struct LabeledEdges {
+  edge_label_t label = 0;
+  Edges edges;
+};
+
+// Scores computed by RocksGraph::LinkPredictionScores.
+enum LinkPredictionMetric : char {
+  kLinkCommonNeighbors = 0,
+  kLinkJaccard = 1,
+  kLinkAdamicAdar = 2,
+};
+
+// Budget of one ShortestPath or Reachable call, so a query between poorly
+// connected vertices cannot run away. Running out returns
+// Status::Incomplete(). 0 means no limit.
+struct PathQueryOptions {
+  // vertices whose lists are read, over both search directions
+  uint64_t max_expanded_vertices = 1 << 20;
+  uint64_t max_micros = 0;
+};
+
+// Running totals behind the rocksgraph.* properties. Unlike the tickers in
+// Options::statistics these are always collected.
+struct GraphStats {
+  static const int kDepthBuckets = 16;
+  std::atomic<uint64_t> adj_list_reads{0};
+  std::atomic<uint64_t> merge_operands{0};
+  std::atomic<uint64_t> max_merge_operands{0};
+  // operand_depth[0] counts reads that folded no operand, operand_depth[b]
+  // reads that folded [2^(b-1), 2^b) of them; the last bucket is open ended.
+  std::atomic<uint64_t> operand_depth[kDepthBuckets] = {};
+  std::atomic<uint64_t> decoded_edges{0};
+  std::atomic<uint64_t> eager_updates{0};
+  std::atomic<uint64_t> lazy_updates{0};
+  std::atomic<uint64_t> morris_saturated{0};
+};
+
+// Names accepted by RocksGraph::GetProperty / GetIntProperty.
+struct GraphProperties {
+  // "rocksgraph.stats" - summary of all the properties below.
+  static const std::string kStats;
+  // "rocksgraph.degree-histogram" - log2 buckets of the Morris-estimated
+  // vertex degrees.
+  static const std::string kDegreeHistogram;
+  // "rocksgraph.merge-operand-depth" - log2 buckets of merge operands folded
+  // per adjacency list read.
+  static const std::string kMergeOperandDepth;
+  // "rocksgraph.policy-mix" - eager vs lazy updates chosen by the adaptive
+  // policy.
+  static const std::string kPolicyMix;
+  // Integer properties.
+  // "rocksgraph.sketch-memory" - bytes used by the degree sketches.
+  static const std::string kSketchMemory;
+  // "rocksgraph.num-vertices", "rocksgraph.num-edges"
+  static const std::string kNumVertices;
+  static const std::string kNumEdges;
+  // "rocksgraph.adj-list-reads", "rocksgraph.max-merge-operands"
+  static const std::string kAdjListReads;
+  static const std::string kMaxMergeOperands;
+  // "rocksgraph.morris-saturated" - dropped degree increments.
+  static const std::string kMorrisSaturated;
 };
 
 class RocksGraph {
  public:
-  node_id_t n, m;
+  // atomic since transactions commit from several threads
+  std::atomic<node_id_t> n, m;
   int filter_type_ = FILTER_TYPE_MORRIS;
   int encoding_type_ = ENCODING_TYPE_NONE;
   int edge_update_policy_ = EDGE_UPDATE_EAGER;
   bool auto_reinitialize_ = false;
+  // Undirected graphs store one symmetric neighbor list per vertex in the
+  // out slot; the in list stays empty. Kept in GraphMeta.log, and reopening
+  // a graph with the other direction fails.
+  bool is_directed_ = true;
+  // Build a (src, dst) filter per adjacency SST so HasEdge can skip reads;
+  // see graph_edge_filter.h. Not available with EDGE_UPDATE_FULL_LAZY.
+  bool edge_filter_ = false;
+  // The filters of the adjacency SSTs, loaded once per file.
+  std::shared_ptr<EdgeFilterCache> edge_filter_cache_;
+  // Keep every version of the adjacency lists in the "adj_history" column
+  // family, whose keys carry a user-defined timestamp, for as-of reads. Not
+  // available with EDGE_UPDATE_FULL_LAZY.
+  bool temporal_ = false;
+  // Adjacency lists of about this many neighbors or more are stored in blob
+  // files, so compactions move a reference instead of rewriting the list;
+  // 0 keeps every list inline. Not used with EDGE_UPDATE_FULL_LAZY, whose
+  // values hold one edge each.
+  uint32_t blob_min_degree_ = 0;
   double update_ratio_ = 0.5;
   double lookup_ratio_ = 0.5;
   double cache_miss_rate_ = 0.9;
@@ -389,9 +838,14 @@ class RocksGraph {
    public:
     int encoding_type_;
     MorrisCounter* morris_;
-    node_id_t* m_;
-    AdjacentListMergeOp(int encoding_type, MorrisCounter* morris, node_id_t& m)
-        : encoding_type_(encoding_type), morris_(morris), m_(&m) {}
+    std::atomic<node_id_t>* m_;
+    bool symmetric_;
+    AdjacentListMergeOp(int encoding_type, MorrisCounter* morris,
+                        std::atomic<node_id_t>& m, bool symmetric = false)
+        : encoding_type_(encoding_type),
+          morris_(morris),
+          m_(&m),
+          symmetric_(symmetric) {}
     virtual ~AdjacentListMergeOp() override{};
     virtual bool Merge(const Slice& key, const Slice* existing_value,
                        const Slice& value, std::string* new_value,
@@ -420,15 +874,38 @@ class RocksGraph {
   RocksGraph(Options& options, int edge_update_policy = EDGE_UPDATE_ADAPTIVE,
              int encoding_type = ENCODING_TYPE_NONE,
              bool auto_reinitialize = false, std::string db_path = "/tmp/demo")
+      : RocksGraph(options, RocksGraphOptions{
+                                .edge_update_policy = edge_update_policy,
+                                .encoding_type = encoding_type,
+                                .auto_reinitialize = auto_reinitialize,
+                                .db_path = db_path}) {}
+
+  RocksGraph(Options& options, const RocksGraphOptions& graph_options)
+      : RocksGraph(options, graph_options, nullptr, nullptr) {}
+
+ private:
+  // With `secondary_path`, opens the DB as a secondary instance instead.
+  // Failures go to `open_status` if given, otherwise they exit.
+  RocksGraph(Options& options, const RocksGraphOptions& graph_options,
+             const std::string* secondary_path, Status* open_status)
       : n(0),
         m(0),
-        encoding_type_(encoding_type),
-        edge_update_policy_(edge_update_policy),
-        auto_reinitialize_(auto_reinitialize),
-        db_path_(db_path),
+        encoding_type_(graph_options.encoding_type),
+        edge_update_policy_(graph_options.edge_update_policy),
+        auto_reinitialize_(graph_options.auto_reinitialize),
+        is_directed_(graph_options.is_directed),
+        edge_filter_(graph_options.edge_filter &&
+                     edge_update_policy_ != EDGE_UPDATE_FULL_LAZY),
+        temporal_(graph_options.temporal &&
+                  edge_update_policy_ != EDGE_UPDATE_FULL_LAZY),
+        blob_min_degree_(edge_update_policy_ != EDGE_UPDATE_FULL_LAZY
+                             ? graph_options.blob_min_degree
+                             : 0),
+        db_path_(graph_options.db_path),
         cms_out(),
         cms_in(),
         mor(){
+    secondary_ = secondary_path != nullptr;
     auto table_options =
         options.table_factory->GetOptions<rocksdb::BlockBasedTableOptions>();
     table_options->filter_policy.reset(
@@ -441,41 +918,142 @@ class RocksGraph {
     // else if(filter_type_ == FILTER_TYPE_MORRIS){
     // }
     options.create_missing_column_families = true;
+    statistics_ = options.statistics;
     std::vector<ColumnFamilyDescriptor> column_families;
-    options.merge_operator.reset(
-        new AdjacentListMergeOp(encoding_type_, &mor, m));
-    column_families.emplace_back(kDefaultColumnFamilyName, options);
+    // a secondary's counts are the ones the primary publishes, so its reads
+    // must not move them
+    options.merge_operator.reset(new AdjacentListMergeOp(
+        encoding_type_, secondary_ ? nullptr : &mor,
+        secondary_ ? secondary_m_ : m, !is_directed_));
+    ColumnFamilyOptions adj_options(options);
+    if (edge_filter_) AddEdgeFilterCollector(&adj_options);
+    if (blob_min_degree_ > 0) ConfigureAdjacencyBlobs(&adj_options);
+    column_families.emplace_back(kDefaultColumnFamilyName, adj_options);
+    // labeled lists share the vertex prefix; their degrees go to the
+    // per-label sketches rather than `mor`
+    ColumnFamilyOptions label_options(options);
+    label_options.merge_operator.reset(
+        new AdjacentListMergeOp(encoding_type_, nullptr, m, !is_directed_));
+    label_options.prefix_extractor.reset(
+        NewFixedPrefixTransform(sizeof(node_id_t)));
+    if (blob_min_degree_ > 0) ConfigureAdjacencyBlobs(&label_options);
+    column_families.emplace_back("labeled_adj", label_options);
     // switch to merge operator for properties
     options.merge_operator.reset(new PropertyMergeOp(encoding_type_));
     column_families.emplace_back("eprop_val", options);
     options.merge_operator = nullptr;
     column_families.emplace_back("vprop_val", options);
+    column_families.emplace_back("id_map", options);
+    // scores kept up to date by IncrementalPageRank
+    column_families.emplace_back("graph_rank", options);
+    // counts and degree sketches published for secondaries
+    column_families.emplace_back("graph_meta", options);
+    if (temporal_) {
+      // history merges must not move the live edge count or sketches
+      ColumnFamilyOptions history_options(options);
+      history_options.comparator = BytewiseComparatorWithU64Ts();
+      history_options.merge_operator.reset(new AdjacentListMergeOp(
+          encoding_type_, nullptr, history_m_, !is_directed_));
+      column_families.emplace_back("adj_history", history_options);
+    }
     std::vector<ColumnFamilyHandle*> handles;
-    if (auto_reinitialize_) {
+    Status s;
+    if (secondary_) {
+      // counts come from graph_meta once the DB is open
+    } else if (auto_reinitialize_) {
       DestroyDB(db_path_, options);
     } else {
       GraphMeta meta;
       ReadMeta(db_path_ + meta_filename, meta);
       n = meta.n;
       m = meta.m;
+      if (meta.is_directed >= 0 && (meta.is_directed != 0) != is_directed_) {
+        s = Status::InvalidArgument(meta.is_directed
+                                        ? "the graph was created directed"
+                                        : "the graph was created undirected");
+      } else if (meta.temporal >= 0 && (meta.temporal != 0) != temporal_) {
+        s = Status::InvalidArgument(
+            meta.temporal ? "the graph was created temporal"
+                          : "the graph was created without history");
+      } else if (meta.blob_min_degree >= 0 &&
+                 meta.blob_min_degree != blob_min_degree_) {
+        s = Status::InvalidArgument(
+            "the graph was created with blob_min_degree " +
+            std::to_string(meta.blob_min_degree));
+      }
+    }
+    if (s.ok()) {
+      s = OpenDB(options, column_families, graph_options.txn_options,
+                 secondary_path, &handles);
     }
-    Status s = DB::Open(options, db_path_, column_families, &handles, &db_);
     if (!s.ok()) {
+      db_ = nullptr;
+      if (open_status) {
+        *open_status = s;
+        return;
+      }
       std::cout << s.ToString() << std::endl;
       exit(1);
     }
     adj_cf_ = handles[0];
-    edge_prop_cf_ = handles[1];
-    vertex_prop_cf_ = handles[2];
+    label_cf_ = handles[1];
+    edge_prop_cf_ = handles[2];
+    vertex_prop_cf_ = handles[3];
+    id_map_cf_ = handles[4];
+    rank_cf_ = handles[5];
+    meta_cf_ = handles[6];
+    if (temporal_) history_cf_ = handles[7];
+    LoadIdMapMeta();
+    if (secondary_) s = LoadPublishedMeta();
+    if (open_status) *open_status = s;
   }
 
+ public:
+  // Opens the graph the primary at `db_path` keeps writing as a read-only
+  // secondary instance, whose own info log goes to `secondary_path`. Reads
+  // see the graph as of the last catch-up with the primary, run every
+  // `catch_up_interval_ms` (0: only on TryCatchUpWithPrimary calls). The
+  // vertex and edge counts and the degree sketch come from the "graph_meta"
+  // column family the primary publishes them to; label sketches are not
+  // published. Writes fail with NotSupported, and GraphMeta.log is neither
+  // written nor needed. Any number of secondaries, in any process, can
+  // follow one primary.
+  // `graph_options` name the primary's path and must match how it was
+  // opened; auto_reinitialize, blob_min_degree and txn_options are ignored.
+  static Status OpenAsSecondary(Options& options,
+                                const RocksGraphOptions& graph_options,
+                                const std::string& secondary_path,
+                                std::unique_ptr<RocksGraph>* graph,
+                                uint64_t catch_up_interval_ms = 1000);
+
   ~RocksGraph() {
-    GraphMeta meta{.n = n, .m = m};
-    WriteMeta(db_path_ + meta_filename, meta);
+    EndTrace();
+    if (!db_) return;
+    if (secondary_) {
+      {
+        std::lock_guard<std::mutex> lock(catch_up_mu_);
+        stop_catch_up_ = true;
+      }
+      catch_up_cv_.notify_all();
+      if (catch_up_thread_.joinable()) catch_up_thread_.join();
+    } else {
+      GraphMeta meta{.n = n,
+                     .m = m,
+                     .is_directed = is_directed_,
+                     .temporal = temporal_,
+                     .blob_min_degree = blob_min_degree_};
+      WriteMeta(db_path_ + meta_filename, meta);
+      PublishMeta();
+    }
     db_->DestroyColumnFamilyHandle(adj_cf_);
+    db_->DestroyColumnFamilyHandle(label_cf_);
     db_->DestroyColumnFamilyHandle(edge_prop_cf_);
     db_->DestroyColumnFamilyHandle(vertex_prop_cf_);
-    db_->SyncWAL();
+    db_->DestroyColumnFamilyHandle(id_map_cf_);
+    db_->DestroyColumnFamilyHandle(rank_cf_);
+    db_->DestroyColumnFamilyHandle(meta_cf_);
+    if (history_cf_) db_->DestroyColumnFamilyHandle(history_cf_);
+    if (!secondary_) db_->SyncWAL();
     db_->Close();
     // delete db_;
   }
@@ -484,9 +1062,19 @@ class RocksGraph {
   Status AddVertex(node_id_t id);
   Status AddEdge(node_id_t from, node_id_t to);
   Status AddEdgeLazy(node_id_t from, node_id_t to);
+  // Stores `attr` next to the neighbor id in both endpoints' lists, following
+  // the update policy like AddEdge. Re-adding an edge replaces its attributes.
+  Status AddEdge(node_id_t from, node_id_t to, const EdgeAttr& attr);
   Status AddVertexProperty(node_id_t id, Property prop);
   Status AddEdgeProperty(node_id_t from, node_id_t to, Property prop);
+  // Sets props[i] on ids[i] in one write batch. Unlike AddVertexProperty the
+  // vertex's other properties are kept.
+  Status AddVertexProperties(const std::vector<node_id_t>& ids,
+                             const std::vector<Property>& props);
   void AddVertexForBulkLoad() { n++; }
+  // Sizes the degree counters for ids below num_vertices up front, so
+  // concurrent writers never race on a counter resize.
+  void ReserveVertices(node_id_t num_vertices) { mor.Reserve(num_vertices); }
   std::pair<std::string, std::string> AddEdges(node_id_t from,
                                                std::vector<node_id_t>& tos,
                                                std::vector<node_id_t>& froms);
@@ -494,8 +1082,116 @@ class RocksGraph {
                             std::vector<node_id_t>& out_neighbors,
                             std::vector<node_id_t>& in_neighbors);
   DB* get_raw_db() { return db_; }
+  bool secondary() const { return secondary_; }
+  // Secondaries: replays what the primary wrote since the last catch-up,
+  // then reloads the published counts and degree sketch.
+  Status TryCatchUpWithPrimary();
+  // Primaries: writes the counts and the degree sketch, only its changed
+  // chunks, to "graph_meta". Graph writes also carry them every
+  // kMetaPublishBatches batches, and closing the graph publishes them.
+  Status PublishMeta();
+  // Starts a GraphTransaction (rocksdb/graph_transaction.h). Needs the graph
+  // to be opened with GraphTransactionDBOptions and without
+  // inplace_merge_support.
+  Status BeginTransaction(std::unique_ptr<GraphTransaction>* txn);
+  ColumnFamilyHandle* get_rank_cf() { return rank_cf_; }
   Status DeleteEdge(node_id_t from, node_id_t to);
+  // Removes the vertex's adjacency lists (labeled ones included), its vertex
+  // properties and the properties of its out-edges in one batch. Neighbors
+  // get one delete operand each, folded away by the merge operator, so the
+  // cost is a single read of the vertex's own list; with ENCODING_TYPE_EFP,
+  // which cannot encode delete operands, neighbor lists are rewritten.
+  // Properties that in-neighbors hold for their edges into the vertex are
+  // left in place. NotSupported with EDGE_UPDATE_FULL_LAZY, whose per-edge
+  // keys give no list to find the neighbors in.
+  Status DeleteVertex(node_id_t id);
   Status GetAllEdges(node_id_t src, Edges* edges);
+  // Sets `exists` to whether the edge from -> to is stored. With edge_filter_
+  // a negative answer usually comes from the per-file filters alone.
+  Status HasEdge(node_id_t from, node_id_t to, bool* exists);
+  // Label-scoped lists, stored apart from the unlabeled ones under
+  // vertex || label || direction keys, so typed traversals only read their
+  // label's bytes. They follow the update policy (FULL_LAZY acts as LAZY),
+  // count in CountEdge() and keep exact per-label degrees in the list
+  // headers. Their writes are traced and reported by GetChangesSince, but
+  // the lists are not scanned by ParallelScan nor exported to CSR
+  // snapshots. The edges carry `label` as their EdgeAttr::label; an `attr`
+  // with another label is refused.
+  Status AddEdge(node_id_t from, node_id_t to, edge_label_t label,
+                 const EdgeAttr* attr = NULL);
+  Status DeleteEdge(node_id_t from, node_id_t to, edge_label_t label);
+  Status GetAllEdges(node_id_t src, edge_label_t label, Edges* edges);
+  // Every label's lists of `src`, in label order, from one prefix seek.
+  Status GetAllLabeledEdges(node_id_t src, std::vector<LabeledEdges>* lists);
+  node_id_t GetOutDegree(node_id_t id, edge_label_t label);
+  node_id_t GetInDegree(node_id_t id, edge_label_t label);
+  // Morris estimate of the edges of `id` under `label`, both directions.
+  node_id_t GetLabelDegreeApproximate(node_id_t id, edge_label_t label);
+  // The k heaviest neighbors of `src` in `direction` (EDGE_DIRECTION_*),
+  // heaviest first with ties broken by id. Only the id and weight columns
+  // are read.
+  Status GetTopKNeighborsByWeight(
+      node_id_t src, size_t k, int direction,
+      std::vector<std::pair<node_id_t, float>>* neighbors);
+  // Neighbors of `src` whose edge timestamp is in [start_time, end_time), in
+  // list order.
+  Status GetNeighborsInTimeRange(node_id_t src, uint64_t start_time,
+                                 uint64_t end_time, int direction,
+                                 std::vector<node_id_t>* neighbors);
+  // Neighborhood similarity for link prediction, computed next to the data:
+  // lists are fetched with MultiGet and intersected as sorted sets, flat
+  // lists in place with SIMD or galloping kernels and EFP lists through
+  // next_geq, without materializing the common neighbors. `direction`
+  // (EDGE_DIRECTION_*) selects the neighborhoods; BOTH merges out and in
+  // lists. Unknown vertices have empty neighborhoods. Not supported with
+  // EDGE_UPDATE_FULL_LAZY.
+  Status CommonNeighbors(node_id_t u, node_id_t v, int direction,
+                         uint64_t* count);
+  // |N(u) ∩ N(v)| for every v in `vs`, reading N(u) once.
+  Status CommonNeighbors(node_id_t u, const std::vector<node_id_t>& vs,
+                         int direction, std::vector<uint64_t>* counts);
+  // |N(u) ∩ N(v)| / |N(u) ∪ N(v)|, 0 when both are empty.
+  Status Jaccard(node_id_t u, const std::vector<node_id_t>& vs, int direction,
+                 std::vector<double>* scores);
+  // Sum of 1 / log(degree) over the common neighbors, with degrees counting
+  // both directions; neighbors of degree 1 are skipped.
+  Status AdamicAdar(node_id_t u, const std::vector<node_id_t>& vs,
+                    int direction, std::vector<double>* scores);
+  // Any of the scores above for arbitrary (u, v) pairs; every distinct
+  // vertex is read once per call.
+  Status LinkPredictionScores(
+      const std::vector<std::pair<node_id_t, node_id_t>>& pairs,
+      LinkPredictionMetric metric, int direction,
+      std::vector<double>* scores);
+  // Shortest path of at most max_hops edges from u to v along out-edges, as
+  // the vertex sequence u ... v; `path` stays empty if there is none. Runs a
+  // bidirectional BFS, over out-lists from u and in-lists from v, that
+  // expands the smaller frontier with one MultiGet per level, all under one
+  // snapshot. Not supported with EDGE_UPDATE_FULL_LAZY.
+  Status ShortestPath(node_id_t u, node_id_t v, uint32_t max_hops,
+                      std::vector<node_id_t>* path,
+                      const PathQueryOptions& options = PathQueryOptions());
+  Status Reachable(node_id_t u, node_id_t v, uint32_t max_hops,
+                   bool* reachable,
+                   const PathQueryOptions& options = PathQueryOptions());
+  // Vertices within `hops` out-edges of `start`, `start` first, in BFS order.
+  // Each level is read with one MultiGet.
+  Status KHop(node_id_t start, uint32_t hops, std::vector<node_id_t>* reached);
+  // Temporal mode (temporal_). Every write is recorded in the history at the
+  // timestamp set here, or at the clock's time in microseconds while it is
+  // 0, in the same batch as the write itself. Timestamps need not increase,
+  // but reads at T see every write stamped at or before T. Labeled lists and
+  // lists bulk loaded through AddEdges have no history.
+  void SetWriteTimestamp(uint64_t timestamp) {
+    write_timestamp_.store(timestamp, std::memory_order_relaxed);
+  }
+  // The lists of `src` as they were at `as_of`.
+  Status GetAllEdgesAsOf(node_id_t src, uint64_t as_of, Edges* edges);
+  Status KHopAsOf(node_id_t start, uint32_t hops, uint64_t as_of,
+                  std::vector<node_id_t>* reached);
+  // Lets compaction fold the versions older than `timestamp` into one, which
+  // bounds the history; as-of reads before it are rejected afterwards.
+  Status TrimHistory(uint64_t timestamp);
   node_id_t GetOutDegree(node_id_t id);
   node_id_t GetInDegree(node_id_t id);
   node_id_t GetDegreeApproximate(node_id_t id, int filter_type_manual = 0);
@@ -505,7 +1201,75 @@ class RocksGraph {
   std::vector<node_id_t> GetVerticesWithProperty(Property prop);
   std::vector<std::pair<node_id_t, node_id_t>> GetEdgesWithProperty(Property prop);
   // node_id_t GetInDegreeApproximate(node_id_t id, int filter_type_manual = 0);
+  // Draws up to fanouts[l] distinct neighbors per seed for every hop l. The
+  // seeds of hop l + 1 are the distinct vertices sampled at hop l. Sampling is
+  // deterministic for a given `seed`, independent of num_threads.
+  Status SampleNeighbors(const std::vector<node_id_t>& seeds,
+                         const std::vector<uint32_t>& fanouts, int direction,
+                         uint64_t seed, std::vector<SampledLayer>* layers,
+                         int num_threads = 1);
+  // Streams every adjacency list under one snapshot. The key space is cut at
+  // SST file boundaries and the pieces are handed out to num_threads workers,
+  // each running its own readahead iterator that bypasses the block cache.
+  Status ParallelScan(const AdjacencyScanCallback& callback,
+                      int num_threads = 1,
+                      size_t readahead_size = 2 * 1024 * 1024);
+  // Freezes the adjacency lists into a CSR file that AttachCSRSnapshot can
+  // serve from (see rocksdb/graph_csr_snapshot.h). Edge attributes are not
+  // exported; vertices served from the snapshot report the defaults.
+  Status ExportCSRSnapshot(const std::string& path);
+  // Serves GetAllEdges and degree queries from the mmap-ed CSR file; vertices
+  // written after the export keep going to the LSM. Writes between the export
+  // and the attach are recovered from the WAL, so it must still hold them:
+  // once the WAL files are recycled (WAL_ttl_seconds, WAL_size_limit_MB),
+  // the attach returns Incomplete and the snapshot has to be exported again.
+  // Replaces any snapshot attached before.
+  Status AttachCSRSnapshot(const std::string& path);
+  void DetachCSRSnapshot();
+  // With blob_min_degree_, rewrites the blob files holding at least
+  // `min_garbage_ratio` garbage, together with every older blob file, and
+  // the adjacency files that reference them. Compactions that merge operands
+  // into a list in a blob file leave the old copy behind as garbage; they do
+  // not relocate live lists themselves, since hub lists rarely change.
+  Status CollectBlobGarbage(double min_garbage_ratio = 0.5);
   Status SimpleWalk(node_id_t start, float decay_factor = 0.20);
+
+  // Vertex relabeling. After SetIdMapping() every API above takes and returns
+  // external ids while storage uses internal ids chosen so that adjacency
+  // keys follow the given order; see RankToLocalityId(). The map is kept in
+  // the "id_map" column family with an LRU cache in front. ParallelScan,
+  // CSR snapshots and GraphAnalytics work on internal ids; use
+  // ToExternalId() to map their results back.
+  //
+  // Computes an `order_type` (RELABEL_ORDER_*) ordering of `edges`, records
+  // it and writes every adjacency list in key order. Needs an empty graph.
+  Status BulkLoadRelabeled(
+      const std::vector<std::pair<node_id_t, node_id_t>>& edges,
+      int order_type);
+  // Assigns order[r] the internal id of rank r. Needs an empty graph; for
+  // loaders that write the adjacency SSTs themselves (tools/bulkload.cc).
+  Status SetIdMapping(const std::vector<node_id_t>& order);
+  bool relabeled() const { return relabel_; }
+  // Identity unless relabeled. With `create`, unseen external ids get a
+  // fresh internal id; otherwise they are NotFound.
+  Status ToInternalId(node_id_t external, node_id_t* internal,
+                      bool create = false);
+  Status ToExternalId(node_id_t internal, node_id_t* external);
+  // Records every point operation, with its arrival time, to `trace_writer`
+  // until EndTrace. See graph_trace.h for the traced ops and the replayer.
+  Status StartTrace(const TraceOptions& trace_options,
+                    std::unique_ptr<TraceWriter>&& trace_writer);
+  Status EndTrace();
+  // Replays the WAL from `since` as logical changes; see graph_changes.h.
+  // Resume from the iterator's checkpoint(). Only WAL files the DB still
+  // keeps are visible, so a consumer that lags behind flushes needs
+  // WAL_ttl_seconds or WAL_size_limit_MB set.
+  Status GetChangesSince(SequenceNumber since,
+                         std::unique_ptr<GraphChangeIterator>* iter,
+                         size_t max_batch_changes = 1024);
+  // Graph counterpart of DB::GetProperty; see GraphProperties for the names.
+  bool GetProperty(const std::string& property, std::string* value);
+  bool GetIntProperty(const std::string& property, uint64_t* value);
   void GetRocksDBStats(std::string& stat) {
     db_->GetProperty("rocksdb.stats", &stat);
   }
@@ -548,6 +1312,21 @@ class RocksGraph {
     outFile.write(reinterpret_cast<const char*>(&meta.n), sizeof(meta.n));
     outFile.write(reinterpret_cast<const char*>(&meta.m), sizeof(meta.m));
     WriteMorrisCounter(outFile, mor);
+    std::lock_guard<std::mutex> lock(label_mu_);
+    size_t num_labels = label_degrees_.size();
+    outFile.write(reinterpret_cast<const char*>(&num_labels),
+                  sizeof(num_labels));
+    for (const auto& label_counter : label_degrees_) {
+      outFile.write(reinterpret_cast<const char*>(&label_counter.first),
+                    sizeof(label_counter.first));
+      WriteMorrisCounter(outFile, *label_counter.second);
+    }
+    outFile.write(reinterpret_cast<const char*>(&meta.is_directed),
+                  sizeof(meta.is_directed));
+    outFile.write(reinterpret_cast<const char*>(&meta.temporal),
+                  sizeof(meta.temporal));
+    outFile.write(reinterpret_cast<const char*>(&meta.blob_min_degree),
+                  sizeof(meta.blob_min_degree));
     outFile.close();
   }
 
@@ -560,6 +1339,29 @@ class RocksGraph {
     inFile.read(reinterpret_cast<char*>(&meta.n), sizeof(meta.n));
     inFile.read(reinterpret_cast<char*>(&meta.m), sizeof(meta.m));
     ReadMorrisCounter(inFile, mor);
+    // files written before labeled lists end here
+    size_t num_labels = 0;
+    inFile.read(reinterpret_cast<char*>(&num_labels), sizeof(num_labels));
+    for (size_t i = 0; inFile && i < num_labels; i++) {
+      edge_label_t label;
+      inFile.read(reinterpret_cast<char*>(&label), sizeof(label));
+      ReadMorrisCounter(inFile, *LabelDegreeCounter(label));
+    }
+    // and files written before the direction was kept here
+    int8_t is_directed;
+    if (inFile.read(reinterpret_cast<char*>(&is_directed),
+                    sizeof(is_directed))) {
+      meta.is_directed = is_directed;
+    }
+    // and before the history and blob settings were
+    int8_t temporal;
+    int64_t blob_min_degree;
+    if (inFile.read(reinterpret_cast<char*>(&temporal), sizeof(temporal)) &&
+        inFile.read(reinterpret_cast<char*>(&blob_min_degree),
+                    sizeof(blob_min_degree))) {
+      meta.temporal = temporal;
+      meta.blob_min_degree = blob_min_degree;
+    }
     inFile.close();
   }
 
@@ -580,18 +1382,25 @@ class RocksGraph {
   void SetRate(double cache_miss_rate) { cache_miss_rate_ = cache_miss_rate; }
 
   int AdaptPolicy(node_id_t src, double update_ratio, double lookup_ratio) {
-    if (level_num_update_countdown == 0) {
-      level_num_update_countdown = 100000;
-      UpdateLevelNum();
+    double level_num_now;
+    {
+      // transactions adapt from several threads at once
+      std::lock_guard<std::mutex> lock(policy_mu_);
+      if (level_num_update_countdown == 0) {
+        level_num_update_countdown = 100000;
+        UpdateLevelNum();
+      }
+      level_num_update_countdown--;
+      level_num_now = level_num;
     }
-    level_num_update_countdown--;
     node_id_t block_size = 2 << 11;
     node_id_t vertex_space = sizeof(node_id_t);
     node_id_t edge_space = sizeof(edge_id_t);
     // node_id_t degree = is_out_edge ? GetOutDegreeApproximate(src)
     //                                : GetInDegreeApproximate(src);
-    node_id_t degree = GetDegreeApproximate(src);
-    double WA = db_->GetOptions().max_bytes_for_level_multiplier * level_num;
+    node_id_t degree = GetDegreeApproximateInternal(src);
+    double WA =
+        db_->GetOptions().max_bytes_for_level_multiplier * level_num_now;
     double left =
         (2 +
          (double)(vertex_space + edge_space * degree) / (double)block_size) +
@@ -606,11 +1415,9 @@ class RocksGraph {
     // } else {
     //   return EDGE_UPDATE_LAZY;
     // }
-    if (left < right) {
-      return EDGE_UPDATE_EAGER;
-    } else {
-      return EDGE_UPDATE_LAZY;
-    }
+    int policy = left < right ? EDGE_UPDATE_EAGER : EDGE_UPDATE_LAZY;
+    RecordPolicyChoice(policy);
+    return policy;
   }
 
   void UpdateLevelNum() {
@@ -669,21 +1476,190 @@ class RocksGraph {
   }
 
  private:
+  // batches the reads of many callers through MultiGetAdjacency
+  friend class GraphAsyncReader;
+  // rewrites lists through a Transaction instead of a WriteBatch
+  friend class GraphTransaction;
+  // writes properties of the storage ids of its CSR snapshot
+  friend class GraphAnalytics;
+
+  // AddVertexProperties on storage ids.
+  Status AddVertexPropertiesInternal(const std::vector<node_id_t>& ids,
+                                     const std::vector<Property>& props);
+
+  // DB::Open, or TransactionDB / OptimisticTransactionDB::Open with
+  // `txn_options`; sets db_, and edge_filter_cache_ with edge_filter_.
+  Status OpenDB(const Options& options,
+                const std::vector<ColumnFamilyDescriptor>& column_families,
+                const GraphTransactionDBOptions* txn_options,
+                const std::string* secondary_path,
+                std::vector<ColumnFamilyHandle*>* handles);
+  // Adds the counts and the sketch chunks changed since the last call to
+  // `batch`; needs meta_mu_.
+  void AppendPublishedMeta(WriteBatch* batch);
+  Status LoadPublishedMeta();
+
   node_id_t random_walk(node_id_t start, float decay_factor = 0.20);
-  DB* db_;
+  // Storage-id versions of the public calls, used once ids are translated.
+  Status GetAllEdgesInternal(node_id_t src, Edges* edges);
+  // Both AddEdge overloads; `attr` may be NULL.
+  Status WriteEdge(node_id_t from, node_id_t to, const EdgeAttr* attr);
+  // Views the adjacency value of `src`, which `value` keeps alive. Vertices
+  // served by the CSR snapshot are re-encoded without attributes.
+  Status GetAdjacencyView(node_id_t src, std::string* value,
+                          EdgeListView* view);
+  // MultiGet over storage ids, filling `views` (backed by `values`) in the
+  // same order. The CSR snapshot serves the vertices it covers; missing
+  // vertices get empty views. Reads with a timestamp go to the history.
+  Status MultiGetAdjacency(const ReadOptions& read_options,
+                           const std::vector<node_id_t>& ids,
+                           std::vector<PinnableSlice>* values,
+                           std::vector<EdgeListView>* views);
+  // Rejects as-of reads without a history or below TrimHistory's cutoff.
+  Status CheckAsOf(uint64_t as_of);
+  // KHop over storage ids; timestamped `read_options` read the history.
+  Status KHopInternal(node_id_t start, uint32_t hops,
+                      const ReadOptions& read_options,
+                      std::vector<node_id_t>* reached);
+  // Every graph write goes through this, so temporal mode can copy the
+  // adjacency updates into the history in the same batch.
+  Status WriteGraph(WriteBatch* batch);
+  // ShortestPath over storage ids.
+  Status SearchPath(node_id_t u, node_id_t v, uint32_t max_hops,
+                    const PathQueryOptions& options,
+                    std::vector<node_id_t>* path);
+  // LinkPredictionScores over storage ids.
+  Status ScorePairs(const std::vector<std::pair<node_id_t, node_id_t>>& pairs,
+                    LinkPredictionMetric metric, int direction,
+                    std::vector<double>* scores);
+  // One direction's labeled list of `v`, in storage ids.
+  Status ReadLabeledList(node_id_t v, edge_label_t label, int direction,
+                         Edges* edges);
+  // Adds or removes u in one labeled list of v, eagerly or as a merge
+  // operand per the update policy. An eager insert that finds u already
+  // there clears `is_new`.
+  Status UpdateLabeledList(WriteBatch* batch, node_id_t v, node_id_t u,
+                           edge_label_t label, int direction, bool remove,
+                           const EdgeAttr* attr, bool* is_new);
+  MorrisCounter* LabelDegreeCounter(edge_label_t label);
+  // Undirected updates: both endpoints' lists change in one batch.
+  Status AddUndirectedEdge(node_id_t from, node_id_t to, int policy,
+                           const EdgeAttr* attr = NULL);
+  Status DeleteUndirectedEdge(node_id_t from, node_id_t to);
+  // DeleteVertex helpers: drop `id` from the lists of its neighbors, where
+  // `masks` holds per neighbor the EDGE_DIRECTION_* bits to clean.
+  Status UnlinkNeighbors(WriteBatch* batch, node_id_t id,
+                         const std::unordered_map<node_id_t, int>& masks);
+  Status DeleteLabeledLists(WriteBatch* batch, node_id_t id);
+  Status InsertNeighbor(WriteBatch* batch, node_id_t v, node_id_t u,
+                        int policy, bool* is_new,
+                        const EdgeAttr* attr = NULL);
+  Status RemoveNeighbor(WriteBatch* batch, node_id_t v, node_id_t u);
+  node_id_t GetDegreeApproximateInternal(node_id_t id,
+                                         int filter_type_manual = 0);
+  // Rewrites internal neighbor ids as external ones, keeping lists sorted.
+  Status TranslateEdges(Edges* edges);
+  void LoadIdMapMeta();
+  Status WriteIdMapping(WriteBatch* batch, node_id_t external,
+                        node_id_t internal);
+  // Returns true if the attached CSR snapshot is authoritative for `id`; then
+  // `found` tells whether the vertex exists and `index` locates it.
+  // The attached snapshot if it serves `id`, else null. Callers read through
+  // the returned copy, which a concurrent detach leaves valid.
+  std::shared_ptr<CSRSnapshot> ServedByCSRSnapshot(node_id_t id, bool* found,
+                                                   uint64_t* index);
+  void DetachCSRSnapshotLocked();
+  // db_->Get on the adjacency CF that also accounts the merge operands the
+  // read folded.
+  Status ReadAdjacency(const std::string& key, std::string* value);
+  void RecordDecodedEdges(const Edges& edges, uint64_t decode_nanos);
+  void RecordPolicyChoice(int policy);
+  void AddEdgeFilterCollector(ColumnFamilyOptions* adj_options);
+  // Moves lists of blob_min_degree_ neighbors or more to blob files, read
+  // through the block cache. See CollectBlobGarbage.
+  void ConfigureAdjacencyBlobs(ColumnFamilyOptions* adj_options);
+  void CountDegree(node_id_t v);
+  void TraceOp(GraphTraceOp op, node_id_t src, node_id_t dst = 0,
+               const Property* prop = nullptr, edge_label_t label = 0) {
+    if (tracing_.load(std::memory_order_relaxed)) {
+      WriteTrace(op, src, dst, prop, label);
+    }
+  }
+  void WriteTrace(GraphTraceOp op, node_id_t src, node_id_t dst,
+                  const Property* prop, edge_label_t label);
+  // Keeps `id` (or the adjacency keys of `batch`) off the CSR snapshot.
+  // WriteGraph marks its batches itself; writes made elsewhere mark their
+  // vertices before they are made.
+  void MarkChanged(node_id_t id) {
+    if (!csr_tracking_.load()) return;
+    std::lock_guard<std::mutex> lock(csr_mu_);
+    csr_changed_.insert(id);
+  }
+  void MarkChanged(const WriteBatch& batch);
+  DB* db_ = nullptr;
+  // db_ itself when opened for transactions, else null
+  TransactionDB* txn_db_ = nullptr;
+  OptimisticTransactionDB* occ_db_ = nullptr;
   // bool is_lazy_;
-  ColumnFamilyHandle *adj_cf_, *edge_prop_cf_, *vertex_prop_cf_;
+  ColumnFamilyHandle *adj_cf_, *label_cf_, *edge_prop_cf_, *vertex_prop_cf_,
+      *id_map_cf_, *rank_cf_;
+  ColumnFamilyHandle* history_cf_ = nullptr;
+  ColumnFamilyHandle* meta_cf_ = nullptr;
+  bool secondary_ = false;
+  std::thread catch_up_thread_;
+  std::mutex catch_up_mu_;
+  std::condition_variable catch_up_cv_;
+  bool stop_catch_up_ = false;
+  // graph write batches so far; every kMetaPublishBatches-th one also
+  // carries the counts and the changed sketch chunks
+  static constexpr uint64_t kMetaPublishBatches = 4096;
+  std::atomic<uint64_t> meta_batches_{0};
+  std::mutex meta_mu_;
+  // hash of every sketch chunk as last published
+  std::vector<uint64_t> published_chunk_hashes_;
+  // edge count the history merge operator adjusts; not reported anywhere
+  std::atomic<node_id_t> history_m_{0};
+  // likewise for the adjacency merges a secondary's reads run
+  std::atomic<node_id_t> secondary_m_{0};
+  std::atomic<uint64_t> write_timestamp_{0};
   CountMinSketch cms_out;
   CountMinSketch cms_in;
   MorrisCounter mor;
+  std::unordered_map<edge_label_t, std::unique_ptr<MorrisCounter>>
+      label_degrees_;
+  std::mutex label_mu_;
   double level_num = 2.5;
   int level_num_update_countdown = 0;
+  // guards level_num and its countdown
+  std::mutex policy_mu_;
   // MorrisCounter mor_out;
   // MorrisCounter mor_out_delete;
   // MorrisCounter mor_in;
   // MorrisCounter mor_in_delete;
   double cms_delta = 0.1;
   double cms_epsilon = 1.0 / 12000;
+  // read and replaced with std::atomic_load / std::atomic_store
+  std::shared_ptr<CSRSnapshot> csr_snapshot_;
+  std::unordered_set<node_id_t> csr_changed_;
+  std::mutex csr_mu_;
+  // set from the start of an attach until the detach; writes record the
+  // vertices they change while it is
+  std::atomic<bool> csr_tracking_{false};
+  // held shared by WriteGraph around its check of csr_tracking_ and its
+  // write, so an attach can wait for the writes that did not check it
+  std::shared_mutex csr_write_mu_;
+  // serializes attaches and detaches
+  std::mutex csr_attach_mu_;
+  bool relabel_ = false;
+  node_id_t next_internal_id_ = 0;
+  std::mutex id_mu_;
+  IdMapCache to_internal_cache_;
+  IdMapCache to_external_cache_;
+  // accessed with std::atomic_load/atomic_store; tracing_ is the cheap check
+  std::shared_ptr<GraphTracer> tracer_;
+  std::atomic<bool> tracing_{false};
+  std::shared_ptr<Statistics> statistics_;
+  GraphStats graph_stats_;
 };
 
 }  // namespace ROCKSDB_NAMESPACE
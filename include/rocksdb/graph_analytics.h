@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "rocksdb/graph.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+using dense_id_t = uint32_t;
+
+// Read-only compressed sparse row copy of the adjacency column family.
+// Vertices are renumbered 0..num_vertices-1 in ascending order of their
+// stored ids (internal ids on a relabeled graph), so sorted neighbor lists
+// stay sorted; ids[d] maps a dense id back. Neighbors that have no
+// adjacency key of their own are dropped.
+struct GraphCSR {
+  dense_id_t num_vertices = 0;
+  std::vector<node_id_t> ids;
+  std::vector<uint64_t> out_offsets;
+  std::vector<dense_id_t> out_neighbors;
+  std::vector<uint64_t> in_offsets;
+  std::vector<dense_id_t> in_neighbors;
+
+  uint64_t out_degree(dense_id_t v) const {
+    return out_offsets[v + 1] - out_offsets[v];
+  }
+  uint64_t in_degree(dense_id_t v) const {
+    return in_offsets[v + 1] - in_offsets[v];
+  }
+  size_t CalcMemoryUsage() const {
+    return ids.capacity() * sizeof(node_id_t) +
+           (out_offsets.capacity() + in_offsets.capacity()) * sizeof(uint64_t) +
+           (out_neighbors.capacity() + in_neighbors.capacity()) *
+               sizeof(dense_id_t);
+  }
+};
+
+// Whole-graph kernels over a CSR snapshot of a RocksGraph. The snapshot is
+// taken once with LoadSnapshot() (a ParallelScan under a DB snapshot) and
+// then every kernel runs purely in memory on num_threads threads.
+class GraphAnalytics {
+ public:
+  explicit GraphAnalytics(RocksGraph* graph, int num_threads = 1)
+      : graph_(graph), num_threads_(num_threads < 1 ? 1 : num_threads) {}
+
+  Status LoadSnapshot();
+  const GraphCSR& csr() const { return csr_; }
+
+  // Pull-based PageRank over in-edges; ranks are indexed by dense id.
+  Status PageRank(std::vector<double>* ranks, int max_iterations = 20,
+                  double damping = 0.85, double tolerance = 1e-9);
+
+  // Weakly connected components with a lock-free union-find; every vertex is
+  // labeled with the smallest stored id in its component.
+  Status WeaklyConnectedComponents(std::vector<node_id_t>* labels);
+
+  // Triangles of the underlying undirected simple graph. Edges are oriented
+  // from lower to higher (degree, id) rank so every triangle is counted once.
+  Status TriangleCount(uint64_t* total,
+                       std::vector<uint64_t>* per_vertex = nullptr);
+
+  // Stores values[d] as property `name` of vertex ids[d] using batched
+  // writes.
+  template <typename T>
+  Status WriteVertexProperty(const std::string& name,
+                             const std::vector<T>& values,
+                             size_t batch_size = 4096) {
+    if (values.size() != csr_.num_vertices) {
+      return Status::InvalidArgument("one value per snapshot vertex expected");
+    }
+    std::vector<node_id_t> ids;
+    std::vector<Property> props;
+    for (size_t d = 0; d < values.size(); d++) {
+      // snapshot ids are storage ids already
+      ids.push_back(csr_.ids[d]);
+      props.push_back(Property{name, std::to_string(values[d])});
+      if (ids.size() == batch_size || d + 1 == values.size()) {
+        Status s = graph_->AddVertexPropertiesInternal(ids, props);
+        if (!s.ok()) return s;
+        ids.clear();
+        props.clear();
+      }
+    }
+    return Status::OK();
+  }
+
+ private:
+  RocksGraph* graph_;
+  int num_threads_;
+  GraphCSR csr_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
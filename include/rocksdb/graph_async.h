@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rocksdb/graph.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+struct GraphAsyncReadOptions {
+  // Threads issuing the reads. While one decodes a batch and runs its
+  // callbacks, the others keep batches in flight.
+  size_t num_threads = 2;
+  // Queued reads, from any caller, that one MultiGet takes at most.
+  size_t max_batch_size = 256;
+  // Set on the MultiGet ReadOptions, together with optimize_multiget_for_io,
+  // so builds with coroutine support read the files of a batch in parallel.
+  // Without it the blocks of each file are still read with one MultiRead.
+  bool async_io = true;
+};
+
+// Non-blocking adjacency reads. Calls only queue the read and return; a few
+// worker threads gather the queued reads of every caller into MultiGet
+// batches and complete them through a callback, run on a worker, or a
+// future. So a handful of threads can keep hundreds of adjacency reads in
+// flight, and KHopAsync traversals share batches with each other.
+//
+// Reads see the latest lists, served by the CSR snapshot where attached,
+// and take and return external ids. Not supported with
+// EDGE_UPDATE_FULL_LAZY. Destruction completes every queued read first.
+class GraphAsyncReader {
+ public:
+  using Callback = std::function<void(const Status&)>;
+
+  explicit GraphAsyncReader(
+      RocksGraph* graph,
+      const GraphAsyncReadOptions& options = GraphAsyncReadOptions());
+  ~GraphAsyncReader();
+  // No copy and move.
+  GraphAsyncReader(const GraphAsyncReader&) = delete;
+  GraphAsyncReader& operator=(const GraphAsyncReader&) = delete;
+
+  // GetAllEdges; `edges` must stay alive until `done` runs.
+  void GetAllEdgesAsync(node_id_t src, Edges* edges, Callback done);
+  std::future<Status> GetAllEdgesAsync(node_id_t src, Edges* edges);
+  // KHop, with every level queued as one read per frontier vertex. `reached`
+  // ends up as KHop would fill it.
+  void KHopAsync(node_id_t start, uint32_t hops,
+                 std::vector<node_id_t>* reached, Callback done);
+  std::future<Status> KHopAsync(node_id_t start, uint32_t hops,
+                                std::vector<node_id_t>* reached);
+
+  // Reads completed and MultiGet calls issued so far.
+  uint64_t reads() const { return reads_.load(std::memory_order_relaxed); }
+  uint64_t batches() const {
+    return batches_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Read of one list by storage id. `value` and `view` are null when the
+  // batch failed and empty when the vertex is missing.
+  struct Read {
+    node_id_t id;
+    std::function<void(const Status&, const Slice* value,
+                       EdgeListView* view)>
+        done;
+  };
+  struct KHopState;
+
+  void Submit(std::vector<Read>* reads);
+  void Work();
+  // Queues the next level of `state`, or completes it.
+  void ExpandLevel(const std::shared_ptr<KHopState>& state);
+
+  RocksGraph* graph_;
+  GraphAsyncReadOptions options_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Read> queue_;
+  // reads taken off the queue whose callbacks have not returned; their
+  // callbacks may queue more
+  size_t running_ = 0;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+  std::atomic<uint64_t> reads_{0};
+  std::atomic<uint64_t> batches_{0};
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,93 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/graph.h"
+#include "rocksdb/transaction_log.h"
+#include "rocksdb/write_batch.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// Logical graph updates reported by RocksGraph::GetChangesSince.
+enum GraphChangeType : char {
+  kGraphChangeAddVertex = 0,
+  kGraphChangeDeleteVertex = 1,
+  kGraphChangeAddEdge = 2,
+  kGraphChangeDeleteEdge = 3,
+  kGraphChangeSetVertexProperty = 4,
+  kGraphChangeSetEdgeProperty = 5,
+  kGraphChangeAddLabeledEdge = 6,
+  kGraphChangeDeleteLabeledEdge = 7,
+  kGraphChangeTypeMax,
+};
+
+const char* GraphChangeTypeName(GraphChangeType type);
+
+struct GraphChange {
+  GraphChangeType type = kGraphChangeTypeMax;
+  // sequence number of the write batch that made the change
+  SequenceNumber sequence = 0;
+  node_id_t src = 0;
+  // only meaningful for edge changes
+  node_id_t dst = 0;
+  // only meaningful for the Set*Property changes
+  Property prop;
+  // only meaningful for the labeled edge changes
+  edge_label_t label = 0;
+};
+
+// Tags `batch` with the logical change it makes, as WAL-only log data. A
+// batch carrying tags is reported from its tags alone, so a tag of type
+// kGraphChangeTypeMax just marks a batch whose change another batch reports.
+void PutGraphChangeRecord(WriteBatch* batch, GraphChangeType type,
+                          node_id_t src = 0, node_id_t dst = 0,
+                          edge_label_t label = 0);
+// The log data PutGraphChangeRecord adds, for writers without a WriteBatch.
+std::string GraphChangeRecord(GraphChangeType type, node_id_t src = 0,
+                              node_id_t dst = 0, edge_label_t label = 0);
+
+// How the iterator finds the graph's writes in the WAL.
+struct GraphChangeSource {
+  uint32_t adj_cf_id = 0;
+  uint32_t vertex_prop_cf_id = 0;
+  uint32_t edge_prop_cf_id = 0;
+  int encoding_type = 0;
+  bool is_directed = true;
+  // Maps storage ids back to the caller's ids.
+  std::function<Status(node_id_t, node_id_t*)> to_external;
+};
+
+// Turns the WAL back into graph changes, one group of whole write batches per
+// step. Batches without tags (bulk loads) are decoded from their adjacency
+// merge operands and list Puts; property writes are always decoded from the
+// property column families. Labeled edges are reported from their tags.
+class GraphChangeIterator {
+ public:
+  GraphChangeIterator(std::unique_ptr<TransactionLogIterator>&& wal,
+                      const GraphChangeSource& source, SequenceNumber since,
+                      size_t max_batch_changes);
+
+  // False once the WAL is exhausted or on error; check status().
+  bool Valid() const { return valid_; }
+  // Moves to the next group of whole write batches, closed once it holds
+  // max_batch_changes changes, so one large batch can overshoot the limit.
+  void Next();
+  Status status() const { return status_; }
+  const std::vector<GraphChange>& changes() const { return changes_; }
+  // Sequence number to pass to GetChangesSince to resume right after the
+  // current group. Stays put once the iterator is exhausted.
+  SequenceNumber checkpoint() const { return checkpoint_; }
+
+ private:
+  std::unique_ptr<TransactionLogIterator> wal_;
+  GraphChangeSource source_;
+  size_t max_batch_changes_;
+  std::vector<GraphChange> changes_;
+  SequenceNumber checkpoint_;
+  Status status_;
+  bool valid_ = false;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,72 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "rocksdb/graph.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// On-disk layout of a frozen adjacency snapshot. All sections are 8-byte
+// aligned arrays following the header:
+//   ids[num_vertices]                 ascending stored ids
+//   out_offsets[num_vertices + 1]     into out_neighbors
+//   out_neighbors[num_out_edges]
+//   in_offsets[num_vertices + 1]      into in_neighbors
+//   in_neighbors[num_in_edges]
+struct CSRSnapshotHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t sequence;
+  uint64_t num_vertices;
+  uint64_t num_out_edges;
+  uint64_t num_in_edges;
+};
+
+const uint64_t kCSRSnapshotMagic = 0x52534347534b4352ULL;
+const uint32_t kCSRSnapshotVersion = 1;
+
+// Read-only view over a CSR snapshot file. The file is opened with mmap
+// reads, so lookups are plain memory accesses into the mapping.
+class CSRSnapshot {
+ public:
+  static Status Open(Env* env, const std::string& path,
+                     std::unique_ptr<CSRSnapshot>* snapshot);
+
+  // Writes the adjacency of `db`'s column family as of `db_snapshot`.
+  static Status Export(DB* db, ColumnFamilyHandle* adj_cf,
+                       const Snapshot* db_snapshot, int encoding_type,
+                       Env* env, const std::string& path);
+
+  // DB sequence number the snapshot reflects.
+  uint64_t sequence() const { return header_->sequence; }
+  uint64_t num_vertices() const { return header_->num_vertices; }
+
+  // Position of `id` in the snapshot, or false if it has no adjacency key.
+  bool Find(node_id_t id, uint64_t* index) const;
+  uint32_t out_degree(uint64_t index) const {
+    return static_cast<uint32_t>(out_offsets_[index + 1] - out_offsets_[index]);
+  }
+  uint32_t in_degree(uint64_t index) const {
+    return static_cast<uint32_t>(in_offsets_[index + 1] - in_offsets_[index]);
+  }
+  // Copies the lists into freshly allocated arrays (release with free_edges).
+  void GetEdges(uint64_t index, Edges* edges) const;
+
+ private:
+  CSRSnapshot() {}
+
+  std::unique_ptr<RandomAccessFile> file_;
+  // only used when the Env cannot hand out the mapping directly
+  std::unique_ptr<char[]> buffer_;
+  const CSRSnapshotHeader* header_ = nullptr;
+  const node_id_t* ids_ = nullptr;
+  const uint64_t* out_offsets_ = nullptr;
+  const node_id_t* out_neighbors_ = nullptr;
+  const uint64_t* in_offsets_ = nullptr;
+  const node_id_t* in_neighbors_ = nullptr;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,49 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rocksdb/graph.h"
+#include "rocksdb/table_properties.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// Meta block holding a Ribbon filter over the (src, dst) pairs of every
+// out-edge stored in the file, in merge operands as well as in full lists. A
+// list moved to a blob file matches every edge of its vertex. Files without
+// the block (bulk-loaded, written before the filter was enabled, or holding
+// keys the collector does not understand) must be read.
+extern const std::string kEdgeFilterBlockName;
+
+// Collector for the adjacency column family. `encoding_type` must match the
+// graph's, since values are decoded to find the neighbors.
+std::shared_ptr<TablePropertiesCollectorFactory> NewEdgeFilterCollectorFactory(
+    int encoding_type, double bits_per_key = 10);
+
+// The edge filters of the files of one adjacency column family. A file's
+// filter is read from its meta block the first time a lookup reaches the
+// file and kept until the file is no longer live.
+class EdgeFilterCache {
+ public:
+  EdgeFilterCache(DB* db, ColumnFamilyHandle* adj_cf);
+  ~EdgeFilterCache();
+
+  // False only if no memtable holds a write to from's list and no file that
+  // may hold the list has the edge in its filter.
+  bool EdgeMayExist(node_id_t from, node_id_t to);
+
+ private:
+  struct FileFilter;
+  // nullptr if the file could not be read; such files are tried again
+  std::shared_ptr<FileFilter> GetFileFilter(uint64_t number, uint32_t path_id,
+                                            uint64_t file_size);
+
+  DB* db_;
+  ColumnFamilyHandle* adj_cf_;
+  std::mutex mu_;
+  // by file number
+  std::unordered_map<uint64_t, std::shared_ptr<FileFilter>> filters_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "rocksdb/graph.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+struct IncrementalRankOptions {
+  double damping = 0.85;
+  // Residual a vertex may keep unpushed. The scores then sum to within
+  // num_vertices * tolerance / (1 - damping) of the exact ones.
+  double tolerance = 1e-6;
+  // Changes read from the change stream per step.
+  size_t max_batch_changes = 1024;
+};
+
+// PageRank and degree centrality kept up to date from the graph's change
+// stream instead of recomputed. Scores solve
+//   x(v) = (1 - damping) + damping * sum over u -> v of x(u) / outdeg(u),
+// so they average about 1 and x / num_vertices() is the usual normalized
+// rank, except that dangling vertices pass nothing on.
+//
+// Every vertex keeps an estimate p and a residual r in the "graph_rank"
+// column family, with
+//   r(v) = (1 - damping) + damping * sum over u -> v of p(u) / outdeg(u)
+//          - p(v).
+// An edge update only touches the residuals of the endpoints (the source
+// estimate is rescaled so its other neighbors keep their share), and forward
+// push then drains residuals above the tolerance from those vertices only.
+//
+// The lists a batch of changes replaced are read through a DB snapshot held
+// since the previous Rebuild or CatchUp, so duplicate adds and deletes of
+// absent edges cost nothing. Labeled lists are not ranked; FULL_LAZY graphs
+// and graphs without snapshots (inplace_merge_support) are not supported.
+// Calls are serialized; keep one instance per graph, as they share the
+// column family.
+class IncrementalPageRank {
+ public:
+  explicit IncrementalPageRank(
+      RocksGraph* graph,
+      const IncrementalRankOptions& options = IncrementalRankOptions());
+  ~IncrementalPageRank();
+  // No copy and move.
+  IncrementalPageRank(const IncrementalPageRank&) = delete;
+  IncrementalPageRank& operator=(const IncrementalPageRank&) = delete;
+
+  // Recomputes every score from the current lists and starts following the
+  // change stream from there.
+  Status Rebuild();
+  // Applies the changes written since the previous Rebuild or CatchUp. Falls
+  // back to Rebuild the first time and when the WAL no longer reaches back
+  // far enough; see GetChangesSince for keeping it.
+  Status CatchUp();
+
+  // NotFound for vertices the ranking has not seen.
+  Status GetScore(node_id_t id, double* score);
+  // The degree in `direction` over num_vertices() - 1. Undirected graphs
+  // have the same degree in every direction.
+  Status GetDegreeCentrality(node_id_t id, int direction, double* centrality);
+
+  uint64_t num_vertices() const { return num_vertices_; }
+  // Pushes done so far, the unit of work of both Rebuild and CatchUp.
+  uint64_t pushes() const { return pushes_; }
+  uint64_t rebuilds() const { return rebuilds_; }
+
+ private:
+  struct RankState {
+    double p = 0;
+    double r = 0;
+    uint32_t out_degree = 0;
+    uint32_t in_degree = 0;
+  };
+
+  // Out-neighbors (every neighbor on undirected graphs) and in-neighbors of
+  // `id` at `snapshot`, lazy-delete markers skipped.
+  Status ReadLists(const Snapshot* snapshot, node_id_t id,
+                   std::vector<node_id_t>* out, std::vector<node_id_t>* in,
+                   bool* exists);
+  // The cached state of `id`, loaded from the column family or created for
+  // a vertex the ranking has not seen.
+  Status State(node_id_t id, RankState** state);
+  // Pushes the queued residuals, reading out-lists at `snapshot_`.
+  Status Push();
+  void Enqueue(node_id_t id, const RankState& state);
+  // Moves `state`'s contribution from `before` to `after`.
+  Status Relink(node_id_t id, const std::vector<node_id_t>& before,
+                const std::vector<node_id_t>& after);
+  // Drops the snapshot and the caches after a failed step, so the next
+  // CatchUp rebuilds.
+  void Abandon();
+  // Writes the cached states and the vertex count, then clears the caches.
+  // `reset` first drops every stored state.
+  Status Flush(const std::unordered_set<node_id_t>& deleted, bool reset);
+
+  RocksGraph* graph_;
+  IncrementalRankOptions options_;
+  std::mutex mu_;
+  // lists and residuals are current as of this snapshot
+  const Snapshot* snapshot_ = nullptr;
+  SequenceNumber checkpoint_ = 0;
+  // set while rebuilding: the stored states are stale
+  bool fresh_ = false;
+  std::unordered_map<node_id_t, RankState> states_;
+  std::unordered_map<node_id_t, std::vector<node_id_t>> out_lists_;
+  std::deque<node_id_t> queue_;
+  std::unordered_set<node_id_t> queued_;
+  uint64_t num_vertices_ = 0;
+  uint64_t pushes_ = 0;
+  uint64_t rebuilds_ = 0;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,63 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rocksdb/graph.h"
+#include "rocksdb/sst_partitioner.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// Vertex keys hold the id little-endian, so they sort by the byte-reversed
+// id rather than by the id: a range of keys is a contiguous id range only
+// after relabeling, where it is a range of ranks (see RankToLocalityId).
+// Position of `key` in that order, read from its 8-byte vertex prefix, which
+// labeled, FULL_LAZY and property keys share. Shorter keys are zero-padded,
+// so positions never decrease along the key order.
+uint64_t VertexKeyPosition(const Slice& key);
+
+// Cuts compaction outputs where the keys cross a boundary vertex, so every
+// file holds keys of one vertex range only and DeleteFilesInRange, manual
+// CompactRange and range-parallel scans over those ranges line up with file
+// boundaries. Files are still cut by size within a range. Set it as the
+// sst_partitioner_factory of the Options passed to RocksGraph; every column
+// family then uses the same ranges.
+class VertexRangePartitionerFactory : public SstPartitionerFactory {
+ public:
+  // Each boundary (a storage id) is the first vertex of a new range.
+  explicit VertexRangePartitionerFactory(
+      const std::vector<node_id_t>& boundaries = {});
+
+  static const char* kClassName() { return "VertexRangePartitionerFactory"; }
+  const char* Name() const override { return kClassName(); }
+
+  std::unique_ptr<SstPartitioner> CreatePartitioner(
+      const SstPartitioner::Context& context) const override;
+
+  // Applies to compactions picked afterwards; files written earlier follow
+  // the new ranges once compacted again.
+  void SetBoundaries(const std::vector<node_id_t>& boundaries);
+  // Sorted in key order.
+  std::vector<node_id_t> boundaries() const;
+  // Range of storage id `id`, in [0, boundaries().size()].
+  size_t PartitionOf(node_id_t id) const;
+
+ private:
+  mutable std::mutex mu_;
+  std::vector<node_id_t> boundaries_;
+  // VertexKeyPosition of each boundary, shared with the partitioners
+  std::shared_ptr<const std::vector<uint64_t>> positions_;
+};
+
+std::shared_ptr<VertexRangePartitionerFactory>
+NewVertexRangePartitionerFactory(const std::vector<node_id_t>& boundaries = {});
+
+// Scans the adjacency lists in key order under a snapshot and picks up to
+// num_partitions - 1 boundaries that split them into ranges of about equal
+// vertex count or, with `degree_weighted`, about equal out + in edge count.
+// FULL_LAZY graphs weigh every edge key as one edge.
+Status ComputeVertexRangeBoundaries(RocksGraph* graph, uint32_t num_partitions,
+                                    bool degree_weighted,
+                                    std::vector<node_id_t>* boundaries);
+
+}  // namespace ROCKSDB_NAMESPACE
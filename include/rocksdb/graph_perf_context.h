@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "rocksdb/perf_level.h"
+#include "rocksdb/rocksdb_namespace.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// Per-thread costs of RocksGraph operations, the graph counterpart of
+// PerfContext and gated by the same PerfLevel: counts need kEnableCount,
+// timings kEnableTimeExceptForMutex or higher.
+struct GraphPerfContext {
+  void Reset();
+  std::string ToString(bool exclude_zero_counters = false) const;
+
+  // adjacency list point reads and the merge operands they folded
+  uint64_t adj_list_read_count;
+  uint64_t adj_merge_operand_count;
+  uint64_t max_adj_merge_operands;
+  uint64_t adj_list_read_nanos;
+  // neighbor ids decoded from adjacency lists
+  uint64_t decoded_edge_count;
+  uint64_t efp_decode_nanos;
+  // edge updates the adaptive policy sent down each path
+  uint64_t eager_update_count;
+  uint64_t lazy_update_count;
+};
+
+// Returns the calling thread's GraphPerfContext.
+GraphPerfContext* get_graph_perf_context();
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rocksdb/rocksdb_namespace.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+#define RELABEL_ORDER_NONE 0x0
+#define RELABEL_ORDER_DEGREE 0x1  // descending degree, hubs packed together
+#define RELABEL_ORDER_BFS 0x2     // BFS from the highest-degree vertices
+#define RELABEL_ORDER_RCM 0x3     // reverse Cuthill-McKee
+#define RELABEL_ORDER_GORDER 0x4  // greedy Gorder over a sliding window
+
+// Returns the distinct vertices of `edges` in locality order: order[r] is the
+// external id that gets rank r. Edges are treated as undirected.
+std::vector<int64_t> ComputeVertexOrder(
+    const std::vector<std::pair<int64_t, int64_t>>& edges, int order_type);
+
+// Adjacency keys are the little-endian bytes of the id, so consecutive ids do
+// not sort next to each other. This maps rank r < num_vertices to an id whose
+// key sorts at position r among all ranks: the most significant digit of the
+// rank lands in the lowest key byte. The top byte uses a reduced radix, which
+// keeps every id below 2 * num_vertices.
+int64_t inline RankToLocalityId(uint64_t rank, uint64_t num_vertices) {
+  int bytes = 1;
+  uint64_t lower = 1;  // 256^(bytes - 1)
+  while (bytes < 8 && lower * 256 < num_vertices) {
+    lower *= 256;
+    bytes++;
+  }
+  uint64_t top_radix = (num_vertices + lower - 1) / lower;
+  if (top_radix == 0) top_radix = 1;
+  uint64_t id = 0;
+  // least significant digit, radix top_radix, goes to the highest byte
+  id |= (rank % top_radix) << (8 * (bytes - 1));
+  rank /= top_radix;
+  for (int b = bytes - 2; b >= 0; b--) {
+    id |= (rank % 256) << (8 * b);
+    rank /= 256;
+  }
+  return static_cast<int64_t>(id);
+}
+
+// First id handed to vertices created after a relabeled load.
+int64_t inline LocalityIdLimit(uint64_t num_vertices) {
+  uint64_t lower = 1;
+  while (lower * 256 < num_vertices) lower *= 256;
+  uint64_t top_radix = (num_vertices + lower - 1) / lower;
+  return static_cast<int64_t>((top_radix == 0 ? 1 : top_radix) * lower);
+}
+
+// Small LRU map used to keep the hot part of the id translation in memory.
+class IdMapCache {
+ public:
+  explicit IdMapCache(size_t capacity = 1 << 20) : capacity_(capacity) {}
+
+  bool Lookup(int64_t key, int64_t* value) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = map_.find(key);
+    if (it == map_.end()) return false;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    *value = it->second->second;
+    return true;
+  }
+
+  void Insert(int64_t key, int64_t value) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+      it->second->second = value;
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return;
+    }
+    lru_.emplace_front(key, value);
+    map_[key] = lru_.begin();
+    if (map_.size() > capacity_) {
+      map_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mu_);
+    lru_.clear();
+    map_.clear();
+  }
+
+ private:
+  size_t capacity_;
+  std::mutex mu_;
+  std::list<std::pair<int64_t, int64_t>> lru_;
+  std::unordered_map<int64_t, std::list<std::pair<int64_t, int64_t>>::iterator>
+      map_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
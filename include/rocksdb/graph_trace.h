@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "rocksdb/graph.h"
+#include "rocksdb/options.h"
+#include "rocksdb/system_clock.h"
+#include "rocksdb/trace_reader_writer.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// Graph operations captured by RocksGraph::StartTrace. Ids are the external
+// ids the caller passed, so a trace replays on a graph with any id mapping.
+enum GraphTraceOp : char {
+  kGraphTraceAddVertex = 0,
+  kGraphTraceAddEdge = 1,
+  kGraphTraceAddEdgeLazy = 2,
+  kGraphTraceDeleteEdge = 3,
+  kGraphTraceAddVertexProperty = 4,
+  kGraphTraceAddEdgeProperty = 5,
+  kGraphTraceGetAllEdges = 6,
+  kGraphTraceGetOutDegree = 7,
+  kGraphTraceGetInDegree = 8,
+  kGraphTraceGetVertexProperty = 9,
+  kGraphTraceGetEdgeProperty = 10,
+  kGraphTraceHasEdge = 11,
+  kGraphTraceDeleteVertex = 12,
+  kGraphTraceAddLabeledEdge = 13,
+  kGraphTraceDeleteLabeledEdge = 14,
+  kGraphTraceOpMax,
+};
+
+const char* GraphTraceOpName(GraphTraceOp op);
+bool IsGraphTraceWrite(GraphTraceOp op);
+
+struct GraphTraceRecord {
+  uint64_t timestamp = 0;  // microseconds
+  GraphTraceOp op = kGraphTraceOpMax;
+  node_id_t src = 0;
+  // only meaningful for edge ops
+  node_id_t dst = 0;
+  // only meaningful for the Add*Property ops
+  Property prop;
+  // only meaningful for the labeled edge ops
+  edge_label_t label = 0;
+};
+
+// Writes graph operations through a TraceWriter. Records use the regular
+// trace framing (timestamp, type kGraphTrace, payload), so any TraceWriter
+// implementation works. Safe to call from concurrent threads.
+class GraphTracer {
+ public:
+  GraphTracer(SystemClock* clock, const TraceOptions& trace_options,
+              std::unique_ptr<TraceWriter>&& trace_writer);
+  ~GraphTracer();
+  // No copy and move.
+  GraphTracer(const GraphTracer&) = delete;
+  GraphTracer& operator=(const GraphTracer&) = delete;
+
+  Status WriteHeader();
+  // Stamps the record with the current time. Honors max_trace_file_size,
+  // sampling_frequency and the kTraceFilterGet/kTraceFilterWrite filters.
+  Status Write(GraphTraceOp op, node_id_t src, node_id_t dst = 0,
+               const Property* prop = nullptr, edge_label_t label = 0);
+  Status Close();
+
+ private:
+  SystemClock* clock_;
+  TraceOptions trace_options_;
+  std::mutex mu_;
+  std::unique_ptr<TraceWriter> trace_writer_;
+  uint64_t trace_request_count_ = 0;
+};
+
+// Reads a trace produced by GraphTracer.
+class GraphTraceReader {
+ public:
+  explicit GraphTraceReader(std::unique_ptr<TraceReader>&& reader);
+
+  // Must be called first; `start_time` is when tracing began.
+  Status ReadHeader(uint64_t* start_time);
+  // Returns Status::Incomplete() at the end of the trace.
+  Status Read(GraphTraceRecord* record);
+
+ private:
+  std::unique_ptr<TraceReader> trace_reader_;
+};
+
+// Applies one traced operation to `graph`. Reads of missing vertices or
+// properties are not errors.
+Status ExecuteGraphTraceRecord(RocksGraph* graph,
+                               const GraphTraceRecord& record);
+
+struct GraphReplayOptions {
+  // Records are partitioned across threads by source vertex only, so each
+  // vertex's operations keep their traced order, but an edge operation may
+  // pass an earlier operation on its destination vertex (e.g. an AddEdge
+  // replayed before the DeleteVertex of its target). One thread replays
+  // the trace exactly in order.
+  int num_threads = 1;
+  // Speed-up over the traced inter-arrival times, e.g. 2.0 replays twice as
+  // fast. 0 issues every operation as soon as its thread is free.
+  double fast_forward = 1.0;
+};
+
+// Re-issues a graph trace against a RocksGraph.
+class GraphTraceReplayer {
+ public:
+  GraphTraceReplayer(RocksGraph* graph, std::unique_ptr<TraceReader>&& reader);
+
+  // Replays the whole trace. Returns the first error an operation reported,
+  // after the remaining records have still been replayed.
+  Status Replay(const GraphReplayOptions& options);
+
+  uint64_t ops_replayed() const { return ops_replayed_.load(); }
+  uint64_t ops_failed() const { return ops_failed_.load(); }
+
+ private:
+  struct Worker;
+
+  void Issue(const GraphTraceRecord& record, uint64_t trace_start,
+             uint64_t replay_start, double fast_forward);
+
+  RocksGraph* graph_;
+  GraphTraceReader reader_;
+  SystemClock* clock_;
+  std::atomic<uint64_t> ops_replayed_{0};
+  std::atomic<uint64_t> ops_failed_{0};
+  std::mutex status_mu_;
+  Status first_error_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "rocksdb/graph.h"
+#include "rocksdb/utilities/transaction.h"
+
+namespace ROCKSDB_NAMESPACE {
+
+// Set as RocksGraphOptions::txn_options to open the graph on a TransactionDB,
+// or on an OptimisticTransactionDB with `optimistic`.
+struct GraphTransactionDBOptions {
+  // Pessimistic transactions lock each vertex list as they first write or
+  // read it for update, and fail the operation with Busy or TimedOut on a
+  // conflict. Optimistic ones take no locks and fail Commit with Busy
+  // instead. They only check the lists they read or rewrite, so lazy
+  // writers appending to the same hub go through side by side.
+  bool optimistic = false;
+  // Stripes of the vertex lock table. Each stripe has its own mutex and
+  // wait queue, so with many stripes a hub whose lock is contended only
+  // stalls the writers of the vertices hashed to its stripe.
+  size_t num_stripes = 256;
+  // How long an operation waits for a vertex lock another transaction holds.
+  int64_t lock_timeout_ms = 1000;
+  // Optimistic only: buckets of the mutexes that serialize commit-time
+  // validation, likewise hashed by vertex key.
+  uint32_t occ_lock_buckets = 1 << 16;
+};
+
+// Many edge and property updates applied atomically. Conflicts are checked
+// per vertex key: the adjacency list of each endpoint, the property set of
+// a vertex and the edge properties of a source vertex. Lists are updated as
+// the update policy says: lazy adds and deletes append a merge operand,
+// eager ones read the list for update and rewrite it, so concurrent eager
+// writers conflict instead of losing each other's edges. Later operations
+// see the earlier ones of the same transaction.
+//
+// Labeled lists and temporal graphs are not supported, nor is FULL_LAZY.
+// Writes made outside transactions take the vertex locks of a pessimistic
+// graph but are not checked against optimistic transactions. Destroying an
+// uncommitted transaction rolls it back.
+class GraphTransaction {
+ public:
+  ~GraphTransaction();
+  // No copy and move.
+  GraphTransaction(const GraphTransaction&) = delete;
+  GraphTransaction& operator=(const GraphTransaction&) = delete;
+
+  Status AddEdge(node_id_t from, node_id_t to, const EdgeAttr* attr = NULL);
+  Status DeleteEdge(node_id_t from, node_id_t to);
+  // Reads with the lists of `from` locked (pessimistic) or validated at
+  // Commit (optimistic), so decisions made on the answer stay valid.
+  Status HasEdge(node_id_t from, node_id_t to, bool* exists);
+  Status GetAllEdges(node_id_t src, Edges* edges);
+  // Replaces the vertex's properties, like RocksGraph::AddVertexProperty.
+  Status AddVertexProperty(node_id_t id, const Property& prop);
+  Status AddEdgeProperty(node_id_t from, node_id_t to, const Property& prop);
+
+  // Busy: a conflicting transaction committed first (optimistic). The
+  // edge count and degree counters move only once the commit succeeds.
+  Status Commit();
+  Status Rollback();
+
+ private:
+  friend class RocksGraph;
+  GraphTransaction(RocksGraph* graph, Transaction* txn);
+
+  // Adds `u` to (or removes it from) the `direction` list of `v`, both
+  // storage ids. `changed` is whether the list gained or lost the edge. Lazy
+  // adds count as gained and lazy deletes as unchanged, since the merge
+  // operator corrects the counters for them.
+  Status UpdateList(node_id_t v, int direction, node_id_t u, bool add,
+                    const EdgeAttr* attr, bool* changed);
+  Status ReadList(node_id_t v, std::string* value, bool* found);
+
+  RocksGraph* graph_;
+  Transaction* txn_;
+  bool done_ = false;
+  // applied to the graph's counters on Commit
+  int64_t edge_delta_ = 0;
+  std::vector<node_id_t> counted_;
+  std::vector<node_id_t> decayed_;
+  // vertices whose lists were written, kept off a CSR snapshot on Commit
+  std::vector<node_id_t> touched_;
+};
+
+}  // namespace ROCKSDB_NAMESPACE
@@ -128,6 +128,7 @@ struct SstFileMetaData : public FileStorageInfo {
 
   uint64_t num_entries = 0;
   uint64_t num_deletions = 0;
+  uint64_t num_merge_operands = 0;
 
   uint64_t oldest_blob_file_number = 0;  // The id of the oldest blob file
                                          // referenced by the file.
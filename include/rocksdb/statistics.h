@@ -531,6 +531,23 @@ enum Tickers : uint32_t {
   // Number of FS reads avoided due to scan prefetching
   PREFETCH_HITS,
 
+  // RocksGraph adjacency list point reads (GetAllEdges, degree queries and
+  // the reads behind eager updates).
+  GRAPH_ADJ_LIST_READS,
+  // Merge operands folded by those reads.
+  GRAPH_ADJ_MERGE_OPERANDS,
+  // Neighbor ids decoded by adjacency list reads.
+  GRAPH_DECODED_EDGES,
+  // Edge updates the adaptive policy sent down the eager / lazy path.
+  GRAPH_POLICY_EAGER,
+  GRAPH_POLICY_LAZY,
+  // Degree increments dropped because the vertex's Morris counter saturated.
+  GRAPH_MORRIS_SATURATED,
+  // HasEdge calls that consulted the edge filters / that the filters
+  // answered without reading the adjacency list.
+  GRAPH_EDGE_FILTER_CHECKED,
+  GRAPH_EDGE_FILTER_USEFUL,
+
   TICKER_ENUM_MAX
 };
 
@@ -660,6 +677,13 @@ enum Histograms : uint32_t {
   // system's prefetch) from the end of SST table during block based table open
   TABLE_OPEN_PREFETCH_TAIL_READ_BYTES,
 
+  // RocksGraph: merge operands per adjacency list read.
+  GRAPH_ADJ_MERGE_OPERANDS_PER_READ,
+  // RocksGraph: neighbors (out + in) per decoded adjacency list.
+  GRAPH_ADJ_LIST_LENGTH,
+  // RocksGraph: time to decode an Elias-Fano encoded adjacency list.
+  GRAPH_EFP_DECODE_MICROS,
+
   HISTOGRAM_ENUM_MAX
 };
 
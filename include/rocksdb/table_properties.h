@@ -9,6 +9,8 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "rocksdb/customizable.h"
 #include "rocksdb/status.h"
@@ -135,6 +137,16 @@ class TablePropertiesCollector {
 
   // EXPERIMENTAL Return whether the output file should be further compacted
   virtual bool NeedCompact() const { return false; }
+
+  // EXPERIMENTAL Called before Finish() by the block-based table builder.
+  // Every (name, contents) pair added to `blocks` is stored as a meta block
+  // of that name, to be read on demand, rather than as a property that is
+  // loaded whenever the table is opened. Names must not collide with the
+  // table's own meta blocks.
+  virtual Status FinishMetaBlocks(
+      std::vector<std::pair<std::string, std::string>>* /*blocks*/) {
+    return Status::OK();
+  }
 };
 
 // Constructs TablePropertiesCollector. Internals create a new
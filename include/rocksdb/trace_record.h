@@ -39,6 +39,8 @@ enum TraceType : char {
   kIOTracer = 12,
   // Query level tracing related trace type.
   kTraceMultiGet = 13,
+  // Graph operation tracing (RocksGraph::StartTrace).
+  kGraphTrace = 14,
   // All trace types should be added before kTraceMax
   kTraceMax,
 };
@@ -41,7 +41,14 @@ public enum CompactionPriority {
    * level. The file picking process will cycle through all the files in a
    * round-robin manner.
    */
-  RoundRobin((byte)0x4);
+  RoundRobin((byte)0x4),
+
+  /**
+   * First compact files with the most merge operands per entry, larger
+   * files first on ties. Suits merge-heavy workloads, where a key's read
+   * cost grows with the operands stacked above its base value.
+   */
+  MergeOperandDensity((byte)0x5);
 
 
   private final byte value;
@@ -264,6 +264,14 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {PREFETCH_BYTES, "rocksdb.prefetch.bytes"},
     {PREFETCH_BYTES_USEFUL, "rocksdb.prefetch.bytes.useful"},
     {PREFETCH_HITS, "rocksdb.prefetch.hits"},
+    {GRAPH_ADJ_LIST_READS, "rocksgraph.adj.list.reads"},
+    {GRAPH_ADJ_MERGE_OPERANDS, "rocksgraph.adj.merge.operands"},
+    {GRAPH_DECODED_EDGES, "rocksgraph.decoded.edges"},
+    {GRAPH_POLICY_EAGER, "rocksgraph.policy.eager"},
+    {GRAPH_POLICY_LAZY, "rocksgraph.policy.lazy"},
+    {GRAPH_MORRIS_SATURATED, "rocksgraph.morris.saturated"},
+    {GRAPH_EDGE_FILTER_CHECKED, "rocksgraph.edge.filter.checked"},
+    {GRAPH_EDGE_FILTER_USEFUL, "rocksgraph.edge.filter.useful"},
 };
 
 const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
@@ -332,6 +340,10 @@ const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
     {ASYNC_PREFETCH_ABORT_MICROS, "rocksdb.async.prefetch.abort.micros"},
     {TABLE_OPEN_PREFETCH_TAIL_READ_BYTES,
      "rocksdb.table.open.prefetch.tail.read.bytes"},
+    {GRAPH_ADJ_MERGE_OPERANDS_PER_READ,
+     "rocksgraph.adj.merge.operands.per.read"},
+    {GRAPH_ADJ_LIST_LENGTH, "rocksgraph.adj.list.length"},
+    {GRAPH_EFP_DECODE_MICROS, "rocksgraph.efp.decode.micros"},
 };
 
 std::shared_ptr<Statistics> CreateDBStatistics() {
@@ -46,6 +46,8 @@ struct ImmutableCFOptions {
 
   bool inplace_update_support;
 
+  bool inplace_merge_support;
+
   UpdateStatus (*inplace_callback)(char* existing_value,
                                    uint32_t* existing_value_size,
                                    Slice delta_value,
@@ -49,6 +49,7 @@ AdvancedColumnFamilyOptions::AdvancedColumnFamilyOptions(const Options& options)
           options.max_write_buffer_size_to_maintain),
       inplace_update_support(options.inplace_update_support),
       inplace_update_num_locks(options.inplace_update_num_locks),
+      inplace_merge_support(options.inplace_merge_support),
       experimental_mempurge_threshold(options.experimental_mempurge_threshold),
       inplace_callback(options.inplace_callback),
       memtable_prefix_bloom_size_ratio(
@@ -381,6 +382,9 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
         log,
         "                Options.inplace_update_num_locks: %" ROCKSDB_PRIszt,
         inplace_update_num_locks);
+    ROCKS_LOG_HEADER(log,
+                     "                   Options.inplace_merge_support: %d",
+                     inplace_merge_support);
     // TODO: easier config for bloom (maybe based on avg key/value size)
     ROCKS_LOG_HEADER(
         log, "              Options.memtable_prefix_bloom_size_ratio: %f",
@@ -102,6 +102,17 @@ LIB_SOURCES =                                                   \
   db/write_stall_stats.cc                                       \
   db/write_thread.cc                                            \
   db/graph.cc                                                   \
+  db/graph_analytics.cc                                         \
+  db/graph_changes.cc                                           \
+  db/graph_pagerank.cc                                          \
+  db/graph_partitioner.cc                                       \
+  db/graph_async.cc                                             \
+  db/graph_transaction.cc                                       \
+  db/graph_csr_snapshot.cc                                      \
+  db/graph_edge_filter.cc                                       \
+  db/graph_perf_context.cc                                      \
+  db/graph_relabel.cc                                           \
+  db/graph_trace.cc                                             \
   env/composite_env.cc                                          \
   env/env.cc                                                    \
   env/env_chroot.cc                                             \
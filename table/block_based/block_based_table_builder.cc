@@ -1776,6 +1776,29 @@ void BlockBasedTableBuilder::WriteRangeDelBlock(
   }
 }
 
+void BlockBasedTableBuilder::WriteCollectorMetaBlocks(
+    MetaIndexBuilder* meta_index_builder) {
+  for (const auto& collector : rep_->table_properties_collectors) {
+    std::vector<std::pair<std::string, std::string>> blocks;
+    Status s = collector->FinishMetaBlocks(&blocks);
+    if (!s.ok()) {
+      // like a failed Finish(), this only costs the file the collector's data
+      LogPropertiesCollectionError(rep_->ioptions.logger, "FinishMetaBlocks",
+                                   collector->Name());
+      continue;
+    }
+    for (const auto& block : blocks) {
+      if (!ok()) return;
+      BlockHandle block_handle;
+      // opaque to the table reader, so typed like the metaindex: never
+      // warmed into the block cache
+      WriteMaybeCompressedBlock(block.second, kNoCompression, &block_handle,
+                                BlockType::kMetaIndex);
+      if (ok()) meta_index_builder->Add(block.first, block_handle);
+    }
+  }
+}
+
 void BlockBasedTableBuilder::WriteFooter(BlockHandle& metaindex_block_handle,
                                          BlockHandle& index_block_handle) {
   assert(ok());
@@ -1987,15 +2010,17 @@ Status BlockBasedTableBuilder::Finish() {
   //    2. [meta block: index]
   //    3. [meta block: compression dictionary]
   //    4. [meta block: range deletion tombstone]
-  //    5. [meta block: properties]
-  //    6. [metaindex block]
-  //    7. Footer
+  //    5. [meta blocks: from properties collectors]
+  //    6. [meta block: properties]
+  //    7. [metaindex block]
+  //    8. Footer
   BlockHandle metaindex_block_handle, index_block_handle;
   MetaIndexBuilder meta_index_builder;
   WriteFilterBlock(&meta_index_builder);
   WriteIndexBlock(&meta_index_builder, &index_block_handle);
   WriteCompressionDictBlock(&meta_index_builder);
   WriteRangeDelBlock(&meta_index_builder);
+  WriteCollectorMetaBlocks(&meta_index_builder);
   WritePropertiesBlock(&meta_index_builder);
   if (ok()) {
     // flush the meta index block
@@ -14,6 +14,9 @@
 DEFINE_string(write_sst_path, "/home/junfeng/db_backup/", "sst file path");
 DEFINE_string(dataset, "", "graph dataset");
 DEFINE_bool(is_undirected, false, "is undirected graph");
+DEFINE_int32(relabel_order, 0,
+             "vertex relabeling before the load: 0 none, 1 degree, 2 BFS, "
+             "3 RCM, 4 Gorder");
 
 std::unordered_map<uint64_t, std::vector<rocksdb::node_id_t>> out_adj_lists;
 std::unordered_map<uint64_t, std::vector<rocksdb::node_id_t>> in_adj_lists;
@@ -38,6 +41,38 @@ void read_graph() {
     << degree << " edges." << std::endl; 
 }
 
+// Replaces the external ids in the adjacency maps with the internal ids of a
+// locality ordering and records the mapping in the graph.
+void relabel_graph(rocksdb::RocksGraph* db) {
+  std::vector<std::pair<rocksdb::node_id_t, rocksdb::node_id_t>> edges;
+  for (auto& kv : out_adj_lists) {
+    for (auto to : kv.second) edges.emplace_back(kv.first, to);
+  }
+  auto order = rocksdb::ComputeVertexOrder(edges, FLAGS_relabel_order);
+  auto s = db->SetIdMapping(order);
+  if (!s.ok()) {
+    std::cout << "Fail to record id mapping: " << s.ToString() << std::endl;
+    exit(1);
+  }
+  std::unordered_map<rocksdb::node_id_t, rocksdb::node_id_t> internal;
+  for (size_t r = 0; r < order.size(); r++) {
+    internal[order[r]] = rocksdb::RankToLocalityId(r, order.size());
+  }
+  auto translate =
+      [&internal](
+          std::unordered_map<uint64_t, std::vector<rocksdb::node_id_t>>& lists) {
+        std::unordered_map<uint64_t, std::vector<rocksdb::node_id_t>> result;
+        for (auto& kv : lists) {
+          auto& list = result[internal[kv.first]];
+          for (auto v : kv.second) list.push_back(internal[v]);
+        }
+        lists.swap(result);
+      };
+  translate(out_adj_lists);
+  translate(in_adj_lists);
+  std::cout << "relabeled " << order.size() << " vertices." << std::endl;
+}
+
 rocksdb::SstFileWriter* get_sst_writer() {
   auto writer = new rocksdb::SstFileWriter (rocksdb::EnvOptions(), options);
   auto s = writer->Open("/tmp/ingest.sst");
@@ -52,18 +87,40 @@ void write_sst(rocksdb::SstFileWriter* writer, rocksdb::RocksGraph* db) {
   std::cout << "start to write sst..." << std::endl;
   std::unordered_map<std::string, std::string> tmp;
   std::vector<std::string> keys;
-  for (size_t i = 0; i < out_adj_lists.size(); i++) {
-    auto out_v = out_adj_lists[i];
-    auto in_v = in_adj_lists[i];
-    std::sort(out_v.begin(), out_v.end());
-    std::sort(in_v.begin(), in_v.end());
-    auto s = db->AddEdges(i, out_adj_lists[i], in_adj_lists[i]);
+  auto encode = [&](size_t i, uint64_t id,
+                    std::vector<rocksdb::node_id_t>& out_v,
+                    std::vector<rocksdb::node_id_t>& in_v) {
+    auto s = db->AddEdges(id, out_v, in_v);
     db->AddVertexForBulkLoad();
     tmp.insert(s);
     keys.push_back(s.first);
     if (i % 100000 == 0) {
       std::cout << "Finish encoding " << i << " vertices..." << std::endl;
     }
+  };
+  if (FLAGS_relabel_order == RELABEL_ORDER_NONE) {
+    for (size_t i = 0; i < out_adj_lists.size(); i++) {
+      auto out_v = out_adj_lists[i];
+      auto in_v = in_adj_lists[i];
+      std::sort(out_v.begin(), out_v.end());
+      std::sort(in_v.begin(), in_v.end());
+      encode(i, i, out_adj_lists[i], in_adj_lists[i]);
+    }
+  } else {
+    // relabeled ids are not dense, so walk the vertices that have edges
+    std::vector<uint64_t> vertices;
+    for (auto& kv : out_adj_lists) vertices.push_back(kv.first);
+    for (auto& kv : in_adj_lists) vertices.push_back(kv.first);
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                   vertices.end());
+    for (size_t i = 0; i < vertices.size(); i++) {
+      auto out_v = out_adj_lists[vertices[i]];
+      auto in_v = in_adj_lists[vertices[i]];
+      std::sort(out_v.begin(), out_v.end());
+      std::sort(in_v.begin(), in_v.end());
+      encode(i, vertices[i], out_v, in_v);
+    }
   }
   std::sort(keys.begin(), keys.end());
   std::cout << "Start writing to sst..." << std::endl;
@@ -80,7 +137,12 @@ int main(int argc, char** argv) {
   read_graph();
   auto writer = get_sst_writer();
   options.create_if_missing = true;
-  rocksdb::RocksGraph* db = new rocksdb::RocksGraph(options);
+  rocksdb::RocksGraph* db = new rocksdb::RocksGraph(
+      options, EDGE_UPDATE_ADAPTIVE, ENCODING_TYPE_NONE, false, "/tmp/demo",
+      !FLAGS_is_undirected);
+  if (FLAGS_relabel_order != RELABEL_ORDER_NONE) {
+    relabel_graph(db);
+  }
   // write sst file
   write_sst(writer, db);
   auto s = writer->Finish();
@@ -559,6 +559,7 @@ bool Tracer::ShouldSkipTrace(const TraceType& trace_type) {
     case kBlockTraceUncompressionDictBlock:
     case kBlockTraceRangeDeletionBlock:
     case kIOTracer:
+    case kGraphTrace:
       filter_mask = kTraceFilterNone;
       break;
     case kTraceMultiGet:
@@ -82,6 +82,11 @@ Status OptimisticTransactionDB::Open(
   // Enable MemTable History if not already enabled
   for (auto& column_family : column_families_copy) {
     ColumnFamilyOptions* options = &column_family.options;
+    if (options->inplace_merge_support) {
+      // folded merges keep the sequence number validation looks at
+      return Status::NotSupported(
+          "inplace_merge_support is incompatible with transactions");
+    }
 
     if (options->max_write_buffer_size_to_maintain == 0 &&
         options->max_write_buffer_number_to_maintain == 0) {
@@ -242,6 +242,13 @@ Status TransactionDB::Open(
         "WRITE_PREPARED is incompatible with unordered_writes if "
         "two_write_queues is not enabled.");
   }
+  for (const auto& column_family : column_families) {
+    if (column_family.options.inplace_merge_support) {
+      // folded merges keep the sequence number conflict checks look at
+      return Status::NotSupported(
+          "inplace_merge_support is incompatible with transactions");
+    }
+  }
 
   std::vector<ColumnFamilyDescriptor> column_families_copy = column_families;
   std::vector<size_t> compaction_enabled_cf_indices;